@@ -0,0 +1,113 @@
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <cstdint>
+
+#include <tudocomp/util/compact_hash/map/typedefs.hpp>
+#include <tudocomp/util/compact_hash/set/typedefs.hpp>
+
+// Compares sparse tables whose quotients and values have a width of
+// 8, 16 or 32 bits, which buckets store as arrays of native integers,
+// with tables whose widths are one bit larger.
+//
+// The tables are sized up front, such that the quotient width stays
+// the same during all inserts. Each table is built and searched
+// `rounds` times, and the fastest round is reported.
+//
+// Usage: byte_widths [log2 of the table size] [rounds]
+
+using namespace tdc::compact_hash;
+
+template<typename F>
+double seconds(F f) {
+    auto begin = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+}
+
+std::vector<uint64_t> make_keys(size_t n, size_t key_width) {
+    std::mt19937_64 gen(key_width);
+    std::vector<uint64_t> keys(n);
+    for (auto& key : keys) {
+        key = gen() & ((1ull << key_width) - 1);
+    }
+    return keys;
+}
+
+void report(std::string const& name, size_t quot_width, size_t n, double insert, double search, uint64_t checksum) {
+    std::cout << name << " quotients " << quot_width << " bit"
+              << ": insert " << (insert * 1e9 / n) << " ns"
+              << ", search " << (search * 1e9 / n) << " ns"
+              << " (checksum " << checksum << ")" << std::endl;
+}
+
+template<typename table_t>
+void bench_map(std::string const& name, size_t log2, size_t rounds, size_t quot_width, size_t value_width) {
+    size_t const n = (1ull << log2) / 2;
+    auto const keys = make_keys(n, log2 + quot_width);
+    uint64_t const value_mask = (1ull << value_width) - 1;
+
+    double insert = 1e9;
+    double search = 1e9;
+    uint64_t checksum = 0;
+    for (size_t round = 0; round < rounds; round++) {
+        auto table = table_t(1ull << log2, log2 + quot_width, value_width);
+        insert = std::min(insert, seconds([&]() {
+            for (uint64_t key : keys) {
+                table.insert(key, key & value_mask);
+            }
+        }));
+        checksum = 0;
+        search = std::min(search, seconds([&]() {
+            for (uint64_t key : keys) {
+                checksum += uint64_t(*table.search(key));
+            }
+        }));
+        CHECK_EQ(table.quotient_width(), quot_width);
+    }
+    report(name, quot_width, n, insert, search, checksum);
+}
+
+template<typename table_t>
+void bench_set(std::string const& name, size_t log2, size_t rounds, size_t quot_width) {
+    size_t const n = (1ull << log2) / 2;
+    auto const keys = make_keys(n, log2 + quot_width);
+
+    double insert = 1e9;
+    double search = 1e9;
+    uint64_t checksum = 0;
+    for (size_t round = 0; round < rounds; round++) {
+        auto table = table_t(1ull << log2, log2 + quot_width);
+        insert = std::min(insert, seconds([&]() {
+            for (uint64_t key : keys) {
+                table.lookup_insert(key);
+            }
+        }));
+        checksum = 0;
+        search = std::min(search, seconds([&]() {
+            for (uint64_t key : keys) {
+                checksum += table.count(key);
+            }
+        }));
+    }
+    report(name, quot_width, n, insert, search, checksum);
+}
+
+int main(int argc, char** argv) {
+    size_t const log2 = (argc > 1) ? std::stoull(argv[1]) : 22;
+    size_t const rounds = (argc > 2) ? std::stoull(argv[2]) : 5;
+
+    for (size_t quot_width : { 8, 9, 16, 17, 32, 33 }) {
+        bench_map<map::sparse_cv_hashmap_t<uint64_t>>("map, 64 bit values     ", log2, rounds, quot_width, 32);
+    }
+    for (size_t width : { 8, 9, 16, 17, 32, 33 }) {
+        bench_map<map::sparse_cv_hashmap_t<tdc::dynamic_t>>("map, values as wide", log2, rounds, width, width);
+    }
+    for (size_t quot_width : { 8, 9, 16, 17, 32, 33 }) {
+        bench_set<set::sparse_cv_hashset_t<>>("set                     ", log2, rounds, quot_width);
+    }
+}
@@ -0,0 +1,93 @@
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <cstdint>
+
+#include <tudocomp/util/compact_hash/map/typedefs.hpp>
+
+// Compares failed searches in displacement tables with and without
+// per-slot fingerprints, see `displacement_t<T, true>`.
+//
+// The tables are sized up front and filled to a load factor of 0.9
+// without growing. Then keys that are not in the table are searched,
+// `repeats` times as many as there are entries.
+//
+// Usage: fingerprints [log2 of the table size] [repeats]
+
+using namespace tdc::compact_hash;
+
+template<typename displacement_table_t>
+using fingerprint_hashmap_t = map::hashmap_t<
+    uint64_t, poplar_xorshift_t, buckets_bv_t,
+    displacement_t<displacement_table_t, true>>;
+
+template<typename F>
+double seconds(F f) {
+    auto begin = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+}
+
+template<typename table_t>
+void bench(std::string const& name, size_t log2, size_t repeats, size_t fingerprint_width) {
+    size_t const table_size = size_t(1) << log2;
+    size_t const n = table_size * 9 / 10;
+    size_t const key_width = log2 + 16;
+
+    auto config = typename table_t::config_args{};
+    config.displacement_config.fingerprint_width = fingerprint_width;
+    auto table = table_t(table_size, key_width, 64, config);
+    table.max_load_factor(1.0);
+
+    // NB: Only even keys are inserted, so the odd keys are never found.
+    std::mt19937_64 gen(log2);
+    std::vector<uint64_t> keys(n);
+    for (auto& key : keys) {
+        key = gen() & ((1ull << key_width) - 1) & ~1ull;
+        table.insert(key, uint64_t(key));
+    }
+    CHECK_EQ(table.table_size(), table_size);
+
+    size_t found = 0;
+    double miss = seconds([&]() {
+        for (size_t i = 0; i < repeats; i++) {
+            for (uint64_t key : keys) {
+                found += table.count(key | 1);
+            }
+        }
+    });
+    CHECK_EQ(found, 0u);
+
+    uint64_t checksum = 0;
+    double hit = seconds([&]() {
+        for (uint64_t key : keys) {
+            checksum += *table.search(key);
+        }
+    });
+
+    std::cout << name << " fingerprints " << fingerprint_width << " bit"
+              << ": failed search " << (miss * 1e9 / (n * repeats)) << " ns"
+              << ", search " << (hit * 1e9 / n) << " ns"
+              << " (" << tdc::heap_size_compute(table).size_in_kibibytes() << " KiB"
+              << ", checksum " << checksum << ")" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    size_t const log2 = (argc > 1) ? std::stoull(argv[1]) : 16;
+    size_t const repeats = (argc > 2) ? std::stoull(argv[2]) : 10;
+
+    using layered_t = fingerprint_hashmap_t<
+        layered_displacement_table_t<dynamic_layered_bit_width_t>>;
+    using elias_t = fingerprint_hashmap_t<
+        elias_gamma_displacement_table_t<dynamic_fixed_elias_gamma_bucket_size_t>>;
+
+    for (size_t fingerprint_width : { 0, 4, 8 }) {
+        bench<layered_t>("sparse layered", log2, repeats, fingerprint_width);
+    }
+    for (size_t fingerprint_width : { 0, 4, 8 }) {
+        bench<elias_t>("sparse elias  ", log2, repeats, fingerprint_width);
+    }
+}
@@ -0,0 +1,87 @@
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <cstdint>
+
+#include <tudocomp/util/compact_hash/map/typedefs.hpp>
+#include <tudocomp/util/compact_hash/map/fixed_width_hashmap_t.hpp>
+
+// Compares tables with widths fixed at compile time against tables
+// with the same widths set at runtime.
+//
+// Usage: fixed_widths [number of keys]
+
+using namespace tdc::compact_hash;
+using namespace tdc::compact_hash::map;
+
+constexpr size_t KEY_WIDTH = 32;
+constexpr size_t VALUE_WIDTH = 20;
+
+using layered_t = displacement_t<layered_displacement_table_t<dynamic_layered_bit_width_t>>;
+
+template<typename F>
+double seconds(F f) {
+    auto begin = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+}
+
+template<typename table_t>
+void bench(std::string const& name, table_t& table, std::vector<uint64_t> const& keys) {
+    using value_type = typename table_t::value_type;
+
+    double insert = seconds([&]() {
+        for (size_t i = 0; i < keys.size(); i++) {
+            // NB: Not 0, which marks empty slots in `plain_sentinel_t`.
+            table.insert(keys[i], value_type((i & 0xfffff) | 1));
+        }
+    });
+
+    // NB: Repeats the searches of small tables to get measurable times.
+    size_t const rounds = std::max<size_t>(1, (1ull << 24) / keys.size());
+    uint64_t checksum = 0;
+    double search = seconds([&]() {
+        for (size_t r = 0; r < rounds; r++) {
+            for (uint64_t key : keys) {
+                checksum += uint64_t(*table.search(key));
+            }
+        }
+    });
+
+    std::cout << name
+              << ": insert " << (insert * 1e9 / keys.size()) << " ns"
+              << ", search " << (search * 1e9 / (keys.size() * rounds)) << " ns"
+              << " (checksum " << checksum << ")" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    size_t const n = (argc > 1) ? std::stoull(argv[1]) : (1ull << 22);
+
+    std::mt19937_64 gen(1);
+    std::vector<uint64_t> keys(n);
+    for (auto& key : keys) {
+        key = gen() & ((1ull << KEY_WIDTH) - 1);
+    }
+
+    {
+        auto table = sparse_cv_hashmap_t<tdc::dynamic_t>(0, KEY_WIDTH, VALUE_WIDTH);
+        bench("sparse_cv, dynamic widths    ", table, keys);
+    }
+    {
+        auto table = fixed_width_hashmap_t<KEY_WIDTH, VALUE_WIDTH>();
+        bench("sparse_cv, fixed widths      ", table, keys);
+    }
+    {
+        auto table = plain_layered_hashmap_t<tdc::dynamic_t>(0, KEY_WIDTH, VALUE_WIDTH);
+        bench("plain_layered, dynamic widths", table, keys);
+    }
+    {
+        auto table = fixed_width_hashmap_t<
+            KEY_WIDTH, VALUE_WIDTH, static_poplar_xorshift_t<KEY_WIDTH>, plain_sentinel_t, layered_t>();
+        bench("plain_layered, fixed widths  ", table, keys);
+    }
+}
@@ -0,0 +1,156 @@
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <cstdint>
+
+#include <tudocomp/util/compact_hash/hash_functions.hpp>
+#include <tudocomp/util/bits.hpp>
+
+// Compares the probe lengths of linear probing with different hash functions
+// on structured key sets.
+//
+// Usage: hash_quality [number of keys]
+
+using namespace tdc::compact_hash;
+
+/// Keys `0, 1, 2, ...`
+std::vector<uint64_t> sequential_keys(size_t n) {
+    std::vector<uint64_t> keys(n);
+    for (size_t i = 0; i < n; i++) {
+        keys[i] = i;
+    }
+    return keys;
+}
+
+/// Keys `0, 4096, 8192, ...`
+std::vector<uint64_t> strided_keys(size_t n) {
+    std::vector<uint64_t> keys(n);
+    for (size_t i = 0; i < n; i++) {
+        keys[i] = i << 12;
+    }
+    return keys;
+}
+
+/// Keys `parent << 8 | character` of the LZ78 trie of a text
+/// over a small skewed alphabet, as inserted by an LZ78 compressor.
+std::vector<uint64_t> lz78_keys(size_t n) {
+    std::mt19937_64 gen(1);
+    std::geometric_distribution<int> dist(0.3);
+
+    std::vector<uint64_t> keys;
+    std::map<uint64_t, uint64_t> trie;
+    uint64_t node = 0;
+    while (keys.size() < n) {
+        uint64_t const c = 'a' + std::min(dist(gen), 25);
+        uint64_t const key = (node << 8) | c;
+        auto it = trie.find(key);
+        if (it != trie.end()) {
+            node = it->second;
+        } else {
+            trie[key] = keys.size() + 1;
+            keys.push_back(key);
+            node = 0;
+        }
+    }
+    return keys;
+}
+
+struct probe_stats_t {
+    double mean;
+    size_t p99;
+    size_t max;
+};
+
+/// Inserts `keys` with linear probing into a table of `2^capacity_log2` slots,
+/// addressed by the low bits of the hash value like the compact tables.
+template<typename hash_t>
+probe_stats_t probe_lengths(std::vector<uint64_t> const& keys, size_t capacity_log2,
+                            typename hash_t::config_args config) {
+    uint64_t max_key = 0;
+    for (uint64_t key : keys) {
+        max_key = std::max(max_key, key);
+    }
+    uint32_t const key_width = std::max<uint32_t>(tdc::bits_for(max_key), capacity_log2);
+    auto hash = hash_t(key_width, config);
+
+    size_t const capacity = 1ull << capacity_log2;
+    std::vector<bool> occupied(capacity);
+    std::vector<size_t> lengths;
+    lengths.reserve(keys.size());
+
+    for (uint64_t key : keys) {
+        size_t pos = hash.hash(key) & (capacity - 1);
+        size_t length = 0;
+        while (occupied[pos]) {
+            pos = (pos + 1) & (capacity - 1);
+            length++;
+        }
+        occupied[pos] = true;
+        lengths.push_back(length);
+    }
+
+    double sum = 0;
+    for (size_t length : lengths) {
+        sum += length;
+    }
+    std::sort(lengths.begin(), lengths.end());
+    return probe_stats_t {
+        sum / lengths.size(),
+        lengths[lengths.size() * 99 / 100],
+        lengths.back(),
+    };
+}
+
+template<typename hash_t>
+void report(std::string const& name, std::vector<uint64_t> const& keys, size_t capacity_log2,
+            typename hash_t::config_args config = typename hash_t::config_args{}) {
+    auto stats = probe_lengths<hash_t>(keys, capacity_log2, config);
+    std::cout << "  " << std::left << std::setw(24) << name
+              << std::right << std::fixed << std::setprecision(2)
+              << std::setw(10) << stats.mean
+              << std::setw(8) << stats.p99
+              << std::setw(8) << stats.max << std::endl;
+}
+
+int main(int argc, char** argv) {
+    size_t const n = (argc > 1) ? std::stoull(argv[1]) : (1ull << 20);
+
+    // NB: Load factor of 0.5 as with the default `max_load_factor`.
+    size_t const capacity_log2 = tdc::bits_for(n * 2 - 1);
+
+    auto seeded = [](uint64_t seed) {
+        auto config = multiply_xorshift_t::config_args{};
+        config.seed = seed;
+        return config;
+    };
+    auto feistel_seeded = [](uint64_t seed) {
+        auto config = feistel_t::config_args{};
+        config.seed = seed;
+        return config;
+    };
+
+    std::pair<char const*, std::vector<uint64_t>> key_sets[] = {
+        { "sequential", sequential_keys(n) },
+        { "strided", strided_keys(n) },
+        { "lz78 trie", lz78_keys(n) },
+    };
+
+    for (auto const& key_set : key_sets) {
+        std::cout << key_set.first << " (" << n << " keys, 2^" << capacity_log2 << " slots)" << std::endl;
+        std::cout << "  " << std::left << std::setw(24) << "hash"
+                  << std::right << std::setw(10) << "mean"
+                  << std::setw(8) << "p99"
+                  << std::setw(8) << "max" << std::endl;
+        report<xorshift_t>("xorshift_t", key_set.second, capacity_log2);
+        report<poplar_xorshift_t>("poplar_xorshift_t", key_set.second, capacity_log2);
+        report<multiply_xorshift_t>("multiply_xorshift_t", key_set.second, capacity_log2);
+        report<multiply_xorshift_t>("  seeded", key_set.second, capacity_log2, seeded(42));
+        report<feistel_t>("feistel_t", key_set.second, capacity_log2);
+        report<feistel_t>("  seeded", key_set.second, capacity_log2, feistel_seeded(42));
+    }
+}
@@ -0,0 +1,84 @@
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <cstdint>
+
+#include <tudocomp/util/compact_hash/map/typedefs.hpp>
+
+// Compares the hopscotch placement with the cv_bvs placement of Cleary
+// at a high load factor, for sparse and plain storage.
+//
+// The tables are sized up front and filled to the given load factor
+// without growing. Then each key is searched once, followed by as many
+// searches for keys that are not in the table.
+//
+// Usage: hopscotch [log2 of the table size] [load factor in percent]
+
+using namespace tdc::compact_hash;
+
+template<typename F>
+double seconds(F f) {
+    auto begin = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+}
+
+template<typename table_t>
+void bench(std::string const& name, size_t log2, size_t load_percent) {
+    size_t const table_size = size_t(1) << log2;
+    size_t const n = table_size * load_percent / 100;
+    size_t const key_width = log2 + 16;
+
+    // NB: The keys of the negative searches are the odd keys,
+    // which are never inserted.
+    std::mt19937_64 gen(log2);
+    std::vector<uint64_t> keys(n);
+    for (auto& key : keys) {
+        key = (gen() & ((1ull << key_width) - 1)) & ~1ull;
+    }
+
+    auto table = table_t(table_size, key_width, 64);
+    table.max_load_factor(1.0);
+
+    double insert = seconds([&]() {
+        for (uint64_t key : keys) {
+            table.insert(key, uint64_t(key | 1));
+        }
+    });
+    CHECK_EQ(table.table_size(), table_size);
+
+    uint64_t checksum = 0;
+    double hit = seconds([&]() {
+        for (uint64_t key : keys) {
+            checksum += *table.search(key);
+        }
+    });
+    size_t found = 0;
+    double miss = seconds([&]() {
+        for (uint64_t key : keys) {
+            found += table.count(key | 1);
+        }
+    });
+    CHECK_EQ(found, 0u);
+
+    std::cout << name
+              << ": insert " << (insert * 1e9 / n) << " ns"
+              << ", search " << (hit * 1e9 / n) << " ns"
+              << ", failed search " << (miss * 1e9 / n) << " ns"
+              << " (" << table.size() << " entries"
+              << ", " << tdc::heap_size_compute(table).size_in_kibibytes() << " KiB"
+              << ", checksum " << checksum << ")" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    size_t const log2 = (argc > 1) ? std::stoull(argv[1]) : 20;
+    size_t const load_percent = (argc > 2) ? std::stoull(argv[2]) : 90;
+
+    bench<map::sparse_cv_hashmap_t<uint64_t>>       ("sparse cv_bvs   ", log2, load_percent);
+    bench<map::sparse_hopscotch_hashmap_t<uint64_t>>("sparse hopscotch", log2, load_percent);
+    bench<map::plain_cv_hashmap_t<uint64_t>>        ("plain cv_bvs    ", log2, load_percent);
+    bench<map::plain_hopscotch_hashmap_t<uint64_t>> ("plain hopscotch ", log2, load_percent);
+}
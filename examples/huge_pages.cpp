@@ -0,0 +1,105 @@
+#include <algorithm>
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <cstdint>
+#include <cstring>
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <tudocomp/util/compact_hash/map/typedefs.hpp>
+
+// Compares random lookups in tables backed by normal and by huge pages.
+//
+// Usage: huge_pages [number of keys]
+
+using namespace tdc::compact_hash;
+
+using map_type = map::mmap_layered_hashmap_t<uint64_t>;
+
+/// Counts the data TLB misses of the calling thread, if the system allows it.
+class dtlb_miss_counter_t {
+    int m_fd;
+public:
+    dtlb_miss_counter_t() {
+        perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HW_CACHE;
+        attr.config = PERF_COUNT_HW_CACHE_DTLB
+                    | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+                    | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        m_fd = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+    }
+    ~dtlb_miss_counter_t() {
+        if (m_fd >= 0) close(m_fd);
+    }
+    void start() {
+        if (m_fd < 0) return;
+        ioctl(m_fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(m_fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+    std::string stop() {
+        if (m_fd < 0) return "n/a";
+        ioctl(m_fd, PERF_EVENT_IOC_DISABLE, 0);
+        uint64_t count = 0;
+        if (read(m_fd, &count, sizeof(count)) != sizeof(count)) return "n/a";
+        return std::to_string(count);
+    }
+};
+
+void run(std::string const& name, page_size_t page_size, size_t n) {
+    auto config = map_type::config_args{};
+    config.storage_config.allocation_config.page_size = page_size;
+    config.displacement_config.table_config.transparent_huge_pages
+        = page_size != page_size_t::normal;
+
+    // NB: Sized up front, such that the table does not grow.
+    size_t table_size = 1;
+    while (table_size < n * 2) table_size *= 2;
+    auto map = map_type(table_size, 64, 64, config);
+
+    std::mt19937_64 gen(n);
+    std::vector<uint64_t> keys(n);
+    for (auto& key : keys) {
+        key = gen();
+        map.insert(key, uint64_t(key | 1));
+    }
+    std::shuffle(keys.begin(), keys.end(), gen);
+
+    dtlb_miss_counter_t counter;
+    counter.start();
+    auto begin = std::chrono::steady_clock::now();
+
+    uint64_t checksum = 0;
+    for (auto key : keys) {
+        checksum += *map.search(key);
+    }
+
+    auto end = std::chrono::steady_clock::now();
+    auto misses = counter.stop();
+
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
+    std::cout << name
+              << "\tns/lookup: " << double(ns) / n
+              << "\tdTLB misses/lookup: "
+              << (misses == "n/a" ? misses : std::to_string(double(std::stoull(misses)) / n))
+              << "\t(checksum " << checksum << ")"
+              << std::endl;
+}
+
+int main(int argc, char** argv) {
+    size_t n = (argc > 1) ? std::stoull(argv[1]) : (size_t(1) << 24);
+
+    run("normal         ", page_size_t::normal, n);
+    run("transparent_huge", page_size_t::transparent_huge, n);
+    run("huge_2mb       ", page_size_t::huge_2mb, n);
+}
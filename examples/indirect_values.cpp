@@ -0,0 +1,89 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <cstdint>
+
+#include <tudocomp/util/compact_hash/map/typedefs.hpp>
+#include <tudocomp/util/compact_hash/map/indirect_hashmap_t.hpp>
+
+// Compares values stored inside the table with values stored in a
+// `value_arena_t`, for values of 32, 128 and 512 bytes.
+//
+// Usage: indirect_values [number of keys]
+
+using namespace tdc::compact_hash;
+
+/// A value of `bytes` bytes.
+template<size_t bytes>
+struct blob_t {
+    std::array<uint64_t, bytes / 8> words;
+
+    blob_t() = default;
+    explicit blob_t(uint64_t seed) {
+        words.fill(seed);
+    }
+};
+
+template<typename table_t>
+void run(std::string const& name, std::vector<uint64_t> const& keys, std::vector<uint64_t> const& lookups) {
+    using value_type = typename table_t::value_type;
+
+    auto table = table_t(0, 64);
+
+    auto begin = std::chrono::steady_clock::now();
+    for (auto key : keys) {
+        table.emplace(key, key);
+    }
+    auto middle = std::chrono::steady_clock::now();
+
+    uint64_t checksum = 0;
+    for (auto key : lookups) {
+        value_type const& value = *table.search(key);
+        checksum += value.words[0];
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    auto insert_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(middle - begin).count();
+    auto search_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - middle).count();
+    auto bytes = tdc::heap_size<table_t>::compute(table).size_in_bytes();
+
+    std::cout << "  " << std::left << std::setw(10) << name
+              << std::right << std::fixed << std::setprecision(1)
+              << std::setw(14) << double(insert_ns) / keys.size()
+              << std::setw(14) << double(search_ns) / lookups.size()
+              << std::setw(14) << double(bytes) / keys.size()
+              << "\t(checksum " << checksum << ")" << std::endl;
+}
+
+template<size_t bytes>
+void run_size(std::vector<uint64_t> const& keys, std::vector<uint64_t> const& lookups) {
+    std::cout << bytes << " byte values (" << keys.size() << " keys)" << std::endl;
+    std::cout << "  " << std::left << std::setw(10) << "storage"
+              << std::right << std::setw(14) << "ns/insert"
+              << std::setw(14) << "ns/search"
+              << std::setw(14) << "bytes/key" << std::endl;
+    run<map::sparse_cv_hashmap_t<blob_t<bytes>>>("inline", keys, lookups);
+    run<map::indirect_hashmap_t<blob_t<bytes>>>("indirect", keys, lookups);
+}
+
+int main(int argc, char** argv) {
+    size_t const n = (argc > 1) ? std::stoull(argv[1]) : (size_t(1) << 20);
+
+    std::mt19937_64 gen(n);
+    std::vector<uint64_t> keys(n);
+    for (auto& key : keys) {
+        key = gen();
+    }
+    std::vector<uint64_t> lookups = keys;
+    std::shuffle(lookups.begin(), lookups.end(), gen);
+
+    run_size<32>(keys, lookups);
+    run_size<128>(keys, lookups);
+    run_size<512>(keys, lookups);
+}
@@ -0,0 +1,272 @@
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <glog/logging.h>
+
+#include <tudocomp/util/serialization.hpp>
+
+namespace tdc {
+    /// Runtime arguments of the chunked serialization.
+    struct chunked_config_t {
+        /// Number of threads that encode or decode chunks at the same time.
+        size_t threads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+        /// Number of units of the storage (e.g., buckets) per chunk.
+        size_t units_per_chunk = size_t(1) << 16;
+        /// Whether to store and verify a checksum for each chunk.
+        bool checksums = true;
+    };
+
+    /// 64 bit checksum of a byte range, computed a word at a time.
+    inline uint64_t chunk_checksum(char const* data, size_t size) {
+        uint64_t h = 0x9E3779B97F4A7C15ull ^ size;
+        auto mix = [&](uint64_t word) {
+            h ^= word;
+            h *= 0xFF51AFD7ED558CCDull;
+            h ^= h >> 32;
+        };
+
+        size_t i = 0;
+        for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+            uint64_t word;
+            memcpy(&word, data + i, sizeof(uint64_t));
+            mix(word);
+        }
+        if (i < size) {
+            uint64_t word = 0;
+            memcpy(&word, data + i, size - i);
+            mix(word);
+        }
+        return h;
+    }
+
+    /// Container format consisting of a header, an index of chunk offsets,
+    /// and the chunks themselves.
+    ///
+    /// Layout, all fields are 64 bit words:
+    /// - magic, version, flags, chunk count
+    /// - per chunk: offset relative to the magic, size in bytes, checksum
+    /// - the chunk payloads
+    ///
+    /// Each chunk is encoded into its own buffer, so that up to
+    /// `chunked_config_t::threads` chunks get encoded or decoded in parallel,
+    /// while the stream itself is accessed sequentially with one large
+    /// `write` or `read` per chunk.
+    struct chunked_format_t {
+        static constexpr uint64_t MAGIC = 0x4B4E554843434454ull; // "TDCCHUNK"
+        static constexpr uint64_t VERSION = 1;
+        static constexpr uint64_t FLAG_CHECKSUMS = 1;
+
+        struct index_entry_t {
+            uint64_t offset;
+            uint64_t size;
+            uint64_t checksum;
+        };
+
+        inline static size_t header_size(size_t chunk_count) {
+            return sizeof(uint64_t) * 4 + sizeof(index_entry_t) * chunk_count;
+        }
+
+        /// Calls `f(i)` for all `i` in `[begin, end)`,
+        /// on up to `threads` threads at a time.
+        template<typename F>
+        inline static void parallel_for(size_t begin, size_t end, size_t threads, F f) {
+            if (threads <= 1 || end - begin <= 1) {
+                for (size_t i = begin; i < end; i++) {
+                    f(i);
+                }
+                return;
+            }
+
+            std::vector<std::thread> workers;
+            for (size_t i = begin; i < end; i++) {
+                workers.emplace_back(f, i);
+            }
+            for (auto& worker : workers) {
+                worker.join();
+            }
+        }
+    };
+
+    /// Writes a chunked container to a seekable stream.
+    ///
+    /// The index is reserved up front and filled in by `finish()`.
+    class chunked_writer_t {
+        using index_entry_t = chunked_format_t::index_entry_t;
+
+        std::ostream& m_out;
+        chunked_config_t m_config;
+        std::streampos m_start;
+        std::vector<index_entry_t> m_index;
+        size_t m_written = 0;
+        uint64_t m_offset;
+    public:
+        inline chunked_writer_t(std::ostream& out, size_t chunk_count, chunked_config_t const& config):
+            m_out(out),
+            m_config(config),
+            m_start(out.tellp()),
+            m_index(chunk_count, index_entry_t { 0, 0, 0 }),
+            m_offset(chunked_format_t::header_size(chunk_count))
+        {
+            CHECK(m_start != std::streampos(-1))
+                << "The chunked serialization needs a seekable stream";
+
+            std::string placeholder(m_offset, '\0');
+            m_out.write(placeholder.data(), placeholder.size());
+        }
+
+        /// Encodes the chunks `[begin, end)` with `f(chunk, std::ostream&)`,
+        /// and appends them in order.
+        template<typename F>
+        inline void write(size_t begin, size_t end, F f) {
+            CHECK_EQ(begin, m_written) << "Chunks need to be written in order";
+            CHECK_LE(end, m_index.size());
+
+            size_t const threads = std::max<size_t>(m_config.threads, 1);
+            std::vector<std::string> buffers(threads);
+
+            for (size_t wave = begin; wave < end; wave += threads) {
+                size_t const wave_end = std::min(wave + threads, end);
+
+                chunked_format_t::parallel_for(wave, wave_end, threads, [&](size_t chunk) {
+                    std::ostringstream chunk_out;
+                    f(chunk, static_cast<std::ostream&>(chunk_out));
+                    auto& buffer = buffers[chunk - wave];
+                    buffer = chunk_out.str();
+                    m_index[chunk].size = buffer.size();
+                    m_index[chunk].checksum = m_config.checksums
+                        ? chunk_checksum(buffer.data(), buffer.size()) : 0;
+                });
+
+                for (size_t chunk = wave; chunk < wave_end; chunk++) {
+                    auto& buffer = buffers[chunk - wave];
+                    m_index[chunk].offset = m_offset;
+                    m_out.write(buffer.data(), buffer.size());
+                    m_offset += buffer.size();
+                    buffer = std::string();
+                }
+            }
+            m_written = end;
+        }
+
+        /// Writes the header and the index, and returns the overall size.
+        inline object_size_t finish() {
+            CHECK_EQ(m_written, m_index.size()) << "Not all chunks have been written";
+
+            auto end = m_out.tellp();
+            m_out.seekp(m_start);
+
+            uint64_t const flags = m_config.checksums ? chunked_format_t::FLAG_CHECKSUMS : 0;
+            serialize_write(m_out, uint64_t(chunked_format_t::MAGIC));
+            serialize_write(m_out, uint64_t(chunked_format_t::VERSION));
+            serialize_write(m_out, flags);
+            serialize_write(m_out, uint64_t(m_index.size()));
+            for (auto const& entry : m_index) {
+                serialize_write(m_out, entry.offset);
+                serialize_write(m_out, entry.size);
+                serialize_write(m_out, entry.checksum);
+            }
+
+            m_out.seekp(end);
+            return object_size_t::exact(m_offset);
+        }
+    };
+
+    /// Reads a chunked container written by `chunked_writer_t`.
+    class chunked_reader_t {
+        using index_entry_t = chunked_format_t::index_entry_t;
+
+        struct chunk_buf_t: std::streambuf {
+            inline chunk_buf_t(std::string& buffer) {
+                setg(&buffer[0], &buffer[0], &buffer[0] + buffer.size());
+            }
+        };
+
+        std::istream& m_in;
+        chunked_config_t m_config;
+        std::vector<index_entry_t> m_index;
+        bool m_has_checksums;
+        size_t m_read = 0;
+        uint64_t m_offset;
+    public:
+        inline chunked_reader_t(std::istream& in, chunked_config_t const& config):
+            m_in(in),
+            m_config(config)
+        {
+            uint64_t const magic = serialize_read<uint64_t>(m_in);
+            uint64_t const version = serialize_read<uint64_t>(m_in);
+            uint64_t const flags = serialize_read<uint64_t>(m_in);
+            CHECK_EQ(magic, uint64_t(chunked_format_t::MAGIC))
+                << "Not a chunked serialization";
+            CHECK_EQ(version, uint64_t(chunked_format_t::VERSION))
+                << "Unsupported version of the chunked serialization";
+            m_has_checksums = (flags & chunked_format_t::FLAG_CHECKSUMS) != 0;
+
+            size_t const chunk_count = serialize_read<uint64_t>(m_in);
+            m_index.resize(chunk_count);
+            for (auto& entry : m_index) {
+                entry.offset = serialize_read<uint64_t>(m_in);
+                entry.size = serialize_read<uint64_t>(m_in);
+                entry.checksum = serialize_read<uint64_t>(m_in);
+            }
+            m_offset = chunked_format_t::header_size(chunk_count);
+        }
+
+        inline size_t chunk_count() const {
+            return m_index.size();
+        }
+
+        /// Decodes the chunks `[begin, end)` with `f(chunk, std::istream&)`.
+        template<typename F>
+        inline void read(size_t begin, size_t end, F f) {
+            CHECK_EQ(begin, m_read) << "Chunks need to be read in order";
+            CHECK_LE(end, m_index.size());
+
+            size_t const threads = std::max<size_t>(m_config.threads, 1);
+            std::vector<std::string> buffers(threads);
+
+            for (size_t wave = begin; wave < end; wave += threads) {
+                size_t const wave_end = std::min(wave + threads, end);
+
+                for (size_t chunk = wave; chunk < wave_end; chunk++) {
+                    auto const& entry = m_index[chunk];
+                    CHECK_EQ(entry.offset, m_offset) << "Corrupt chunk index";
+
+                    auto& buffer = buffers[chunk - wave];
+                    buffer.resize(entry.size);
+                    m_in.read(&buffer[0], entry.size);
+                    CHECK(m_in) << "Unexpected end of the chunked serialization";
+                    m_offset += entry.size;
+                }
+
+                chunked_format_t::parallel_for(wave, wave_end, threads, [&](size_t chunk) {
+                    auto& buffer = buffers[chunk - wave];
+                    if (m_has_checksums && m_config.checksums) {
+                        CHECK_EQ(chunk_checksum(buffer.data(), buffer.size()),
+                                 m_index[chunk].checksum)
+                            << "Checksum mismatch in chunk " << chunk;
+                    }
+                    chunk_buf_t buf(buffer);
+                    std::istream chunk_in(&buf);
+                    f(chunk, chunk_in);
+                });
+            }
+            m_read = end;
+        }
+    };
+
+    /// Chunked serialization of a data structure, which allows to encode
+    /// and decode independent parts of it in parallel.
+    ///
+    /// Needs to be specialized with `write(out, val, config)`
+    /// and `read(in, config)`.
+    template<typename T>
+    struct serialize_chunked {
+    };
+}
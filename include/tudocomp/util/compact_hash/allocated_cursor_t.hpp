@@ -0,0 +1,88 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace tdc {namespace compact_hash {
+
+/// Position of an allocated entry in the table, and its initial address.
+///
+/// Placements visit the entries between two empty locations one at a
+/// time with it, see the `first_allocated_between()` and
+/// `next_allocated()` methods of their contexts.
+struct allocated_cursor_t {
+    size_t pos = 0;
+    uint64_t initial_address = 0;
+    /// Empty location before the first entry of the walk.
+    size_t start = 0;
+    /// Empty location behind the last entry of the walk.
+    /// The walk wraps around the end of the table if `end <= start`,
+    /// and visits the whole table if `end == start`.
+    size_t end = 0;
+    bool done = false;
+};
+
+/// Returns the first allocated location of the walk of `c`
+/// at or behind location `pos`, or sets `c.done` if the walk
+/// reaches `c.end` before.
+///
+/// The storage skips empty locations faster than checking
+/// them one by one.
+template<typename storage_context_t>
+inline size_t skip_empty(storage_context_t& sctx,
+                         size_t table_size,
+                         allocated_cursor_t& c,
+                         size_t pos) {
+    while (true) {
+        size_t const end = (pos <= c.end) ? c.end : table_size;
+        size_t const next = sctx.next_allocated_pos(pos, end);
+        if (next != end) {
+            return next;
+        }
+        if (end == c.end) {
+            c.done = true;
+            return next;
+        }
+        pos = 0;
+    }
+}
+
+/// Returns the first empty location of the table.
+///
+/// NB: A table always has one, since its load factor is below 1.
+template<typename storage_context_t>
+inline size_t first_empty_pos(storage_context_t& sctx) {
+    size_t pos = 0;
+    while (!sctx.pos_is_empty(sctx.table_pos(pos))) {
+        pos++;
+    }
+    return pos;
+}
+
+/// Splits the table at empty locations into up to `parts` ranges.
+///
+/// Returns the sorted empty locations between the ranges. Range `i`
+/// is the walk from location `i` to location `i + 1`, and the last
+/// one wraps around to the first location. No group of entries with
+/// the same initial address spans two ranges, such that each range can
+/// be decoded on its own.
+template<typename storage_context_t>
+inline std::vector<size_t> split_at_empty(storage_context_t& sctx,
+                                          size_t table_size,
+                                          size_t parts) {
+    std::vector<size_t> bounds { first_empty_pos(sctx) };
+    for (size_t i = 1; i < parts; i++) {
+        size_t pos = std::max(table_size / parts * i, bounds.back() + 1);
+        while (pos < table_size && !sctx.pos_is_empty(sctx.table_pos(pos))) {
+            pos++;
+        }
+        if (pos == table_size) {
+            break;
+        }
+        bounds.push_back(pos);
+    }
+    return bounds;
+}
+
+}}
@@ -0,0 +1,224 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define TDC_COMPACT_HASH_X86_DISPATCH 1
+#include <immintrin.h>
+#endif
+
+namespace tdc {namespace compact_hash {
+
+/// Instruction sets used to hash many keys at once.
+enum class simd_level_t {
+    scalar,
+    /// four keys per instruction, with emulated 64 bit multiplications
+    avx2,
+    /// eight keys per instruction, with `vpmullq`
+    avx512,
+};
+
+/// The best instruction set supported by the running CPU.
+inline simd_level_t detected_simd_level() {
+#ifdef TDC_COMPACT_HASH_X86_DISPATCH
+    static simd_level_t const level = []() {
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512dq")) {
+            return simd_level_t::avx512;
+        }
+        if (__builtin_cpu_supports("avx2")) {
+            return simd_level_t::avx2;
+        }
+        return simd_level_t::scalar;
+    }();
+    return level;
+#else
+    return simd_level_t::scalar;
+#endif
+}
+
+/// Constants of three xorshift-multiply rounds
+/// `x = ((x ^ (x >> shifts[i])) * primes[i]) & mask`, as computed by
+/// `poplar::bijective_hash::Xorshift`.
+///
+/// The rounds are inverted by applying them in reverse order,
+/// with the multiplication first and the inverse primes.
+struct xorshift_mul_rounds_t {
+    uint64_t mask;
+    uint64_t shifts[3];
+    uint64_t primes[3];
+};
+
+namespace hash_kernels {
+
+template<bool inverse>
+inline void xorshift_mul_scalar(xorshift_mul_rounds_t const& r,
+                                uint64_t const* in, uint64_t* out, size_t n) {
+    // NB: Local copies, since `out` could alias `r` as far as the compiler knows.
+    uint64_t const mask = r.mask;
+    uint64_t const s0 = r.shifts[0], s1 = r.shifts[1], s2 = r.shifts[2];
+    uint64_t const p0 = r.primes[0], p1 = r.primes[1], p2 = r.primes[2];
+    for (size_t i = 0; i < n; i++) {
+        uint64_t x = in[i];
+        if (inverse) {
+            x = (x * p2) & mask; x ^= x >> s2;
+            x = (x * p1) & mask; x ^= x >> s1;
+            x = (x * p0) & mask; x ^= x >> s0;
+        } else {
+            x ^= x >> s0; x = (x * p0) & mask;
+            x ^= x >> s1; x = (x * p1) & mask;
+            x ^= x >> s2; x = (x * p2) & mask;
+        }
+        out[i] = x;
+    }
+}
+
+inline void xorshift_scalar(uint64_t j, uint64_t mask,
+                            uint64_t const* in, uint64_t* out, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        uint64_t const x = in[i];
+        out[i] = (x ^ ((x << j) & mask)) & mask;
+    }
+}
+
+#ifdef TDC_COMPACT_HASH_X86_DISPATCH
+
+/// Low 64 bits of the products of the lanes of `a` and `b`.
+__attribute__((target("avx2")))
+inline __m256i mullo64_avx2(__m256i a, __m256i b) {
+    __m256i const lo = _mm256_mul_epu32(a, b);
+    __m256i const a_hi_b = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), b);
+    __m256i const a_b_hi = _mm256_mul_epu32(a, _mm256_srli_epi64(b, 32));
+    __m256i const cross = _mm256_slli_epi64(_mm256_add_epi64(a_hi_b, a_b_hi), 32);
+    return _mm256_add_epi64(lo, cross);
+}
+
+template<bool inverse>
+__attribute__((target("avx2")))
+inline void xorshift_mul_avx2(xorshift_mul_rounds_t const& r,
+                              uint64_t const* in, uint64_t* out, size_t n) {
+    __m256i const mask = _mm256_set1_epi64x(r.mask);
+    __m256i primes[3];
+    __m128i shifts[3];
+    for (size_t k = 0; k < 3; k++) {
+        primes[k] = _mm256_set1_epi64x(r.primes[k]);
+        shifts[k] = _mm_cvtsi64_si128(r.shifts[k]);
+    }
+
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i x = _mm256_loadu_si256((__m256i const*) (in + i));
+        for (size_t k = 0; k < 3; k++) {
+            size_t const round = inverse ? 2 - k : k;
+            if (inverse) {
+                x = _mm256_and_si256(mullo64_avx2(x, primes[round]), mask);
+                x = _mm256_xor_si256(x, _mm256_srl_epi64(x, shifts[round]));
+            } else {
+                x = _mm256_xor_si256(x, _mm256_srl_epi64(x, shifts[round]));
+                x = _mm256_and_si256(mullo64_avx2(x, primes[round]), mask);
+            }
+        }
+        _mm256_storeu_si256((__m256i*) (out + i), x);
+    }
+    xorshift_mul_scalar<inverse>(r, in + i, out + i, n - i);
+}
+
+/// Shifts the lanes of `x` right by `shift`.
+///
+/// NB: `_mm512_srl_epi64()` passes an undefined vector as the masked-off
+/// source, which GCC reports with `-Wmaybe-uninitialized`. The zero-masked
+/// variant with all lanes selected is the same instruction without it.
+__attribute__((target("avx512f")))
+inline __m512i srl_avx512(__m512i x, __m128i shift) {
+    return _mm512_maskz_srl_epi64(__mmask8(0xff), x, shift);
+}
+
+template<bool inverse>
+__attribute__((target("avx512f,avx512dq")))
+inline void xorshift_mul_avx512(xorshift_mul_rounds_t const& r,
+                                uint64_t const* in, uint64_t* out, size_t n) {
+    __m512i const mask = _mm512_set1_epi64(r.mask);
+    __m512i primes[3];
+    __m128i shifts[3];
+    for (size_t k = 0; k < 3; k++) {
+        primes[k] = _mm512_set1_epi64(r.primes[k]);
+        shifts[k] = _mm_cvtsi64_si128(r.shifts[k]);
+    }
+
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m512i x = _mm512_loadu_si512((void const*) (in + i));
+        for (size_t k = 0; k < 3; k++) {
+            size_t const round = inverse ? 2 - k : k;
+            if (inverse) {
+                x = _mm512_and_si512(_mm512_mullo_epi64(x, primes[round]), mask);
+                x = _mm512_xor_si512(x, srl_avx512(x, shifts[round]));
+            } else {
+                x = _mm512_xor_si512(x, srl_avx512(x, shifts[round]));
+                x = _mm512_and_si512(_mm512_mullo_epi64(x, primes[round]), mask);
+            }
+        }
+        _mm512_storeu_si512((void*) (out + i), x);
+    }
+    xorshift_mul_scalar<inverse>(r, in + i, out + i, n - i);
+}
+
+__attribute__((target("avx2")))
+inline void xorshift_avx2(uint64_t j, uint64_t mask,
+                          uint64_t const* in, uint64_t* out, size_t n) {
+    __m256i const vmask = _mm256_set1_epi64x(mask);
+    __m128i const shift = _mm_cvtsi64_si128(j);
+
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i const x = _mm256_loadu_si256((__m256i const*) (in + i));
+        __m256i const shifted = _mm256_and_si256(_mm256_sll_epi64(x, shift), vmask);
+        _mm256_storeu_si256((__m256i*) (out + i),
+                            _mm256_and_si256(_mm256_xor_si256(x, shifted), vmask));
+    }
+    xorshift_scalar(j, mask, in + i, out + i, n - i);
+}
+
+#endif
+
+/// Applies the rounds `r` (or their inverse) to `in[0..n)`,
+/// and stores the results in `out[0..n)`, which may be the same array.
+template<bool inverse>
+inline void xorshift_mul(xorshift_mul_rounds_t const& r,
+                         uint64_t const* in, uint64_t* out, size_t n,
+                         simd_level_t level) {
+#ifdef TDC_COMPACT_HASH_X86_DISPATCH
+    switch (level) {
+        case simd_level_t::avx512:
+            xorshift_mul_avx512<inverse>(r, in, out, n);
+            return;
+        case simd_level_t::avx2:
+            xorshift_mul_avx2<inverse>(r, in, out, n);
+            return;
+        default:
+            break;
+    }
+#endif
+    xorshift_mul_scalar<inverse>(r, in, out, n);
+}
+
+/// Computes `(x ^ ((x << j) & mask)) & mask` for all `x` in `in[0..n)`,
+/// and stores the results in `out[0..n)`, which may be the same array.
+///
+/// NB: AVX-512 brings no benefit without multiplications, so it uses AVX2.
+inline void xorshift(uint64_t j, uint64_t mask,
+                     uint64_t const* in, uint64_t* out, size_t n,
+                     simd_level_t level) {
+#ifdef TDC_COMPACT_HASH_X86_DISPATCH
+    if (level != simd_level_t::scalar) {
+        xorshift_avx2(j, mask, in, out, n);
+        return;
+    }
+#endif
+    xorshift_scalar(j, mask, in, out, n);
+}
+
+}
+
+}}
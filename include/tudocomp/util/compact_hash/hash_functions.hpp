@@ -1,7 +1,9 @@
 #pragma once
 
 #include <glog/logging.h>
+#include <tudocomp/util/heap_size.hpp>
 #include <tudocomp/util/serialization.hpp>
+#include <tudocomp/util/compact_hash/hash_batch.hpp>
 
 // Source: https://github.com/kampersanda/poplar-trie/blob/master/include/poplar/bijective_hash.hpp
 namespace poplar{namespace bijective_hash {
@@ -110,6 +112,27 @@ public:
     return x;
   }
 
+  /// Hashes `in[0..n)` into `out[0..n)`, which may be the same array,
+  /// with the same results as `hash()`.
+  inline void hash_batch(uint64_t const* in, uint64_t* out, size_t n) const {
+    hash_batch(in, out, n, tdc::compact_hash::detected_simd_level());
+  }
+
+  inline void hash_batch(uint64_t const* in, uint64_t* out, size_t n,
+                         tdc::compact_hash::simd_level_t level) const {
+    tdc::compact_hash::hash_kernels::xorshift_mul<false>(rounds(0), in, out, n, level);
+  }
+
+  /// Reverses `hash_batch()`, with the same results as `hash_inv()`.
+  inline void hash_inv_batch(uint64_t const* in, uint64_t* out, size_t n) const {
+    hash_inv_batch(in, out, n, tdc::compact_hash::detected_simd_level());
+  }
+
+  inline void hash_inv_batch(uint64_t const* in, uint64_t* out, size_t n,
+                             tdc::compact_hash::simd_level_t level) const {
+    tdc::compact_hash::hash_kernels::xorshift_mul<true>(rounds(1), in, out, n, level);
+  }
+
   /// STL compability
   inline uint64_t operator()(uint64_t x) const {
     return hash(x);
@@ -139,6 +162,18 @@ private:
   template<typename T>
   friend struct ::tdc::heap_size;
 
+  /// The constants of the rounds of `hash_` (`inverse == 0`)
+  /// or `hash_inv_` (`inverse == 1`).
+  tdc::compact_hash::xorshift_mul_rounds_t rounds(size_t inverse) const {
+    tdc::compact_hash::xorshift_mul_rounds_t r;
+    r.mask = mask();
+    for (size_t n = 0; n < 3; n++) {
+      r.shifts[n] = m_shift + n;
+      r.primes[n] = PRIME_TABLE[bits()][inverse][n];
+    }
+    return r;
+  }
+
   template <uint32_t N>
   uint64_t hash_(uint64_t x) const {
     DCHECK_LE(x, mask());
@@ -203,10 +238,371 @@ public:
     inline uint64_t hash_inv(uint64_t x) const {
         return hash(x);
     }
+
+    /// Hashes `in[0..n)` into `out[0..n)`, which may be the same array,
+    /// with the same results as `hash()`.
+    inline void hash_batch(uint64_t const* in, uint64_t* out, size_t n) const {
+        hash_batch(in, out, n, detected_simd_level());
+    }
+
+    inline void hash_batch(uint64_t const* in, uint64_t* out, size_t n,
+                           simd_level_t level) const {
+        hash_kernels::xorshift(m_j, m_w_mask, in, out, n, level);
+    }
+
+    /// Reverses `hash_batch()`, with the same results as `hash_inv()`.
+    inline void hash_inv_batch(uint64_t const* in, uint64_t* out, size_t n) const {
+        hash_batch(in, out, n);
+    }
+
+    inline void hash_inv_batch(uint64_t const* in, uint64_t* out, size_t n,
+                               simd_level_t level) const {
+        hash_batch(in, out, n, level);
+    }
 };
 
 using poplar_xorshift_t = poplar::bijective_hash::Xorshift;
 
+/// Next value of the SplitMix64 generator with state `state`,
+/// used to derive the constants of seeded hash functions.
+inline uint64_t splitmix64(uint64_t& state) {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+/// Multiplicative inverse of the odd integer `a` modulo 2^64,
+/// which is also its inverse modulo 2^w for all w.
+inline uint64_t inverse_of_odd(uint64_t a) {
+    DCHECK_EQ(a & 1, 1u);
+    // NB: Newton's iteration doubles the amount of correct low bits,
+    // starting with 5 bits for x = 3a xor 2.
+    uint64_t x = (3 * a) ^ 2;
+    for (size_t i = 0; i < 4; i++) {
+        x *= 2 - a * x;
+    }
+    return x;
+}
+
+/// Bijective hash function on `w` bits that alternates xorshifts with
+/// multiplications by odd constants (like the finalizer of MurmurHash3),
+/// all modulo 2^w.
+///
+/// Every bit of the key influences every bit of the hash value, so
+/// sequential or strided keys are spread evenly. The inverse multiplies
+/// by the modular inverses of the constants, computed on construction.
+///
+/// With a non-zero `config_args::seed`, the constants and an initial xor
+/// are derived from the seed, such that key sets can not be chosen
+/// against a publicly known function.
+class multiply_xorshift_t {
+    uint32_t m_width;
+    uint64_t m_seed;
+    uint64_t m_mask;
+    uint64_t m_shift;
+    uint64_t m_xor;
+    uint64_t m_mul[2];
+    uint64_t m_inv[2];
+
+    template<typename T>
+    friend struct ::tdc::serialize;
+
+    template<typename T>
+    friend struct ::tdc::heap_size;
+
+    /// Involution on `w` bits, since the shift is at least `w / 2`.
+    inline uint64_t xorshift(uint64_t x) const {
+        return x ^ (x >> m_shift);
+    }
+public:
+    /// runtime initilization arguments, if any
+    struct config_args {
+        /// Seed of the constants, or 0 for the fixed default constants.
+        uint64_t seed = 0;
+    };
+
+    /// get the config of this instance
+    inline config_args current_config() const {
+        auto r = config_args{};
+        r.seed = m_seed;
+        return r;
+    }
+
+    /// Constructs a hash function for values with a width of `w` bits.
+    inline multiply_xorshift_t(uint32_t w, config_args config):
+        m_width(w),
+        m_seed(config.seed),
+        m_mask(-1ull >> (64 - w)),
+        m_shift((w + 1) / 2)
+    {
+        DCHECK_NE(w, 0U);
+        DCHECK_LE(w, 64U);
+
+        if (m_seed == 0) {
+            m_xor = 0;
+            m_mul[0] = 0xff51afd7ed558ccdull;
+            m_mul[1] = 0xc4ceb9fe1a85ec53ull;
+        } else {
+            uint64_t state = m_seed;
+            m_xor = splitmix64(state) & m_mask;
+            m_mul[0] = splitmix64(state) | 1;
+            m_mul[1] = splitmix64(state) | 1;
+        }
+        for (size_t i = 0; i < 2; i++) {
+            m_inv[i] = inverse_of_odd(m_mul[i]) & m_mask;
+            m_mul[i] &= m_mask;
+        }
+    }
+
+    /// This takes a value `x` with a width of `w` bits,
+    /// and calculates a hash value with a width of `w` bits.
+    inline uint64_t hash(uint64_t x) const {
+        DCHECK_LE(x, m_mask);
+        x = xorshift(x ^ m_xor);
+        x = xorshift((x * m_mul[0]) & m_mask);
+        x = xorshift((x * m_mul[1]) & m_mask);
+        return x;
+    }
+
+    /// This takes a hash value `x` with a width of `w` bits,
+    /// and reverses the hash function to the original value.
+    inline uint64_t hash_inv(uint64_t x) const {
+        DCHECK_LE(x, m_mask);
+        x = (xorshift(x) * m_inv[1]) & m_mask;
+        x = (xorshift(x) * m_inv[0]) & m_mask;
+        return xorshift(x) ^ m_xor;
+    }
+
+    /// Hashes `in[0..n)` into `out[0..n)`, which may be the same array,
+    /// with the same results as `hash()`.
+    inline void hash_batch(uint64_t const* in, uint64_t* out, size_t n) const {
+        for (size_t i = 0; i < n; i++) {
+            out[i] = hash(in[i]);
+        }
+    }
+
+    /// Reverses `hash_batch()`, with the same results as `hash_inv()`.
+    inline void hash_inv_batch(uint64_t const* in, uint64_t* out, size_t n) const {
+        for (size_t i = 0; i < n; i++) {
+            out[i] = hash_inv(in[i]);
+        }
+    }
+};
+
+/// Bijective hash function on `w` bits, built as a Feistel network with
+/// four rounds over the two halves of the value. For odd `w`, the halves
+/// differ by one bit, and swap their widths after each round.
+///
+/// The round function is a full 64 bit mixer of the other half and a round
+/// key, which gives the strongest mixing of the hash functions here,
+/// at the cost of four mixer evaluations per key.
+/// The inverse applies the rounds in reverse order.
+///
+/// The round keys are derived from `config_args::seed`.
+class feistel_t {
+    static constexpr size_t ROUNDS = 4;
+
+    uint32_t m_width;
+    uint64_t m_seed;
+    uint8_t m_high_width;
+    uint8_t m_low_width;
+    uint64_t m_keys[ROUNDS];
+
+    template<typename T>
+    friend struct ::tdc::serialize;
+
+    template<typename T>
+    friend struct ::tdc::heap_size;
+
+    inline static uint64_t mask(size_t width) {
+        return (1ull << width) - 1;
+    }
+
+    /// The finalizer of MurmurHash3.
+    inline static uint64_t mix(uint64_t x) {
+        x ^= x >> 33;
+        x *= 0xff51afd7ed558ccdull;
+        x ^= x >> 33;
+        x *= 0xc4ceb9fe1a85ec53ull;
+        x ^= x >> 33;
+        return x;
+    }
+
+    /// Maps the halves `(high, low)` of `v`, with widths `(hw, lw)`,
+    /// to `(low, high ^ f(low))`, with widths `(lw, hw)`.
+    inline static uint64_t round(uint64_t v, size_t hw, size_t lw, uint64_t key) {
+        uint64_t const high = v >> lw;
+        uint64_t const low = v & mask(lw);
+        return (low << hw) | ((high ^ mix(low ^ key)) & mask(hw));
+    }
+
+    /// Reverses `round(v, hw, lw, key)`.
+    inline static uint64_t round_inv(uint64_t v, size_t hw, size_t lw, uint64_t key) {
+        uint64_t const low = v >> hw;
+        uint64_t const high = (v ^ mix(low ^ key)) & mask(hw);
+        return (high << lw) | low;
+    }
+public:
+    /// runtime initilization arguments, if any
+    struct config_args {
+        /// Seed of the round keys.
+        uint64_t seed = 0;
+    };
+
+    /// get the config of this instance
+    inline config_args current_config() const {
+        auto r = config_args{};
+        r.seed = m_seed;
+        return r;
+    }
+
+    /// Constructs a hash function for values with a width of `w` bits.
+    inline feistel_t(uint32_t w, config_args config):
+        m_width(w),
+        m_seed(config.seed),
+        m_high_width(w / 2),
+        m_low_width(w - w / 2)
+    {
+        DCHECK_NE(w, 0U);
+        DCHECK_LE(w, 64U);
+
+        uint64_t state = m_seed;
+        for (size_t i = 0; i < ROUNDS; i++) {
+            m_keys[i] = splitmix64(state);
+        }
+    }
+
+    /// This takes a value `x` with a width of `w` bits,
+    /// and calculates a hash value with a width of `w` bits.
+    inline uint64_t hash(uint64_t x) const {
+        DCHECK_LE(x, -1ull >> (64 - m_width));
+        size_t const a = m_high_width;
+        size_t const b = m_low_width;
+        x = round(x, a, b, m_keys[0]);
+        x = round(x, b, a, m_keys[1]);
+        x = round(x, a, b, m_keys[2]);
+        x = round(x, b, a, m_keys[3]);
+        return x;
+    }
+
+    /// This takes a hash value `x` with a width of `w` bits,
+    /// and reverses the hash function to the original value.
+    inline uint64_t hash_inv(uint64_t x) const {
+        DCHECK_LE(x, -1ull >> (64 - m_width));
+        size_t const a = m_high_width;
+        size_t const b = m_low_width;
+        x = round_inv(x, b, a, m_keys[3]);
+        x = round_inv(x, a, b, m_keys[2]);
+        x = round_inv(x, b, a, m_keys[1]);
+        x = round_inv(x, a, b, m_keys[0]);
+        return x;
+    }
+
+    /// Hashes `in[0..n)` into `out[0..n)`, which may be the same array,
+    /// with the same results as `hash()`.
+    inline void hash_batch(uint64_t const* in, uint64_t* out, size_t n) const {
+        for (size_t i = 0; i < n; i++) {
+            out[i] = hash(in[i]);
+        }
+    }
+
+    /// Reverses `hash_batch()`, with the same results as `hash_inv()`.
+    inline void hash_inv_batch(uint64_t const* in, uint64_t* out, size_t n) const {
+        for (size_t i = 0; i < n; i++) {
+            out[i] = hash_inv(in[i]);
+        }
+    }
+};
+
+
+/// `poplar_xorshift_t` for keys with a width of `W` bits known at compile time,
+/// with the same hash values.
+///
+/// The shifts, primes and mask are constants, so `hash()` and `hash_inv()`
+/// multiply by immediates instead of loading the primes of the current width
+/// from `PRIME_TABLE`.
+///
+/// NB: A table with more than 2^(W-1) slots hashes with a larger width,
+/// for which this falls back to the runtime constants.
+template<uint32_t W>
+class static_poplar_xorshift_t {
+    static_assert(0 < W && W <= 64, "W has to be in [1, 64]");
+
+    static constexpr uint64_t MASK = -1ull >> (64 - W);
+    static constexpr uint64_t SHIFT = W / 2 + 1;
+
+    template<size_t inverse, size_t N>
+    static constexpr uint64_t PRIME = poplar::bijective_hash::PRIME_TABLE[W][inverse][N];
+
+    poplar_xorshift_t m_dynamic;
+
+    template<typename T>
+    friend struct ::tdc::serialize;
+
+    template<typename T>
+    friend struct ::tdc::heap_size;
+
+    static_poplar_xorshift_t() = default;
+
+    inline bool is_static() const {
+        return m_dynamic.bits() == W;
+    }
+public:
+    /// runtime initilization arguments, if any
+    struct config_args {};
+
+    /// get the config of this instance
+    inline config_args current_config() const { return config_args{}; }
+
+    /// Constructs a hash function for values with a width of `w` bits.
+    inline static_poplar_xorshift_t(uint32_t w, config_args config):
+        m_dynamic(w, poplar_xorshift_t::config_args{}) {}
+
+    inline uint64_t hash(uint64_t x) const {
+        if (!is_static()) {
+            return m_dynamic.hash(x);
+        }
+        DCHECK_LE(x, uint64_t(MASK));
+        x ^= x >> SHIFT;       x = (x * PRIME<0, 0>) & MASK;
+        x ^= x >> (SHIFT + 1); x = (x * PRIME<0, 1>) & MASK;
+        x ^= x >> (SHIFT + 2); x = (x * PRIME<0, 2>) & MASK;
+        return x;
+    }
+
+    inline uint64_t hash_inv(uint64_t x) const {
+        if (!is_static()) {
+            return m_dynamic.hash_inv(x);
+        }
+        DCHECK_LE(x, uint64_t(MASK));
+        x = (x * PRIME<1, 2>) & MASK; x ^= x >> (SHIFT + 2);
+        x = (x * PRIME<1, 1>) & MASK; x ^= x >> (SHIFT + 1);
+        x = (x * PRIME<1, 0>) & MASK; x ^= x >> SHIFT;
+        return x;
+    }
+
+    /// Hashes `in[0..n)` into `out[0..n)`, which may be the same array,
+    /// with the same results as `hash()`.
+    inline void hash_batch(uint64_t const* in, uint64_t* out, size_t n) const {
+        m_dynamic.hash_batch(in, out, n);
+    }
+
+    inline void hash_batch(uint64_t const* in, uint64_t* out, size_t n,
+                           simd_level_t level) const {
+        m_dynamic.hash_batch(in, out, n, level);
+    }
+
+    /// Reverses `hash_batch()`, with the same results as `hash_inv()`.
+    inline void hash_inv_batch(uint64_t const* in, uint64_t* out, size_t n) const {
+        m_dynamic.hash_inv_batch(in, out, n);
+    }
+
+    inline void hash_inv_batch(uint64_t const* in, uint64_t* out, size_t n,
+                               simd_level_t level) const {
+        m_dynamic.hash_inv_batch(in, out, n, level);
+    }
+};
+
 }
 
 template<>
@@ -297,4 +693,100 @@ struct serialize<poplar::bijective_hash::Xorshift> {
     }
 };
 
+template<>
+struct heap_size<compact_hash::multiply_xorshift_t> {
+    using T = compact_hash::multiply_xorshift_t;
+
+    static object_size_t compute(T const& val) {
+        return object_size_t::exact(sizeof(T));
+    }
+};
+
+/// NB: Only the width and the seed are stored,
+/// the constants are derived from them again.
+template<>
+struct serialize<compact_hash::multiply_xorshift_t> {
+    using T = compact_hash::multiply_xorshift_t;
+
+    static object_size_t write(std::ostream& out, T const& val) {
+        auto bytes = object_size_t::empty();
+
+        bytes += serialize<uint32_t>::write(out, val.m_width);
+        bytes += serialize<uint64_t>::write(out, val.m_seed);
+
+        return bytes;
+    }
+    static T read(std::istream& in) {
+        auto width = serialize<uint32_t>::read(in);
+        auto config = T::config_args{};
+        config.seed = serialize<uint64_t>::read(in);
+        return T(width, config);
+    }
+    static bool equal_check(T const& lhs, T const& rhs) {
+        return gen_equal_check(m_width)
+        && gen_equal_check(m_seed);
+    }
+};
+
+template<>
+struct heap_size<compact_hash::feistel_t> {
+    using T = compact_hash::feistel_t;
+
+    static object_size_t compute(T const& val) {
+        return object_size_t::exact(sizeof(T));
+    }
+};
+
+/// NB: Only the width and the seed are stored,
+/// the round keys are derived from them again.
+template<>
+struct serialize<compact_hash::feistel_t> {
+    using T = compact_hash::feistel_t;
+
+    static object_size_t write(std::ostream& out, T const& val) {
+        auto bytes = object_size_t::empty();
+
+        bytes += serialize<uint32_t>::write(out, val.m_width);
+        bytes += serialize<uint64_t>::write(out, val.m_seed);
+
+        return bytes;
+    }
+    static T read(std::istream& in) {
+        auto width = serialize<uint32_t>::read(in);
+        auto config = T::config_args{};
+        config.seed = serialize<uint64_t>::read(in);
+        return T(width, config);
+    }
+    static bool equal_check(T const& lhs, T const& rhs) {
+        return gen_equal_check(m_width)
+        && gen_equal_check(m_seed);
+    }
+};
+
+template<uint32_t W>
+struct heap_size<compact_hash::static_poplar_xorshift_t<W>> {
+    using T = compact_hash::static_poplar_xorshift_t<W>;
+
+    static object_size_t compute(T const& val) {
+        return heap_size<poplar::bijective_hash::Xorshift>::compute(val.m_dynamic);
+    }
+};
+
+template<uint32_t W>
+struct serialize<compact_hash::static_poplar_xorshift_t<W>> {
+    using T = compact_hash::static_poplar_xorshift_t<W>;
+
+    static object_size_t write(std::ostream& out, T const& val) {
+        return serialize<poplar::bijective_hash::Xorshift>::write(out, val.m_dynamic);
+    }
+    static T read(std::istream& in) {
+        T ret;
+        ret.m_dynamic = serialize<poplar::bijective_hash::Xorshift>::read(in);
+        return ret;
+    }
+    static bool equal_check(T const& lhs, T const& rhs) {
+        return gen_equal_check(m_dynamic);
+    }
+};
+
 }
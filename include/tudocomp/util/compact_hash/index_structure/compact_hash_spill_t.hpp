@@ -0,0 +1,94 @@
+#pragma once
+
+#include <glog/logging.h>
+
+#include <tudocomp/util/bits.hpp>
+#include <tudocomp/util/heap_size.hpp>
+#include <tudocomp/util/serialization.hpp>
+
+#include <tudocomp/util/compact_hash/map/hashmap_t.hpp>
+#include <tudocomp/util/compact_hash/hash_functions.hpp>
+#include <tudocomp/util/compact_hash/storage/buckets_bv_t.hpp>
+#include <tudocomp/util/compact_hash/index_structure/cv_bvs_t.hpp>
+#include <tudocomp/util/compact_hash/index_structure/displacement_t.hpp>
+#include <tudocomp/util/compact_hash/index_structure/layered_displacement_table_t.hpp>
+
+namespace tdc {namespace compact_hash {
+
+/// Spills displacement values into a compact hashtable keyed by
+/// table position, whose value width grows with the largest spilled
+/// displacement.
+///
+/// `placement_t` is the placement of the spill table itself.
+/// See `layered_compact_hash_spill_t` for the recursive m-Bonsai layering.
+template<typename placement_t = cv_bvs_t>
+class compact_hash_spill_t {
+    template<typename T>
+    friend struct ::tdc::serialize;
+
+    template<typename T>
+    friend struct ::tdc::heap_size;
+
+    using map_t = map::hashmap_t<dynamic_t, poplar_xorshift_t, buckets_bv_t, placement_t>;
+
+    map_t m_spill;
+public:
+    /// runtime initilization arguments, if any
+    struct config_args {};
+
+    /// get the config of this instance
+    inline config_args current_config() const { return config_args{}; }
+
+    compact_hash_spill_t() = default;
+    compact_hash_spill_t(size_t table_size, config_args config):
+        m_spill(0, bits_for(table_size - 1), 1) {}
+
+    inline size_t get(size_t pos) {
+        auto ptr = m_spill.search(pos);
+        DCHECK(ptr != m_spill.end());
+        return uint64_t(*ptr);
+    }
+    inline void set(size_t pos, size_t val) {
+        m_spill.insert_kv_width(pos, uint64_t(val), m_spill.key_width(), bits_for(val));
+    }
+};
+
+/// The recursive m-Bonsai layering: Displacements are spilled into a
+/// compact hashtable, which itself stores its displacements in a layered
+/// table with `spill_bit_width_t`, and only spills those into a
+/// `std::unordered_map`.
+template<typename spill_bit_width_t = static_layered_bit_width_t<7>>
+using layered_compact_hash_spill_t = compact_hash_spill_t<
+    displacement_t<layered_displacement_table_t<spill_bit_width_t>>>;
+
+}
+
+template<typename placement_t>
+struct heap_size<compact_hash::compact_hash_spill_t<placement_t>> {
+    using T = compact_hash::compact_hash_spill_t<placement_t>;
+
+    static object_size_t compute(T const& val) {
+        return heap_size_compute(val.m_spill);
+    }
+};
+
+template<typename placement_t>
+struct serialize<compact_hash::compact_hash_spill_t<placement_t>> {
+    using T = compact_hash::compact_hash_spill_t<placement_t>;
+
+    static object_size_t write(std::ostream& out, T const& val) {
+        return serialize_write(out, val.m_spill);
+    }
+
+    static T read(std::istream& in) {
+        T ret;
+        serialize_read_into(in, ret.m_spill);
+        return ret;
+    }
+
+    static bool equal_check(T const& lhs, T const& rhs) {
+        return gen_equal_check(m_spill);
+    }
+};
+
+}
@@ -0,0 +1,530 @@
+#pragma once
+
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+#include <tudocomp/util/bit_packed_layout_t.hpp>
+#include <tudocomp/ds/IntVector.hpp>
+#include <tudocomp/ds/IntPtr.hpp>
+
+#include "../entry_t.hpp"
+#include "../allocated_cursor_t.hpp"
+#include "../stash_t.hpp"
+
+#include <tudocomp/util/serialization.hpp>
+#include <tudocomp/util/delta_serialization.hpp>
+
+namespace tdc {namespace compact_hash {
+
+/// Bucketized cuckoo placement.
+///
+/// The table is divided into blocks of 4 slots. An entry is stored in one
+/// of two candidate blocks: Its _home block_, given by the upper bits of its
+/// initial address, or its _alternative block_, which is the home block
+/// xor an offset derived from the quotient.
+/// Because of this, a search inspects at most two blocks.
+///
+/// To restore the initial address of an entry, a 4 bit tag is
+/// stored per slot, containing the lower bits of the initial address
+/// and a bit that indicates if the entry lies in its alternative block.
+///
+/// If an insertion can not find a free slot in either of its blocks,
+/// a breadth-first search for a sequence of entries that can be moved
+/// to their other block is performed. In the rare case that this fails,
+/// the entry is put in an arbitrary free slot and its initial
+/// address is remembered in a _stash_.
+///
+/// Since entries can move between their blocks, the _id_ of an entry is
+/// its hashed key: `id = initial_address | (quotient << log2(table_size))`.
+class cuckoo_t {
+    template<typename T>
+    friend struct ::tdc::serialize;
+
+    template<typename T>
+    friend struct ::tdc::heap_size;
+
+    using tag_vec_t = IntVector<uint_t<4>>;
+    using tag_val_t = typename tag_vec_t::value_type;
+
+    tag_vec_t m_tags;
+    stash_t m_stash;
+    size_t m_max_search;
+
+    cuckoo_t() = default;
+
+public:
+    /// log2 of the amount of slots per block
+    static constexpr size_t BLOCK_SIZE_LOG2 = 2;
+
+    /// tag bits for the lower bits of the initial address
+    static constexpr size_t TAG_LOW_MASK = (1ull << BLOCK_SIZE_LOG2) - 1;
+    /// tag bit for entries in their alternative block
+    static constexpr size_t TAG_ALT = 1ull << BLOCK_SIZE_LOG2;
+    /// tag bit for entries in the stash
+    static constexpr size_t TAG_STASH = TAG_ALT << 1;
+
+    /// Whether several threads can walk over the entries at the same time.
+    static constexpr bool concurrent_walk = true;
+
+    /// Whether the context inserts the entries of a batch in groups,
+    /// with `lookup_insert_group()`.
+    static constexpr bool grouped_insert = false;
+
+    /// runtime initilization arguments, if any
+    struct config_args {
+        /// maximal amount of slots visited when searching
+        /// for entries to move away on insertion
+        size_t max_search = 512;
+    };
+
+    /// get the config of this instance
+    inline config_args current_config() const {
+        return config_args{ m_max_search };
+    }
+
+    inline cuckoo_t(size_t table_size, config_args config):
+        m_max_search(config.max_search)
+    {
+        m_tags.reserve(table_size);
+        m_tags.resize(table_size);
+    }
+
+    /// Amount of entries whose initial address is kept in the stash.
+    inline size_t stash_size() const {
+        return m_stash.size();
+    }
+
+    template<typename storage_t, typename size_mgr_t>
+    struct context_t {
+        using satellite_t = typename storage_t::satellite_t_export;
+        using entry_width_t = typename satellite_t::entry_bit_width_t;
+        using entry_t = generic_entry_t<typename satellite_t::entry_ptr_t>;
+        using table_pos_t = typename storage_t::table_pos_t;
+
+        tag_vec_t& m_tags;
+        stash_t& m_stash;
+        size_t const m_max_search;
+        size_t const table_size;
+        entry_width_t widths;
+        size_mgr_t const& size_mgr;
+        storage_t& storage;
+
+        static constexpr size_t NO_POS = size_t(-1);
+
+        inline size_t block_log2() const {
+            return std::min<size_t>(BLOCK_SIZE_LOG2, size_mgr.capacity_log2());
+        }
+
+        inline size_t block_size() const {
+            return 1ull << block_log2();
+        }
+
+        inline size_t get_tag(size_t pos) const {
+            return tag_val_t(m_tags[pos]);
+        }
+
+        inline void set_tag(size_t pos, size_t tag) {
+            m_tags[pos] = tag;
+        }
+
+        /// The offset between the home and alternative block of an entry.
+        ///
+        /// NB: Because the blocks are combined with an xor, each of them
+        /// is the alternative of the other.
+        inline size_t block_offset(uint64_t stored_quotient, uint64_t low) const {
+            size_t const block_count_log2 = size_mgr.capacity_log2() - block_log2();
+            if (block_count_log2 == 0) {
+                return 0;
+            }
+
+            uint64_t x = (stored_quotient * 0x9E3779B97F4A7C15ull + low)
+                       * 0xC2B2AE3D27D4EB4Full;
+            size_t offset = x >> (64 - block_count_log2);
+
+            return (offset == 0) ? 1 : offset;
+        }
+
+        inline uint64_t entry_id(uint64_t initial_address, uint64_t stored_quotient) const {
+            return (stored_quotient << size_mgr.capacity_log2()) | initial_address;
+        }
+
+        /// Restores the initial address of the allocated entry at `pos`.
+        inline uint64_t initial_address_at(size_t pos, uint64_t stored_quotient) {
+            size_t const tag = get_tag(pos);
+            if (tag & TAG_STASH) {
+                return m_stash.initial_address(pos);
+            }
+
+            size_t const low = tag & TAG_LOW_MASK;
+            size_t block = pos >> block_log2();
+            if (tag & TAG_ALT) {
+                block ^= block_offset(stored_quotient, low);
+            }
+            return (block << block_log2()) | low;
+        }
+
+        /// Returns the position of the entry with tag `tag` and
+        /// quotient `stored_quotient` in block `block`, or `NO_POS`.
+        template<typename sctx_t>
+        inline size_t search_block(sctx_t& sctx,
+                                   size_t block,
+                                   size_t tag,
+                                   uint64_t stored_quotient) {
+            size_t const start = block << block_log2();
+            for (size_t pos = start; pos < start + block_size(); pos++) {
+                auto p = sctx.table_pos(pos);
+                if (!sctx.pos_is_empty(p)
+                    && get_tag(pos) == tag
+                    && sctx.at(p).get_quotient() == stored_quotient) {
+                    return pos;
+                }
+            }
+            return NO_POS;
+        }
+
+        /// Returns the position of the first empty slot in block `block`,
+        /// or `NO_POS`.
+        template<typename sctx_t>
+        inline size_t empty_in_block(sctx_t& sctx, size_t block) {
+            size_t const start = block << block_log2();
+            for (size_t pos = start; pos < start + block_size(); pos++) {
+                if (sctx.pos_is_empty(sctx.table_pos(pos))) {
+                    return pos;
+                }
+            }
+            return NO_POS;
+        }
+
+        /// Returns the position of the entry, or `NO_POS`.
+        template<typename sctx_t>
+        inline size_t search_pos(sctx_t& sctx,
+                                 uint64_t initial_address,
+                                 uint64_t stored_quotient) {
+            size_t const low = initial_address & (block_size() - 1);
+            size_t const home = initial_address >> block_log2();
+            size_t const alt = home ^ block_offset(stored_quotient, low);
+
+            size_t pos = search_block(sctx, home, low, stored_quotient);
+            if (pos == NO_POS && alt != home) {
+                pos = search_block(sctx, alt, low | TAG_ALT, stored_quotient);
+            }
+            if (pos == NO_POS && !m_stash.empty()) {
+                pos = m_stash.find(initial_address, [&](size_t stashed) {
+                    return sctx.at(sctx.table_pos(stashed)).get_quotient() == stored_quotient;
+                });
+            }
+            return pos;
+        }
+
+        entry_t lookup_id(uint64_t id) {
+            uint64_t initial_address = id & (table_size - 1);
+            uint64_t stored_quotient = id >> size_mgr.capacity_log2();
+
+            return search(initial_address, stored_quotient);
+        }
+
+        entry_t lookup_insert(uint64_t initial_address,
+                              uint64_t stored_quotient)
+        {
+            auto sctx = storage.context(table_size, widths);
+            uint64_t const id = entry_id(initial_address, stored_quotient);
+
+            size_t pos = search_pos(sctx, initial_address, stored_quotient);
+            if (pos != NO_POS) {
+                return entry_t::found_exist(id, sctx.at(sctx.table_pos(pos)));
+            }
+
+            size_t const low = initial_address & (block_size() - 1);
+            size_t const home = initial_address >> block_log2();
+            size_t const alt = home ^ block_offset(stored_quotient, low);
+
+            if ((pos = empty_in_block(sctx, home)) != NO_POS) {
+                set_tag(pos, low);
+            } else if ((pos = empty_in_block(sctx, alt)) != NO_POS) {
+                set_tag(pos, low | TAG_ALT);
+            } else if ((pos = move_away(sctx, home, alt)) != NO_POS) {
+                // NB: The position has been made free, and is
+                // left allocated but uninitialized
+                set_tag(pos, ((pos >> block_log2()) == home) ? low : (low | TAG_ALT));
+                auto ptrs = sctx.at(sctx.table_pos(pos));
+                ptrs.set_quotient(stored_quotient);
+                return entry_t::found_new(id, ptrs);
+            } else {
+                // Fall back to the stash
+                pos = home << block_log2();
+                while (!sctx.pos_is_empty(sctx.table_pos(pos))) {
+                    pos = size_mgr.mod_add(pos);
+                    DCHECK_NE(pos, home << block_log2());
+                }
+                set_tag(pos, TAG_STASH);
+                m_stash.insert(pos, initial_address);
+            }
+
+            auto ptrs = sctx.allocate_pos(sctx.table_pos(pos));
+            ptrs.set_quotient(stored_quotient);
+            return entry_t::found_new(id, ptrs);
+        }
+
+        /// Searches for a sequence of entries that can be moved to their
+        /// other block, starting with one in the blocks `home` or `alt`,
+        /// and performs the moves.
+        ///
+        /// Returns the position in `home` or `alt` that got freed up,
+        /// or `NO_POS` if no such sequence could be found.
+        template<typename sctx_t>
+        inline size_t move_away(sctx_t& sctx, size_t home, size_t alt) {
+            struct node_t {
+                size_t pos;
+                size_t parent;
+            };
+            std::vector<node_t> nodes;
+
+            auto on_path = [&](size_t pos, size_t node) {
+                for (; node != NO_POS; node = nodes[node].parent) {
+                    if (nodes[node].pos == pos) {
+                        return true;
+                    }
+                }
+                return false;
+            };
+
+            // NB: A slot may appear only once on a path,
+            // since its entry would otherwise be moved twice.
+            auto push_block = [&](size_t block, size_t parent) {
+                size_t const start = block << block_log2();
+                for (size_t pos = start; pos < start + block_size(); pos++) {
+                    if (!on_path(pos, parent)) {
+                        nodes.push_back(node_t { pos, parent });
+                    }
+                }
+            };
+
+            push_block(home, NO_POS);
+            if (alt != home) {
+                push_block(alt, NO_POS);
+            }
+
+            for (size_t i = 0; i < nodes.size() && nodes.size() < m_max_search; i++) {
+                size_t const pos = nodes[i].pos;
+                size_t const tag = get_tag(pos);
+                if (tag & TAG_STASH) {
+                    continue;
+                }
+
+                auto quot = sctx.at(sctx.table_pos(pos)).get_quotient();
+                size_t const block = pos >> block_log2();
+                size_t const other = block ^ block_offset(quot, tag & TAG_LOW_MASK);
+                if (other == block) {
+                    continue;
+                }
+
+                size_t const free_pos = empty_in_block(sctx, other);
+                if (free_pos == NO_POS) {
+                    push_block(other, i);
+                    continue;
+                }
+
+                // Move the entries along the path, starting at its end
+                {
+                    auto free_ptrs = sctx.allocate_pos(sctx.table_pos(free_pos));
+                    free_ptrs.init_from(sctx.at(sctx.table_pos(pos)));
+                    set_tag(free_pos, tag ^ TAG_ALT);
+                }
+                size_t j = i;
+                while (nodes[j].parent != NO_POS) {
+                    size_t const dst = nodes[j].pos;
+                    size_t const src = nodes[nodes[j].parent].pos;
+                    sctx.at(sctx.table_pos(dst)).move_from(sctx.at(sctx.table_pos(src)));
+                    set_tag(dst, get_tag(src) ^ TAG_ALT);
+                    j = nodes[j].parent;
+                }
+
+                size_t const root = nodes[j].pos;
+                sctx.at(sctx.table_pos(root)).uninitialize();
+                return root;
+            }
+
+            return NO_POS;
+        }
+
+        /// Returns a cursor to the first entry visited by `for_all_allocated()`.
+        inline allocated_cursor_t first_allocated() {
+            auto sctx = storage.context(table_size, widths);
+            size_t const start = first_empty_pos(sctx);
+            return first_allocated_between(start, start);
+        }
+
+        /// Returns a cursor to the first entry between the empty
+        /// locations `start` and `end`, see `allocated_cursor_t`.
+        inline allocated_cursor_t first_allocated_between(size_t start, size_t end) {
+            allocated_cursor_t c;
+            c.start = start;
+            c.end = end;
+            c.pos = start;
+            next_allocated(c);
+            return c;
+        }
+
+        /// Advances `c` to the next entry, or sets `c.done`
+        /// at the end of its walk.
+        inline void next_allocated(allocated_cursor_t& c) {
+            auto sctx = storage.context(table_size, widths);
+
+            size_t const i = skip_empty(sctx, table_size, c, size_mgr.mod_add(c.pos));
+            if (c.done) {
+                return;
+            }
+            c.initial_address = initial_address_at(i, sctx.at(sctx.table_pos(i)).get_quotient());
+            c.pos = i;
+        }
+
+        template<typename F>
+        inline void for_all_allocated(F f) {
+            for (auto c = first_allocated(); !c.done; next_allocated(c)) {
+                f(c.initial_address, c.pos);
+            }
+        }
+
+        template<typename F>
+        inline void drain_all(F f) {
+            table_pos_t drain_start;
+            bool first = true;
+
+            for_all_allocated([&](auto initial_address, auto i) {
+                auto sctx = storage.context(table_size, widths);
+                auto p = sctx.table_pos(i);
+
+                if (first) {
+                    first = false;
+                    drain_start = p;
+                }
+
+                sctx.trim_storage(&drain_start, p);
+                f(initial_address, sctx.at(p));
+            });
+        }
+
+        inline entry_t search(uint64_t const initial_address,
+                              uint64_t stored_quotient) {
+            auto sctx = storage.context(table_size, widths);
+
+            size_t pos = search_pos(sctx, initial_address, stored_quotient);
+            if (pos == NO_POS) {
+                return entry_t::not_found();
+            }
+
+            uint64_t const id = entry_id(initial_address, stored_quotient);
+            return entry_t::found_exist(id, sctx.at(sctx.table_pos(pos)));
+        }
+
+        /// Removes the entry with the given initial address and quotient.
+        ///
+        /// Returns `true` if the entry existed.
+        inline bool erase(uint64_t const initial_address,
+                          uint64_t stored_quotient) {
+            auto sctx = storage.context(table_size, widths);
+
+            size_t pos = search_pos(sctx, initial_address, stored_quotient);
+            if (pos == NO_POS) {
+                return false;
+            }
+
+            if (get_tag(pos) & TAG_STASH) {
+                m_stash.erase(pos);
+            }
+            set_tag(pos, 0);
+            sctx.deallocate_pos(sctx.table_pos(pos));
+
+            return true;
+        }
+    };
+    template<typename storage_t, typename size_mgr_t>
+    inline auto context(storage_t& storage,
+                        size_t table_size,
+                        typename storage_t::satellite_t_export::entry_bit_width_t const& widths,
+                        size_mgr_t const& size_mgr) {
+        return context_t<storage_t, size_mgr_t> {
+            m_tags, m_stash, m_max_search, table_size, widths, size_mgr, storage
+        };
+    }
+};
+
+}
+
+template<>
+struct heap_size<compact_hash::cuckoo_t> {
+    using T = compact_hash::cuckoo_t;
+
+    static object_size_t compute(T const& val, size_t table_size) {
+        auto bytes = object_size_t::empty();
+
+        DCHECK_EQ(val.m_tags.size(), table_size);
+        bytes += object_size_t::exact(val.m_tags.stat_allocation_size_in_bytes());
+        bytes += heap_size<size_t>::compute(val.m_max_search);
+
+        bytes += heap_size<compact_hash::stash_t>::compute(val.m_stash);
+
+        return bytes;
+    }
+};
+
+template<>
+struct serialize<compact_hash::cuckoo_t> {
+    using T = compact_hash::cuckoo_t;
+
+    static object_size_t write(std::ostream& out, T const& val, size_t table_size) {
+        auto bytes = object_size_t::empty();
+
+        DCHECK_EQ(val.m_tags.size(), table_size);
+
+        bytes += serialize_write(out, val.m_max_search);
+
+        auto data = (char const*) val.m_tags.data();
+        auto size = val.m_tags.stat_allocation_size_in_bytes();
+        out.write(data, size);
+        bytes += object_size_t::exact(size);
+
+        bytes += serialize<compact_hash::stash_t>::write(out, val.m_stash);
+
+        return bytes;
+    }
+
+    static T read(std::istream& in, size_t table_size,
+                  typename T::config_args const& = typename T::config_args{}) {
+        T ret;
+
+        serialize_read_into(in, ret.m_max_search);
+
+        ret.m_tags.reserve(table_size);
+        ret.m_tags.resize(table_size);
+        auto data = (char*) ret.m_tags.data();
+        auto size = ret.m_tags.stat_allocation_size_in_bytes();
+        in.read(data, size);
+
+        ret.m_stash = serialize<compact_hash::stash_t>::read(in);
+
+        return ret;
+    }
+
+    /// NB: An entry can move to its other bucket, and to and from the stash,
+    /// without a change at the positions of the storage it was at,
+    /// so a delta contains the whole placement.
+    static object_size_t write_ranges(std::ostream& out, T const& val,
+                                      size_t table_size, delta_ranges_t const&) {
+        return write(out, val, table_size);
+    }
+
+    static void read_ranges(std::istream& in, T& val,
+                            size_t table_size, delta_ranges_t const&) {
+        val = read(in, table_size);
+    }
+
+    static bool equal_check(T const& lhs, T const& rhs, size_t table_size) {
+        return gen_equal_diagnostic(lhs.m_tags == rhs.m_tags)
+        && serialize<compact_hash::stash_t>::equal_check(lhs.m_stash, rhs.m_stash)
+        && gen_equal_check(m_max_search);
+    }
+};
+
+}
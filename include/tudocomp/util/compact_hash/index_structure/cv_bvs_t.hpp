@@ -5,8 +5,12 @@
 #include <tudocomp/ds/IntVector.hpp>
 #include <tudocomp/ds/IntPtr.hpp>
 #include "../entry_t.hpp"
+#include "../allocated_cursor_t.hpp"
+#include "../storage/shift_elements.hpp"
+#include "../page_policy.hpp"
 
 #include <tudocomp/util/serialization.hpp>
+#include <tudocomp/util/delta_serialization.hpp>
 
 namespace tdc {namespace compact_hash {
 
@@ -18,17 +22,36 @@ class cv_bvs_t {
     friend struct ::tdc::heap_size;
 
     IntVector<uint_t<2>> m_cv;
+    bool m_transparent_huge_pages = false;
     inline cv_bvs_t(IntVector<uint_t<2>>&& cv): m_cv(std::move(cv)) {}
 
 public:
+    /// Whether several threads can walk over the entries at the same time.
+    static constexpr bool concurrent_walk = true;
+
+    /// Whether the context inserts the entries of a batch in groups,
+    /// with `lookup_insert_group()`.
+    static constexpr bool grouped_insert = false;
+
     /// runtime initilization arguments, if any
-    struct config_args {};
+    struct config_args {
+        /// Whether to back the bit vectors with transparent huge pages.
+        bool transparent_huge_pages = false;
+    };
 
     /// get the config of this instance
-    inline config_args current_config() const { return config_args{}; }
+    inline config_args current_config() const {
+        return config_args{ m_transparent_huge_pages };
+    }
 
-    inline cv_bvs_t(size_t table_size, config_args config) {
+    inline cv_bvs_t(size_t table_size, config_args config):
+        m_transparent_huge_pages(config.transparent_huge_pages)
+    {
         m_cv.reserve(table_size);
+        if (m_transparent_huge_pages) {
+            // NB: The advice needs to be given before the pages are touched.
+            advise_transparent_huge_pages(m_cv.data(), (table_size * 2 + 7) / 8);
+        }
         m_cv.resize(table_size);
     }
 
@@ -72,9 +95,16 @@ public:
         }
 
         /// Setter for the v bit at table position `pos`.
+        ///
+        /// NB: Unlike the c bits, the v bit of a new group can change
+        /// at a position whose entry stays unchanged, so the position
+        /// is marked as changed for delta snapshots explicitly.
         inline void set_v(size_t pos, bool v) {
             auto x = m_cv[pos] & 0b10;
             m_cv[pos] = x | (0b01 * v);
+
+            auto sctx = storage.context(table_size, widths);
+            sctx.mark_changed(sctx.table_pos(pos));
         }
 
         /// Setter for the c bit at table position `pos`.
@@ -195,91 +225,7 @@ public:
             size_t from, size_t to)
         {
             auto sctx = storage.context(table_size, widths);
-            // move from...to one to the right, then insert at from
-
-            DCHECK(from != to);
-
-            table_pos_t from_pos;
-
-            if (to < from) {
-                // if the range wraps around, we decompose into two ranges:
-                // [   |      |      ]
-                // | to^      ^from  |
-                // ^start         end^
-                // [ 2 ]      [  1   ]
-                //
-                // NB: because we require from != to, and insert 1 additional element,
-                // we are always dealing with a minimum 2 element range,
-                // and thus can not end up with a split range with length == 0.
-
-                from_pos = sparse_shift(from,  table_size);
-                if (to > 0) {
-                    auto start_pos = sparse_shift(0, to);
-                    sctx.at(from_pos).swap_with(sctx.at(start_pos));
-                }
-            } else {
-                // [     |      |      ]
-                //   from^      ^to
-
-                from_pos = sparse_shift(from, to);
-            }
-
-            // insert the element from the end of the range at the free
-            // position to the right of it.
-            auto new_loc = sctx.allocate_pos(sctx.table_pos(to));
-
-            auto from_ptrs = sctx.at(from_pos);
-            new_loc.init_from(from_ptrs);
-            from_ptrs.uninitialize();
-
-            return from_ptrs;
-        }
-
-        /// Shifts all elements one to the right,
-        /// moving the last element to the front position,
-        /// and returns a ptr pair to it.
-        inline table_pos_t sparse_shift(size_t from, size_t to) {
-            DCHECK_LT(from, to);
-            auto sctx = storage.context(table_size, widths);
-
-            // initialize iterators like this:
-            // [         ]
-            // ^from   to^
-            //          ||
-            //    <- src^|
-            //    <- dest^
-
-            auto from_loc = sctx.table_pos(from);
-            auto from_iter = sctx.make_iter(from_loc);
-
-            auto last = sctx.table_pos(to - 1);
-            auto src = sctx.make_iter(last);
-            auto dst = sctx.make_iter(sctx.table_pos(to));
-
-            // move the element at the last position to a temporary position
-            auto tmp_p = sctx.at(last);
-            auto tmp = tmp_p.move_out();
-
-            // move all elements one to the right
-            // TODO: Could be optimized
-            // to memcpies for different underlying layouts
-            while(src != from_iter) {
-                // Decrement first for backward iteration
-                src.decrement();
-                dst.decrement();
-
-                // Get access to the value/quotient at src and dst
-                auto src_be = src.get();
-                auto dst_be = dst.get();
-
-                // Copy value/quotient over
-                dst_be.move_from(src_be);
-            }
-
-            // move last element to the front
-            auto from_p = sctx.at(from_loc);
-            from_p.set(std::move(tmp));
-            return from_loc;
+            return compact_hash::shift_elements_and_insert(sctx, from, to);
         }
 
         inline uint64_t local_id_to_global_id(uint64_t initial_address, uint64_t local_id) {
@@ -377,51 +323,58 @@ public:
             }
         }
 
-        template<typename F>
-        inline void for_all_allocated(F f) {
+        /// Returns a cursor to the first entry visited by `for_all_allocated()`.
+        ///
+        /// The walk starts behind an empty location, such that
+        /// it starts at the beginning of a complete group.
+        inline allocated_cursor_t first_allocated() {
             auto sctx = storage.context(table_size, widths);
+            size_t const start = first_empty_pos(sctx);
+            return first_allocated_between(start, start);
+        }
 
-            // first, skip forward to the first empty location
-            // so that iteration can start at the beginning of the first complete group
-
-            size_t i = 0;
-            for(;;i++) {
-                if (sctx.pos_is_empty(sctx.table_pos(i))) {
-                    break;
-                }
-            }
-
-            // Remember our startpoint so that we can recognize it when
-            // we wrapped around back to it
-            size_t const original_start = i;
-
-            // We proceed to the next position so that we can iterate until
-            // we reach `original_start` again.
-            uint64_t initial_address = i;
-            i = size_mgr.mod_add(i);
+        /// Returns a cursor to the first entry between the empty
+        /// locations `start` and `end`, see `allocated_cursor_t`.
+        inline allocated_cursor_t first_allocated_between(size_t start, size_t end) {
+            allocated_cursor_t c;
+            c.start = start;
+            c.end = end;
+            c.pos = start;
+            c.initial_address = start;
+            next_allocated(c);
+            return c;
+        }
 
-            while(true) {
-                auto sctx = storage.context(table_size, widths);
-                while (sctx.pos_is_empty(sctx.table_pos(i))) {
-                    if (i == original_start) {
-                        return;
-                    }
+        /// Advances `c` to the next entry, or sets `c.done`
+        /// at the end of its walk.
+        inline void next_allocated(allocated_cursor_t& c) {
+            auto sctx = storage.context(table_size, widths);
 
-                    initial_address = i;
-                    i = size_mgr.mod_add(i);
-                }
+            // The last skipped empty location is the one
+            // before the initial address of the next group.
+            size_t const pos = size_mgr.mod_add(c.pos);
+            size_t const i = skip_empty(sctx, table_size, c, pos);
+            if (c.done) {
+                return;
+            }
+            if (i != pos) {
+                c.initial_address = size_mgr.mod_sub(i);
+            }
 
-                // If start of group, find next v bit to find initial address
-                if (get_c(i)) {
-                    initial_address = size_mgr.mod_add(initial_address);
-                    while(!get_v(initial_address)) {
-                        initial_address = size_mgr.mod_add(initial_address);
-                    }
+            // If start of group, find next v bit to find initial address
+            if (get_c(i)) {
+                c.initial_address = size_mgr.mod_add(c.initial_address);
+                while(!get_v(c.initial_address)) {
+                    c.initial_address = size_mgr.mod_add(c.initial_address);
                 }
+            }
+            c.pos = i;
+        }
 
-                f(initial_address, i);
-
-                i = size_mgr.mod_add(i);
+        template<typename F>
+        inline void for_all_allocated(F f) {
+            for (auto c = first_allocated(); !c.done; next_allocated(c)) {
+                f(c.initial_address, c.pos);
             }
         }
 
@@ -515,18 +468,36 @@ struct serialize<compact_hash::cv_bvs_t> {
     }
 
     static T read(std::istream& in,
-                  size_t table_size) {
+                  size_t table_size,
+                  typename T::config_args const& config = typename T::config_args{}) {
         auto cv = IntVector<uint_t<2>>();
         cv.reserve(table_size);
+        if (config.transparent_huge_pages) {
+            compact_hash::advise_transparent_huge_pages(cv.data(), (table_size * 2 + 7) / 8);
+        }
         cv.resize(table_size);
         auto data = (char*) cv.data();
         auto size = cv.stat_allocation_size_in_bytes();
 
         in.read(data, size);
 
-        return T {
+        auto ret = T {
             std::move(cv)
         };
+        ret.m_transparent_huge_pages = config.transparent_huge_pages;
+        return ret;
+    }
+
+    static object_size_t write_ranges(std::ostream& out, T const& val,
+                                      size_t table_size, delta_ranges_t const& ranges) {
+        DCHECK_EQ(val.m_cv.size(), table_size);
+        return delta_write_bits(out, val.m_cv.data(), 2, ranges);
+    }
+
+    static void read_ranges(std::istream& in, T& val,
+                            size_t table_size, delta_ranges_t const& ranges) {
+        DCHECK_EQ(val.m_cv.size(), table_size);
+        delta_read_bits(in, val.m_cv.data(), 2, ranges);
     }
 
     static bool equal_check(T const& lhs, T const& rhs, size_t table_size) {
@@ -1,21 +1,49 @@
 #pragma once
 
+#include <algorithm>
 #include <limits>
 #include <unordered_map>
 #include <type_traits>
+#include <vector>
 
 #include <tudocomp/util/bit_packed_layout_t.hpp>
 #include <tudocomp/util/int_coder.hpp>
 #include <tudocomp/ds/IntVector.hpp>
 #include <tudocomp/ds/IntPtr.hpp>
 
+#include "../util.hpp"
 #include "../entry_t.hpp"
+#include "../allocated_cursor_t.hpp"
 
 #include <tudocomp/util/serialization.hpp>
+#include <tudocomp/util/delta_serialization.hpp>
 
 namespace tdc {namespace compact_hash {
 
-template<typename displacement_table_t>
+/// Optional per-slot fingerprints of the entries of a table.
+///
+/// A fingerprint is a small hash of the initial address and quotient
+/// of an entry, which allows a search to skip non-matching slots
+/// without decoding their displacement value or quotient.
+/// A width of 0 disables the fingerprints.
+using fingerprints_t = IntVector<dynamic_t>;
+
+/// Computes the fingerprint of an entry with a width of `width` bits.
+inline uint64_t fingerprint(size_t width, uint64_t initial_address, uint64_t stored_quotient) {
+    DCHECK_GT(width, 0U);
+    uint64_t x = (initial_address * 0x9E3779B97F4A7C15ull) ^ stored_quotient;
+    x *= 0xC2B2AE3D27D4EB4Full;
+    return x >> (64 - width);
+}
+
+/// Linear probing, with a displacement value per slot represented by a
+/// `displacement_table_t`.
+///
+/// With `fingerprinted`, each slot can additionally store a fingerprint
+/// of its entry, see `config_args::fingerprint_width`.
+/// Otherwise, the fingerprints are disabled and not serialized,
+/// which keeps the serialization format of the displacement table.
+template<typename displacement_table_t, bool fingerprinted = false>
 class displacement_t {
     template<typename T>
     friend struct ::tdc::serialize;
@@ -24,24 +52,54 @@ class displacement_t {
     friend struct ::tdc::heap_size;
 
     displacement_table_t m_displace;
+    size_t m_fingerprint_width;
+    fingerprints_t m_fingerprints;
 
-    displacement_t(displacement_table_t&& table):
-        m_displace(std::move(table)) {}
+    displacement_t(displacement_table_t&& table,
+                   size_t fingerprint_width,
+                   fingerprints_t&& fingerprints):
+        m_displace(std::move(table)),
+        m_fingerprint_width(fingerprint_width),
+        m_fingerprints(std::move(fingerprints)) {}
 
 public:
     displacement_table_t& displacement_table() { return m_displace; }
+
+    /// Whether several threads can walk over the entries at the same time.
+    static constexpr bool concurrent_walk = displacement_table_t::concurrent_get;
+
+    /// Whether the context inserts the entries of a batch in groups,
+    /// with `lookup_insert_group()`.
+    static constexpr bool grouped_insert = true;
+
     /// runtime initilization arguments, if any
     struct config_args {
         typename displacement_table_t::config_args table_config;
+
+        /// bits per slot used for fingerprints, or 0 for none.
+        ///
+        /// NB: Needs a `fingerprinted` displacement_t.
+        size_t fingerprint_width = fingerprinted ? 8 : 0;
     };
 
     /// get the config of this instance
     inline config_args current_config() const {
-        return config_args { m_displace.current_config() };
+        return config_args { m_displace.current_config(), m_fingerprint_width };
     }
 
     inline displacement_t(size_t table_size, config_args config):
-        m_displace(table_size, config.table_config) {}
+        m_displace(table_size, config.table_config),
+        m_fingerprint_width(config.fingerprint_width)
+    {
+        DCHECK_LE(m_fingerprint_width, 64U);
+        CHECK(fingerprinted || m_fingerprint_width == 0)
+            << "fingerprints need a displacement_t<T, true>";
+        if (m_fingerprint_width > 0) {
+            m_fingerprints.width(config.fingerprint_width);
+            m_fingerprints.reserve(table_size);
+            m_fingerprints.resize(table_size);
+        }
+    }
 
     template<typename storage_t, typename size_mgr_t>
     struct context_t {
@@ -55,6 +113,32 @@ public:
         entry_width_t widths;
         size_mgr_t const& size_mgr;
         storage_t& storage;
+        /// NB: `nullptr` if fingerprints are disabled.
+        fingerprints_t* m_fingerprints;
+
+        /// Fingerprint of the entry, or 0 if fingerprints are disabled.
+        inline uint64_t fingerprint_of(uint64_t initial_address,
+                                       uint64_t stored_quotient) const {
+            if (m_fingerprints == nullptr) {
+                return 0;
+            }
+            return fingerprint(m_fingerprints->width(), initial_address, stored_quotient);
+        }
+
+        /// Returns `false` if the slot `pos` can not contain an entry
+        /// with fingerprint `fp`.
+        inline bool fingerprint_matches(size_t pos, uint64_t fp) const {
+            if (m_fingerprints == nullptr) {
+                return true;
+            }
+            return uint64_t(typename fingerprints_t::value_type((*m_fingerprints)[pos])) == fp;
+        }
+
+        inline void set_fingerprint(size_t pos, uint64_t fp) {
+            if (m_fingerprints != nullptr) {
+                (*m_fingerprints)[pos] = fp;
+            }
+        }
 
         entry_t lookup_id(uint64_t id) {
             uint64_t position = id;
@@ -69,6 +153,7 @@ public:
                               uint64_t stored_quotient)
         {
             auto sctx = storage.context(table_size, widths);
+            auto const fp = fingerprint_of(initial_address, stored_quotient);
 
             auto cursor = initial_address;
             while(true) {
@@ -77,11 +162,13 @@ public:
                 if (sctx.pos_is_empty(pos)) {
                     auto ptrs = sctx.allocate_pos(pos);
                     m_displace.set(cursor, size_mgr.mod_sub(cursor, initial_address));
+                    set_fingerprint(cursor, fp);
                     ptrs.set_quotient(stored_quotient);
                     return entry_t::found_new(cursor, ptrs);
                 }
 
-                if(m_displace.get(cursor) == size_mgr.mod_sub(cursor, initial_address)) {
+                if(fingerprint_matches(cursor, fp)
+                   && m_displace.get(cursor) == size_mgr.mod_sub(cursor, initial_address)) {
                     auto ptrs = sctx.at(pos);
                     if (ptrs.get_quotient() == stored_quotient) {
                         return entry_t::found_exist(cursor, ptrs);
@@ -96,44 +183,153 @@ public:
             return entry_t::not_found();
         }
 
+        /// Inserts the entries with the initial addresses `initial_addresses[k]`
+        /// and quotients `stored_quotients[k]`, for `k < n`, like calling
+        /// `lookup_insert()` for each of them.
+        ///
+        /// The locations of all new entries are found first, and then
+        /// allocated with a single reallocation per bucket of the storage.
+        /// Calls `f(k, ptrs)` for each new entry, with its uninitialized value.
+        ///
+        /// Returns the `k` of the entries whose key exists in the table,
+        /// or earlier in the group, in order. They are left to the caller.
+        ///
+        /// NB: The group should span a short range of initial addresses,
+        /// since the locations are tracked relative to the smallest one.
         template<typename F>
-        inline void for_all_allocated(F f) {
+        inline std::vector<size_t> lookup_insert_group(uint64_t const* initial_addresses,
+                                                       uint64_t const* stored_quotients,
+                                                       size_t n,
+                                                       F f)
+        {
+            size_t const NONE = size_t(-1);
             auto sctx = storage.context(table_size, widths);
 
-            // first, skip forward to the first empty location
-            // so that iteration can start at the beginning of the first complete group
+            std::vector<size_t> existing;
+            if (n == 0) {
+                return existing;
+            }
+            uint64_t const base = *std::min_element(initial_addresses, initial_addresses + n);
+
+            // The entry of the group that takes each location, by its distance to `base`
+            std::vector<size_t> reserved;
+
+            for (size_t k = 0; k < n; k++) {
+                uint64_t const initial_address = initial_addresses[k];
+                uint64_t const stored_quotient = stored_quotients[k];
+                auto const fp = fingerprint_of(initial_address, stored_quotient);
+
+                auto cursor = initial_address;
+                while(true) {
+                    size_t const offset = size_mgr.mod_sub(cursor, base);
+
+                    if (offset < reserved.size() && reserved[offset] != NONE) {
+                        size_t const other = reserved[offset];
+                        if (initial_addresses[other] == initial_address
+                            && stored_quotients[other] == stored_quotient) {
+                            existing.push_back(k);
+                            break;
+                        }
+                    } else {
+                        auto pos = sctx.table_pos(cursor);
+
+                        if (sctx.pos_is_empty(pos)) {
+                            if (offset >= reserved.size()) {
+                                reserved.resize(offset + 1, NONE);
+                            }
+                            reserved[offset] = k;
+                            break;
+                        }
+
+                        if(fingerprint_matches(cursor, fp)
+                           && m_displace.get(cursor) == size_mgr.mod_sub(cursor, initial_address)) {
+                            auto ptrs = sctx.at(pos);
+                            if (ptrs.get_quotient() == stored_quotient) {
+                                existing.push_back(k);
+                                break;
+                            }
+                        }
+                    }
 
-            size_t i = 0;
-            for(;;i++) {
-                if (sctx.pos_is_empty(sctx.table_pos(i))) {
-                    break;
+                    cursor = size_mgr.mod_add(cursor);
+                    DCHECK_NE(cursor, initial_address);
                 }
             }
 
-            // Remember our startpoint so that we can recognize it when
-            // we wrapped around back to it
-            size_t const original_start = i;
-
-            // We proceed to the next position so that we can iterate until
-            // we reach `original_start` again.
-            i = size_mgr.mod_add(i);
-
-            while(true) {
-                auto sctx = storage.context(table_size, widths);
-                while (sctx.pos_is_empty(sctx.table_pos(i))) {
-                    if (i == original_start) {
-                        return;
+            // Allocate the reserved locations of each bucket at once
+            size_t offset = 0;
+            while (offset < reserved.size()) {
+                size_t const first = size_mgr.mod_add(base, offset) & ~size_t(63);
+                uint64_t bits = 0;
+                for (; offset < reserved.size(); offset++) {
+                    size_t const cursor = size_mgr.mod_add(base, offset);
+                    if ((cursor & ~size_t(63)) != first) {
+                        break;
+                    }
+                    if (reserved[offset] != NONE) {
+                        bits |= 1ull << (cursor & 63);
                     }
+                }
+                if (bits == 0) {
+                    continue;
+                }
+
+                sctx.allocate_positions(first, bits);
+                for (; bits != 0; bits &= bits - 1) {
+                    size_t const cursor = first + trailing_zeros(bits);
+                    size_t const k = reserved[size_mgr.mod_sub(cursor, base)];
 
-                    i = size_mgr.mod_add(i);
+                    auto ptrs = sctx.at(sctx.table_pos(cursor));
+                    m_displace.set(cursor, size_mgr.mod_sub(cursor, initial_addresses[k]));
+                    set_fingerprint(cursor, fingerprint_of(initial_addresses[k], stored_quotients[k]));
+                    ptrs.set_quotient(stored_quotients[k]);
+                    f(k, ptrs);
                 }
+            }
+
+            return existing;
+        }
+
+        /// Returns a cursor to the first entry visited by `for_all_allocated()`.
+        ///
+        /// The walk starts behind an empty location, such that
+        /// it starts at the beginning of a complete group.
+        inline allocated_cursor_t first_allocated() {
+            auto sctx = storage.context(table_size, widths);
+            size_t const start = first_empty_pos(sctx);
+            return first_allocated_between(start, start);
+        }
+
+        /// Returns a cursor to the first entry between the empty
+        /// locations `start` and `end`, see `allocated_cursor_t`.
+        inline allocated_cursor_t first_allocated_between(size_t start, size_t end) {
+            allocated_cursor_t c;
+            c.start = start;
+            c.end = end;
+            c.pos = start;
+            next_allocated(c);
+            return c;
+        }
 
-                auto disp = m_displace.get(i);
-                uint64_t initial_address = size_mgr.mod_sub(i, disp);
+        /// Advances `c` to the next entry, or sets `c.done`
+        /// at the end of its walk.
+        inline void next_allocated(allocated_cursor_t& c) {
+            auto sctx = storage.context(table_size, widths);
 
-                f(initial_address, i);
+            size_t const i = skip_empty(sctx, table_size, c, size_mgr.mod_add(c.pos));
+            if (c.done) {
+                return;
+            }
 
-                i = size_mgr.mod_add(i);
+            auto disp = m_displace.get(i);
+            c.initial_address = size_mgr.mod_sub(i, disp);
+            c.pos = i;
+        }
+
+        template<typename F>
+        inline void for_all_allocated(F f) {
+            for (auto c = first_allocated(); !c.done; next_allocated(c)) {
+                f(c.initial_address, c.pos);
             }
         }
 
@@ -159,6 +355,8 @@ public:
         inline entry_t search(uint64_t const initial_address,
                               uint64_t stored_quotient) {
             auto sctx = storage.context(table_size, widths);
+            auto const fp = fingerprint_of(initial_address, stored_quotient);
+
             auto cursor = initial_address;
             while(true) {
                 auto pos = sctx.table_pos(cursor);
@@ -167,7 +365,8 @@ public:
                     return entry_t::not_found();
                 }
 
-                if(m_displace.get(cursor) == size_mgr.mod_sub(cursor, initial_address)) {
+                if(fingerprint_matches(cursor, fp)
+                   && m_displace.get(cursor) == size_mgr.mod_sub(cursor, initial_address)) {
                     auto ptrs = sctx.at(pos);
                     if (ptrs.get_quotient() == stored_quotient) {
                         return entry_t::found_exist(cursor, ptrs);
@@ -188,40 +387,98 @@ public:
                         typename storage_t::satellite_t_export::entry_bit_width_t const& widths,
                         size_mgr_t const& size_mgr) {
         return context_t<storage_t, size_mgr_t> {
-            m_displace, table_size, widths, size_mgr, storage
+            m_displace, table_size, widths, size_mgr, storage,
+            (m_fingerprint_width > 0) ? &m_fingerprints : nullptr,
         };
     }
 };
 
 }
 
-template<typename displacement_table_t>
-struct heap_size<compact_hash::displacement_t<displacement_table_t>> {
-    using T = compact_hash::displacement_t<displacement_table_t>;
+template<typename displacement_table_t, bool fingerprinted>
+struct heap_size<compact_hash::displacement_t<displacement_table_t, fingerprinted>> {
+    using T = compact_hash::displacement_t<displacement_table_t, fingerprinted>;
 
     static object_size_t compute(T const& val, size_t table_size) {
-        return heap_size<displacement_table_t>::compute(val.m_displace, table_size);
+        auto bytes = heap_size<displacement_table_t>::compute(val.m_displace, table_size);
+        bytes += object_size_t::exact(val.m_fingerprints.stat_allocation_size_in_bytes());
+        return bytes;
     }
 };
 
-template<typename displacement_table_t>
-struct serialize<compact_hash::displacement_t<displacement_table_t>> {
-    using T = compact_hash::displacement_t<displacement_table_t>;
+/// NB: Without `fingerprinted`, this is the format of the displacement table.
+template<typename displacement_table_t, bool fingerprinted>
+struct serialize<compact_hash::displacement_t<displacement_table_t, fingerprinted>> {
+    using T = compact_hash::displacement_t<displacement_table_t, fingerprinted>;
 
     static object_size_t write(std::ostream& out, T const& val, size_t table_size) {
-        return serialize<displacement_table_t>::write(out, val.m_displace, table_size);
+        auto bytes = serialize<displacement_table_t>::write(out, val.m_displace, table_size);
+        if (!fingerprinted) {
+            return bytes;
+        }
+
+        bytes += serialize_write(out, val.m_fingerprint_width);
+        if (val.m_fingerprint_width > 0) {
+            auto data = (char const*) val.m_fingerprints.data();
+            auto size = val.m_fingerprints.stat_allocation_size_in_bytes();
+            out.write(data, size);
+            bytes += object_size_t::exact(size);
+        }
+
+        return bytes;
     }
 
-    static T read(std::istream& in, size_t table_size) {
+    static T read(std::istream& in, size_t table_size,
+                  typename T::config_args const& config = typename T::config_args{}) {
         auto displace =
-            serialize<displacement_table_t>::read(in, table_size);
+            serialize<displacement_table_t>::read(in, table_size, config.table_config);
+
+        compact_hash::fingerprints_t fingerprints;
+        size_t fingerprint_width = 0;
+        if (fingerprinted) {
+            serialize_read_into(in, fingerprint_width);
+        }
+        if (fingerprint_width > 0) {
+            fingerprints.width(fingerprint_width);
+            fingerprints.reserve(table_size);
+            fingerprints.resize(table_size);
+            auto data = (char*) fingerprints.data();
+            auto size = fingerprints.stat_allocation_size_in_bytes();
+            in.read(data, size);
+        }
 
         return T {
-            std::move(displace)
+            std::move(displace),
+            fingerprint_width,
+            std::move(fingerprints),
         };
     }
+    /// NB: A displacement or fingerprint only changes along with the entry
+    /// at its position, whose bucket the storage marks as changed.
+    static object_size_t write_ranges(std::ostream& out, T const& val,
+                                      size_t table_size, delta_ranges_t const& ranges) {
+        auto bytes = serialize<displacement_table_t>::write_ranges(
+            out, val.m_displace, table_size, ranges);
+        if (fingerprinted && val.m_fingerprint_width > 0) {
+            bytes += delta_write_bits(out, val.m_fingerprints.data(),
+                                      val.m_fingerprint_width, ranges);
+        }
+        return bytes;
+    }
+
+    static void read_ranges(std::istream& in, T& val,
+                            size_t table_size, delta_ranges_t const& ranges) {
+        serialize<displacement_table_t>::read_ranges(in, val.m_displace, table_size, ranges);
+        if (fingerprinted && val.m_fingerprint_width > 0) {
+            delta_read_bits(in, val.m_fingerprints.data(),
+                            val.m_fingerprint_width, ranges);
+        }
+    }
+
     static bool equal_check(T const& lhs, T const& rhs, size_t table_size) {
-        return gen_equal_check(m_displace, table_size);
+        return gen_equal_check(m_displace, table_size)
+        && gen_equal_check(m_fingerprint_width)
+        && gen_equal_diagnostic(lhs.m_fingerprints == rhs.m_fingerprints);
     }
 };
 
@@ -11,6 +11,7 @@
 #include <tudocomp/ds/IntPtr.hpp>
 
 #include <tudocomp/util/serialization.hpp>
+#include <tudocomp/util/delta_serialization.hpp>
 
 namespace tdc {namespace compact_hash {
 
@@ -401,6 +402,11 @@ template<typename elias_gamma_bucket_size_t>
 class elias_gamma_displacement_table_t {
 public:
     using bucket_size_t = elias_gamma_bucket_size_t;
+
+    /// Whether `get()` can be called from several threads at the same time.
+    ///
+    /// NB: `get()` moves the decoding cursors below.
+    static constexpr bool concurrent_get = false;
 private:
     mutable uint64_t m_elem_cursor = 0;
     mutable uint64_t m_bit_cursor = 0;
@@ -563,12 +569,13 @@ struct serialize<compact_hash::elias_gamma_displacement_table_t<elias_gamma_buck
         return bytes;
     }
 
-    static T read(std::istream& in, size_t table_size) {
+    static T read(std::istream& in, size_t table_size,
+                  typename T::config_args const& config = typename T::config_args{}) {
         using bucket_t = compact_hash::elias_gamma_bucket_t;
         using table_t =
             compact_hash::elias_gamma_displacement_table_t<elias_gamma_bucket_size_t>;
 
-        table_t table = table_t(table_size, {});
+        table_t table = table_t(table_size, config);
         table.m_bucket_size_cache = serialize<size_t>::read(in);
         table.m_bucket_size = serialize<elias_gamma_bucket_size_t>::read(in);
 
@@ -590,6 +597,19 @@ struct serialize<compact_hash::elias_gamma_displacement_table_t<elias_gamma_buck
         return table;
     }
 
+    /// NB: The buckets are variable-length codes, which are not aligned
+    /// with the positions of the table,
+    /// so a delta contains the whole placement.
+    static object_size_t write_ranges(std::ostream& out, T const& val,
+                                      size_t table_size, delta_ranges_t const&) {
+        return write(out, val, table_size);
+    }
+
+    static void read_ranges(std::istream& in, T& val,
+                            size_t table_size, delta_ranges_t const&) {
+        val = read(in, table_size);
+    }
+
     static bool equal_check(T const& lhs, T const& rhs, size_t table_size) {
         for (size_t i = 0; i < table_size; i++) {
             if (!gen_equal_diagnostic(lhs.get(i) == rhs.get(i))) {
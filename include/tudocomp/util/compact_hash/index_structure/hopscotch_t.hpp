@@ -0,0 +1,411 @@
+#pragma once
+
+#include <limits>
+#include <type_traits>
+
+#include <tudocomp/util/bit_packed_layout_t.hpp>
+#include <tudocomp/ds/IntVector.hpp>
+#include <tudocomp/ds/IntPtr.hpp>
+
+#include "../util.hpp"
+#include "../entry_t.hpp"
+#include "../allocated_cursor_t.hpp"
+#include "../stash_t.hpp"
+
+#include <tudocomp/util/serialization.hpp>
+#include <tudocomp/util/delta_serialization.hpp>
+
+namespace tdc {namespace compact_hash {
+
+/// Hopscotch placement.
+///
+/// Every entry is stored at most `neighborhood_size - 1` slots after its
+/// initial address. Each slot keeps a bitmap of `neighborhood_size` bits,
+/// in which bit `i` is set if the slot `i` positions after it contains an
+/// entry with this slot as initial address.
+/// Thus, a search only inspects the slots marked in a single bitmap.
+///
+/// On insertion, the nearest free slot is moved towards the initial address
+/// by exchanging it with entries that stay inside their own neighborhood.
+/// In the rare case that this is not possible, the entry is put into the
+/// free slot and its initial address is remembered in a _stash_.
+///
+/// Since entries can move inside their neighborhood, the _id_ of an entry is
+/// its hashed key: `id = initial_address | (quotient << log2(table_size))`.
+template<size_t neighborhood_size = 32>
+class hopscotch_t {
+    static_assert(0 < neighborhood_size && neighborhood_size <= 64,
+                  "the neighborhood bitmap needs to fit into 64 bit");
+
+    template<typename T>
+    friend struct ::tdc::serialize;
+
+    template<typename T>
+    friend struct ::tdc::heap_size;
+
+    using hop_vec_t = IntVector<uint_t<neighborhood_size>>;
+    using hop_val_t = typename hop_vec_t::value_type;
+
+    hop_vec_t m_hop;
+    stash_t m_stash;
+
+    hopscotch_t() = default;
+
+public:
+    /// Whether several threads can walk over the entries at the same time.
+    static constexpr bool concurrent_walk = true;
+
+    /// Whether the context inserts the entries of a batch in groups,
+    /// with `lookup_insert_group()`.
+    static constexpr bool grouped_insert = false;
+
+    /// runtime initilization arguments, if any
+    struct config_args {};
+
+    /// get the config of this instance
+    inline config_args current_config() const { return config_args{}; }
+
+    inline hopscotch_t(size_t table_size, config_args config) {
+        m_hop.reserve(table_size);
+        m_hop.resize(table_size);
+    }
+
+    /// Amount of entries whose initial address is kept in the stash.
+    inline size_t stash_size() const {
+        return m_stash.size();
+    }
+
+    template<typename storage_t, typename size_mgr_t>
+    struct context_t {
+        using satellite_t = typename storage_t::satellite_t_export;
+        using entry_width_t = typename satellite_t::entry_bit_width_t;
+        using entry_t = generic_entry_t<typename satellite_t::entry_ptr_t>;
+        using table_pos_t = typename storage_t::table_pos_t;
+
+        hop_vec_t& m_hop;
+        stash_t& m_stash;
+        size_t const table_size;
+        entry_width_t widths;
+        size_mgr_t const& size_mgr;
+        storage_t& storage;
+
+        static constexpr size_t NO_POS = size_t(-1);
+
+        /// The neighborhood can not be larger than the table itself.
+        inline size_t neighborhood() const {
+            return std::min<size_t>(neighborhood_size, table_size);
+        }
+
+        inline uint64_t get_hop(size_t pos) const {
+            return uint64_t(hop_val_t(m_hop[pos]));
+        }
+
+        inline void set_hop(size_t pos, uint64_t bitmap) {
+            m_hop[pos] = bitmap;
+        }
+
+        inline uint64_t entry_id(uint64_t initial_address, uint64_t stored_quotient) const {
+            return (stored_quotient << size_mgr.capacity_log2()) | initial_address;
+        }
+
+        /// Restores the initial address of the allocated entry at `pos`.
+        inline uint64_t initial_address_at(size_t pos) {
+            for (size_t i = 0; i < neighborhood(); i++) {
+                size_t const home = size_mgr.mod_sub(pos, i);
+                if (get_hop(home) & (1ull << i)) {
+                    return home;
+                }
+            }
+
+            return m_stash.initial_address(pos);
+        }
+
+        /// Returns the position of the entry, or `NO_POS`.
+        template<typename sctx_t>
+        inline size_t search_pos(sctx_t& sctx,
+                                 uint64_t initial_address,
+                                 uint64_t stored_quotient) {
+            uint64_t bitmap = get_hop(initial_address);
+            while (bitmap != 0) {
+                size_t const pos = size_mgr.mod_add(initial_address,
+                                                    trailing_zeros(bitmap));
+                if (sctx.at(sctx.table_pos(pos)).get_quotient() == stored_quotient) {
+                    return pos;
+                }
+                bitmap &= bitmap - 1;
+            }
+
+            if (m_stash.empty()) {
+                return NO_POS;
+            }
+            return m_stash.find(initial_address, [&](size_t stashed) {
+                return sctx.at(sctx.table_pos(stashed)).get_quotient() == stored_quotient;
+            });
+        }
+
+        entry_t lookup_id(uint64_t id) {
+            uint64_t initial_address = id & (table_size - 1);
+            uint64_t stored_quotient = id >> size_mgr.capacity_log2();
+
+            return search(initial_address, stored_quotient);
+        }
+
+        entry_t lookup_insert(uint64_t initial_address,
+                              uint64_t stored_quotient)
+        {
+            auto sctx = storage.context(table_size, widths);
+            uint64_t const id = entry_id(initial_address, stored_quotient);
+
+            size_t const found_pos = search_pos(sctx, initial_address, stored_quotient);
+            if (found_pos != NO_POS) {
+                return entry_t::found_exist(id, sctx.at(sctx.table_pos(found_pos)));
+            }
+
+            // Find the nearest free slot
+            size_t hole = initial_address;
+            while (!sctx.pos_is_empty(sctx.table_pos(hole))) {
+                hole = size_mgr.mod_add(hole);
+                DCHECK_NE(hole, initial_address);
+            }
+
+            // NB: Once an entry got moved into the free slot, the hole
+            // is an allocated location whose value has been moved out.
+            bool hole_allocated = false;
+
+            // Move the hole towards the initial address
+            while (size_mgr.mod_sub(hole, initial_address) >= neighborhood()) {
+                size_t const src = move_into_hole(sctx, hole, hole_allocated);
+                if (src == NO_POS) {
+                    break;
+                }
+                hole = src;
+                hole_allocated = true;
+            }
+
+            auto pos = sctx.table_pos(hole);
+            auto ptrs = hole_allocated ? sctx.at(pos) : sctx.allocate_pos(pos);
+            if (hole_allocated) {
+                ptrs.uninitialize();
+            }
+
+            size_t const dist = size_mgr.mod_sub(hole, initial_address);
+            if (dist < neighborhood()) {
+                set_hop(initial_address, get_hop(initial_address) | (1ull << dist));
+            } else {
+                m_stash.insert(hole, initial_address);
+            }
+
+            ptrs.set_quotient(stored_quotient);
+            return entry_t::found_new(id, ptrs);
+        }
+
+        /// Moves an entry in front of `hole` into it, such that the entry
+        /// stays inside its neighborhood.
+        ///
+        /// Returns the new position of the hole, or `NO_POS` if no entry
+        /// can be moved.
+        template<typename sctx_t>
+        inline size_t move_into_hole(sctx_t& sctx, size_t hole, bool hole_allocated) {
+            // Try the initial addresses furthest away from the hole first,
+            // to make as much progress as possible.
+            for (size_t dist = neighborhood() - 1; dist > 0; dist--) {
+                size_t const home = size_mgr.mod_sub(hole, dist);
+                uint64_t const bitmap = get_hop(home);
+                uint64_t const movable = bitmap & ((1ull << dist) - 1);
+                if (movable == 0) {
+                    continue;
+                }
+
+                size_t const offset = trailing_zeros(movable);
+                size_t const src = size_mgr.mod_add(home, offset);
+
+                if (hole_allocated) {
+                    sctx.at(sctx.table_pos(hole)).move_from(sctx.at(sctx.table_pos(src)));
+                } else {
+                    auto hole_ptrs = sctx.allocate_pos(sctx.table_pos(hole));
+                    hole_ptrs.init_from(sctx.at(sctx.table_pos(src)));
+                }
+                set_hop(home, (bitmap & ~(1ull << offset)) | (1ull << dist));
+
+                return src;
+            }
+            return NO_POS;
+        }
+
+        /// Returns a cursor to the first entry visited by `for_all_allocated()`.
+        inline allocated_cursor_t first_allocated() {
+            auto sctx = storage.context(table_size, widths);
+            size_t const start = first_empty_pos(sctx);
+            return first_allocated_between(start, start);
+        }
+
+        /// Returns a cursor to the first entry between the empty
+        /// locations `start` and `end`, see `allocated_cursor_t`.
+        inline allocated_cursor_t first_allocated_between(size_t start, size_t end) {
+            allocated_cursor_t c;
+            c.start = start;
+            c.end = end;
+            c.pos = start;
+            next_allocated(c);
+            return c;
+        }
+
+        /// Advances `c` to the next entry, or sets `c.done`
+        /// at the end of its walk.
+        inline void next_allocated(allocated_cursor_t& c) {
+            auto sctx = storage.context(table_size, widths);
+
+            size_t const i = skip_empty(sctx, table_size, c, size_mgr.mod_add(c.pos));
+            if (c.done) {
+                return;
+            }
+            c.initial_address = initial_address_at(i);
+            c.pos = i;
+        }
+
+        template<typename F>
+        inline void for_all_allocated(F f) {
+            for (auto c = first_allocated(); !c.done; next_allocated(c)) {
+                f(c.initial_address, c.pos);
+            }
+        }
+
+        template<typename F>
+        inline void drain_all(F f) {
+            table_pos_t drain_start;
+            bool first = true;
+
+            for_all_allocated([&](auto initial_address, auto i) {
+                auto sctx = storage.context(table_size, widths);
+                auto p = sctx.table_pos(i);
+
+                if (first) {
+                    first = false;
+                    drain_start = p;
+                }
+
+                sctx.trim_storage(&drain_start, p);
+                f(initial_address, sctx.at(p));
+            });
+        }
+
+        inline entry_t search(uint64_t const initial_address,
+                              uint64_t stored_quotient) {
+            auto sctx = storage.context(table_size, widths);
+
+            size_t pos = search_pos(sctx, initial_address, stored_quotient);
+            if (pos == NO_POS) {
+                return entry_t::not_found();
+            }
+
+            uint64_t const id = entry_id(initial_address, stored_quotient);
+            return entry_t::found_exist(id, sctx.at(sctx.table_pos(pos)));
+        }
+
+        /// Removes the entry with the given initial address and quotient.
+        ///
+        /// Returns `true` if the entry existed.
+        inline bool erase(uint64_t const initial_address,
+                          uint64_t stored_quotient) {
+            auto sctx = storage.context(table_size, widths);
+
+            size_t pos = search_pos(sctx, initial_address, stored_quotient);
+            if (pos == NO_POS) {
+                return false;
+            }
+
+            size_t const dist = size_mgr.mod_sub(pos, initial_address);
+            if (dist < neighborhood()
+                && (get_hop(initial_address) & (1ull << dist))) {
+                set_hop(initial_address, get_hop(initial_address) & ~(1ull << dist));
+            } else {
+                m_stash.erase(pos);
+            }
+            sctx.deallocate_pos(sctx.table_pos(pos));
+
+            return true;
+        }
+    };
+    template<typename storage_t, typename size_mgr_t>
+    inline auto context(storage_t& storage,
+                        size_t table_size,
+                        typename storage_t::satellite_t_export::entry_bit_width_t const& widths,
+                        size_mgr_t const& size_mgr) {
+        return context_t<storage_t, size_mgr_t> {
+            m_hop, m_stash, table_size, widths, size_mgr, storage
+        };
+    }
+};
+
+}
+
+template<size_t neighborhood_size>
+struct heap_size<compact_hash::hopscotch_t<neighborhood_size>> {
+    using T = compact_hash::hopscotch_t<neighborhood_size>;
+
+    static object_size_t compute(T const& val, size_t table_size) {
+        auto bytes = object_size_t::empty();
+
+        DCHECK_EQ(val.m_hop.size(), table_size);
+        bytes += object_size_t::exact(val.m_hop.stat_allocation_size_in_bytes());
+
+        bytes += heap_size<compact_hash::stash_t>::compute(val.m_stash);
+
+        return bytes;
+    }
+};
+
+template<size_t neighborhood_size>
+struct serialize<compact_hash::hopscotch_t<neighborhood_size>> {
+    using T = compact_hash::hopscotch_t<neighborhood_size>;
+
+    static object_size_t write(std::ostream& out, T const& val, size_t table_size) {
+        auto bytes = object_size_t::empty();
+
+        DCHECK_EQ(val.m_hop.size(), table_size);
+
+        auto data = (char const*) val.m_hop.data();
+        auto size = val.m_hop.stat_allocation_size_in_bytes();
+        out.write(data, size);
+        bytes += object_size_t::exact(size);
+
+        bytes += serialize<compact_hash::stash_t>::write(out, val.m_stash);
+
+        return bytes;
+    }
+
+    static T read(std::istream& in, size_t table_size,
+                  typename T::config_args const& = typename T::config_args{}) {
+        T ret;
+
+        ret.m_hop.reserve(table_size);
+        ret.m_hop.resize(table_size);
+        auto data = (char*) ret.m_hop.data();
+        auto size = ret.m_hop.stat_allocation_size_in_bytes();
+        in.read(data, size);
+
+        ret.m_stash = serialize<compact_hash::stash_t>::read(in);
+
+        return ret;
+    }
+
+    /// NB: The hop bits of a home position change when an entry of its
+    /// neighborhood is inserted or moved elsewhere,
+    /// so a delta contains the whole placement.
+    static object_size_t write_ranges(std::ostream& out, T const& val,
+                                      size_t table_size, delta_ranges_t const&) {
+        return write(out, val, table_size);
+    }
+
+    static void read_ranges(std::istream& in, T& val,
+                            size_t table_size, delta_ranges_t const&) {
+        val = read(in, table_size);
+    }
+
+    static bool equal_check(T const& lhs, T const& rhs, size_t table_size) {
+        return gen_equal_diagnostic(lhs.m_hop == rhs.m_hop)
+        && serialize<compact_hash::stash_t>::equal_check(lhs.m_stash, rhs.m_stash);
+    }
+};
+
+}
@@ -10,7 +10,12 @@
 #include <tudocomp/ds/IntVector.hpp>
 #include <tudocomp/ds/IntPtr.hpp>
 
+#include <tudocomp/util/bits.hpp>
+#include <tudocomp/util/heap_size.hpp>
 #include <tudocomp/util/serialization.hpp>
+#include <tudocomp/util/delta_serialization.hpp>
+
+#include <tudocomp/util/compact_hash/page_policy.hpp>
 
 namespace tdc {namespace compact_hash {
 
@@ -51,10 +56,41 @@ struct dynamic_layered_bit_width_t {
     inline uint64_t max() const { return (1ull << m_width) - 1; }
 };
 
+/// Spills displacement values into a `std::unordered_map<size_t, size_t>`.
+///
+/// This is fast, but costs about 40 bytes or more per spilled entry.
+class unordered_map_spill_t {
+    template<typename T>
+    friend struct ::tdc::serialize;
+
+    template<typename T>
+    friend struct ::tdc::heap_size;
+
+    std::unordered_map<size_t, size_t> m_spill;
+public:
+    /// runtime initilization arguments, if any
+    struct config_args {};
+
+    /// get the config of this instance
+    inline config_args current_config() const { return config_args{}; }
+
+    unordered_map_spill_t() = default;
+    unordered_map_spill_t(size_t table_size, config_args config) {}
+
+    inline size_t get(size_t pos) {
+        DCHECK(m_spill.count(pos) != 0);
+        return m_spill[pos];
+    }
+    inline void set(size_t pos, size_t val) {
+        m_spill[pos] = val;
+    }
+};
+
 /// Stores displacement entries as integers with a bit width given by
 /// `bit_width_t`. Displacement value larger than that
-/// will be spilled into a `std::unordered_map<size_t, size_t>`.
-template<typename bit_width_t>
+/// will be spilled into a secondary structure given by `spill_t`,
+/// see also `compact_hash_spill_t`.
+template<typename bit_width_t, typename spill_t = unordered_map_spill_t>
 class layered_displacement_table_t {
     template<typename T>
     friend struct ::tdc::serialize;
@@ -66,34 +102,55 @@ class layered_displacement_table_t {
     using elem_val_t = typename IntVector<elem_t>::value_type;
 
     IntVector<elem_t> m_displace;
-    std::unordered_map<size_t, size_t> m_spill;
+    spill_t m_spill;
     bit_width_t m_bit_width;
+    bool m_transparent_huge_pages = false;
 
     layered_displacement_table_t() = default;
 public:
+    /// Whether `get()` can be called from several threads at the same time.
+    static constexpr bool concurrent_get = true;
+
     /// runtime initilization arguments, if any
     struct config_args {
         typename bit_width_t::config_args bit_width_config;
+        typename spill_t::config_args spill_config;
+        /// Whether to back the displacement array with transparent huge pages.
+        bool transparent_huge_pages = false;
     };
 
     /// get the config of this instance
     inline config_args current_config() const {
-        return config_args{ m_bit_width.current_config() };
+        return config_args{
+            m_bit_width.current_config(),
+            m_spill.current_config(),
+            m_transparent_huge_pages,
+        };
     }
 
     inline layered_displacement_table_t(size_t table_size,
                                         config_args config):
-        m_bit_width(config.bit_width_config)
+        m_spill(table_size, config.spill_config),
+        m_bit_width(config.bit_width_config),
+        m_transparent_huge_pages(config.transparent_huge_pages)
     {
         m_bit_width.set_width(m_displace);
         m_displace.reserve(table_size);
+        if (m_transparent_huge_pages) {
+            // NB: The advice needs to be given before the pages are touched.
+            advise_transparent_huge_pages(
+                m_displace.data(), (table_size * m_displace.width() + 7) / 8);
+        }
         m_displace.resize(table_size);
     }
+    /// The secondary structure of the displacements that exceed `bit_width_t`.
+    inline spill_t const& spill() const { return m_spill; }
+
     inline size_t get(size_t pos) {
         size_t max = m_bit_width.max();
         size_t tmp = elem_val_t(m_displace[pos]);
         if (tmp == max) {
-            return m_spill[pos];
+            return m_spill.get(pos);
         } else {
             return tmp;
         }
@@ -102,7 +159,7 @@ public:
         size_t max = m_bit_width.max();
         if (val >= max) {
             m_displace[pos] = max;
-            m_spill[pos] = val;
+            m_spill.set(pos, val);
         } else {
             m_displace[pos] = val;
         }
@@ -111,9 +168,9 @@ public:
 
 }
 
-template<typename bit_width_t>
-struct heap_size<compact_hash::layered_displacement_table_t<bit_width_t>> {
-    using T = compact_hash::layered_displacement_table_t<bit_width_t>;
+template<typename bit_width_t, typename spill_t>
+struct heap_size<compact_hash::layered_displacement_table_t<bit_width_t, spill_t>> {
+    using T = compact_hash::layered_displacement_table_t<bit_width_t, spill_t>;
 
     static object_size_t compute(T const& val, size_t table_size) {
         auto bytes = object_size_t::empty();
@@ -122,20 +179,15 @@ struct heap_size<compact_hash::layered_displacement_table_t<bit_width_t>> {
         auto size = val.m_displace.stat_allocation_size_in_bytes();
         bytes += object_size_t::exact(size);
         bytes += heap_size_compute(val.m_bit_width);
-
-        size_t unordered_map_size_guess
-            = sizeof(decltype(val.m_spill))
-            + val.m_spill.size() * sizeof(size_t) * 2;
-
-        bytes += object_size_t::unknown_extra_data(unordered_map_size_guess);
+        bytes += heap_size_compute(val.m_spill);
 
         return bytes;
     }
 };
 
-template<typename bit_width_t>
-struct serialize<compact_hash::layered_displacement_table_t<bit_width_t>> {
-    using T = compact_hash::layered_displacement_table_t<bit_width_t>;
+template<typename bit_width_t, typename spill_t>
+struct serialize<compact_hash::layered_displacement_table_t<bit_width_t, spill_t>> {
+    using T = compact_hash::layered_displacement_table_t<bit_width_t, spill_t>;
 
     static object_size_t write(std::ostream& out, T const& val, size_t table_size) {
         auto bytes = object_size_t::empty();
@@ -149,6 +201,78 @@ struct serialize<compact_hash::layered_displacement_table_t<bit_width_t>> {
         out.write(data, size);
         bytes += object_size_t::exact(size);
 
+        bytes += serialize_write(out, val.m_spill);
+
+        return bytes;
+    }
+
+    static T read(std::istream& in, size_t table_size,
+                  typename T::config_args const& config = typename T::config_args{}) {
+        T ret;
+        ret.m_transparent_huge_pages = config.transparent_huge_pages;
+        serialize_read_into(in, ret.m_bit_width);
+        ret.m_bit_width.set_width(ret.m_displace);
+        ret.m_displace.reserve(table_size);
+        if (ret.m_transparent_huge_pages) {
+            compact_hash::advise_transparent_huge_pages(
+                ret.m_displace.data(), (table_size * ret.m_displace.width() + 7) / 8);
+        }
+        ret.m_displace.resize(table_size);
+        auto data = (char*) ret.m_displace.data();
+        auto size = ret.m_displace.stat_allocation_size_in_bytes();
+        in.read(data, size);
+
+        serialize_read_into(in, ret.m_spill);
+
+        return ret;
+    }
+
+    /// NB: The spilled displacements are few, and written as a whole.
+    static object_size_t write_ranges(std::ostream& out, T const& val,
+                                      size_t table_size, delta_ranges_t const& ranges) {
+        auto bytes = object_size_t::empty();
+
+        DCHECK_EQ(val.m_displace.size(), table_size);
+        bytes += delta_write_bits(out, val.m_displace.data(), val.m_displace.width(), ranges);
+        bytes += serialize_write(out, val.m_spill);
+
+        return bytes;
+    }
+
+    static void read_ranges(std::istream& in, T& val,
+                            size_t table_size, delta_ranges_t const& ranges) {
+        DCHECK_EQ(val.m_displace.size(), table_size);
+        delta_read_bits(in, val.m_displace.data(), val.m_displace.width(), ranges);
+        serialize_read_into(in, val.m_spill);
+    }
+
+    static bool equal_check(T const& lhs, T const& rhs, size_t table_size) {
+        return gen_equal_diagnostic(lhs.m_displace == rhs.m_displace)
+        && gen_equal_check(m_spill)
+        && gen_equal_check(m_bit_width);
+    }
+};
+
+template<>
+struct heap_size<compact_hash::unordered_map_spill_t> {
+    using T = compact_hash::unordered_map_spill_t;
+
+    static object_size_t compute(T const& val) {
+        size_t unordered_map_size_guess
+            = sizeof(decltype(val.m_spill))
+            + val.m_spill.size() * sizeof(size_t) * 2;
+
+        return object_size_t::unknown_extra_data(unordered_map_size_guess);
+    }
+};
+
+template<>
+struct serialize<compact_hash::unordered_map_spill_t> {
+    using T = compact_hash::unordered_map_spill_t;
+
+    static object_size_t write(std::ostream& out, T const& val) {
+        auto bytes = object_size_t::empty();
+
         size_t spill_size = val.m_spill.size();
         out.write((char*) &spill_size, sizeof(size_t));
         bytes += object_size_t::exact(sizeof(size_t));
@@ -167,15 +291,8 @@ struct serialize<compact_hash::layered_displacement_table_t<bit_width_t>> {
         return bytes;
     }
 
-    static T read(std::istream& in, size_t table_size) {
+    static T read(std::istream& in) {
         T ret;
-        serialize_read_into(in, ret.m_bit_width);
-        ret.m_bit_width.set_width(ret.m_displace);
-        ret.m_displace.reserve(table_size);
-        ret.m_displace.resize(table_size);
-        auto data = (char*) ret.m_displace.data();
-        auto size = ret.m_displace.stat_allocation_size_in_bytes();
-        in.read(data, size);
 
         auto& spill = ret.m_spill;
         size_t spill_size;
@@ -193,10 +310,8 @@ struct serialize<compact_hash::layered_displacement_table_t<bit_width_t>> {
         return ret;
     }
 
-    static bool equal_check(T const& lhs, T const& rhs, size_t table_size) {
-        return gen_equal_diagnostic(lhs.m_displace == rhs.m_displace)
-        && gen_equal_diagnostic(lhs.m_spill == rhs.m_spill)
-        && gen_equal_check(m_bit_width);
+    static bool equal_check(T const& lhs, T const& rhs) {
+        return gen_equal_diagnostic(lhs.m_spill == rhs.m_spill);
     }
 };
 
@@ -19,6 +19,9 @@ struct naive_displacement_table_t {
     template<typename T>
     friend struct ::tdc::serialize;
 
+    /// Whether `get()` can be called from several threads at the same time.
+    static constexpr bool concurrent_get = true;
+
     /// runtime initilization arguments, if any
     struct config_args {};
 
@@ -0,0 +1,294 @@
+#pragma once
+
+#include <limits>
+#include <type_traits>
+
+#include "../entry_t.hpp"
+#include "../storage/shift_elements.hpp"
+#include "displacement_t.hpp"
+
+#include <tudocomp/util/serialization.hpp>
+#include <tudocomp/util/delta_serialization.hpp>
+
+namespace tdc {namespace compact_hash {
+
+/// Robin Hood placement on top of linear probing.
+///
+/// The displacement table stores the probe distance of each entry
+/// to its initial address, like in `displacement_t`. Additionally, all
+/// entries of a cluster are kept sorted by their initial address, which means:
+/// - entries with the same initial address form a contiguous run,
+/// - a search can stop as soon as it reaches an entry with a smaller
+///   probe distance than the searched one,
+/// - entries can be removed with backward-shift deletion.
+///
+/// The _id_ of an entry is its position inside its run, combined with
+/// its initial address like in `cv_bvs_t`:
+/// `id = initial_address | (local_position << log2(table_size))`.
+/// Besides on a rehash, ids change on `erase()`: the backward-shift
+/// deletion moves the later entries of the run up by one position,
+/// which decrements their local position.
+template<typename displacement_table_t>
+class robin_hood_t {
+    template<typename T>
+    friend struct ::tdc::serialize;
+
+    template<typename T>
+    friend struct ::tdc::heap_size;
+
+    displacement_table_t m_displace;
+
+    robin_hood_t(displacement_table_t&& table):
+        m_displace(std::move(table)) {}
+
+public:
+    displacement_table_t& displacement_table() { return m_displace; }
+
+    /// Whether several threads can walk over the entries at the same time.
+    static constexpr bool concurrent_walk = displacement_table_t::concurrent_get;
+
+    /// Whether the context inserts the entries of a batch in groups,
+    /// with `lookup_insert_group()`.
+    static constexpr bool grouped_insert = false;
+
+    /// runtime initilization arguments, if any
+    struct config_args {
+        typename displacement_table_t::config_args table_config;
+    };
+
+    /// get the config of this instance
+    inline config_args current_config() const {
+        return config_args { m_displace.current_config() };
+    }
+
+    inline robin_hood_t(size_t table_size, config_args config):
+        m_displace(table_size, config.table_config) {}
+
+    // NB: Iteration and draining only need the displacement of each entry,
+    // and thus work the same as for `displacement_t`.
+    template<typename storage_t, typename size_mgr_t>
+    struct context_t: displacement_t<displacement_table_t>::template context_t<storage_t, size_mgr_t> {
+        using base_t = typename displacement_t<displacement_table_t>::template context_t<storage_t, size_mgr_t>;
+        using entry_ptr_t = typename base_t::satellite_t::entry_ptr_t;
+        using entry_t = typename base_t::entry_t;
+
+        using base_t::m_displace;
+        using base_t::table_size;
+        using base_t::widths;
+        using base_t::size_mgr;
+        using base_t::storage;
+
+        inline context_t(base_t base): base_t(base) {}
+
+        inline uint64_t local_id_to_global_id(uint64_t initial_address, uint64_t local_id) {
+            local_id <<= size_mgr.capacity_log2();
+            local_id |= initial_address;
+            return local_id;
+        }
+
+        /// Finds the start of the run of entries belonging to
+        /// `initial_address`, or the position at which it would start.
+        ///
+        /// `dist` is set to the probe distance of the returned position.
+        inline size_t search_run_start(uint64_t initial_address, size_t& dist) {
+            auto sctx = storage.context(table_size, widths);
+            auto cursor = initial_address;
+            dist = 0;
+
+            // Skip entries belonging to earlier initial addresses
+            while (!sctx.pos_is_empty(sctx.table_pos(cursor))
+                   && m_displace.get(cursor) > dist) {
+                cursor = size_mgr.mod_add(cursor);
+                dist++;
+                DCHECK_NE(cursor, initial_address);
+            }
+
+            return cursor;
+        }
+
+        entry_t lookup_id(uint64_t id) {
+            uint64_t local_id = id >> size_mgr.capacity_log2();
+            uint64_t initial_address = id & ((1ull << size_mgr.capacity_log2()) - 1);
+
+            size_t dist;
+            auto run_start = search_run_start(initial_address, dist);
+            auto position = size_mgr.mod_add(run_start, local_id);
+
+            auto sctx = storage.context(table_size, widths);
+            auto sparse_entry = sctx.at(sctx.table_pos(position));
+
+            return entry_t::found_exist(id, sparse_entry);
+        }
+
+        entry_t lookup_insert(uint64_t initial_address,
+                              uint64_t stored_quotient)
+        {
+            auto sctx = storage.context(table_size, widths);
+
+            size_t dist;
+            auto const run_start = search_run_start(initial_address, dist);
+            auto cursor = run_start;
+
+            // Search the run of the initial address
+            while (!sctx.pos_is_empty(sctx.table_pos(cursor))
+                   && m_displace.get(cursor) == dist) {
+                auto ptrs = sctx.at(sctx.table_pos(cursor));
+                if (ptrs.get_quotient() == stored_quotient) {
+                    uint64_t global_id = local_id_to_global_id(
+                        initial_address, size_mgr.mod_sub(cursor, run_start));
+                    return entry_t::found_exist(global_id, ptrs);
+                }
+                cursor = size_mgr.mod_add(cursor);
+                dist++;
+                DCHECK_NE(cursor, initial_address);
+            }
+
+            // Append the new entry to the end of the run
+            uint64_t global_id = local_id_to_global_id(
+                initial_address, size_mgr.mod_sub(cursor, run_start));
+
+            auto pos = sctx.table_pos(cursor);
+            if (sctx.pos_is_empty(pos)) {
+                auto ptrs = sctx.allocate_pos(pos);
+                m_displace.set(cursor, dist);
+                ptrs.set_quotient(stored_quotient);
+                return entry_t::found_new(global_id, ptrs);
+            }
+
+            // Shift the rest of the cluster one to the right to make room
+            auto end = cursor;
+            while (!sctx.pos_is_empty(sctx.table_pos(end))) {
+                end = size_mgr.mod_add(end);
+                DCHECK_NE(end, cursor);
+            }
+            for (size_t i = end; i != cursor;) {
+                size_t next_i = size_mgr.mod_sub(i);
+                m_displace.set(i, m_displace.get(next_i) + 1);
+                i = next_i;
+            }
+            m_displace.set(cursor, dist);
+
+            auto ptrs = compact_hash::shift_elements_and_insert(sctx, cursor, end);
+            ptrs.set_quotient(stored_quotient);
+            return entry_t::found_new(global_id, ptrs);
+        }
+
+        inline entry_t search(uint64_t const initial_address,
+                              uint64_t stored_quotient) {
+            auto sctx = storage.context(table_size, widths);
+
+            size_t dist;
+            auto const run_start = search_run_start(initial_address, dist);
+            auto cursor = run_start;
+
+            // NB: The search stops at the first entry with a smaller
+            // probe distance, which belongs to a later initial address.
+            while (!sctx.pos_is_empty(sctx.table_pos(cursor))
+                   && m_displace.get(cursor) == dist) {
+                auto ptrs = sctx.at(sctx.table_pos(cursor));
+                if (ptrs.get_quotient() == stored_quotient) {
+                    uint64_t global_id = local_id_to_global_id(
+                        initial_address, size_mgr.mod_sub(cursor, run_start));
+                    return entry_t::found_exist(global_id, ptrs);
+                }
+                cursor = size_mgr.mod_add(cursor);
+                dist++;
+                DCHECK_NE(cursor, initial_address);
+            }
+
+            return entry_t::not_found();
+        }
+
+        /// Removes the entry with the given initial address and quotient
+        /// by shifting the following entries of the cluster one to the left.
+        ///
+        /// Returns `true` if the entry existed.
+        inline bool erase(uint64_t const initial_address,
+                          uint64_t stored_quotient) {
+            auto sctx = storage.context(table_size, widths);
+
+            auto r = search(initial_address, stored_quotient);
+            if (!r.found()) {
+                return false;
+            }
+
+            size_t dist;
+            auto cursor = size_mgr.mod_add(
+                search_run_start(initial_address, dist),
+                r.id() >> size_mgr.capacity_log2());
+
+            while(true) {
+                auto next = size_mgr.mod_add(cursor);
+                auto next_pos = sctx.table_pos(next);
+                if (sctx.pos_is_empty(next_pos) || m_displace.get(next) == 0) {
+                    break;
+                }
+
+                sctx.at(sctx.table_pos(cursor)).move_from(sctx.at(next_pos));
+                m_displace.set(cursor, m_displace.get(next) - 1);
+                cursor = next;
+            }
+
+            m_displace.set(cursor, 0);
+            sctx.deallocate_pos(sctx.table_pos(cursor));
+
+            return true;
+        }
+    };
+    template<typename storage_t, typename size_mgr_t>
+    inline auto context(storage_t& storage,
+                        size_t table_size,
+                        typename storage_t::satellite_t_export::entry_bit_width_t const& widths,
+                        size_mgr_t const& size_mgr) {
+        using base_t = typename context_t<storage_t, size_mgr_t>::base_t;
+        return context_t<storage_t, size_mgr_t> {
+            base_t { m_displace, table_size, widths, size_mgr, storage, nullptr }
+        };
+    }
+};
+
+}
+
+template<typename displacement_table_t>
+struct heap_size<compact_hash::robin_hood_t<displacement_table_t>> {
+    using T = compact_hash::robin_hood_t<displacement_table_t>;
+
+    static object_size_t compute(T const& val, size_t table_size) {
+        return heap_size<displacement_table_t>::compute(val.m_displace, table_size);
+    }
+};
+
+template<typename displacement_table_t>
+struct serialize<compact_hash::robin_hood_t<displacement_table_t>> {
+    using T = compact_hash::robin_hood_t<displacement_table_t>;
+
+    static object_size_t write(std::ostream& out, T const& val, size_t table_size) {
+        return serialize<displacement_table_t>::write(out, val.m_displace, table_size);
+    }
+
+    static T read(std::istream& in, size_t table_size,
+                  typename T::config_args const& config = typename T::config_args{}) {
+        auto displace =
+            serialize<displacement_table_t>::read(in, table_size, config.table_config);
+
+        return T {
+            std::move(displace)
+        };
+    }
+    static object_size_t write_ranges(std::ostream& out, T const& val,
+                                      size_t table_size, delta_ranges_t const& ranges) {
+        return serialize<displacement_table_t>::write_ranges(
+            out, val.m_displace, table_size, ranges);
+    }
+
+    static void read_ranges(std::istream& in, T& val,
+                            size_t table_size, delta_ranges_t const& ranges) {
+        serialize<displacement_table_t>::read_ranges(in, val.m_displace, table_size, ranges);
+    }
+
+    static bool equal_check(T const& lhs, T const& rhs, size_t table_size) {
+        return gen_equal_check(m_displace, table_size);
+    }
+};
+
+}
@@ -0,0 +1,242 @@
+#pragma once
+
+#include <glog/logging.h>
+
+#include <tudocomp/util/serialization.hpp>
+#include <tudocomp/util/heap_size.hpp>
+
+#include <tudocomp/util/compact_hash/map/hashmap_t.hpp>
+#include <tudocomp/util/compact_hash/hash_functions.hpp>
+#include <tudocomp/util/compact_hash/storage/buckets_bv_t.hpp>
+#include <tudocomp/util/compact_hash/index_structure/cv_bvs_t.hpp>
+
+namespace tdc {namespace compact_hash{namespace map {
+
+/// A hashmap for keys of `key_bits` bits and values of `val_bits` bits,
+/// both fixed at compile time.
+///
+/// The values are stored as `uint_t<val_bits>`, so accessing them uses
+/// constant shifts and masks, and the default hash function
+/// `static_poplar_xorshift_t` has constant primes.
+/// The quotient width still depends on the table size, and is not constant.
+///
+/// There are no methods that change the widths, so the table only
+/// reallocates when its size grows.
+template<size_t key_bits,
+         size_t val_bits,
+         typename hash_t = static_poplar_xorshift_t<key_bits>,
+         template<typename> typename storage_t = buckets_bv_t,
+         typename placement_t = cv_bvs_t>
+class fixed_width_hashmap_t {
+    static_assert(0 < key_bits && key_bits <= 64, "key_bits has to be in [1, 64]");
+    static_assert(0 < val_bits && val_bits <= 64, "val_bits has to be in [1, 64]");
+public:
+    using table_t = hashmap_t<uint_t<val_bits>, hash_t, storage_t, placement_t>;
+
+    using config_args = typename table_t::config_args;
+    using value_type = typename table_t::value_type;
+    using reference_type = typename table_t::reference_type;
+    using pointer_type = typename table_t::pointer_type;
+    using entry_t = typename table_t::entry_t;
+
+    static constexpr size_t DEFAULT_TABLE_SIZE = table_t::DEFAULT_TABLE_SIZE;
+
+private:
+    table_t m_table;
+
+    template<typename T>
+    friend struct ::tdc::serialize;
+
+    template<typename T>
+    friend struct ::tdc::heap_size;
+
+    inline fixed_width_hashmap_t(table_t&& table):
+        m_table(std::move(table)) {}
+public:
+    /// Constructs a hashtable with a initial table size `size`.
+    inline fixed_width_hashmap_t(size_t size = DEFAULT_TABLE_SIZE):
+        m_table(size, key_bits, val_bits) {}
+
+    inline fixed_width_hashmap_t(size_t size, config_args config):
+        m_table(size, key_bits, val_bits, config) {}
+
+    /// Width of the keys stored in this datastructure.
+    inline static constexpr size_t key_width() {
+        return key_bits;
+    }
+
+    /// Width of the values stored in this datastructure.
+    inline static constexpr size_t value_width() {
+        return val_bits;
+    }
+
+    /// Returns the amount of elements inside the datastructure.
+    inline size_t size() const {
+        return m_table.size();
+    }
+
+    /// Returns the current size of the hashtable.
+    inline size_t table_size() const {
+        return m_table.table_size();
+    }
+
+    /// Sets the maximum load factor
+    /// (how full the table can get before re-allocating).
+    inline void max_load_factor(float z) {
+        m_table.max_load_factor(z);
+    }
+
+    /// Returns the maximum load factor.
+    inline float max_load_factor() const noexcept {
+        return m_table.max_load_factor();
+    }
+
+    /// Inserts a key-value pair into the hashtable.
+    inline entry_t insert(uint64_t key, value_type&& value) {
+        return m_table.insert(key, std::move(value));
+    }
+
+    /// Returns a reference to the element with key `key`.
+    ///
+    /// If the value does not already exist in the table, it will be
+    /// default-constructed.
+    inline reference_type access(uint64_t key) {
+        return m_table.access(key);
+    }
+
+    /// Returns a reference to the element with key `key`.
+    ///
+    /// If the value does not already exist in the table, it will be
+    /// default-constructed.
+    inline reference_type operator[](uint64_t key) {
+        return m_table.access(key);
+    }
+
+    /// Returns an `entry_t` to the element with key `key`.
+    ///
+    /// If the value does not already exist in the table, it will be
+    /// default-constructed.
+    inline entry_t access_entry(uint64_t key) {
+        return m_table.access_entry(key);
+    }
+
+    /// Inserts `init` under the key `key` if it does not exist yet,
+    /// or otherwise replaces its value `v` with `update(v)`,
+    /// see `hashmap_t::upsert()`.
+    ///
+    /// NB: The values keep their width, so larger values are truncated.
+    template<typename F>
+    inline reference_type upsert(uint64_t key, value_type init, F update) {
+        return m_table.upsert(key, std::move(init), update);
+    }
+
+    /// Inserts `delta` under the key `key` if it does not exist yet,
+    /// or otherwise replaces its value `v` with `combine(v, delta)`,
+    /// see `hashmap_t::merge()`.
+    template<typename C>
+    inline reference_type merge(uint64_t key, value_type delta, C combine) {
+        return m_table.merge(key, std::move(delta), combine);
+    }
+
+    /// Inserts the `n` key-value pairs `keys[i]` and `values[i]`,
+    /// see `hashmap_t::insert_batch()`.
+    inline void insert_batch(uint64_t const* keys, value_type const* values, size_t n) {
+        m_table.insert_batch(keys, values, n);
+    }
+
+    /// Inserts or combines the `n` key-value pairs `keys[i]` and `values[i]`,
+    /// see `hashmap_t::upsert_batch()`.
+    template<typename C>
+    inline void upsert_batch(uint64_t const* keys, value_type const* values, size_t n, C combine) {
+        m_table.upsert_batch(keys, values, n, combine);
+    }
+
+    /// Search for a key inside the hashtable.
+    ///
+    /// This returns a pointer to the value if its found, or null
+    /// otherwise.
+    inline pointer_type search(uint64_t key) {
+        return m_table.search(key);
+    }
+
+    /// Compatibility with `std::unordered_map`.
+    inline pointer_type find(uint64_t key) {
+        return m_table.find(key);
+    }
+
+    /// Compatibility with `std::unordered_map`.
+    inline size_t count(uint64_t key) {
+        return m_table.count(key);
+    }
+
+    /// Removes the key `key` from the table, if it exists.
+    ///
+    /// Returns the number of removed elements, which is either 0 or 1.
+    inline size_t erase(uint64_t key) {
+        return m_table.erase(key);
+    }
+
+    /// Calls `f(key, value)` for each entry, see `hashmap_t::for_each()`.
+    template<typename F>
+    inline void for_each(F f) {
+        m_table.for_each(f);
+    }
+
+    /// Calls `f(key, value)` from up to `threads` threads at the same time,
+    /// see `hashmap_t::parallel_for_each()`.
+    template<typename F>
+    inline void parallel_for_each(F f, size_t threads = std::max<size_t>(std::thread::hardware_concurrency(), 1)) {
+        m_table.parallel_for_each(f, threads);
+    }
+
+    /// Reduces all entries to one `T`, see `hashmap_t::parallel_reduce()`.
+    template<typename T, typename F, typename C>
+    inline T parallel_reduce(T identity, F f, C combine,
+                             size_t threads = std::max<size_t>(std::thread::hardware_concurrency(), 1)) {
+        return m_table.parallel_reduce(std::move(identity), f, combine, threads);
+    }
+
+    /// Returns all entries as a range, see `hashmap_t::entries()`.
+    inline typename table_t::entry_range_t entries() {
+        return m_table.entries();
+    }
+
+    /// The underlying table, for the operations that do not change its widths.
+    inline table_t const& table() const {
+        return m_table;
+    }
+};
+
+}}
+
+template<size_t key_bits, size_t val_bits, typename hash_t, template<typename> typename storage_t, typename placement_t>
+struct heap_size<compact_hash::map::fixed_width_hashmap_t<key_bits, val_bits, hash_t, storage_t, placement_t>> {
+    using T = compact_hash::map::fixed_width_hashmap_t<key_bits, val_bits, hash_t, storage_t, placement_t>;
+
+    static object_size_t compute(T const& val) {
+        return heap_size<typename T::table_t>::compute(val.m_table);
+    }
+};
+
+/// NB: Uses the format of the underlying `hashmap_t`, and checks
+/// on reading that the widths match.
+template<size_t key_bits, size_t val_bits, typename hash_t, template<typename> typename storage_t, typename placement_t>
+struct serialize<compact_hash::map::fixed_width_hashmap_t<key_bits, val_bits, hash_t, storage_t, placement_t>> {
+    using T = compact_hash::map::fixed_width_hashmap_t<key_bits, val_bits, hash_t, storage_t, placement_t>;
+    using table_t = typename T::table_t;
+
+    static object_size_t write(std::ostream& out, T const& val) {
+        return serialize<table_t>::write(out, val.m_table);
+    }
+    static T read(std::istream& in) {
+        auto table = serialize<table_t>::read(in);
+        CHECK_EQ(table.key_width(), key_bits);
+        CHECK_EQ(table.value_width(), val_bits);
+        return T(std::move(table));
+    }
+    static bool equal_check(T const& lhs, T const& rhs) {
+        return gen_equal_check(m_table);
+    }
+};
+
+}
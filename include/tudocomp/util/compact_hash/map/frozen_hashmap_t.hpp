@@ -0,0 +1,118 @@
+#pragma once
+
+#include <cstring>
+#include <memory>
+#include <sstream>
+#include <string>
+
+#include <tudocomp/util/heap_size.hpp>
+#include <tudocomp/util/compact_hash/map/hashmap_view_t.hpp>
+
+namespace tdc {namespace compact_hash{namespace map {
+
+/// An immutable hashmap with integer values, built by `freeze()`
+/// from a populated `hashmap_t`.
+///
+/// It owns the representation of `hashmap_view_t` in memory: the
+/// occupied slots as a bit vector with rank samples, and the displacements,
+/// quotients and values of the occupied slots packed in slot order.
+/// This is usually considerably smaller than the `hashmap_t`
+/// it was built from.
+///
+/// All operations are `const`, so concurrent readers need no synchronization.
+/// `write()` stores the representation, which can be queried later
+/// with a `hashmap_view_t` directly from a file mapped with `mmap_file_t`.
+template<typename hash_t = poplar_xorshift_t>
+class frozen_hashmap_t {
+    std::unique_ptr<uint64_t[]> m_data;
+    size_t m_size_in_bytes;
+    hashmap_view_t<hash_t> m_view;
+
+    template<typename T>
+    friend struct ::tdc::heap_size;
+
+    inline static std::unique_ptr<uint64_t[]> copy_words(std::string const& bytes) {
+        auto data = std::make_unique<uint64_t[]>((bytes.size() + 7) / 8);
+        memcpy(data.get(), bytes.data(), bytes.size());
+        return data;
+    }
+
+    inline frozen_hashmap_t(std::string const& bytes):
+        m_data(copy_words(bytes)),
+        m_size_in_bytes(bytes.size()),
+        m_view(m_data.get(), m_size_in_bytes) {}
+public:
+    /// Builds the frozen representation of `table`,
+    /// which can be any `hashmap_t` with integer values or any `hashset_t`.
+    template<typename table_t>
+    inline static frozen_hashmap_t build(table_t& table) {
+        std::stringstream out;
+        hashmap_view_t<hash_t>::write(out, table);
+        return frozen_hashmap_t(out.str());
+    }
+
+    /// Returns the amount of elements inside the datastructure.
+    inline size_t size() const {
+        return m_view.size();
+    }
+
+    /// Returns the size of the hashtable.
+    inline size_t table_size() const {
+        return m_view.table_size();
+    }
+
+    /// Width of the keys stored in this datastructure.
+    inline size_t key_width() const {
+        return m_view.key_width();
+    }
+
+    /// Width of the values stored in this datastructure.
+    inline size_t value_width() const {
+        return m_view.value_width();
+    }
+
+    /// Search for a key inside the hashtable.
+    ///
+    /// Returns `true` and sets `value` if the key is found.
+    inline bool search(uint64_t key, uint64_t& value) const {
+        return m_view.search(key, value);
+    }
+
+    /// Count the number of occurrences of `key`, as defined on STL containers.
+    ///
+    /// It will return either 0 or 1.
+    inline size_t count(uint64_t key) const {
+        return m_view.count(key);
+    }
+
+    /// The view of the representation.
+    inline hashmap_view_t<hash_t> const& view() const {
+        return m_view;
+    }
+
+    /// Writes the representation to `out`,
+    /// such that it can be opened with a `hashmap_view_t`.
+    inline object_size_t write(std::ostream& out) const {
+        out.write((char const*) m_data.get(), m_size_in_bytes);
+        return object_size_t::exact(m_size_in_bytes);
+    }
+};
+
+/// Builds an immutable `frozen_hashmap_t` from `map`, which stays unchanged.
+template<typename val_t, typename hash_t, template<typename> typename storage_t, typename placement_t>
+inline frozen_hashmap_t<hash_t> freeze(hashmap_t<val_t, hash_t, storage_t, placement_t>& map) {
+    return frozen_hashmap_t<hash_t>::build(map);
+}
+
+}}
+
+template<typename hash_t>
+struct heap_size<compact_hash::map::frozen_hashmap_t<hash_t>> {
+    using T = compact_hash::map::frozen_hashmap_t<hash_t>;
+
+    static object_size_t compute(T const& val) {
+        return object_size_t::exact(sizeof(T) + (val.m_size_in_bytes + 7) / 8 * 8);
+    }
+};
+
+}
@@ -1,17 +1,33 @@
 #pragma once
 
+#include <iterator>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
 #include <glog/logging.h>
 
 #include <tudocomp/util/compact_hash/util.hpp>
 #include <tudocomp/util/compact_hash/size_manager_t.hpp>
+#include <tudocomp/util/compact_hash/allocated_cursor_t.hpp>
 #include <tudocomp/util/serialization.hpp>
+#include <tudocomp/util/bits.hpp>
 
 #include <tudocomp/util/compact_hash/map/satellite_data_t.hpp>
 
 #include <tudocomp/util/serialization.hpp>
+#include <tudocomp/util/chunked_serialization.hpp>
+#include <tudocomp/util/delta_serialization.hpp>
 
 namespace tdc {namespace compact_hash{namespace map {
 
+template<typename hash_t>
+class hashmap_view_t;
+
+template<typename hash_t>
+class perfect_hashmap_t;
+
 template<typename val_t, typename hash_t, template<typename> typename storage_t, typename placement_t>
 class hashmap_t {
     using storage_app_t = storage_t<satellite_data_t<val_t>>;
@@ -35,6 +51,17 @@ public:
         return r;
     }
 
+    /// Marks all buckets of the storage as unchanged, and starts tracking
+    /// changes if `storage_config.track_dirty` was not set.
+    ///
+    /// Call this after writing or loading a full snapshot, such that
+    /// `tdc::serialize_delta` only writes the buckets changed since then.
+    ///
+    /// NB: Only supported by storages that track changes (`buckets_bv_t`).
+    inline void clear_dirty() {
+        m_storage.clear_dirty(table_size());
+    }
+
     /// By-value representation of a value
     using value_type = typename cbp::cbp_repr_t<val_t>::value_type;
     /// Reference to a value
@@ -185,6 +212,19 @@ public:
         return result;
     }
 
+    /// Inserts a value constructed from `args` under the key `key`,
+    /// if the key does not exist yet.
+    ///
+    /// The value is constructed directly in its slot, without a
+    /// temporary value to move from. An existing value is left unchanged,
+    /// which the `key_already_exist()` of the returned `entry_t` tells.
+    /// For values of runtime width (`dynamic_t`), the value width grows
+    /// as needed to fit the new value.
+    template<typename... Args>
+    inline entry_t emplace(uint64_t key, Args&&... args) {
+        return emplace_entry(has_dynamic_values(), key, std::forward<Args>(args)...);
+    }
+
     /// Returns a reference to the element with key `key`.
     ///
     /// If the value does not already exist in the table, it will be
@@ -242,7 +282,7 @@ public:
         auto result = grow_and_insert(key, raw_key_width, raw_val_width);
 
         if (!result.key_already_exist()) {
-            result.ptr().set_val_no_drop(value_type());
+            result.ptr().emplace_val_no_drop();
         }
 
         pointer_type addr = result.ptr().val_ptr();
@@ -257,6 +297,84 @@ public:
         return access(key);
     }
 
+    /// Inserts `init` under the key `key` if it does not exist yet,
+    /// or otherwise replaces its value `v` with `update(v)`.
+    ///
+    /// Looks up or creates the entry with a single probe, and never
+    /// default-constructs a value. For values of runtime width (`dynamic_t`),
+    /// the value width grows as needed to fit `init` or the updated value.
+    ///
+    /// Returns a reference to the value.
+    template<typename F>
+    inline reference_type upsert(uint64_t key, value_type init, F update) {
+        auto const init_width = needed_value_width(init, has_dynamic_values());
+        auto raw_val_width = std::max<size_t>(init_width, value_width());
+
+        auto result = grow_and_insert(key, key_width(), raw_val_width);
+        pointer_type addr = result.ptr().val_ptr();
+        DCHECK(addr != pointer_type());
+
+        if (!result.key_already_exist()) {
+            result.ptr().set_val_no_drop(std::move(init));
+            return *addr;
+        }
+
+        value_type value = update(value_type(*addr));
+        auto const width = needed_value_width(value, has_dynamic_values());
+        if (width > value_width()) {
+            // NB: Growing reallocates the table, which moves the entry.
+            grow_if_needed(size(), key_width(), width);
+            addr = search(key);
+        }
+        *addr = std::move(value);
+        return *addr;
+    }
+
+    /// Inserts `delta` under the key `key` if it does not exist yet,
+    /// or otherwise replaces its value `v` with `combine(v, delta)`.
+    ///
+    /// For example, `merge(key, 1, std::plus<uint64_t>())` counts
+    /// the occurrences of `key`. See `upsert()`.
+    template<typename C>
+    inline reference_type merge(uint64_t key, value_type delta, C combine) {
+        return upsert(key, delta, [&](value_type value) {
+            return combine(std::move(value), delta);
+        });
+    }
+
+    /// Inserts the `n` key-value pairs `keys[i]` and `values[i]`,
+    /// like calling `insert()` for each of them in order.
+    ///
+    /// Hashes the whole batch at once, and decides about growing the table
+    /// once for the batch, with room for `n` new keys. The pairs are
+    /// partitioned by ranges of initial addresses, and inserted one
+    /// partition after the other, such that all inserts into the same
+    /// bucket happen while it is in the cache. Placements with
+    /// `grouped_insert` (`displacement_t`) insert the new keys of a
+    /// partition at once, with one reallocation per bucket of the storage.
+    /// For values of runtime width (`dynamic_t`), the value width grows to
+    /// fit the largest value.
+    ///
+    /// NB: A batch with many keys that already exist can grow the table
+    /// earlier than inserting its pairs one by one.
+    inline void insert_batch(uint64_t const* keys, value_type const* values, size_t n) {
+        apply_batch(keys, values, n, [](value_type, value_type const& value) {
+            return value;
+        });
+    }
+
+    /// Inserts the `n` key-value pairs `keys[i]` and `values[i]` like
+    /// `insert_batch()`, but replaces the value `v` of an existing key
+    /// with `combine(v, values[i])`, like `merge()`.
+    ///
+    /// Pairs with the same key are combined in the order of the batch.
+    template<typename C>
+    inline void upsert_batch(uint64_t const* keys, value_type const* values, size_t n, C combine) {
+        apply_batch(keys, values, n, [&](value_type old_value, value_type const& value) {
+            return combine(std::move(old_value), value);
+        });
+    }
+
     /// Grow the key width as needed.
     ///
     /// Note that it is more efficient to change the width directly during
@@ -280,14 +398,36 @@ public:
     ///
     /// This returns a pointer to the value if its found, or null
     /// otherwise.
+    ///
+    /// NB: The value can be changed through the returned pointer, so if
+    /// the storage tracks changes for delta snapshots, the search counts as
+    /// a change of the buckets it inspects, see `serialize_delta`.
+    /// Use `count()` for lookups that do not.
     inline pointer_type search(uint64_t key) {
+        if (m_storage.tracks_dirty()) {
+            return search_in(m_storage, key);
+        } else {
+            storage_app_t const& storage = m_storage;
+            return search_in(storage, key);
+        }
+    }
+
+    /// Removes the element with key `key` from the hashtable, if it exists.
+    ///
+    /// Returns the number of removed elements, which is either 0 or 1.
+    /// This requires a placement that supports deletion, like `robin_hood_t`.
+    ///
+    /// With `robin_hood_t`, this invalidates the ids of the entries
+    /// with the same initial address, since the backward-shift deletion
+    /// changes their local positions.
+    inline size_t erase(uint64_t key) {
         auto dkey = decompose_key(key);
         auto pctx = m_placement.context(m_storage, table_size(), storage_widths(), m_sizing);
-        auto r = pctx.search(dkey.initial_address, dkey.stored_quotient);
-        if (r.found()) {
-            return r.ptr().val_ptr();
+        if (pctx.erase(dkey.initial_address, dkey.stored_quotient)) {
+            m_sizing.set_size(m_sizing.size() - 1);
+            return 1;
         } else {
-            return pointer_type();
+            return 0;
         }
     }
 
@@ -320,6 +460,143 @@ public:
         });
     }
 
+    /// Calls `f(key, value)` for each entry of the hashtable,
+    /// where `value` is a `reference_type`.
+    ///
+    /// The keys are composed from their quotients on the fly, and are
+    /// visited in no particular order. `f` may change the values, but
+    /// must not insert or remove entries.
+    template<typename F>
+    inline void for_each(F f) {
+        auto pctx = m_placement.context(m_storage, table_size(), storage_widths(), m_sizing);
+        auto sctx = m_storage.context(table_size(), storage_widths());
+        pctx.for_all_allocated([&](auto initial_address, auto pos) {
+            auto ptr = sctx.at(sctx.table_pos(pos));
+            f(this->compose_key(initial_address, ptr.get_quotient()), *ptr.val_ptr());
+        });
+    }
+
+    /// Calls `f(key, value)` for each entry of the hashtable like
+    /// `for_each()`, but from up to `threads` threads at the same time.
+    ///
+    /// The table is split at empty locations into ranges that can be
+    /// decoded on their own, and each thread walks one of them, so `f`
+    /// needs to be safe to call concurrently. Unlike in `for_each()`, `f`
+    /// must not change the values, since neighbouring bit-packed values
+    /// of two ranges can share a word. Walks on one thread if the
+    /// placement can not be read concurrently (`elias_gamma_displacement_table_t`),
+    /// or if the storage tracks changed buckets.
+    template<typename F>
+    inline void parallel_for_each(F f, size_t threads = std::max<size_t>(std::thread::hardware_concurrency(), 1)) {
+        auto const bounds = walk_bounds(threads);
+        chunked_format_t::parallel_for(0, bounds.size(), bounds.size(), [&](size_t i) {
+            for_each_between(bounds[i], bounds[(i + 1) % bounds.size()], f);
+        });
+    }
+
+    /// Reduces all entries of the hashtable to one `T` from up to
+    /// `threads` threads at the same time, see `parallel_for_each()`.
+    ///
+    /// Each thread starts with a copy of `identity` and calls
+    /// `f(acc, key, value)` for each entry of its range, where `acc` is
+    /// a `T&`. The results of the threads are then merged one by one
+    /// with `acc = combine(std::move(acc), std::move(other))`.
+    template<typename T, typename F, typename C>
+    inline T parallel_reduce(T identity, F f, C combine,
+                             size_t threads = std::max<size_t>(std::thread::hardware_concurrency(), 1)) {
+        auto const bounds = walk_bounds(threads);
+        std::vector<T> partial(bounds.size(), identity);
+        chunked_format_t::parallel_for(0, bounds.size(), bounds.size(), [&](size_t i) {
+            auto& acc = partial[i];
+            auto g = [&](uint64_t key, reference_type value) {
+                f(acc, key, value);
+            };
+            for_each_between(bounds[i], bounds[(i + 1) % bounds.size()], g);
+        });
+
+        T result = std::move(identity);
+        for (auto& other : partial) {
+            result = combine(std::move(result), std::move(other));
+        }
+        return result;
+    }
+
+    /// Forward iterator over the entries of the hashtable, see `entries()`.
+    ///
+    /// Dereferencing it yields a pair of the key, composed from its
+    /// quotient on the fly, and a `reference_type` to the value.
+    /// Inserting or removing entries invalidates all iterators.
+    class iterator_t {
+        hashmap_t* m_table = nullptr;
+        allocated_cursor_t m_cursor;
+
+        friend class hashmap_t;
+
+        inline iterator_t(hashmap_t& table, allocated_cursor_t cursor):
+            m_table(&table), m_cursor(cursor) {}
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = std::pair<uint64_t, typename cbp::cbp_repr_t<val_t>::value_type>;
+        using reference = std::pair<uint64_t, reference_type>;
+        using pointer = void;
+        using difference_type = std::ptrdiff_t;
+
+        /// The end iterator.
+        inline iterator_t() {
+            m_cursor.done = true;
+        }
+
+        inline reference operator*() const {
+            auto& t = *m_table;
+            auto sctx = t.m_storage.context(t.table_size(), t.storage_widths());
+            auto ptr = sctx.at(sctx.table_pos(m_cursor.pos));
+            return reference {
+                t.compose_key(m_cursor.initial_address, ptr.get_quotient()),
+                *ptr.val_ptr(),
+            };
+        }
+
+        inline iterator_t& operator++() {
+            auto& t = *m_table;
+            auto pctx = t.m_placement.context(t.m_storage, t.table_size(), t.storage_widths(), t.m_sizing);
+            pctx.next_allocated(m_cursor);
+            return *this;
+        }
+
+        inline iterator_t operator++(int) {
+            auto r = *this;
+            ++*this;
+            return r;
+        }
+
+        inline friend bool operator==(iterator_t const& lhs, iterator_t const& rhs) {
+            return lhs.m_cursor.done == rhs.m_cursor.done
+                && (lhs.m_cursor.done || lhs.m_cursor.pos == rhs.m_cursor.pos);
+        }
+
+        inline friend bool operator!=(iterator_t const& lhs, iterator_t const& rhs) {
+            return !(lhs == rhs);
+        }
+    };
+
+    /// The entries of the hashtable as a range for range-based for loops
+    /// and STL algorithms.
+    ///
+    /// NB: `end()` of the hashtable itself is the null pointer
+    /// returned by `find()`, so the iterators live in this range.
+    struct entry_range_t {
+        iterator_t m_begin;
+
+        inline iterator_t begin() const { return m_begin; }
+        inline iterator_t end() const { return iterator_t(); }
+    };
+
+    /// Returns all entries of the hashtable as a range, see `iterator_t`.
+    inline entry_range_t entries() {
+        auto pctx = m_placement.context(m_storage, table_size(), storage_widths(), m_sizing);
+        return entry_range_t { iterator_t(*this, pctx.first_allocated()) };
+    }
+
     /// Check wether for the `new_size` this hashtable would need
     /// to perform a grow of the capacity
     inline bool needs_to_grow_capacity(size_t new_size) const {
@@ -360,9 +637,11 @@ public:
 
     /// Count the number of occurrences of `key`, as defined on STL containers.
     ///
-    /// It will return either 0 or 1.
+    /// It will return either 0 or 1. This is a lookup, and does not
+    /// count as a change for delta snapshots.
     inline size_t count(uint64_t key) {
-        return search(key) != pointer_type();
+        storage_app_t const& storage = m_storage;
+        return search_in(storage, key) != pointer_type();
     }
 
     inline std::string debug_print_storage() {
@@ -417,6 +696,18 @@ private:
     template<typename T>
     friend struct ::tdc::heap_size;
 
+    template<typename T>
+    friend struct ::tdc::serialize_chunked;
+
+    template<typename T>
+    friend struct ::tdc::serialize_delta;
+
+    template<typename T>
+    friend class hashmap_view_t;
+
+    template<typename T>
+    friend class perfect_hashmap_t;
+
     /// The actual amount of bits currently usable for
     /// storing a key in the hashtable.
     ///
@@ -438,6 +729,20 @@ private:
         return { uint8_t(quotient_width()), uint8_t(value_width()) };
     }
 
+    /// Whether the width of the values is set at runtime,
+    /// and can grow to fit larger values.
+    using has_dynamic_values = std::is_same<val_t, dynamic_t>;
+
+    /// Amount of bits needed to store `value`, or 0 for
+    /// values whose width does not change.
+    inline static size_t needed_value_width(uint64_t value, std::true_type) {
+        return bits_for(value);
+    }
+    template<typename T>
+    inline static size_t needed_value_width(T const&, std::false_type) {
+        return 0;
+    }
+
     /// Debug check that a key does not occupy more bits than the
     /// hashtable currently allows.
     inline bool dcheck_key_width(uint64_t key) {
@@ -457,6 +762,20 @@ private:
         return m_sizing.decompose_hashed_value(hres);
     }
 
+    /// Searches `key` in `storage`, which is either `m_storage`
+    /// or a const reference to it.
+    template<typename storage_ref_t>
+    inline pointer_type search_in(storage_ref_t& storage, uint64_t key) {
+        auto dkey = decompose_key(key);
+        auto pctx = m_placement.context(storage, table_size(), storage_widths(), m_sizing);
+        auto r = pctx.search(dkey.initial_address, dkey.stored_quotient);
+        if (r.found()) {
+            return r.ptr().val_ptr();
+        } else {
+            return pointer_type();
+        }
+    }
+
 public: // need direct access to compose_key to restore the key from an entry's quotient
     /// Compose a key from its initial address and quotient.
     inline uint64_t compose_key(uint64_t initial_address, uint64_t quotient) {
@@ -468,6 +787,28 @@ public: // need direct access to compose_key to restore the key from an entry's
     }
 private:
 
+    /// Returns the empty locations at which `parallel_for_each()`
+    /// splits the table into up to `threads` ranges.
+    inline std::vector<size_t> walk_bounds(size_t threads) {
+        if (!placement_t::concurrent_walk || m_storage.tracks_dirty()) {
+            threads = 1;
+        }
+        auto sctx = m_storage.context(table_size(), storage_widths());
+        return split_at_empty(sctx, table_size(), std::max<size_t>(threads, 1));
+    }
+
+    /// Calls `f(key, value)` for each entry between the
+    /// empty locations `start` and `end`.
+    template<typename F>
+    inline void for_each_between(size_t start, size_t end, F& f) {
+        auto pctx = m_placement.context(m_storage, table_size(), storage_widths(), m_sizing);
+        auto sctx = m_storage.context(table_size(), storage_widths());
+        for (auto c = pctx.first_allocated_between(start, end); !c.done; pctx.next_allocated(c)) {
+            auto ptr = sctx.at(sctx.table_pos(c.pos));
+            f(this->compose_key(c.initial_address, ptr.get_quotient()), *ptr.val_ptr());
+        }
+    }
+
     /// Run the destructors of the bucket elements,
     /// but don't drop them from the table.
     ///
@@ -507,6 +848,173 @@ private:
         return result;
     }
 
+    template<typename... Args>
+    inline entry_t emplace_entry(std::false_type, uint64_t key, Args&&... args) {
+        auto result = grow_and_insert(key, key_width(), value_width());
+        if (!result.key_already_exist()) {
+            result.ptr().emplace_val_no_drop(std::forward<Args>(args)...);
+        }
+        return result;
+    }
+    template<typename... Args>
+    inline entry_t emplace_entry(std::true_type, uint64_t key, Args&&... args) {
+        // NB: The width of a bit-packed value is only known
+        // after constructing it.
+        value_type value(std::forward<Args>(args)...);
+        auto const width = std::max<size_t>(bits_for(value), value_width());
+        auto result = grow_and_insert(key, key_width(), width);
+        if (!result.key_already_exist()) {
+            result.ptr().set_val_no_drop(std::move(value));
+        }
+        return result;
+    }
+
+    /// Inserts `values[i]` under `keys[i]` for the new keys of the batch,
+    /// and replaces the value `v` of an existing one with `update(v, values[i])`.
+    ///
+    /// See `insert_batch()`.
+    template<typename F>
+    inline void apply_batch(uint64_t const* keys, value_type const* values, size_t n, F update) {
+        if (n == 0) {
+            return;
+        }
+
+        size_t raw_val_width = value_width();
+        for (size_t i = 0; i < n; i++) {
+            DCHECK(dcheck_key_width(keys[i])) << "Attempt to insert key " << keys[i] << ", which requires more than the current set maximum of " << key_width() << " bits, but should not.";
+            raw_val_width = std::max(raw_val_width, needed_value_width(values[i], has_dynamic_values()));
+        }
+        grow_if_needed(size() + n, key_width(), raw_val_width);
+
+        std::vector<uint64_t> hashes(n);
+        m_hash.hash_batch(keys, hashes.data(), n);
+
+        std::vector<size_t> group_ends;
+        auto const order = batch_order(hashes, group_ends);
+        apply_batch_groups(keys, values, hashes, order, group_ends, update,
+                           std::integral_constant<bool, placement_t::grouped_insert>());
+    }
+
+    /// Inserts the batch one pair after the other.
+    template<typename F>
+    inline void apply_batch_groups(uint64_t const* keys,
+                                   value_type const* values,
+                                   std::vector<uint64_t> const& hashes,
+                                   std::vector<size_t> const& order,
+                                   std::vector<size_t> const&,
+                                   F update,
+                                   std::false_type) {
+        for (size_t i : order) {
+            auto const dkey = m_sizing.decompose_hashed_value(hashes[i]);
+            auto pctx = m_placement.context(m_storage, table_size(), storage_widths(), m_sizing);
+            auto result = pctx.lookup_insert(dkey.initial_address, dkey.stored_quotient);
+
+            if (!result.key_already_exist()) {
+                m_sizing.set_size(m_sizing.size() + 1);
+                result.ptr().set_val_no_drop(value_type(values[i]));
+                continue;
+            }
+
+            update_batch_value(keys[i], result.ptr().val_ptr(), values[i], update);
+        }
+    }
+
+    /// Inserts the new keys of each group of the batch at once, see
+    /// `lookup_insert_group()` of the placement, and then updates the
+    /// values of the existing keys in the order of the group.
+    template<typename F>
+    inline void apply_batch_groups(uint64_t const* keys,
+                                   value_type const* values,
+                                   std::vector<uint64_t> const& hashes,
+                                   std::vector<size_t> const& order,
+                                   std::vector<size_t> const& group_ends,
+                                   F update,
+                                   std::true_type) {
+        std::vector<uint64_t> initial_addresses;
+        std::vector<uint64_t> stored_quotients;
+
+        size_t begin = 0;
+        for (size_t end : group_ends) {
+            if (begin == end) {
+                continue;
+            }
+
+            initial_addresses.clear();
+            stored_quotients.clear();
+            for (size_t j = begin; j < end; j++) {
+                auto const dkey = m_sizing.decompose_hashed_value(hashes[order[j]]);
+                initial_addresses.push_back(dkey.initial_address);
+                stored_quotients.push_back(dkey.stored_quotient);
+            }
+
+            auto pctx = m_placement.context(m_storage, table_size(), storage_widths(), m_sizing);
+            auto const existing = pctx.lookup_insert_group(
+                initial_addresses.data(), stored_quotients.data(), end - begin,
+                [&](size_t k, auto ptrs) {
+                    m_sizing.set_size(m_sizing.size() + 1);
+                    ptrs.set_val_no_drop(value_type(values[order[begin + k]]));
+                });
+
+            for (size_t k : existing) {
+                size_t const i = order[begin + k];
+                auto const dkey = m_sizing.decompose_hashed_value(hashes[i]);
+                auto pctx = m_placement.context(m_storage, table_size(), storage_widths(), m_sizing);
+                auto result = pctx.lookup_insert(dkey.initial_address, dkey.stored_quotient);
+                DCHECK(result.key_already_exist());
+
+                update_batch_value(keys[i], result.ptr().val_ptr(), values[i], update);
+            }
+
+            begin = end;
+        }
+    }
+
+    /// Replaces the value `*addr` of the existing key `key` with `update(*addr, value)`.
+    template<typename F>
+    inline void update_batch_value(uint64_t key, pointer_type addr, value_type const& value, F update) {
+        value_type new_value = update(value_type(*addr), value);
+        auto const width = needed_value_width(new_value, has_dynamic_values());
+        if (width > value_width()) {
+            // NB: Only the value width changes, so the table keeps its
+            // size and the hashes of the batch stay valid.
+            grow_if_needed(size(), key_width(), width);
+            addr = search(key);
+        }
+        *addr = std::move(new_value);
+    }
+
+    /// Returns the order in which to insert the batch with the hash values `hashes`.
+    ///
+    /// Partitions the batch by ranges of initial addresses, with at least
+    /// one bucket of the storage per range, and keeps the order of the
+    /// batch inside a partition. The end of each partition in the order
+    /// is stored in `group_ends`.
+    inline std::vector<size_t> batch_order(std::vector<uint64_t> const& hashes,
+                                           std::vector<size_t>& group_ends) const {
+        size_t const n = hashes.size();
+        size_t const address_width = m_sizing.capacity_log2();
+        size_t const range_width = std::min<size_t>(address_width, 6);
+        size_t const part_width = std::min<size_t>(address_width - range_width, bits_for(n));
+        size_t const shift = address_width - part_width;
+        uint64_t const address_mask = (1ull << address_width) - 1;
+
+        std::vector<size_t> offsets((size_t(1) << part_width) + 1);
+        for (uint64_t hres : hashes) {
+            offsets[((hres & address_mask) >> shift) + 1]++;
+        }
+        for (size_t p = 1; p < offsets.size(); p++) {
+            offsets[p] += offsets[p - 1];
+        }
+
+        std::vector<size_t> order(n);
+        for (size_t i = 0; i < n; i++) {
+            order[offsets[(hashes[i] & address_mask) >> shift]++] = i;
+        }
+        offsets.pop_back();
+        group_ends = std::move(offsets);
+        return order;
+    }
+
     /// Check the current key width and table site against the arguments,
     /// and grows the table or quotient bitvectors as needed.
     inline void grow_if_needed(size_t const new_size,
@@ -594,7 +1102,14 @@ struct serialize<compact_hash::map::hashmap_t<val_t, hash_t, storage_t, placemen
 
         return bytes;
     }
-    static T read(std::istream& in) {
+    /// Reads a hashmap written by `write()`.
+    ///
+    /// The storage config is not serialized, so the table uses
+    /// `config.storage_config`, e.g. the directory of a file-backed
+    /// allocation. Likewise, whether the placement advises transparent
+    /// huge pages is taken from `config.displacement_config`.
+    /// The other parts of `config` are read from the stream.
+    static T read(std::istream& in, typename T::config_args const& config = typename T::config_args{}) {
         using namespace compact_hash::map;
         using namespace compact_hash;
 
@@ -609,8 +1124,8 @@ struct serialize<compact_hash::map::hashmap_t<val_t, hash_t, storage_t, placemen
         ret.m_val_width = std::move(val_width);
         ret.m_hash = std::move(hash);
 
-        auto storage = serialize<typename T::storage_app_t>::read(in, ret.table_size(), ret.storage_widths());
-        auto placement = serialize<placement_t>::read(in, ret.table_size());
+        auto storage = serialize<typename T::storage_app_t>::read(in, ret.table_size(), ret.storage_widths(), config.storage_config);
+        auto placement = serialize<placement_t>::read(in, ret.table_size(), config.displacement_config);
 
         ret.m_storage = std::move(storage);
         ret.m_placement = std::move(placement);
@@ -640,4 +1155,197 @@ struct serialize<compact_hash::map::hashmap_t<val_t, hash_t, storage_t, placemen
     }
 };
 
+/// Writes the hashmap as a chunked container.
+///
+/// The first chunk contains everything except the slots of the storage,
+/// which are split into chunks of `chunked_config_t::units_per_chunk`
+/// units each.
+template<typename val_t, typename hash_t, template<typename> typename storage_t, typename placement_t>
+struct serialize_chunked<compact_hash::map::hashmap_t<val_t, hash_t, storage_t, placement_t>> {
+    using T = compact_hash::map::hashmap_t<val_t, hash_t, storage_t, placement_t>;
+    using storage_serialize_t = serialize<typename T::storage_app_t>;
+
+    static object_size_t write(std::ostream& out, T const& val, chunked_config_t const& config = chunked_config_t()) {
+        using namespace compact_hash;
+
+        CHECK_GT(config.units_per_chunk, 0u);
+
+        auto const table_size = val.table_size();
+        auto const widths = val.storage_widths();
+        uint64_t const units_per_chunk = config.units_per_chunk;
+        size_t const units = storage_serialize_t::unit_count(table_size, widths);
+        size_t const unit_chunks = (units + units_per_chunk - 1) / units_per_chunk;
+
+        chunked_writer_t writer(out, 1 + unit_chunks, config);
+        writer.write(0, 1, [&](size_t, std::ostream& chunk_out) {
+            serialize<uint64_t>::write(chunk_out, units_per_chunk);
+            serialize<size_manager_t>::write(chunk_out, val.m_sizing);
+            serialize<uint8_t>::write(chunk_out, val.m_key_width);
+            serialize<uint8_t>::write(chunk_out, val.m_val_width);
+            serialize<hash_t>::write(chunk_out, val.m_hash);
+            storage_serialize_t::write_head(chunk_out, val.m_storage, table_size, widths);
+            serialize<placement_t>::write(chunk_out, val.m_placement, table_size);
+            serialize<uint8_t>::write(chunk_out, val.m_is_empty);
+        });
+        writer.write(1, 1 + unit_chunks, [&](size_t chunk, std::ostream& chunk_out) {
+            size_t const begin = (chunk - 1) * units_per_chunk;
+            size_t const end = std::min<size_t>(begin + units_per_chunk, units);
+            storage_serialize_t::write_units(chunk_out, val.m_storage, table_size, widths, begin, end);
+        });
+
+        return writer.finish();
+    }
+    /// See `serialize<hashmap_t>::read()` for `table_config`.
+    static T read(std::istream& in,
+                  chunked_config_t const& config = chunked_config_t(),
+                  typename T::config_args const& table_config = typename T::config_args{}) {
+        using namespace compact_hash;
+
+        chunked_reader_t reader(in, config);
+        CHECK_GE(reader.chunk_count(), 1u);
+
+        T ret;
+        uint64_t units_per_chunk = 0;
+
+        reader.read(0, 1, [&](size_t, std::istream& chunk_in) {
+            units_per_chunk = serialize<uint64_t>::read(chunk_in);
+            ret.m_sizing = serialize<size_manager_t>::read(chunk_in);
+            ret.m_key_width = serialize<uint8_t>::read(chunk_in);
+            ret.m_val_width = serialize<uint8_t>::read(chunk_in);
+            ret.m_hash = serialize<hash_t>::read(chunk_in);
+            ret.m_storage = storage_serialize_t::read_head(chunk_in, ret.table_size(), ret.storage_widths(),
+                                                           table_config.storage_config);
+            ret.m_placement = serialize<placement_t>::read(chunk_in, ret.table_size(),
+                                                            table_config.displacement_config);
+            ret.m_is_empty = serialize<uint8_t>::read(chunk_in);
+        });
+
+        auto const table_size = ret.table_size();
+        auto const widths = ret.storage_widths();
+        size_t const units = storage_serialize_t::unit_count(table_size, widths);
+        CHECK_GT(units_per_chunk, 0u);
+        CHECK_EQ(reader.chunk_count(), 1 + (units + units_per_chunk - 1) / units_per_chunk)
+            << "Corrupt chunk index";
+
+        reader.read(1, reader.chunk_count(), [&](size_t chunk, std::istream& chunk_in) {
+            size_t const begin = (chunk - 1) * units_per_chunk;
+            size_t const end = std::min<size_t>(begin + units_per_chunk, units);
+            storage_serialize_t::read_units(chunk_in, ret.m_storage, table_size, widths, begin, end);
+        });
+
+        return ret;
+    }
+};
+
+/// Writes the buckets of the hashmap that changed since the last snapshot,
+/// together with the bookkeeping and the placement state of their positions.
+///
+/// If the table has been rehashed since then, all buckets count as changed,
+/// and the delta replaces the table as a whole.
+template<typename val_t, typename hash_t, template<typename> typename storage_t, typename placement_t>
+struct serialize_delta<compact_hash::map::hashmap_t<val_t, hash_t, storage_t, placement_t>> {
+    using T = compact_hash::map::hashmap_t<val_t, hash_t, storage_t, placement_t>;
+    using storage_serialize_t = serialize<typename T::storage_app_t>;
+
+    /// Writes the changes since the last call of `write()` or
+    /// `T::clear_dirty()`, and marks all buckets as unchanged.
+    static object_size_t write(std::ostream& out, T& val) {
+        using namespace compact_hash;
+
+        CHECK(val.m_storage.tracks_dirty())
+            << "Delta snapshots need `clear_dirty()` or `storage_config.track_dirty`";
+
+        auto const table_size = val.table_size();
+        auto const widths = val.storage_widths();
+        bool const full = storage_serialize_t::all_dirty(val.m_storage, table_size);
+
+        auto bytes = object_size_t::empty();
+
+        bytes += serialize<uint64_t>::write(out, uint64_t(delta_format_t::MAGIC));
+        bytes += serialize<uint64_t>::write(out, uint64_t(delta_format_t::VERSION));
+        bytes += serialize<bool>::write(out, full);
+        bytes += serialize<size_manager_t>::write(out, val.m_sizing);
+        bytes += serialize<uint8_t>::write(out, val.m_key_width);
+        bytes += serialize<uint8_t>::write(out, val.m_val_width);
+        bytes += serialize<hash_t>::write(out, val.m_hash);
+        bytes += serialize<uint8_t>::write(out, val.m_is_empty);
+
+        if (full) {
+            bytes += serialize<placement_t>::write(out, val.m_placement, table_size);
+            bytes += storage_serialize_t::write(out, val.m_storage, table_size, widths);
+        } else {
+            // NB: The placement only changes its state at the positions of
+            // changed buckets, see `mark_changed()` of the storage context.
+            auto const ranges = storage_serialize_t::dirty_ranges(val.m_storage, table_size);
+            bytes += serialize<uint64_t>::write(out, uint64_t(ranges.size()));
+            for (auto const& range : ranges) {
+                bytes += serialize<uint64_t>::write(out, uint64_t(range.first));
+                bytes += serialize<uint64_t>::write(out, uint64_t(range.second));
+            }
+            bytes += serialize<placement_t>::write_ranges(out, val.m_placement, table_size, ranges);
+            bytes += storage_serialize_t::write_dirty_units(out, val.m_storage, table_size, widths);
+        }
+
+        val.clear_dirty();
+
+        return bytes;
+    }
+
+    /// Applies a delta to `val`, which needs to be in the state of the
+    /// snapshot that preceded the delta.
+    static void apply(std::istream& in, T& val) {
+        using namespace compact_hash;
+
+        uint64_t const magic = serialize<uint64_t>::read(in);
+        uint64_t const version = serialize<uint64_t>::read(in);
+        CHECK_EQ(magic, uint64_t(delta_format_t::MAGIC)) << "Not a delta snapshot";
+        CHECK_EQ(version, uint64_t(delta_format_t::VERSION))
+            << "Unsupported version of the delta snapshot";
+
+        bool const full = serialize<bool>::read(in);
+        auto sizing = serialize<size_manager_t>::read(in);
+        auto key_width = serialize<uint8_t>::read(in);
+        auto val_width = serialize<uint8_t>::read(in);
+        auto hash = serialize<hash_t>::read(in);
+
+        if (!full) {
+            CHECK_EQ(sizing.capacity(), val.table_size()) << "Delta does not fit the table";
+            CHECK_EQ(key_width, val.m_key_width) << "Delta does not fit the table";
+            CHECK_EQ(val_width, val.m_val_width) << "Delta does not fit the table";
+        } else {
+            // NB: overwriting the storage does not automatically destroy the values in them.
+            val.destroy_vals();
+        }
+
+        val.m_sizing = std::move(sizing);
+        val.m_key_width = std::move(key_width);
+        val.m_val_width = std::move(val_width);
+        val.m_hash = std::move(hash);
+
+        auto const table_size = val.table_size();
+        auto const widths = val.storage_widths();
+
+        val.m_is_empty = serialize<uint8_t>::read(in);
+
+        if (full) {
+            val.m_placement = serialize<placement_t>::read(in, table_size, val.m_placement.current_config());
+
+            bool const tracks_dirty = val.m_storage.tracks_dirty();
+            val.m_storage = storage_serialize_t::read(in, table_size, widths, val.m_storage.current_config());
+            if (tracks_dirty) {
+                val.clear_dirty();
+            }
+        } else {
+            delta_ranges_t ranges(serialize<uint64_t>::read(in));
+            for (auto& range : ranges) {
+                range.first = serialize<uint64_t>::read(in);
+                range.second = serialize<uint64_t>::read(in);
+                CHECK_LE(range.second, table_size) << "Delta does not fit the table";
+            }
+            serialize<placement_t>::read_ranges(in, val.m_placement, table_size, ranges);
+            storage_serialize_t::read_dirty_units(in, val.m_storage, table_size, widths);
+        }
+    }
+};
+
 }
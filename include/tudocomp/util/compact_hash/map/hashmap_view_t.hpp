@@ -0,0 +1,351 @@
+#pragma once
+
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <glog/logging.h>
+
+#include <tudocomp/util/bits.hpp>
+#include <tudocomp/util/serialization.hpp>
+
+#include <tudocomp/util/compact_hash/util.hpp>
+#include <tudocomp/util/compact_hash/hash_functions.hpp>
+#include <tudocomp/util/compact_hash/map/hashmap_t.hpp>
+#include <tudocomp/util/compact_hash/set/hashset_t.hpp>
+
+namespace tdc {namespace compact_hash{namespace map {
+
+/// A read-only view of a `hashmap_t` with integer values (or of a
+/// `hashset_t`), that can be queried directly from its on-disk representation,
+/// for example a file mapped into memory with `mmap_file_t`.
+///
+/// The on-disk representation is written by `write()`. It consists of a
+/// versioned header and sections aligned to `ALIGNMENT` bytes:
+/// - the serialized hash function,
+/// - a bit vector marking the occupied slots,
+/// - rank samples of that bit vector for every `RANK_SAMPLE` slots,
+/// - the bit-packed displacements, quotients and values
+///   of the occupied slots in the order of their slots.
+///
+/// The integers are stored in the byte order of the writing machine.
+///
+/// Versions of the on-disk representation:
+/// - 1: The displacements are stored for every slot, indexed by the slot,
+///   and only tables with a placement based on linear probing are written.
+/// - 2: The displacements are stored for the occupied slots in rank order,
+///   like the quotients and values, and the entries are placed anew.
+///
+/// `write()` writes version 2, and both versions can be read.
+template<typename hash_t = poplar_xorshift_t>
+class hashmap_view_t {
+public:
+    /// Version of the on-disk representation written by `write()`.
+    static constexpr uint32_t VERSION = 2;
+    /// Alignment of the sections in bytes.
+    static constexpr size_t ALIGNMENT = 64;
+    /// Amount of slots per rank sample.
+    static constexpr size_t RANK_SAMPLE = 512;
+
+    struct header_t {
+        char magic[8];
+        uint32_t version;
+        uint32_t header_size;
+        uint64_t size;
+        uint8_t capacity_log2;
+        uint8_t key_width;
+        uint8_t value_width;
+        uint8_t quotient_width;
+        uint8_t displacement_width;
+        uint8_t padding[3];
+        uint64_t hash_offset;
+        uint64_t hash_size;
+        uint64_t occupied_offset;
+        uint64_t rank_offset;
+        uint64_t displacement_offset;
+        uint64_t quotient_offset;
+        uint64_t value_offset;
+        uint64_t file_size;
+    };
+
+private:
+    static constexpr char MAGIC[8] = { 'T', 'D', 'C', 'C', 'H', 'M', 'A', 'P' };
+
+    header_t const* m_header;
+    hash_t m_hash;
+    uint64_t const* m_occupied;
+    uint64_t const* m_rank;
+    uint64_t const* m_displacement;
+    uint64_t const* m_quotients;
+    uint64_t const* m_values;
+
+    inline static size_t align(size_t offset) {
+        return (offset + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+    }
+
+    inline static header_t const* checked_header(void const* data, size_t size) {
+        CHECK_GE(size, sizeof(header_t)) << "Not a compact hashmap view";
+        CHECK_EQ(uintptr_t(data) % sizeof(uint64_t), 0U) << "Unaligned compact hashmap view";
+
+        auto header = (header_t const*) data;
+        CHECK(memcmp(header->magic, MAGIC, sizeof(MAGIC)) == 0) << "Not a compact hashmap view";
+        CHECK(header->version == 1 || header->version == VERSION)
+            << "Unsupported compact hashmap view version " << header->version;
+        CHECK_EQ(header->header_size, sizeof(header_t)) << "Unsupported compact hashmap view header";
+        CHECK_LE(header->file_size, size) << "Truncated compact hashmap view";
+
+        return header;
+    }
+
+    inline static hash_t read_hash(header_t const* header) {
+        auto hash_data = ((char const*) header) + header->hash_offset;
+        std::istringstream in(std::string(hash_data, header->hash_size));
+        return serialize<hash_t>::read(in);
+    }
+
+    inline bool is_occupied(size_t pos) const {
+        return bit_is_set(m_occupied, pos);
+    }
+
+    /// Amount of occupied slots before `pos`.
+    inline size_t rank(size_t pos) const {
+        return rank(m_occupied, m_rank, pos);
+    }
+
+public:
+    /// Creates a view of the on-disk representation starting at `data`,
+    /// which needs to be aligned to 8 bytes and stay valid for the
+    /// lifetime of the view.
+    inline hashmap_view_t(void const* data, size_t size):
+        m_header(checked_header(data, size)),
+        m_hash(read_hash(m_header))
+    {
+        auto base = (char const*) data;
+        m_occupied = (uint64_t const*) (base + m_header->occupied_offset);
+        m_rank = (uint64_t const*) (base + m_header->rank_offset);
+        m_displacement = (uint64_t const*) (base + m_header->displacement_offset);
+        m_quotients = (uint64_t const*) (base + m_header->quotient_offset);
+        m_values = (uint64_t const*) (base + m_header->value_offset);
+    }
+
+    /// Returns the amount of elements inside the datastructure.
+    inline size_t size() const {
+        return m_header->size;
+    }
+
+    /// Returns the size of the hashtable.
+    inline size_t table_size() const {
+        return 1ull << m_header->capacity_log2;
+    }
+
+    /// Width of the keys stored in this datastructure.
+    inline size_t key_width() const {
+        return m_header->key_width;
+    }
+
+    /// Width of the values stored in this datastructure.
+    inline size_t value_width() const {
+        return m_header->value_width;
+    }
+
+    /// Search for a key inside the hashtable.
+    ///
+    /// Returns `true` and sets `value` if the key is found.
+    inline bool search(uint64_t key, uint64_t& value) const {
+        DCHECK(key_width() == 64 || (key >> key_width()) == 0);
+
+        uint64_t const hres = m_hash.hash(key);
+        size_t const mask = table_size() - 1;
+        uint64_t const initial_address = hres & mask;
+        uint64_t const stored_quotient = hres >> m_header->capacity_log2;
+
+        // NB: All slots of a probe sequence are occupied, so the rank
+        // of a slot is one more than the rank of the slot before it.
+        bool const per_slot = (m_header->version == 1);
+        size_t const dw = m_header->displacement_width;
+        size_t const qw = m_header->quotient_width;
+        size_t const vw = m_header->value_width;
+        size_t pos = initial_address;
+        size_t r = rank(pos);
+        for (size_t dist = 0; is_occupied(pos); dist++) {
+            size_t const d = per_slot ? pos : r;
+            if (get_bits(m_displacement, d * dw, dw) == dist
+                && get_bits(m_quotients, r * qw, qw) == stored_quotient) {
+                value = get_bits(m_values, r * vw, vw);
+                return true;
+            }
+            pos = (pos + 1) & mask;
+            r = (pos == 0) ? 0 : r + 1;
+            DCHECK_NE(pos, initial_address);
+        }
+
+        return false;
+    }
+
+    /// Count the number of occurrences of `key`, as defined on STL containers.
+    ///
+    /// It will return either 0 or 1.
+    inline size_t count(uint64_t key) const {
+        uint64_t value;
+        return search(key, value);
+    }
+
+    /// Writes the on-disk representation of `map` to `out`.
+    ///
+    /// The values need to be integers. The entries are placed anew by
+    /// linear probing, so `placement_t` can be any placement.
+    template<typename val_t, template<typename> typename storage_t, typename placement_t>
+    static object_size_t write(std::ostream& out,
+                               hashmap_t<val_t, hash_t, storage_t, placement_t>& map) {
+        return write_table(out, map, true, [](auto ptr) {
+            return uint64_t(*ptr.val_ptr());
+        });
+    }
+
+    /// Writes the on-disk representation of `set` to `out`,
+    /// with values of width 0.
+    template<typename placement_t>
+    static object_size_t write(std::ostream& out,
+                               set::hashset_t<hash_t, placement_t>& set) {
+        return write_table(out, set, false, [](auto) {
+            return uint64_t(0);
+        });
+    }
+
+private:
+    /// Amount of set bits in `occupied` before `pos`, using the samples `rank`.
+    inline static size_t rank(uint64_t const* occupied, uint64_t const* rank, size_t pos) {
+        size_t r = rank[pos / RANK_SAMPLE];
+        for (size_t w = (pos / RANK_SAMPLE) * (RANK_SAMPLE / 64); w < pos / 64; w++) {
+            r += popcount(occupied[w]);
+        }
+        r += popcount(occupied[pos / 64] & ((1ull << (pos % 64)) - 1));
+        return r;
+    }
+
+    /// Marks and returns the first free slot in `occupied`
+    /// starting at `initial_address`.
+    template<typename sizing_t>
+    inline static uint64_t place(std::vector<uint64_t>& occupied,
+                                 sizing_t const& sizing,
+                                 uint64_t initial_address) {
+        uint64_t pos = initial_address;
+        while (bit_is_set(occupied.data(), pos)) {
+            pos = sizing.mod_add(pos);
+        }
+        occupied[pos / 64] |= 1ull << (pos % 64);
+        return pos;
+    }
+
+    template<typename table_t, typename value_of_t>
+    static object_size_t write_table(std::ostream& out, table_t& table,
+                                     bool has_values, value_of_t value_of) {
+        size_t const table_size = table.table_size();
+        auto const widths = table.storage_widths();
+        auto const& sizing = table.m_sizing;
+
+        auto pctx = table.m_placement.context(table.m_storage, table_size, widths, sizing);
+        auto sctx = table.m_storage.context(table_size, widths);
+
+        // Occupied slots, and the widths of the displacements and values
+        std::vector<uint64_t> occupied(words_for(table_size, 1));
+        uint64_t max_displacement = 0;
+        uint64_t max_value = 0;
+        size_t count = 0;
+        pctx.for_all_allocated([&](auto initial_address, auto pos) {
+            uint64_t const frozen_pos = place(occupied, sizing, initial_address);
+            max_displacement = std::max<uint64_t>(
+                max_displacement, sizing.mod_sub(frozen_pos, uint64_t(initial_address)));
+            max_value = std::max<uint64_t>(max_value, value_of(sctx.at(sctx.table_pos(pos))));
+            count++;
+        });
+        DCHECK_EQ(count, table.size());
+
+        // Rank samples
+        std::vector<uint64_t> rank_samples((table_size + RANK_SAMPLE - 1) / RANK_SAMPLE);
+        for (size_t w = 0, r = 0; w < occupied.size(); w++) {
+            if (w % (RANK_SAMPLE / 64) == 0) {
+                rank_samples[w / (RANK_SAMPLE / 64)] = r;
+            }
+            r += popcount(occupied[w]);
+        }
+
+        // Displacements, quotients and values in rank order.
+        // NB: Repeats the placement of the first pass, which visits
+        // the entries in the same order.
+        size_t const displacement_width = bits_for(max_displacement);
+        size_t const quotient_width = table.quotient_width();
+        size_t const value_width = has_values ? bits_for(max_value) : 0;
+        std::vector<uint64_t> displacement(words_for(count, displacement_width));
+        std::vector<uint64_t> quotients(words_for(count, quotient_width));
+        std::vector<uint64_t> values(words_for(count, value_width));
+        std::vector<uint64_t> placed(occupied.size());
+        pctx.for_all_allocated([&](auto initial_address, auto pos) {
+            uint64_t const frozen_pos = place(placed, sizing, initial_address);
+            size_t const r = rank(occupied.data(), rank_samples.data(), frozen_pos);
+            auto ptr = sctx.at(sctx.table_pos(pos));
+            set_bits(displacement.data(), r * displacement_width, displacement_width,
+                     sizing.mod_sub(frozen_pos, uint64_t(initial_address)));
+            set_bits(quotients.data(), r * quotient_width, quotient_width, ptr.get_quotient());
+            set_bits(values.data(), r * value_width, value_width, value_of(ptr));
+        });
+
+        std::stringstream hash_out;
+        serialize<hash_t>::write(hash_out, table.m_hash);
+        std::string const hash_bytes = hash_out.str();
+
+        // Layout of the sections
+        header_t header;
+        memset(&header, 0, sizeof(header_t));
+        memcpy(header.magic, MAGIC, sizeof(MAGIC));
+        header.version = VERSION;
+        header.header_size = sizeof(header_t);
+        header.size = count;
+        header.capacity_log2 = sizing.capacity_log2();
+        header.key_width = table.key_width();
+        header.value_width = value_width;
+        header.quotient_width = quotient_width;
+        header.displacement_width = displacement_width;
+
+        size_t offset = align(sizeof(header_t));
+        auto place_section = [&](uint64_t& section_offset, size_t bytes) {
+            section_offset = offset;
+            offset = align(offset + bytes);
+        };
+        place_section(header.hash_offset, hash_bytes.size());
+        header.hash_size = hash_bytes.size();
+        place_section(header.occupied_offset, occupied.size() * sizeof(uint64_t));
+        place_section(header.rank_offset, rank_samples.size() * sizeof(uint64_t));
+        place_section(header.displacement_offset, displacement.size() * sizeof(uint64_t));
+        place_section(header.quotient_offset, quotients.size() * sizeof(uint64_t));
+        place_section(header.value_offset, values.size() * sizeof(uint64_t));
+        header.file_size = offset;
+
+        // Write the sections, padded to the alignment
+        size_t written = 0;
+        auto write_section = [&](void const* data, size_t bytes) {
+            static char const zeros[ALIGNMENT] = {};
+            out.write((char const*) data, bytes);
+            written += bytes;
+            size_t const padding = align(written) - written;
+            out.write(zeros, padding);
+            written += padding;
+        };
+        write_section(&header, sizeof(header_t));
+        write_section(hash_bytes.data(), hash_bytes.size());
+        write_section(occupied.data(), occupied.size() * sizeof(uint64_t));
+        write_section(rank_samples.data(), rank_samples.size() * sizeof(uint64_t));
+        write_section(displacement.data(), displacement.size() * sizeof(uint64_t));
+        write_section(quotients.data(), quotients.size() * sizeof(uint64_t));
+        write_section(values.data(), values.size() * sizeof(uint64_t));
+        DCHECK_EQ(written, header.file_size);
+
+        return object_size_t::exact(written);
+    }
+};
+
+template<typename hash_t>
+constexpr char hashmap_view_t<hash_t>::MAGIC[8];
+
+}}}
@@ -0,0 +1,262 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include <glog/logging.h>
+
+#include <tudocomp/util/heap_size.hpp>
+#include <tudocomp/util/bits.hpp>
+
+#include <tudocomp/util/compact_hash/map/hashmap_t.hpp>
+#include <tudocomp/util/compact_hash/map/value_arena_t.hpp>
+#include <tudocomp/util/compact_hash/hash_functions.hpp>
+#include <tudocomp/util/compact_hash/storage/buckets_bv_t.hpp>
+#include <tudocomp/util/compact_hash/index_structure/cv_bvs_t.hpp>
+
+namespace tdc {namespace compact_hash{namespace map {
+
+/// A hashmap that stores its values of type `val_t` outside of the table,
+/// in a `value_arena_t`.
+///
+/// The table only stores the bit-packed index of the slot of each value,
+/// so moving an entry during an insert, removal or reallocation moves
+/// a few bits instead of the value. This suits large values, or values
+/// that are expensive to move.
+///
+/// The values keep their address until they are removed, so the
+/// pointers and references returned by this table stay valid across
+/// inserts, unlike the ones of `hashmap_t`.
+template<typename val_t,
+         typename hash_t = poplar_xorshift_t,
+         template<typename> typename storage_t = buckets_bv_t,
+         typename placement_t = cv_bvs_t>
+class indirect_hashmap_t {
+public:
+    /// The table of the slot indices, which are stored as `index + 1`
+    /// since `plain_sentinel_t` marks empty locations with 0.
+    using table_t = hashmap_t<dynamic_t, hash_t, storage_t, placement_t>;
+    using arena_t = value_arena_t<val_t>;
+
+    using config_args = typename table_t::config_args;
+    using value_type = val_t;
+    using reference_type = val_t&;
+    using pointer_type = val_t*;
+
+    static constexpr size_t DEFAULT_KEY_WIDTH = table_t::DEFAULT_KEY_WIDTH;
+    static constexpr size_t DEFAULT_TABLE_SIZE = table_t::DEFAULT_TABLE_SIZE;
+
+private:
+    table_t m_table;
+    arena_t m_arena;
+
+    template<typename T>
+    friend struct ::tdc::heap_size;
+
+public:
+    /// Constructs a hashtable with a initial table size `size`,
+    /// and a initial key bit-width `key_width`.
+    inline indirect_hashmap_t(size_t size = DEFAULT_TABLE_SIZE,
+                              size_t key_width = DEFAULT_KEY_WIDTH,
+                              config_args config = config_args{}):
+        m_table(size, key_width, 1, config) {}
+
+    inline indirect_hashmap_t(indirect_hashmap_t&& other) = default;
+    inline indirect_hashmap_t& operator=(indirect_hashmap_t&& other) {
+        destroy_vals();
+        m_table = std::move(other.m_table);
+        m_arena = std::move(other.m_arena);
+        return *this;
+    }
+    // NB: These just exist to catch bugs, and could be removed
+    inline indirect_hashmap_t(indirect_hashmap_t const& other) = delete;
+    inline indirect_hashmap_t& operator=(indirect_hashmap_t const& other) = delete;
+
+    inline ~indirect_hashmap_t() {
+        destroy_vals();
+    }
+
+    /// Returns the amount of elements inside the datastructure.
+    inline size_t size() const {
+        return m_table.size();
+    }
+
+    /// Returns the current size of the hashtable.
+    inline size_t table_size() const {
+        return m_table.table_size();
+    }
+
+    /// Width of the keys stored in this datastructure.
+    inline size_t key_width() const {
+        return m_table.key_width();
+    }
+
+    /// Width of the slot indices stored in the table,
+    /// which grows along with the capacity of the table.
+    inline size_t index_width() const {
+        return m_table.value_width();
+    }
+
+    /// Sets the maximum load factor
+    /// (how full the table can get before re-allocating).
+    inline void max_load_factor(float z) {
+        m_table.max_load_factor(z);
+    }
+
+    /// Returns the maximum load factor.
+    inline float max_load_factor() const noexcept {
+        return m_table.max_load_factor();
+    }
+
+    /// Grows the key width.
+    inline void grow_key_width(size_t key_width) {
+        m_table.grow_key_width(key_width);
+    }
+
+    /// Inserts a value constructed from `args` under the key `key`,
+    /// if the key does not exist yet.
+    ///
+    /// Returns a pointer to the value of the key, and whether it was
+    /// newly inserted. An existing value is left unchanged.
+    template<typename... Args>
+    inline std::pair<pointer_type, bool> emplace(uint64_t key, Args&&... args) {
+        // NB: The slot is taken up front, such that the key is
+        // inserted with a single probe.
+        uint64_t const index = m_arena.allocate();
+        auto entry = m_table.access_entry_kv_width(key, key_width(), index_width_for(index));
+        if (entry.key_already_exist()) {
+            m_arena.deallocate(index);
+            return { m_arena.at(uint64_t(*entry.ptr().val_ptr()) - 1), false };
+        }
+        *entry.ptr().val_ptr() = index + 1;
+        pointer_type addr = m_arena.at(index);
+        new (addr) val_t(std::forward<Args>(args)...);
+        return { addr, true };
+    }
+
+    /// Inserts a key-value pair into the hashtable,
+    /// or replaces the value of an existing key.
+    ///
+    /// Returns a pointer to the value.
+    inline pointer_type insert(uint64_t key, value_type&& value) {
+        auto r = emplace(key, std::move(value));
+        if (!r.second) {
+            *r.first = std::move(value);
+        }
+        return r.first;
+    }
+
+    /// Returns a reference to the element with key `key`.
+    ///
+    /// If the value does not already exist in the table, it will be
+    /// default-constructed.
+    inline reference_type access(uint64_t key) {
+        return *emplace(key).first;
+    }
+
+    /// Returns a reference to the element with key `key`.
+    ///
+    /// This has the same semantic is `access(key)`.
+    inline reference_type operator[](uint64_t key) {
+        return access(key);
+    }
+
+    /// Search for a key inside the hashtable.
+    ///
+    /// This returns a pointer to the value if its found, or null
+    /// otherwise.
+    inline pointer_type search(uint64_t key) {
+        auto ptr = m_table.search(key);
+        if (ptr != typename table_t::pointer_type()) {
+            return m_arena.at(uint64_t(*ptr) - 1);
+        } else {
+            return nullptr;
+        }
+    }
+
+    /// Compatibility with `std::unordered_map`.
+    inline pointer_type find(uint64_t key) {
+        return search(key);
+    }
+
+    /// Compatibility with `std::unordered_map`.
+    inline size_t count(uint64_t key) {
+        return search(key) != nullptr ? 1 : 0;
+    }
+
+    /// Removes the element with key `key` from the hashtable, if it exists,
+    /// and releases the slot of its value for reuse.
+    ///
+    /// Returns the number of removed elements, which is either 0 or 1.
+    /// This requires a placement that supports deletion, like `robin_hood_t`.
+    inline size_t erase(uint64_t key) {
+        auto ptr = m_table.search(key);
+        if (ptr == typename table_t::pointer_type()) {
+            return 0;
+        }
+        uint64_t const index = uint64_t(*ptr) - 1;
+        m_table.erase(key);
+        m_arena.at(index)->~val_t();
+        m_arena.deallocate(index);
+        return 1;
+    }
+
+    /// Calls `f(key, value)` for each entry of the hashtable,
+    /// where `value` is a `reference_type`, see `hashmap_t::for_each()`.
+    template<typename F>
+    inline void for_each(F f) {
+        m_table.for_each([&](uint64_t key, auto index) {
+            f(key, *m_arena.at(uint64_t(index) - 1));
+        });
+    }
+
+    /// The underlying table of the slot indices.
+    inline table_t const& table() const {
+        return m_table;
+    }
+
+private:
+    /// Returns the index width needed to insert a new entry with the slot `index`.
+    ///
+    /// Since there are never more slots than locations in the table,
+    /// the width grows to fit an index for each location of the
+    /// (grown) table, such that it changes along with the capacity
+    /// instead of reallocating the table on its own.
+    inline size_t index_width_for(uint64_t index) const {
+        size_t const new_size = size() + 1;
+        if (bits_for(index + 1) <= index_width() && !m_table.needs_to_grow_capacity(new_size)) {
+            return index_width();
+        }
+        return std::max<size_t>(bits_for(index + 1), bits_for(m_table.grown_capacity(new_size)));
+    }
+
+    inline void destroy_vals() {
+        // NB: A moved-from table has no slots.
+        if (!std::is_trivially_destructible<val_t>::value && !m_arena.empty()) {
+            m_table.for_each([&](uint64_t, auto index) {
+                m_arena.at(uint64_t(index) - 1)->~val_t();
+            });
+        }
+    }
+};
+
+}}
+
+template<typename val_t, typename hash_t, template<typename> typename storage_t, typename placement_t>
+struct heap_size<compact_hash::map::indirect_hashmap_t<val_t, hash_t, storage_t, placement_t>> {
+    using T = compact_hash::map::indirect_hashmap_t<val_t, hash_t, storage_t, placement_t>;
+
+    static object_size_t compute(T const& val) {
+        auto bytes = object_size_t::empty();
+
+        bytes += heap_size<typename T::table_t>::compute(val.m_table);
+        bytes += heap_size<typename T::arena_t>::compute(val.m_arena);
+
+        return bytes;
+    }
+};
+
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <tudocomp/util/serialization.hpp>
+#include <tudocomp/util/compact_hash/operation_log_t.hpp>
+
+namespace tdc {namespace compact_hash {namespace map {
+
+/// A hashmap with integer values whose inserts are recorded in an
+/// `operation_log_t`, paired with snapshots written by `serialize`.
+///
+/// After a crash, `recover()` loads the latest snapshot and replays the
+/// log written since then.
+///
+/// NB: Only the inserts done through this class are recorded.
+/// Changes done through `table()` are not.
+template<typename table_t>
+class logged_hashmap_t {
+    table_t m_table;
+    operation_log_t m_log;
+public:
+    using value_type = typename table_t::value_type;
+
+    /// Attaches a log at `log_path` to `table`, appending to an existing log.
+    inline logged_hashmap_t(table_t&& table,
+                            std::string const& log_path,
+                            operation_log_t::config_args log_config = operation_log_t::config_args{}):
+        m_table(std::move(table)),
+        m_log(log_path, log_config) {}
+
+    /// Inserts a key-value pair into the hashtable, and records it.
+    inline void insert(uint64_t key, value_type value) {
+        insert_kv_width(key, value, m_table.key_width(), m_table.value_width());
+    }
+
+    /// Inserts a key-value pair into the hashtable,
+    /// grows the key and value width as needed, and records it.
+    inline void insert_kv_width(uint64_t key, value_type value, uint8_t key_width, uint8_t value_width) {
+        m_table.insert_kv_width(key, value_type(value), key_width, value_width);
+
+        // NB: Logs the widths of the table after the insert,
+        // such that replay grows the table in the same way.
+        m_log.append(key, m_table.key_width(), uint64_t(value), m_table.value_width());
+    }
+
+    /// Appends the buffered records to the log.
+    inline void commit() {
+        m_log.commit();
+    }
+
+    /// Appends the buffered records to the log, and makes them durable.
+    inline void sync() {
+        m_log.commit();
+        m_log.sync();
+    }
+
+    /// Durably writes a snapshot of the table to `snapshot_path`,
+    /// and drops the log records contained in it.
+    inline void checkpoint(std::string const& snapshot_path) {
+        write_file_durably(snapshot_path, [&](std::ostream& out) {
+            serialize<table_t>::write(out, m_table);
+        });
+        m_log.reset();
+    }
+
+    /// Loads the snapshot at `snapshot_path` (or uses `initial` if there is
+    /// none yet), replays the log at `log_path`, and continues to log there.
+    ///
+    /// The records are replayed with `insert_batch()`, in batches of up to
+    /// `log_config.records_per_group` consecutive records with the same widths.
+    inline static logged_hashmap_t recover(std::string const& snapshot_path,
+                                           std::string const& log_path,
+                                           table_t&& initial = table_t(),
+                                           operation_log_t::config_args log_config = operation_log_t::config_args{}) {
+        table_t table = std::move(initial);
+        {
+            std::ifstream in(snapshot_path, std::ios::binary);
+            if (in) {
+                table = serialize<table_t>::read(in);
+            }
+        }
+
+        std::vector<uint64_t> keys;
+        std::vector<value_type> values;
+        uint8_t key_width = 0;
+        uint8_t value_width = 0;
+        auto insert_batch = [&]() {
+            if (!keys.empty()) {
+                // NB: The records carry the widths of the table after
+                // their insert, so the table grows to them first.
+                table.grow_kv_width(key_width, value_width);
+                table.insert_batch(keys.data(), values.data(), keys.size());
+                keys.clear();
+                values.clear();
+            }
+        };
+        operation_log_t::replay(log_path, [&](operation_log_record_t const& record) {
+            if (record.key_width != key_width
+                || record.value_width != value_width
+                || keys.size() >= log_config.records_per_group) {
+                insert_batch();
+                key_width = record.key_width;
+                value_width = record.value_width;
+            }
+            keys.push_back(record.key);
+            values.push_back(value_type(record.value));
+        });
+        insert_batch();
+
+        return logged_hashmap_t(std::move(table), log_path, log_config);
+    }
+
+    inline table_t& table() { return m_table; }
+    inline table_t const& table() const { return m_table; }
+
+    inline operation_log_t& log() { return m_log; }
+};
+
+}}}
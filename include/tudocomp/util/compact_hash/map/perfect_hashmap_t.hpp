@@ -0,0 +1,522 @@
+#pragma once
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include <glog/logging.h>
+
+#include <tudocomp/util/bits.hpp>
+#include <tudocomp/util/heap_size.hpp>
+#include <tudocomp/util/serialization.hpp>
+#include <tudocomp/util/chunked_serialization.hpp>
+
+#include <tudocomp/util/compact_hash/util.hpp>
+#include <tudocomp/util/compact_hash/hash_functions.hpp>
+#include <tudocomp/util/compact_hash/map/hashmap_t.hpp>
+#include <tudocomp/util/compact_hash/set/hashset_t.hpp>
+
+namespace tdc {namespace compact_hash{namespace map {
+
+/// An immutable hashmap with integer values, built from a populated
+/// `hashmap_t` (or `hashset_t`) with a minimal perfect hash function,
+/// such that a lookup inspects exactly one entry.
+///
+/// The perfect hash function is a partitioned PTHash-style construction
+/// over the output of the bijective hash function `hash_t`:
+/// - The low bits of a hash value select a partition of, on average,
+///   `config_args::keys_per_partition` keys.
+///   The remaining bits form the quotient of the key.
+/// - Within a partition, the quotient selects a bucket of, on average,
+///   `config_args::keys_per_bucket` keys, and the pilot of the bucket
+///   selects the positions of its keys within the partition.
+///
+/// Since a partition occupies a contiguous range of entries, an entry
+/// only needs to store its quotient for verification, and its value.
+/// Both are bit-packed next to each other. The offset, size and pilots of
+/// a partition are packed into one block, such that a lookup usually
+/// touches two cache lines: the block of the partition, and the entry.
+///
+/// The partitions are constructed independently by
+/// `config_args::threads` threads.
+template<typename hash_t = poplar_xorshift_t>
+class perfect_hashmap_t {
+public:
+    /// runtime initilization arguments, if any
+    struct config_args {
+        /// Average amount of keys per partition.
+        size_t keys_per_partition = 256;
+        /// Average amount of keys per bucket.
+        size_t keys_per_bucket = 3;
+        /// Amount of threads used for the construction.
+        size_t threads = 1;
+    };
+
+private:
+    /// Words of a partition block before its pilots: offset and size.
+    static constexpr size_t BLOCK_HEADER = 2;
+    /// Amount of pilots tried for a bucket before the construction gives up.
+    ///
+    /// NB: A bucket of `k` keys fits with a pilot with a probability of
+    /// about `(free / size)^k`, so a search that takes this long means
+    /// that the keys of the bucket collide for every pilot.
+    static constexpr uint64_t MAX_PILOT_SEARCH = 1ull << 24;
+
+    hash_t m_hash;
+    size_t m_size = 0;
+    uint8_t m_key_width = 0;
+    uint8_t m_partition_bits = 0;
+    uint8_t m_quotient_width = 0;
+    uint8_t m_value_width = 0;
+    uint8_t m_pilot_width = 0;
+    size_t m_buckets_per_partition = 1;
+    size_t m_block_words = BLOCK_HEADER;
+
+    std::unique_ptr<uint64_t[]> m_blocks;
+    size_t m_blocks_size = 0;
+    std::unique_ptr<uint64_t[]> m_entries;
+    size_t m_entries_size = 0;
+
+    template<typename T>
+    friend struct ::tdc::serialize;
+
+    template<typename T>
+    friend struct ::tdc::heap_size;
+
+    /// Bijective mixing of all bits of `x` (the finalizer of MurmurHash3).
+    inline static uint64_t mix(uint64_t x) {
+        x ^= x >> 33;
+        x *= 0xff51afd7ed558ccdull;
+        x ^= x >> 33;
+        x *= 0xc4ceb9fe1a85ec53ull;
+        x ^= x >> 33;
+        return x;
+    }
+
+    /// Maps `x` uniformly onto `[0, n)`.
+    inline static uint64_t reduce(uint64_t x, uint64_t n) {
+        return uint64_t((__uint128_t(x) * n) >> 64);
+    }
+
+    inline size_t bucket_of(uint64_t quotient) const {
+        return reduce(mix(quotient), m_buckets_per_partition);
+    }
+
+    /// Position of the key with quotient `quotient`
+    /// in a partition of size `size`.
+    inline static size_t position_of(uint64_t quotient, uint64_t pilot, size_t size) {
+        // NB: `mix(pilot + 1)` is never 0, so the position differs from the bucket hash
+        return reduce(mix(quotient ^ mix(pilot + 1)), size);
+    }
+
+    inline size_t entry_width() const {
+        return m_quotient_width + m_value_width;
+    }
+
+    /// Calls `f(begin, end)` on `threads` ranges of `[0, size)`, which
+    /// are multiples of `granularity` long, in parallel.
+    template<typename F>
+    inline static void parallel_ranges(size_t size, size_t granularity, size_t threads, F f) {
+        size_t const units = (size + granularity - 1) / granularity;
+        threads = std::max<size_t>(1, std::min(threads, units));
+        chunked_format_t::parallel_for(0, threads, threads, [&](size_t t) {
+            f(std::min(size, units * t / threads * granularity),
+              std::min(size, units * (t + 1) / threads * granularity));
+        });
+    }
+
+    /// Searches the pilots of one partition, whose quotients and values
+    /// are in `quotients` and `values` (or `nullptr` for a set),
+    /// and reorders them by their position.
+    ///
+    /// Returns the largest pilot.
+    inline uint64_t build_partition(uint64_t* quotients,
+                                    uint64_t* values,
+                                    size_t size,
+                                    uint64_t* pilots) const {
+        size_t const buckets = m_buckets_per_partition;
+        std::fill(pilots, pilots + buckets, 0);
+        if (size == 0) return 0;
+
+        // Group the keys by bucket
+        std::vector<size_t> bucket_begin(buckets + 1);
+        for (size_t i = 0; i < size; i++) {
+            bucket_begin[bucket_of(quotients[i]) + 1]++;
+        }
+        for (size_t b = 0; b < buckets; b++) {
+            bucket_begin[b + 1] += bucket_begin[b];
+        }
+        std::vector<size_t> by_bucket(size);
+        {
+            std::vector<size_t> cursor(bucket_begin.begin(), bucket_begin.end() - 1);
+            for (size_t i = 0; i < size; i++) {
+                by_bucket[cursor[bucket_of(quotients[i])]++] = i;
+            }
+        }
+
+        // Place the largest buckets first
+        std::vector<size_t> order(buckets);
+        for (size_t b = 0; b < buckets; b++) {
+            order[b] = b;
+        }
+        std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+            return bucket_begin[a + 1] - bucket_begin[a] > bucket_begin[b + 1] - bucket_begin[b];
+        });
+
+        std::vector<bool> taken(size);
+        std::vector<size_t> key_at(size);
+        std::vector<size_t> positions;
+        uint64_t max_pilot = 0;
+        for (size_t b : order) {
+            size_t const begin = bucket_begin[b];
+            size_t const end = bucket_begin[b + 1];
+            if (begin == end) break;
+
+            for (uint64_t pilot = 0;; pilot++) {
+                CHECK_LT(pilot, MAX_PILOT_SEARCH)
+                    << "No pilot found for a bucket of " << (end - begin)
+                    << " keys in a partition of " << size << " keys";
+                positions.clear();
+                bool fits = true;
+                for (size_t k = begin; k < end; k++) {
+                    size_t const pos = position_of(quotients[by_bucket[k]], pilot, size);
+                    if (taken[pos]) {
+                        fits = false;
+                        break;
+                    }
+                    taken[pos] = true;
+                    positions.push_back(pos);
+                }
+                if (fits) {
+                    for (size_t k = begin; k < end; k++) {
+                        key_at[positions[k - begin]] = by_bucket[k];
+                    }
+                    pilots[b] = pilot;
+                    max_pilot = std::max(max_pilot, pilot);
+                    break;
+                }
+                for (size_t pos : positions) {
+                    taken[pos] = false;
+                }
+            }
+        }
+
+        // Reorder the keys by their position
+        std::vector<uint64_t> tmp(quotients, quotients + size);
+        for (size_t pos = 0; pos < size; pos++) {
+            quotients[pos] = tmp[key_at[pos]];
+        }
+        if (values != nullptr) {
+            std::copy(values, values + size, tmp.begin());
+            for (size_t pos = 0; pos < size; pos++) {
+                values[pos] = tmp[key_at[pos]];
+            }
+        }
+
+        return max_pilot;
+    }
+
+    template<typename table_t, typename value_of_t>
+    inline perfect_hashmap_t(table_t& table, config_args config,
+                             bool has_values, value_of_t value_of):
+        m_hash(table.m_hash)
+    {
+        CHECK_GT(config.keys_per_partition, 0u);
+        CHECK_GT(config.keys_per_bucket, 0u);
+
+        size_t const table_size = table.table_size();
+        auto const widths = table.storage_widths();
+        auto& sizing = table.m_sizing;
+        auto pctx = table.m_placement.context(table.m_storage, table_size, widths, sizing);
+        auto sctx = table.m_storage.context(table_size, widths);
+
+        size_t const hash_width = table.real_width();
+        m_size = table.size();
+        m_key_width = table.key_width();
+
+        // Partitions of about `keys_per_partition` keys
+        size_t partition_bits = 0;
+        while (partition_bits + 1 < hash_width
+               && (m_size >> (partition_bits + 1)) >= config.keys_per_partition) {
+            partition_bits++;
+        }
+        m_partition_bits = partition_bits;
+        m_quotient_width = hash_width - partition_bits;
+        size_t const partitions = 1ull << partition_bits;
+        uint64_t const partition_mask = partitions - 1;
+
+        size_t const keys_per_partition = std::max<size_t>(1, m_size >> partition_bits);
+        m_buckets_per_partition = (keys_per_partition + config.keys_per_bucket - 1)
+                                / config.keys_per_bucket;
+
+        // Sort the quotients and values by partition
+        auto for_all_entries = [&](auto f) {
+            pctx.for_all_allocated([&](auto initial_address, auto pos) {
+                auto ptr = sctx.at(sctx.table_pos(pos));
+                uint64_t const hres = sizing.compose_hashed_value(initial_address,
+                                                                  ptr.get_quotient());
+                f(hres, value_of(ptr));
+            });
+        };
+
+        std::vector<size_t> offsets(partitions + 1);
+        uint64_t max_value = 0;
+        for_all_entries([&](uint64_t hres, uint64_t value) {
+            offsets[(hres & partition_mask) + 1]++;
+            max_value = std::max(max_value, value);
+        });
+        for (size_t j = 0; j < partitions; j++) {
+            offsets[j + 1] += offsets[j];
+        }
+        DCHECK_EQ(offsets[partitions], m_size);
+        m_value_width = has_values ? bits_for(max_value) : 0;
+
+        std::vector<uint64_t> quotients(m_size);
+        std::vector<uint64_t> values(has_values ? m_size : 0);
+        {
+            std::vector<size_t> cursor(offsets.begin(), offsets.end() - 1);
+            for_all_entries([&](uint64_t hres, uint64_t value) {
+                size_t const i = cursor[hres & partition_mask]++;
+                quotients[i] = hres >> partition_bits;
+                if (has_values) {
+                    values[i] = value;
+                }
+            });
+        }
+
+        // Search the pilots of the partitions in parallel
+        std::vector<uint64_t> pilots(partitions * m_buckets_per_partition);
+        std::vector<uint64_t> max_pilots(partitions);
+        parallel_ranges(partitions, 1, config.threads, [&](size_t begin, size_t end) {
+            for (size_t j = begin; j < end; j++) {
+                max_pilots[j] = build_partition(
+                    quotients.data() + offsets[j],
+                    has_values ? values.data() + offsets[j] : nullptr,
+                    offsets[j + 1] - offsets[j],
+                    pilots.data() + j * m_buckets_per_partition);
+            }
+        });
+        m_pilot_width = bits_for(*std::max_element(max_pilots.begin(), max_pilots.end()));
+
+        // Pack the blocks of the partitions, and the entries
+        m_block_words = BLOCK_HEADER + words_for(m_buckets_per_partition, m_pilot_width);
+        m_blocks_size = partitions * m_block_words + 1;
+        m_blocks = std::make_unique<uint64_t[]>(m_blocks_size);
+        parallel_ranges(partitions, 1, config.threads, [&](size_t begin, size_t end) {
+            for (size_t j = begin; j < end; j++) {
+                uint64_t* block = m_blocks.get() + j * m_block_words;
+                block[0] = offsets[j];
+                block[1] = offsets[j + 1] - offsets[j];
+                for (size_t b = 0; b < m_buckets_per_partition; b++) {
+                    set_bits(block + BLOCK_HEADER, b * m_pilot_width, m_pilot_width,
+                             pilots[j * m_buckets_per_partition + b]);
+                }
+            }
+        });
+
+        // NB: Ranges of 64 entries start at word boundaries,
+        // so the threads never write to the same word.
+        size_t const width = entry_width();
+        m_entries_size = words_for(m_size, width) + 1;
+        m_entries = std::make_unique<uint64_t[]>(m_entries_size);
+        parallel_ranges(m_size, 64, config.threads, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                set_bits(m_entries.get(), i * width, m_quotient_width, quotients[i]);
+                if (has_values) {
+                    set_bits(m_entries.get(), i * width + m_quotient_width, m_value_width, values[i]);
+                }
+            }
+        });
+    }
+
+    inline perfect_hashmap_t() = default;
+public:
+    inline perfect_hashmap_t(perfect_hashmap_t&& other) = default;
+    inline perfect_hashmap_t& operator=(perfect_hashmap_t&& other) = default;
+
+    /// Builds the perfect hashmap of `map`, which needs integer values.
+    template<typename val_t, template<typename> typename storage_t, typename placement_t>
+    inline static perfect_hashmap_t build(hashmap_t<val_t, hash_t, storage_t, placement_t>& map,
+                                          config_args config) {
+        return perfect_hashmap_t(map, config, true, [](auto ptr) {
+            return uint64_t(*ptr.val_ptr());
+        });
+    }
+
+    /// Builds the perfect hashmap of `set`, with values of width 0.
+    template<typename placement_t>
+    inline static perfect_hashmap_t build(set::hashset_t<hash_t, placement_t>& set,
+                                          config_args config) {
+        return perfect_hashmap_t(set, config, false, [](auto) {
+            return uint64_t(0);
+        });
+    }
+
+    template<typename table_t>
+    inline static perfect_hashmap_t build(table_t& table) {
+        return build(table, config_args{});
+    }
+
+    /// Returns the amount of elements inside the datastructure.
+    inline size_t size() const {
+        return m_size;
+    }
+
+    /// Width of the keys stored in this datastructure.
+    inline size_t key_width() const {
+        return m_key_width;
+    }
+
+    /// Width of the values stored in this datastructure.
+    inline size_t value_width() const {
+        return m_value_width;
+    }
+
+    /// Width of the pilots of the buckets.
+    inline size_t pilot_width() const {
+        return m_pilot_width;
+    }
+
+    /// Search for a key inside the hashtable.
+    ///
+    /// Returns `true` and sets `value` if the key is found.
+    inline bool search(uint64_t key, uint64_t& value) const {
+        DCHECK(key_width() == 64 || (key >> key_width()) == 0);
+
+        uint64_t const hres = m_hash.hash(key);
+        uint64_t const partition = hres & ((1ull << m_partition_bits) - 1);
+        uint64_t const quotient = hres >> m_partition_bits;
+
+        uint64_t const* block = m_blocks.get() + partition * m_block_words;
+        size_t const size = block[1];
+        if (size == 0) return false;
+
+        uint64_t const pilot = get_bits(block + BLOCK_HEADER,
+                                        bucket_of(quotient) * m_pilot_width,
+                                        m_pilot_width);
+        size_t const bit = (block[0] + position_of(quotient, pilot, size)) * entry_width();
+        if (get_bits(m_entries.get(), bit, m_quotient_width) != quotient) {
+            return false;
+        }
+        value = get_bits(m_entries.get(), bit + m_quotient_width, m_value_width);
+        return true;
+    }
+
+    /// Count the number of occurrences of `key`, as defined on STL containers.
+    ///
+    /// It will return either 0 or 1.
+    inline size_t count(uint64_t key) const {
+        uint64_t value;
+        return search(key, value);
+    }
+};
+
+/// Builds an immutable `perfect_hashmap_t` from `map`, which stays unchanged.
+template<typename val_t, typename hash_t, template<typename> typename storage_t, typename placement_t>
+inline perfect_hashmap_t<hash_t> freeze_perfect(
+    hashmap_t<val_t, hash_t, storage_t, placement_t>& map,
+    typename perfect_hashmap_t<hash_t>::config_args config)
+{
+    return perfect_hashmap_t<hash_t>::build(map, config);
+}
+
+template<typename val_t, typename hash_t, template<typename> typename storage_t, typename placement_t>
+inline perfect_hashmap_t<hash_t> freeze_perfect(hashmap_t<val_t, hash_t, storage_t, placement_t>& map) {
+    return perfect_hashmap_t<hash_t>::build(map);
+}
+
+/// Builds an immutable `perfect_hashmap_t` from `set`, which stays unchanged.
+template<typename hash_t, typename placement_t>
+inline perfect_hashmap_t<hash_t> freeze_perfect(
+    set::hashset_t<hash_t, placement_t>& set,
+    typename perfect_hashmap_t<hash_t>::config_args config)
+{
+    return perfect_hashmap_t<hash_t>::build(set, config);
+}
+
+template<typename hash_t, typename placement_t>
+inline perfect_hashmap_t<hash_t> freeze_perfect(set::hashset_t<hash_t, placement_t>& set) {
+    return perfect_hashmap_t<hash_t>::build(set);
+}
+
+}}
+
+template<typename hash_t>
+struct heap_size<compact_hash::map::perfect_hashmap_t<hash_t>> {
+    using T = compact_hash::map::perfect_hashmap_t<hash_t>;
+
+    static object_size_t compute(T const& val) {
+        auto bytes = object_size_t::exact(sizeof(T));
+        bytes += object_size_t::exact(val.m_blocks_size * sizeof(uint64_t));
+        bytes += object_size_t::exact(val.m_entries_size * sizeof(uint64_t));
+        return bytes;
+    }
+};
+
+template<typename hash_t>
+struct serialize<compact_hash::map::perfect_hashmap_t<hash_t>> {
+    using T = compact_hash::map::perfect_hashmap_t<hash_t>;
+
+    static object_size_t write(std::ostream& out, T const& val) {
+        auto bytes = object_size_t::empty();
+
+        bytes += serialize<hash_t>::write(out, val.m_hash);
+        bytes += serialize<size_t>::write(out, val.m_size);
+        bytes += serialize<uint8_t>::write(out, val.m_key_width);
+        bytes += serialize<uint8_t>::write(out, val.m_partition_bits);
+        bytes += serialize<uint8_t>::write(out, val.m_quotient_width);
+        bytes += serialize<uint8_t>::write(out, val.m_value_width);
+        bytes += serialize<uint8_t>::write(out, val.m_pilot_width);
+        bytes += serialize<size_t>::write(out, val.m_buckets_per_partition);
+        bytes += serialize<size_t>::write(out, val.m_block_words);
+
+        bytes += serialize<size_t>::write(out, val.m_blocks_size);
+        bytes += serialize_write_words(out, val.m_blocks.get(), val.m_blocks_size);
+        bytes += serialize<size_t>::write(out, val.m_entries_size);
+        bytes += serialize_write_words(out, val.m_entries.get(), val.m_entries_size);
+
+        return bytes;
+    }
+
+    static T read(std::istream& in) {
+        T val;
+
+        val.m_hash = serialize<hash_t>::read(in);
+        val.m_size = serialize<size_t>::read(in);
+        val.m_key_width = serialize<uint8_t>::read(in);
+        val.m_partition_bits = serialize<uint8_t>::read(in);
+        val.m_quotient_width = serialize<uint8_t>::read(in);
+        val.m_value_width = serialize<uint8_t>::read(in);
+        val.m_pilot_width = serialize<uint8_t>::read(in);
+        val.m_buckets_per_partition = serialize<size_t>::read(in);
+        val.m_block_words = serialize<size_t>::read(in);
+
+        val.m_blocks_size = serialize<size_t>::read(in);
+        val.m_blocks = std::make_unique<uint64_t[]>(val.m_blocks_size);
+        serialize_read_words(in, val.m_blocks.get(), val.m_blocks_size);
+        val.m_entries_size = serialize<size_t>::read(in);
+        val.m_entries = std::make_unique<uint64_t[]>(val.m_entries_size);
+        serialize_read_words(in, val.m_entries.get(), val.m_entries_size);
+
+        return val;
+    }
+
+    static bool equal_check(T const& lhs, T const& rhs) {
+        return gen_equal_check(m_size)
+            && gen_equal_check(m_key_width)
+            && gen_equal_check(m_partition_bits)
+            && gen_equal_check(m_quotient_width)
+            && gen_equal_check(m_value_width)
+            && gen_equal_check(m_pilot_width)
+            && gen_equal_check(m_buckets_per_partition)
+            && gen_equal_check(m_block_words)
+            && gen_equal_check(m_blocks_size)
+            && gen_equal_check(m_entries_size)
+            && gen_equal_diagnostic(std::equal(lhs.m_blocks.get(), lhs.m_blocks.get() + lhs.m_blocks_size,
+                                               rhs.m_blocks.get()))
+            && gen_equal_diagnostic(std::equal(lhs.m_entries.get(), lhs.m_entries.get() + lhs.m_entries_size,
+                                               rhs.m_entries.get()));
+    }
+};
+
+}
@@ -4,11 +4,16 @@
 #include <tudocomp/util/compact_hash/hash_functions.hpp>
 #include <tudocomp/util/compact_hash/storage/buckets_bv_t.hpp>
 #include <tudocomp/util/compact_hash/storage/plain_sentinel_t.hpp>
+#include <tudocomp/util/compact_hash/storage/plain_bv_t.hpp>
 #include <tudocomp/util/compact_hash/index_structure/cv_bvs_t.hpp>
+#include <tudocomp/util/compact_hash/index_structure/cuckoo_t.hpp>
+#include <tudocomp/util/compact_hash/index_structure/hopscotch_t.hpp>
 #include <tudocomp/util/compact_hash/index_structure/displacement_t.hpp>
 #include <tudocomp/util/compact_hash/index_structure/elias_gamma_displacement_table_t.hpp>
 #include <tudocomp/util/compact_hash/index_structure/layered_displacement_table_t.hpp>
+#include <tudocomp/util/compact_hash/index_structure/compact_hash_spill_t.hpp>
 #include <tudocomp/util/compact_hash/index_structure/naive_displacement_table_t.hpp>
+#include <tudocomp/util/compact_hash/index_structure/robin_hood_t.hpp>
 
 namespace tdc {namespace compact_hash {namespace map {
 
@@ -20,12 +25,32 @@ template<typename val_t, typename hash_t = poplar_xorshift_t>
 using sparse_cv_hashmap_t
     = hashmap_t<val_t, hash_t, buckets_bv_t, cv_bvs_t>;
 
+template<typename val_t, typename hash_t = poplar_xorshift_t>
+using mmap_cv_hashmap_t
+    = hashmap_t<val_t, hash_t, mmap_sentinel_t, cv_bvs_t>;
+
+template<typename val_t, typename hash_t = poplar_xorshift_t>
+using plain_bv_cv_hashmap_t
+    = hashmap_t<val_t, hash_t, plain_bv_t, cv_bvs_t>;
+
 template<typename val_t, typename hash_t = poplar_xorshift_t>
 using plain_layered_hashmap_t
     = hashmap_t<
         val_t, hash_t, plain_sentinel_t,
         displacement_t<layered_displacement_table_t<dynamic_layered_bit_width_t>>>;
 
+template<typename val_t, typename hash_t = poplar_xorshift_t>
+using plain_bv_layered_hashmap_t
+    = hashmap_t<
+        val_t, hash_t, plain_bv_t,
+        displacement_t<layered_displacement_table_t<dynamic_layered_bit_width_t>>>;
+
+template<typename val_t, typename hash_t = poplar_xorshift_t>
+using mmap_layered_hashmap_t
+    = hashmap_t<
+        val_t, hash_t, mmap_sentinel_t,
+        displacement_t<layered_displacement_table_t<dynamic_layered_bit_width_t>>>;
+
 template<typename val_t, typename hash_t = poplar_xorshift_t>
 using sparse_layered_hashmap_t
     = hashmap_t<
@@ -46,4 +71,32 @@ using sparse_elias_hashmap_t
         displacement_t<elias_gamma_displacement_table_t<
             dynamic_fixed_elias_gamma_bucket_size_t>>>;
 
+template<typename val_t, typename hash_t = poplar_xorshift_t>
+using plain_robin_hood_hashmap_t
+    = hashmap_t<
+        val_t, hash_t, plain_sentinel_t,
+        robin_hood_t<layered_displacement_table_t<dynamic_layered_bit_width_t>>>;
+
+template<typename val_t, typename hash_t = poplar_xorshift_t>
+using sparse_robin_hood_hashmap_t
+    = hashmap_t<
+        val_t, hash_t, buckets_bv_t,
+        robin_hood_t<layered_displacement_table_t<dynamic_layered_bit_width_t>>>;
+
+template<typename val_t, typename hash_t = poplar_xorshift_t>
+using plain_cuckoo_hashmap_t
+    = hashmap_t<val_t, hash_t, plain_sentinel_t, cuckoo_t>;
+
+template<typename val_t, typename hash_t = poplar_xorshift_t>
+using sparse_cuckoo_hashmap_t
+    = hashmap_t<val_t, hash_t, buckets_bv_t, cuckoo_t>;
+
+template<typename val_t, typename hash_t = poplar_xorshift_t>
+using plain_hopscotch_hashmap_t
+    = hashmap_t<val_t, hash_t, plain_sentinel_t, hopscotch_t<>>;
+
+template<typename val_t, typename hash_t = poplar_xorshift_t>
+using sparse_hopscotch_hashmap_t
+    = hashmap_t<val_t, hash_t, buckets_bv_t, hopscotch_t<>>;
+
 }}}
@@ -3,6 +3,8 @@
 
 #include <memory>
 #include <cstdint>
+#include <cstring>
+#include <type_traits>
 #include <utility>
 #include <algorithm>
 
@@ -24,11 +26,28 @@ struct val_quot_bucket_layout_t {
         cbp::cbp_layout_element_t<val_t> vals_layout;
         cbp::cbp_layout_element_t<dynamic_t> quots_layout;
         size_t overall_qword_size;
+        /// The word at which the quotients start, if they are padded.
+        size_t quots_word;
 
-        inline Layout(): vals_layout(), quots_layout(), overall_qword_size(0) {
+        inline Layout(): vals_layout(), quots_layout(), overall_qword_size(0), quots_word(0) {
         }
     };
-    inline static Layout calc_sizes(size_t size, QVWidths widths) {
+
+    /// Whether the `aligned` layout pads the values,
+    /// such that the quotients start at a word boundary.
+    inline static bool pads_quots(QVWidths widths) {
+        return is_native_width(widths.quot_width);
+    }
+
+    /// Calculates the layout of `size` entries.
+    ///
+    /// The `aligned` layout, which is used by the buckets of sparse tables,
+    /// starts quotients of a native width at a word boundary
+    /// (by adding an empty array of words), such that they form an array
+    /// of native integers if `cbp_stores_native_arrays()`. The values start
+    /// at the beginning of the allocation, so values of a native width
+    /// already do.
+    inline static Layout calc_sizes(size_t size, QVWidths widths, bool aligned = false) {
         DCHECK_NE(size, 0U);
         DCHECK_LE(alignof(val_t), alignof(uint64_t));
 
@@ -37,21 +56,52 @@ struct val_quot_bucket_layout_t {
         // The values
         auto values = layout.cbp_elements<val_t>(size, widths.val_width);
 
+        Layout r;
+
         // The quotients
+        if (aligned && pads_quots(widths)) {
+            layout.cbp_elements<uint64_t>(0, 64);
+            r.quots_word = layout.get_size_in_uint64_t_units();
+        }
         auto quots = layout.cbp_elements<dynamic_t>(size, widths.quot_width);
 
-        Layout r;
         r.vals_layout = values;
         r.quots_layout = quots;
         r.overall_qword_size = layout.get_size_in_uint64_t_units();
         return r;
     }
 
+    /// Calls `f(begin, end)` with the words `[begin, end)` of the value array,
+    /// and then of the quotient array, that only hold the slots `[first, last)`.
+    ///
+    /// NB: The words are found with layouts that end behind slot `first` and `last`.
+    /// The ones shared with slots outside of the range are left out, and since
+    /// these layouts round up to whole words, so can be the last word of the range.
+    template<typename F>
+    inline static void for_words_of_slots(size_t size, QVWidths widths,
+                                          size_t first, size_t last, F f) {
+        DCHECK_LE(first, last);
+        DCHECK_LE(last, size);
+        auto words_up_to = [&](size_t vals, size_t quots) -> size_t {
+            auto layout = cbp::bit_layout_t();
+            layout.cbp_elements<val_t>(vals, widths.val_width);
+            layout.cbp_elements<dynamic_t>(quots, widths.quot_width);
+            return layout.get_size_in_uint64_t_units();
+        };
+        auto words_of = [&](size_t begin, size_t end) {
+            if (begin + 1 < end) {
+                f(begin, end - 1);
+            }
+        };
+        words_of(words_up_to(first, 0), words_up_to(last, 0));
+        words_of(words_up_to(size, first), words_up_to(size, last));
+    }
+
     /// Creates the pointers to the beginnings of the two arrays inside
     /// the allocation.
-    inline static val_quot_ptrs_t<val_t> ptr(uint64_t* alloc, size_t size, QVWidths widths) {
+    inline static val_quot_ptrs_t<val_t> ptr(uint64_t* alloc, size_t size, QVWidths widths, bool aligned = false) {
         DCHECK_NE(size, 0U);
-        auto layout = calc_sizes(size, widths);
+        auto layout = calc_sizes(size, widths, aligned);
 
         return val_quot_ptrs_t<val_t> {
             layout.vals_layout.ptr_relative_to(alloc),
@@ -60,9 +110,9 @@ struct val_quot_bucket_layout_t {
     }
 
     // Run destructors of each element in the bucket.
-    inline static void destroy_vals(uint64_t* alloc, size_t size, QVWidths widths) {
+    inline static void destroy_vals(uint64_t* alloc, size_t size, QVWidths widths, bool aligned = false) {
         if (size != 0) {
-            auto start = ptr(alloc, size, widths).val_ptr();
+            auto start = ptr(alloc, size, widths, aligned).val_ptr();
             auto end = start + size;
 
             for(; start != end; start++) {
@@ -73,15 +123,98 @@ struct val_quot_bucket_layout_t {
 
     /// Returns a `val_quot_ptrs_t` to position `pos`,
     /// or a sentinel value that acts as a one-pass-the-end pointer for the empty case.
-    inline static val_quot_ptrs_t<val_t> at(uint64_t* alloc, size_t size, size_t pos, QVWidths widths) {
+    inline static val_quot_ptrs_t<val_t> at(uint64_t* alloc, size_t size, size_t pos, QVWidths widths, bool aligned = false) {
         if(size != 0) {
-            auto ps = ptr(alloc, size, widths);
+            auto ps = ptr(alloc, size, widths, aligned);
             return val_quot_ptrs_t<val_t>(ps.val_ptr() + pos, ps.quot_ptr() + pos);
         } else {
             DCHECK_EQ(pos, 0U);
             return val_quot_ptrs_t<val_t>();
         }
     }
+
+    /// Relocates the `n` entries starting at position `src_pos` of the
+    /// aligned allocation `src` of `src_size` entries to the ones starting
+    /// at position `dst_pos` of the aligned allocation `dst` of `dst_size`
+    /// entries, see `val_quot_ptrs_t::relocate()`.
+    ///
+    /// Quotients and values of a native width are moved with `memcpy()`.
+    inline static void relocate(uint64_t* dst, size_t dst_size, size_t dst_pos,
+                                uint64_t* src, size_t src_size, size_t src_pos,
+                                size_t n, QVWidths widths) {
+        if (n == 0) {
+            return;
+        }
+        DCHECK_LE(dst_pos + n, dst_size);
+        DCHECK_LE(src_pos + n, src_size);
+
+        // NB: `cbp_stores_native_arrays()` is checked only here,
+        // such that lookups do not pay for it.
+        if (!(pads_quots(widths) && cbp_stores_native_arrays())) {
+            val_quot_ptrs_t<val_t>::relocate(at(dst, dst_size, dst_pos, widths, true),
+                                             at(src, src_size, src_pos, widths, true),
+                                             n);
+            return;
+        }
+
+        if (std::is_same<val_t, dynamic_t>::value && is_native_width(widths.val_width)) {
+            size_t const bytes = widths.val_width / 8;
+            std::memcpy(reinterpret_cast<char*>(dst) + dst_pos * bytes,
+                        reinterpret_cast<char const*>(src) + src_pos * bytes,
+                        n * bytes);
+        } else {
+            val_quot_ptrs_t<val_t>::relocate_vals(at(dst, dst_size, dst_pos, widths, true).val_ptr(),
+                                                  at(src, src_size, src_pos, widths, true).val_ptr(),
+                                                  n);
+        }
+
+        size_t const bytes = widths.quot_width / 8;
+        std::memcpy(reinterpret_cast<char*>(dst + calc_sizes(dst_size, widths, true).quots_word) + dst_pos * bytes,
+                    reinterpret_cast<char const*>(src + calc_sizes(src_size, widths, true).quots_word) + src_pos * bytes,
+                    n * bytes);
+    }
+
+    /// Whether the aligned and the packed layout of `size` entries
+    /// can differ, such that they need to be converted into each other.
+    inline static bool aligned_differs(size_t, QVWidths widths) {
+        return pads_quots(widths);
+    }
+
+    /// Copies the `size` entries of the aligned allocation `aligned`
+    /// into the zeroed allocation `packed` of the packed layout.
+    ///
+    /// Serialized buckets use the packed layout, such that their format
+    /// does not change with the padding.
+    inline static void to_packed(uint64_t const* aligned, uint64_t* packed, size_t size, QVWidths widths) {
+        convert(const_cast<uint64_t*>(aligned), true, packed, false, size, widths);
+    }
+
+    /// Copies the `size` entries of the packed allocation `packed`
+    /// into the zeroed allocation `aligned` of the aligned layout.
+    inline static void from_packed(uint64_t const* packed, uint64_t* aligned, size_t size, QVWidths widths) {
+        convert(const_cast<uint64_t*>(packed), false, aligned, true, size, widths);
+    }
+
+private:
+    /// NB: The values lie at the same bits in both layouts, and end
+    /// before the word at which the aligned quotients start. Its bits behind
+    /// the values are either padding or packed quotients, and the latter
+    /// are overwritten by the quotients copied afterwards.
+    inline static void convert(uint64_t* src, bool src_aligned,
+                               uint64_t* dst, bool dst_aligned,
+                               size_t size, QVWidths widths) {
+        if (size == 0) {
+            return;
+        }
+        size_t const value_words = calc_sizes(size, widths, true).quots_word;
+        std::copy(src, src + value_words, dst);
+
+        auto src_quots = ptr(src, size, widths, src_aligned).quot_ptr();
+        auto dst_quots = ptr(dst, size, widths, dst_aligned).quot_ptr();
+        for (size_t i = 0; i < size; i++) {
+            *(dst_quots + i) = uint64_t(*(src_quots + i));
+        }
+    }
 };
 
 }}}
@@ -2,6 +2,9 @@
 
 #include <memory>
 #include <cstdint>
+#include <cstring>
+#include <new>
+#include <type_traits>
 #include <utility>
 #include <algorithm>
 
@@ -24,6 +27,17 @@ public:
         value_type val;
     };
 
+    /// Whether the values are relocated with `memcpy()`, which needs
+    /// values that are not bit-packed, and `is_trivially_relocatable`.
+    static constexpr bool relocates_by_memcpy =
+        std::is_same<ValPtr<val_t>, val_t*>::value && is_trivially_relocatable<val_t>::value;
+
+    /// The raw bytes of an entry moved out with `relocate_out()`.
+    struct relocated_type {
+        uint64_t quot;
+        typename std::aligned_storage<sizeof(value_type), alignof(value_type)>::type val;
+    };
+
     inline val_quot_ptrs_t(ValPtr<val_t> val_ptr,
                       QuotPtr quot_ptr):
         m_val_ptr(val_ptr),
@@ -97,6 +111,12 @@ public:
         cbp::cbp_repr_t<val_t>::construct_val_from_rval(val_ptr(), std::move(val));
     }
 
+    /// Constructs the value in place from `args`.
+    template<typename... Args>
+    inline void emplace_val_no_drop(Args&&... args) {
+        construct_val_no_drop(std::is_same<ValPtr<val_t>, val_t*>(), std::forward<Args>(args)...);
+    }
+
     inline void move_from(val_quot_ptrs_t other) {
         *val_ptr() = std::move(*other.val_ptr());
         set_quotient(other.get_quotient());
@@ -107,6 +127,38 @@ public:
         set_quotient(other.get_quotient());
     }
 
+    /// Constructs the `n` entries starting at `dst` from the ones starting
+    /// at `src`, and ends the lifetime of the latter.
+    ///
+    /// The ranges must not overlap.
+    inline static void relocate(val_quot_ptrs_t dst, val_quot_ptrs_t src, size_t n) {
+        relocate(std::integral_constant<bool, relocates_by_memcpy>(), dst, src, n);
+    }
+
+    /// Constructs the `n` values starting at `dst` from the ones starting
+    /// at `src`, and ends the lifetime of the latter.
+    ///
+    /// The ranges must not overlap.
+    inline static void relocate_vals(ValPtr<val_t> dst, ValPtr<val_t> src, size_t n) {
+        relocate_vals(std::integral_constant<bool, relocates_by_memcpy>(), dst, src, n);
+    }
+
+    /// Moves the raw bytes of the entry out, which ends its lifetime
+    /// without calling its destructor. Expects `relocates_by_memcpy`.
+    inline relocated_type relocate_out() const {
+        relocated_type r;
+        r.quot = get_quotient();
+        std::memcpy(&r.val, static_cast<void const*>(val_ptr()), sizeof(value_type));
+        return r;
+    }
+
+    /// Moves the raw bytes of `other` into the uninitialized
+    /// location of this entry. Expects `relocates_by_memcpy`.
+    inline void relocate_in(relocated_type const& other) const {
+        set_quotient(other.quot);
+        std::memcpy(static_cast<void*>(val_ptr()), &other.val, sizeof(value_type));
+    }
+
     inline void swap_with(val_quot_ptrs_t other) {
         value_type tmp_val = std::move(*val_ptr());
         uint64_t tmp_quot = get_quotient();
@@ -134,6 +186,46 @@ public:
         set_quotient(val.quot);
         *val_ptr() = std::move(val.val);
     }
+
+private:
+    template<typename... Args>
+    inline void construct_val_no_drop(std::true_type, Args&&... args) {
+        new (val_ptr()) value_type(std::forward<Args>(args)...);
+    }
+    template<typename... Args>
+    inline void construct_val_no_drop(std::false_type, Args&&... args) {
+        set_val_no_drop(value_type(std::forward<Args>(args)...));
+    }
+
+    inline static void relocate(std::true_type, val_quot_ptrs_t dst, val_quot_ptrs_t src, size_t n) {
+        relocate_vals(std::true_type(), dst.val_ptr(), src.val_ptr(), n);
+        for (size_t i = 0; i < n; i++) {
+            *dst.m_quot_ptr = uint64_t(*src.m_quot_ptr);
+            dst.m_quot_ptr++;
+            src.m_quot_ptr++;
+        }
+    }
+    inline static void relocate(std::false_type, val_quot_ptrs_t dst, val_quot_ptrs_t src, size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            dst.init_from(src);
+            src.uninitialize();
+            dst.increment_ptr();
+            src.increment_ptr();
+        }
+    }
+    inline static void relocate_vals(std::true_type, ValPtr<val_t> dst, ValPtr<val_t> src, size_t n) {
+        if (n != 0) {
+            std::memcpy(static_cast<void*>(dst), static_cast<void const*>(src), n * sizeof(value_type));
+        }
+    }
+    inline static void relocate_vals(std::false_type, ValPtr<val_t> dst, ValPtr<val_t> src, size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            cbp::cbp_repr_t<val_t>::construct_val_from_ptr(dst, src);
+            cbp::cbp_repr_t<val_t>::call_destructor(src);
+            dst++;
+            src++;
+        }
+    }
 };
 
 }}}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <glog/logging.h>
+
+#include <tudocomp/util/heap_size.hpp>
+
+namespace tdc {namespace compact_hash{namespace map {
+
+/// Storage for values of type `val_t` at stable addresses, allocated
+/// from slabs of a fixed number of slots that are never moved.
+///
+/// Each slot is named by an index, such that a table can store the
+/// index of a value in few bits instead of the value itself.
+/// The arena only manages the memory of the slots:
+/// The values are constructed and destroyed by the caller, which also
+/// has to know which slots hold a value.
+template<typename val_t>
+class value_arena_t {
+    using slot_t = typename std::aligned_storage<sizeof(val_t), alignof(val_t)>::type;
+
+    /// Slabs of about 64 KiB, with a power of two number of slots.
+    inline static constexpr size_t calc_slab_bits(size_t slots, size_t bits) {
+        return (slots <= 1) ? bits : calc_slab_bits(slots / 2, bits + 1);
+    }
+
+    std::vector<std::unique_ptr<slot_t[]>> m_slabs;
+    std::vector<uint64_t> m_free;
+    uint64_t m_end = 0;
+
+    template<typename T>
+    friend struct ::tdc::heap_size;
+public:
+    /// log2 of the number of slots per slab.
+    static constexpr size_t SLAB_BITS = calc_slab_bits((size_t(1) << 16) / sizeof(slot_t), 0);
+    static constexpr size_t SLAB_SIZE = size_t(1) << SLAB_BITS;
+
+    inline value_arena_t() = default;
+    inline value_arena_t(value_arena_t&& other):
+        m_slabs(std::move(other.m_slabs)),
+        m_free(std::move(other.m_free)),
+        m_end(other.m_end)
+    {
+        other.m_end = 0;
+    }
+    inline value_arena_t& operator=(value_arena_t&& other) {
+        m_slabs = std::move(other.m_slabs);
+        m_free = std::move(other.m_free);
+        m_end = other.m_end;
+        other.m_end = 0;
+        return *this;
+    }
+
+    /// Returns the index of an unused slot, preferring the ones
+    /// released by `deallocate()`.
+    inline uint64_t allocate() {
+        if (!m_free.empty()) {
+            uint64_t const index = m_free.back();
+            m_free.pop_back();
+            return index;
+        }
+        if ((m_end >> SLAB_BITS) == m_slabs.size()) {
+            m_slabs.push_back(std::make_unique<slot_t[]>(SLAB_SIZE));
+        }
+        return m_end++;
+    }
+
+    /// Releases the slot `index` for reuse.
+    ///
+    /// The value in it has to be destroyed already.
+    inline void deallocate(uint64_t index) {
+        DCHECK_LT(index, m_end);
+        m_free.push_back(index);
+    }
+
+    /// Returns the address of the slot `index`, which stays the same
+    /// until the arena is destroyed.
+    inline val_t* at(uint64_t index) const {
+        DCHECK_LT(index, m_end);
+        slot_t* slot = &m_slabs[index >> SLAB_BITS][index & (SLAB_SIZE - 1)];
+        return reinterpret_cast<val_t*>(slot);
+    }
+
+    /// One past the largest index handed out so far.
+    inline uint64_t end() const {
+        return m_end;
+    }
+
+    /// Returns true if no slot was handed out yet.
+    inline bool empty() const {
+        return m_end == 0;
+    }
+};
+
+}}
+
+template<typename val_t>
+struct heap_size<compact_hash::map::value_arena_t<val_t>> {
+    using T = compact_hash::map::value_arena_t<val_t>;
+
+    static object_size_t compute(T const& val) {
+        auto bytes = object_size_t::exact(sizeof(T));
+
+        bytes += object_size_t::exact(val.m_slabs.capacity() * sizeof(val.m_slabs[0]));
+        bytes += object_size_t::exact(val.m_slabs.size() * T::SLAB_SIZE * sizeof(val_t));
+        bytes += object_size_t::exact(val.m_free.capacity() * sizeof(uint64_t));
+
+        return bytes;
+    }
+};
+
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <string>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <glog/logging.h>
+
+namespace tdc {namespace compact_hash {
+
+/// Maps a file read-only into memory.
+///
+/// The mapping is shared, so that the pages of the file
+/// are shared between all processes that map it.
+class mmap_file_t {
+    void* m_data = nullptr;
+    size_t m_size = 0;
+
+    inline void unmap() {
+        if (m_data != nullptr) {
+            munmap(m_data, m_size);
+            m_data = nullptr;
+            m_size = 0;
+        }
+    }
+public:
+    inline mmap_file_t() = default;
+
+    /// Maps the file at `path`.
+    ///
+    /// If `populate` is set, the whole file is read into memory up front.
+    inline mmap_file_t(std::string const& path, bool populate = false) {
+        int fd = open(path.c_str(), O_RDONLY);
+        CHECK_GE(fd, 0) << "Could not open " << path;
+
+        struct stat st;
+        CHECK_EQ(fstat(fd, &st), 0) << "Could not stat " << path;
+        m_size = st.st_size;
+
+        if (m_size > 0) {
+            int flags = MAP_SHARED;
+#ifdef MAP_POPULATE
+            if (populate) {
+                flags |= MAP_POPULATE;
+            }
+#endif
+            m_data = mmap(nullptr, m_size, PROT_READ, flags, fd, 0);
+            CHECK(m_data != MAP_FAILED) << "Could not map " << path;
+        }
+
+        close(fd);
+    }
+
+    inline mmap_file_t(mmap_file_t&& other):
+        m_data(other.m_data), m_size(other.m_size)
+    {
+        other.m_data = nullptr;
+        other.m_size = 0;
+    }
+    inline mmap_file_t& operator=(mmap_file_t&& other) {
+        unmap();
+        std::swap(m_data, other.m_data);
+        std::swap(m_size, other.m_size);
+        return *this;
+    }
+    inline mmap_file_t(mmap_file_t const& other) = delete;
+    inline mmap_file_t& operator=(mmap_file_t const& other) = delete;
+
+    inline ~mmap_file_t() {
+        unmap();
+    }
+
+    /// Start of the mapped file, aligned to the page size.
+    inline void const* data() const {
+        return m_data;
+    }
+
+    /// Size of the mapped file in bytes.
+    inline size_t size() const {
+        return m_size;
+    }
+};
+
+}}
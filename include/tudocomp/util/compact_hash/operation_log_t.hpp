@@ -0,0 +1,343 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <glog/logging.h>
+
+#include <tudocomp/util/chunked_serialization.hpp>
+
+namespace tdc {namespace compact_hash {
+
+/// One insert operation recorded in an `operation_log_t`.
+///
+/// For sets, `value_width` is zero and `value` is unused.
+struct operation_log_record_t {
+    uint64_t key;
+    uint64_t value;
+    uint8_t key_width;
+    uint8_t value_width;
+};
+
+/// Append-only log of the insert operations of a hash table, stored in a
+/// local file.
+///
+/// Records are buffered and appended in groups, with one `write` per group
+/// (group commit). Each group is framed by its record count, its size in
+/// bits and a checksum, so that a group torn by a crash is detected
+/// and ignored on replay. The file is synced with `fdatasync` after every
+/// `config_args::groups_per_sync` groups.
+///
+/// Each record is bit-packed as:
+/// - key width - 1 (6 bits), and the key (key width bits)
+/// - value width (7 bits), and the value (value width bits)
+class operation_log_t {
+public:
+    /// runtime initilization arguments, if any
+    struct config_args {
+        /// Number of buffered records that are committed as one group.
+        size_t records_per_group = 4096;
+        /// Number of groups after which the file is synced to disk,
+        /// or 0 to never sync implicitly.
+        size_t groups_per_sync = 1;
+    };
+
+private:
+    static constexpr uint64_t MAGIC = 0x474F4C504F434454ull; // "TDCOPLOG"
+    static constexpr uint64_t VERSION = 1;
+
+    std::string m_path;
+    config_args m_config;
+    int m_fd = -1;
+
+    std::vector<uint64_t> m_group;
+    size_t m_group_bits = 0;
+    size_t m_group_records = 0;
+    size_t m_unsynced_groups = 0;
+
+    inline void append_bits(uint64_t value, size_t bits) {
+        if (bits == 0) return;
+        if (bits < 64) value &= (1ull << bits) - 1;
+
+        size_t const offset = m_group_bits % 64;
+        if (offset == 0) {
+            m_group.push_back(0);
+        }
+        m_group.back() |= value << offset;
+        if (offset + bits > 64) {
+            m_group.push_back(value >> (64 - offset));
+        }
+        m_group_bits += bits;
+    }
+
+    inline static uint64_t read_bits(uint64_t const* data, size_t& bit_pos, size_t bits) {
+        if (bits == 0) return 0;
+
+        size_t const word = bit_pos / 64;
+        size_t const offset = bit_pos % 64;
+        uint64_t value = data[word] >> offset;
+        if (offset + bits > 64) {
+            value |= data[word + 1] << (64 - offset);
+        }
+        if (bits < 64) value &= (1ull << bits) - 1;
+
+        bit_pos += bits;
+        return value;
+    }
+
+    /// Checksum of a group, including its record count and size.
+    inline static uint64_t group_checksum(uint64_t records, uint64_t bits, uint64_t const* data) {
+        uint64_t const words[3] = {
+            records,
+            bits,
+            chunk_checksum((char const*) data, (bits + 63) / 64 * sizeof(uint64_t)),
+        };
+        return chunk_checksum((char const*) words, sizeof(words));
+    }
+
+    inline void write_all(void const* data, size_t size) {
+        auto bytes = (char const*) data;
+        while (size > 0) {
+            ssize_t written = ::write(m_fd, bytes, size);
+            CHECK_GT(written, 0) << "Could not append to the operation log " << m_path;
+            bytes += written;
+            size -= written;
+        }
+    }
+public:
+    inline operation_log_t(std::string path):
+        operation_log_t(std::move(path), config_args()) {}
+
+    inline operation_log_t(std::string path, config_args config):
+        m_path(std::move(path)),
+        m_config(config)
+    {
+        CHECK_GT(m_config.records_per_group, 0u);
+
+        m_fd = ::open(m_path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+        CHECK_GE(m_fd, 0) << "Could not open the operation log " << m_path;
+
+        struct stat st;
+        CHECK_EQ(fstat(m_fd, &st), 0);
+
+        // NB: Drop a group torn by a crash, such that new groups
+        // are not appended behind it, where replay would not reach them.
+        size_t valid_bytes = 0;
+        if (st.st_size > 0) {
+            replay(m_path, [](operation_log_record_t const&) {}, &valid_bytes);
+            if (valid_bytes < size_t(st.st_size)) {
+                CHECK_EQ(ftruncate(m_fd, valid_bytes), 0)
+                    << "Could not truncate the operation log " << m_path;
+            }
+        }
+
+        // NB: A new log, or one torn inside its header, which replay
+        // reports as having no valid bytes.
+        if (valid_bytes == 0) {
+            uint64_t const header[2] = { MAGIC, VERSION };
+            write_all(header, sizeof(header));
+            m_unsynced_groups++;
+        }
+    }
+
+    inline operation_log_t(operation_log_t&& other):
+        m_path(std::move(other.m_path)),
+        m_config(other.m_config),
+        m_fd(other.m_fd),
+        m_group(std::move(other.m_group)),
+        m_group_bits(other.m_group_bits),
+        m_group_records(other.m_group_records),
+        m_unsynced_groups(other.m_unsynced_groups)
+    {
+        other.m_fd = -1;
+    }
+    inline operation_log_t(operation_log_t const& other) = delete;
+    inline operation_log_t& operator=(operation_log_t const& other) = delete;
+
+    inline ~operation_log_t() {
+        if (m_fd >= 0) {
+            commit();
+            sync();
+            ::close(m_fd);
+        }
+    }
+
+    /// Records the insert of a key into a set.
+    inline void append(uint64_t key, uint8_t key_width) {
+        append(key, key_width, 0, 0);
+    }
+
+    /// Records the insert or update of a key-value pair in a map.
+    inline void append(uint64_t key, uint8_t key_width, uint64_t value, uint8_t value_width) {
+        DCHECK_GE(key_width, 1u);
+        DCHECK_LE(key_width, 64u);
+        DCHECK_LE(value_width, 64u);
+
+        append_bits(key_width - 1, 6);
+        append_bits(key, key_width);
+        append_bits(value_width, 7);
+        append_bits(value, value_width);
+        m_group_records++;
+
+        if (m_group_records >= m_config.records_per_group) {
+            commit();
+        }
+    }
+
+    /// Appends the buffered records as one group.
+    inline void commit() {
+        if (m_group_records == 0) return;
+
+        uint64_t const header[3] = {
+            m_group_records,
+            m_group_bits,
+            group_checksum(m_group_records, m_group_bits, m_group.data()),
+        };
+        // NB: One write per group, so the header and the records are appended together.
+        m_group.insert(m_group.begin(), header, header + 3);
+        write_all(m_group.data(), m_group.size() * sizeof(uint64_t));
+
+        m_group.clear();
+        m_group_bits = 0;
+        m_group_records = 0;
+
+        m_unsynced_groups++;
+        if (m_config.groups_per_sync > 0 && m_unsynced_groups >= m_config.groups_per_sync) {
+            sync();
+        }
+    }
+
+    /// Makes all committed groups durable.
+    inline void sync() {
+        if (m_unsynced_groups == 0) return;
+        CHECK_EQ(fdatasync(m_fd), 0) << "Could not sync the operation log " << m_path;
+        m_unsynced_groups = 0;
+    }
+
+    /// Drops all records, e.g., after they are contained in a durable snapshot.
+    inline void reset() {
+        m_group.clear();
+        m_group_bits = 0;
+        m_group_records = 0;
+
+        CHECK_EQ(ftruncate(m_fd, 0), 0) << "Could not truncate the operation log " << m_path;
+        uint64_t const header[2] = { MAGIC, VERSION };
+        write_all(header, sizeof(header));
+        m_unsynced_groups++;
+        sync();
+    }
+
+    inline std::string const& path() const {
+        return m_path;
+    }
+
+    /// Calls `f(operation_log_record_t const&)` for all records of the log
+    /// at `path`, in the order they were appended, and returns their number.
+    ///
+    /// Replay stops at the first incomplete or corrupt group, which can be
+    /// left behind by a crash during a commit. A missing file counts as an
+    /// empty log. If `valid_bytes` is given, it is set to the size of
+    /// the log up to that group.
+    template<typename F>
+    inline static size_t replay(std::string const& path, F f, size_t* valid_bytes = nullptr) {
+        if (valid_bytes != nullptr) {
+            *valid_bytes = 0;
+        }
+
+        FILE* file = fopen(path.c_str(), "rb");
+        if (file == nullptr) {
+            return 0;
+        }
+
+        fseek(file, 0, SEEK_END);
+        size_t remaining_words = ftell(file) / sizeof(uint64_t);
+        fseek(file, 0, SEEK_SET);
+
+        auto read_words = [&](uint64_t* data, size_t size) {
+            if (size > remaining_words) return false;
+            remaining_words -= size;
+            return fread(data, sizeof(uint64_t), size, file) == size;
+        };
+
+        size_t count = 0;
+        uint64_t header[3];
+        if (read_words(header, 2)) {
+            CHECK_EQ(header[0], uint64_t(MAGIC)) << "Not an operation log: " << path;
+            CHECK_EQ(header[1], uint64_t(VERSION)) << "Unsupported version of the operation log " << path;
+            size_t valid_words = 2;
+
+            std::vector<uint64_t> group;
+            while (read_words(header, 3)) {
+                size_t const records = header[0];
+                size_t const bits = header[1];
+                if ((bits + 63) / 64 > remaining_words) break;
+                group.resize((bits + 63) / 64);
+                if (!read_words(group.data(), group.size())) break;
+                if (group_checksum(records, bits, group.data()) != header[2]) break;
+
+                // NB: Needed for reading the last value of a group with one access.
+                group.push_back(0);
+
+                size_t bit_pos = 0;
+                for (size_t i = 0; i < records; i++) {
+                    operation_log_record_t record;
+                    record.key_width = read_bits(group.data(), bit_pos, 6) + 1;
+                    record.key = read_bits(group.data(), bit_pos, record.key_width);
+                    record.value_width = read_bits(group.data(), bit_pos, 7);
+                    record.value = read_bits(group.data(), bit_pos, record.value_width);
+                    f(static_cast<operation_log_record_t const&>(record));
+                }
+                count += records;
+                valid_words += 3 + (bits + 63) / 64;
+            }
+            if (valid_bytes != nullptr) {
+                *valid_bytes = valid_words * sizeof(uint64_t);
+            }
+        }
+
+        fclose(file);
+        return count;
+    }
+};
+
+/// Writes a file with `f(std::ostream&)`, such that it is either
+/// completely replaced or left untouched by a crash.
+///
+/// The data is written to a temporary file next to `path`, synced,
+/// and renamed over `path`.
+template<typename F>
+inline void write_file_durably(std::string const& path, F f) {
+    std::string const tmp_path = path + ".tmp";
+    {
+        std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+        CHECK(out) << "Could not create " << tmp_path;
+        f(static_cast<std::ostream&>(out));
+        out.flush();
+        CHECK(out) << "Could not write " << tmp_path;
+    }
+
+    int fd = ::open(tmp_path.c_str(), O_RDONLY);
+    CHECK_GE(fd, 0) << "Could not open " << tmp_path;
+    CHECK_EQ(fsync(fd), 0) << "Could not sync " << tmp_path;
+    ::close(fd);
+
+    CHECK_EQ(rename(tmp_path.c_str(), path.c_str()), 0) << "Could not rename " << tmp_path;
+
+    // NB: The rename itself is durable once the directory is synced.
+    auto slash = path.rfind('/');
+    std::string const dir = (slash == std::string::npos) ? "." : path.substr(0, slash + 1);
+    int dir_fd = ::open(dir.c_str(), O_RDONLY);
+    if (dir_fd >= 0) {
+        fsync(dir_fd);
+        ::close(dir_fd);
+    }
+}
+
+}}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
+#endif
+
+namespace tdc {namespace compact_hash {
+
+/// Size of the pages backing a large array.
+enum class page_size_t {
+    /// The default page size of the system.
+    normal,
+    /// Transparent huge pages, requested with `madvise(MADV_HUGEPAGE)`.
+    transparent_huge,
+    /// Explicit 2 MiB pages, falling back to transparent huge pages
+    /// if none are available.
+    huge_2mb,
+    /// Explicit 1 GiB pages, falling back to transparent huge pages
+    /// if none are available.
+    huge_1gb,
+};
+
+/// Placement of the pages of a large array on the NUMA nodes.
+enum class numa_policy_t {
+    /// Each page is placed on the node of the thread that touches it first.
+    first_touch,
+    /// The pages are interleaved round-robin over all nodes.
+    interleave,
+};
+
+/// Size of a page of the given kind in bytes.
+inline size_t page_size_in_bytes(page_size_t page_size) {
+    switch (page_size) {
+        case page_size_t::huge_2mb:
+            return size_t(1) << 21;
+        case page_size_t::huge_1gb:
+            return size_t(1) << 30;
+        default:
+            return sysconf(_SC_PAGESIZE);
+    }
+}
+
+/// Calls `f(begin, bytes)` with the largest range of whole pages
+/// contained in `[data, data + bytes)`, if any.
+template<typename F>
+inline void with_whole_pages(void* data, size_t bytes, F f) {
+    uintptr_t const page = sysconf(_SC_PAGESIZE);
+    uintptr_t const begin = (uintptr_t(data) + page - 1) / page * page;
+    uintptr_t const end = (uintptr_t(data) + bytes) / page * page;
+    if (begin < end) {
+        f((void*) begin, size_t(end - begin));
+    }
+}
+
+/// Asks the kernel to back the pages in `[data, data + bytes)` with
+/// transparent huge pages.
+///
+/// This only affects pages that are not touched yet, or that get
+/// collapsed later on by the kernel.
+inline void advise_transparent_huge_pages(void* data, size_t bytes) {
+#ifdef MADV_HUGEPAGE
+    with_whole_pages(data, bytes, [](void* begin, size_t len) {
+        madvise(begin, len, MADV_HUGEPAGE);
+    });
+#endif
+}
+
+/// Interleaves the pages in `[data, data + bytes)` round-robin
+/// over all NUMA nodes.
+///
+/// This only affects pages that are not touched yet.
+inline void interleave_numa_nodes(void* data, size_t bytes) {
+#if defined(__linux__) && defined(SYS_mbind)
+    with_whole_pages(data, bytes, [](void* begin, size_t len) {
+        // NB: Nodes that do not exist are ignored by the kernel.
+        unsigned long nodemask = ~0ul;
+        syscall(SYS_mbind, begin, len, MPOL_INTERLEAVE,
+                &nodemask, sizeof(nodemask) * 8, 0);
+    });
+#endif
+}
+
+}}
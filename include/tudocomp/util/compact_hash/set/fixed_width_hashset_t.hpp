@@ -0,0 +1,165 @@
+#pragma once
+
+#include <glog/logging.h>
+
+#include <tudocomp/util/serialization.hpp>
+#include <tudocomp/util/heap_size.hpp>
+
+#include <tudocomp/util/compact_hash/set/hashset_t.hpp>
+#include <tudocomp/util/compact_hash/hash_functions.hpp>
+#include <tudocomp/util/compact_hash/index_structure/cv_bvs_t.hpp>
+
+namespace tdc {namespace compact_hash{namespace set {
+
+/// A hashset for keys of `key_bits` bits, fixed at compile time.
+///
+/// The default hash function `static_poplar_xorshift_t` has constant primes.
+/// There are no methods that change the key width, so the table only
+/// reallocates when its size grows.
+template<size_t key_bits,
+         typename hash_t = static_poplar_xorshift_t<key_bits>,
+         typename placement_t = cv_bvs_t>
+class fixed_width_hashset_t {
+    static_assert(0 < key_bits && key_bits <= 64, "key_bits has to be in [1, 64]");
+public:
+    using table_t = hashset_t<hash_t, placement_t>;
+
+    using config_args = typename table_t::config_args;
+    using entry_t = typename table_t::entry_t;
+    using default_on_resize_t = typename table_t::default_on_resize_t;
+
+    static constexpr size_t DEFAULT_TABLE_SIZE = table_t::DEFAULT_TABLE_SIZE;
+
+private:
+    table_t m_table;
+
+    template<typename T>
+    friend struct ::tdc::serialize;
+
+    template<typename T>
+    friend struct ::tdc::heap_size;
+
+    inline fixed_width_hashset_t(table_t&& table):
+        m_table(std::move(table)) {}
+public:
+    /// Constructs a hashtable with a initial table size `size`.
+    inline fixed_width_hashset_t(size_t size = DEFAULT_TABLE_SIZE):
+        m_table(size, key_bits) {}
+
+    inline fixed_width_hashset_t(size_t size, config_args config):
+        m_table(size, key_bits, config) {}
+
+    /// Width of the keys stored in this datastructure.
+    inline static constexpr size_t key_width() {
+        return key_bits;
+    }
+
+    /// Returns the amount of elements inside the datastructure.
+    inline size_t size() const {
+        return m_table.size();
+    }
+
+    /// Returns the current size of the hashtable.
+    inline size_t table_size() const {
+        return m_table.table_size();
+    }
+
+    /// Sets the maximum load factor
+    /// (how full the table can get before re-allocating).
+    inline void max_load_factor(float z) {
+        m_table.max_load_factor(z);
+    }
+
+    /// Returns the maximum load factor.
+    inline float max_load_factor() const noexcept {
+        return m_table.max_load_factor();
+    }
+
+    /// Looks up the key `key` in the set, inserting it if
+    /// it doesn't already exist. See `hashset_t::lookup_insert()`.
+    template<typename on_resize_t = default_on_resize_t>
+    inline entry_t lookup_insert(uint64_t key,
+                                 on_resize_t&& on_resize = on_resize_t()) {
+        return m_table.lookup_insert(key, on_resize);
+    }
+
+    /// Search for a key inside the hashset.
+    inline entry_t lookup(uint64_t key) {
+        return m_table.lookup(key);
+    }
+
+    /// Compatibility with `std::unordered_set`.
+    inline size_t count(uint64_t key) {
+        return m_table.count(key);
+    }
+
+    /// Removes the key `key` from the set, if it exists.
+    ///
+    /// Returns the number of removed elements, which is either 0 or 1.
+    inline size_t erase(uint64_t key) {
+        return m_table.erase(key);
+    }
+
+    /// Calls `f(key)` for each key, see `hashset_t::for_each()`.
+    template<typename F>
+    inline void for_each(F f) {
+        m_table.for_each(f);
+    }
+
+    /// Calls `f(key)` from up to `threads` threads at the same time,
+    /// see `hashset_t::parallel_for_each()`.
+    template<typename F>
+    inline void parallel_for_each(F f, size_t threads = std::max<size_t>(std::thread::hardware_concurrency(), 1)) {
+        m_table.parallel_for_each(f, threads);
+    }
+
+    /// Reduces all keys to one `T`, see `hashset_t::parallel_reduce()`.
+    template<typename T, typename F, typename C>
+    inline T parallel_reduce(T identity, F f, C combine,
+                             size_t threads = std::max<size_t>(std::thread::hardware_concurrency(), 1)) {
+        return m_table.parallel_reduce(std::move(identity), f, combine, threads);
+    }
+
+    /// Returns all keys as a range, see `hashset_t::entries()`.
+    inline typename table_t::entry_range_t entries() {
+        return m_table.entries();
+    }
+
+    /// The underlying table, for the operations that do not change its width.
+    inline table_t const& table() const {
+        return m_table;
+    }
+};
+
+}}
+
+template<size_t key_bits, typename hash_t, typename placement_t>
+struct heap_size<compact_hash::set::fixed_width_hashset_t<key_bits, hash_t, placement_t>> {
+    using T = compact_hash::set::fixed_width_hashset_t<key_bits, hash_t, placement_t>;
+
+    static object_size_t compute(T const& val) {
+        return heap_size<typename T::table_t>::compute(val.m_table);
+    }
+};
+
+/// NB: Uses the format of the underlying `hashset_t`, and checks
+/// on reading that the width matches.
+template<size_t key_bits, typename hash_t, typename placement_t>
+struct serialize<compact_hash::set::fixed_width_hashset_t<key_bits, hash_t, placement_t>> {
+    using T = compact_hash::set::fixed_width_hashset_t<key_bits, hash_t, placement_t>;
+    using table_t = typename T::table_t;
+
+    static object_size_t write(std::ostream& out, T const& val) {
+        return serialize<table_t>::write(out, val.m_table);
+    }
+    static T read(std::istream& in) {
+        auto table = serialize<table_t>::read(in);
+        CHECK_EQ(table.key_width(), key_bits);
+        return T(std::move(table));
+    }
+    static bool equal_check(T const& lhs, T const& rhs) {
+        return gen_equal_check(m_table);
+    }
+};
+
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <tudocomp/util/heap_size.hpp>
+#include <tudocomp/util/compact_hash/set/hashset_t.hpp>
+#include <tudocomp/util/compact_hash/map/frozen_hashmap_t.hpp>
+
+namespace tdc {namespace compact_hash {namespace set {
+
+/// An immutable hashset, built by `freeze()` from a populated `hashset_t`.
+///
+/// It shares the representation of `map::frozen_hashmap_t`,
+/// with values of width 0.
+template<typename hash_t = poplar_xorshift_t>
+class frozen_hashset_t {
+    map::frozen_hashmap_t<hash_t> m_frozen;
+
+    template<typename T>
+    friend struct ::tdc::heap_size;
+
+    inline frozen_hashset_t(map::frozen_hashmap_t<hash_t>&& frozen):
+        m_frozen(std::move(frozen)) {}
+public:
+    /// Builds the frozen representation of `set`.
+    template<typename placement_t>
+    inline static frozen_hashset_t build(hashset_t<hash_t, placement_t>& set) {
+        return frozen_hashset_t(map::frozen_hashmap_t<hash_t>::build(set));
+    }
+
+    /// Returns the amount of elements inside the datastructure.
+    inline size_t size() const {
+        return m_frozen.size();
+    }
+
+    /// Returns the size of the hashtable.
+    inline size_t table_size() const {
+        return m_frozen.table_size();
+    }
+
+    /// Width of the keys stored in this datastructure.
+    inline size_t key_width() const {
+        return m_frozen.key_width();
+    }
+
+    /// Count the number of occurrences of `key`, as defined on STL containers.
+    ///
+    /// It will return either 0 or 1.
+    inline size_t count(uint64_t key) const {
+        return m_frozen.count(key);
+    }
+
+    /// Writes the representation to `out`,
+    /// such that it can be opened with a `map::hashmap_view_t`.
+    inline object_size_t write(std::ostream& out) const {
+        return m_frozen.write(out);
+    }
+};
+
+/// Builds an immutable `frozen_hashset_t` from `set`, which stays unchanged.
+template<typename hash_t, typename placement_t>
+inline frozen_hashset_t<hash_t> freeze(hashset_t<hash_t, placement_t>& set) {
+    return frozen_hashset_t<hash_t>::build(set);
+}
+
+}}
+
+template<typename hash_t>
+struct heap_size<compact_hash::set::frozen_hashset_t<hash_t>> {
+    using T = compact_hash::set::frozen_hashset_t<hash_t>;
+
+    static object_size_t compute(T const& val) {
+        return heap_size<compact_hash::map::frozen_hashmap_t<hash_t>>::compute(val.m_frozen);
+    }
+};
+
+}
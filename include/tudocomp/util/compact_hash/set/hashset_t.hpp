@@ -1,15 +1,32 @@
 #pragma once
 
+#include <algorithm>
+#include <iterator>
+#include <thread>
+#include <vector>
+
 #include <tudocomp/util/compact_hash/util.hpp>
 #include <tudocomp/util/compact_hash/size_manager_t.hpp>
 #include <tudocomp/util/compact_hash/storage/buckets_bv_t.hpp>
 #include <tudocomp/util/compact_hash/entry_t.hpp>
+#include <tudocomp/util/compact_hash/allocated_cursor_t.hpp>
 
 #include <tudocomp/util/compact_hash/set/no_satellite_data_t.hpp>
 
 #include <tudocomp/util/serialization.hpp>
+#include <tudocomp/util/chunked_serialization.hpp>
+
+namespace tdc {namespace compact_hash {
+namespace map {
+
+template<typename hash_t>
+class hashmap_view_t;
 
-namespace tdc {namespace compact_hash {namespace set {
+template<typename hash_t>
+class perfect_hashmap_t;
+
+}
+namespace set {
 
 template<typename hash_t, typename placement_t>
 class hashset_t {
@@ -178,6 +195,25 @@ public:
         return pctx.search(dkey.initial_address, dkey.stored_quotient);
     }
 
+    /// Removes the key `key` from the set, if it exists.
+    ///
+    /// Returns the number of removed elements, which is either 0 or 1.
+    /// This requires a placement that supports deletion, like `robin_hood_t`.
+    ///
+    /// With `robin_hood_t`, this invalidates the ids of the entries
+    /// with the same initial address, since the backward-shift deletion
+    /// changes their local positions.
+    inline size_t erase(uint64_t key) {
+        auto dkey = decompose_key(key);
+        auto pctx = m_placement.context(m_storage, table_size(), storage_widths(), m_sizing);
+        if (pctx.erase(dkey.initial_address, dkey.stored_quotient)) {
+            m_sizing.set_size(m_sizing.size() - 1);
+            return 1;
+        } else {
+            return 0;
+        }
+    }
+
     /// Takes an ID as returned by `entry_t::id()`, and returns the corresponding `entry_t`.
     ///
     /// The bavior is undefined if the id does not exist in the data structure, or after an
@@ -220,6 +256,133 @@ public:
         });
     }
 
+    /// Calls `f(key)` for each key of the hashset.
+    ///
+    /// The keys are composed from their quotients on the fly, and are
+    /// visited in no particular order. `f` must not insert or remove keys.
+    template<typename F>
+    inline void for_each(F f) {
+        auto pctx = m_placement.context(m_storage, table_size(), storage_widths(), m_sizing);
+        auto sctx = m_storage.context(table_size(), storage_widths());
+        pctx.for_all_allocated([&](auto initial_address, auto pos) {
+            auto ptr = sctx.at(sctx.table_pos(pos));
+            f(this->compose_key(initial_address, ptr.get_quotient()));
+        });
+    }
+
+    /// Calls `f(key)` for each key of the hashset like `for_each()`,
+    /// but from up to `threads` threads at the same time.
+    ///
+    /// The table is split at empty locations into ranges that can be
+    /// decoded on their own, and each thread walks one of them, so `f`
+    /// needs to be safe to call concurrently. Walks on one thread if the
+    /// placement can not be read concurrently, or if the storage tracks
+    /// changed buckets.
+    template<typename F>
+    inline void parallel_for_each(F f, size_t threads = std::max<size_t>(std::thread::hardware_concurrency(), 1)) {
+        auto const bounds = walk_bounds(threads);
+        chunked_format_t::parallel_for(0, bounds.size(), bounds.size(), [&](size_t i) {
+            for_each_between(bounds[i], bounds[(i + 1) % bounds.size()], f);
+        });
+    }
+
+    /// Reduces all keys of the hashset to one `T` from up to `threads`
+    /// threads at the same time, see `parallel_for_each()`.
+    ///
+    /// Each thread starts with a copy of `identity` and calls
+    /// `f(acc, key)` for each key of its range, where `acc` is a `T&`.
+    /// The results of the threads are then merged one by one with
+    /// `acc = combine(std::move(acc), std::move(other))`.
+    template<typename T, typename F, typename C>
+    inline T parallel_reduce(T identity, F f, C combine,
+                             size_t threads = std::max<size_t>(std::thread::hardware_concurrency(), 1)) {
+        auto const bounds = walk_bounds(threads);
+        std::vector<T> partial(bounds.size(), identity);
+        chunked_format_t::parallel_for(0, bounds.size(), bounds.size(), [&](size_t i) {
+            auto& acc = partial[i];
+            auto g = [&](uint64_t key) {
+                f(acc, key);
+            };
+            for_each_between(bounds[i], bounds[(i + 1) % bounds.size()], g);
+        });
+
+        T result = std::move(identity);
+        for (auto& other : partial) {
+            result = combine(std::move(result), std::move(other));
+        }
+        return result;
+    }
+
+    /// Forward iterator over the keys of the hashset, see `entries()`.
+    ///
+    /// Dereferencing it yields the key, composed from its
+    /// quotient on the fly.
+    /// Inserting or removing keys invalidates all iterators.
+    class iterator_t {
+        hashset_t* m_table = nullptr;
+        allocated_cursor_t m_cursor;
+
+        friend class hashset_t;
+
+        inline iterator_t(hashset_t& table, allocated_cursor_t cursor):
+            m_table(&table), m_cursor(cursor) {}
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = uint64_t;
+        using reference = uint64_t;
+        using pointer = void;
+        using difference_type = std::ptrdiff_t;
+
+        /// The end iterator.
+        inline iterator_t() {
+            m_cursor.done = true;
+        }
+
+        inline reference operator*() const {
+            auto& t = *m_table;
+            auto sctx = t.m_storage.context(t.table_size(), t.storage_widths());
+            auto ptr = sctx.at(sctx.table_pos(m_cursor.pos));
+            return t.compose_key(m_cursor.initial_address, ptr.get_quotient());
+        }
+
+        inline iterator_t& operator++() {
+            auto& t = *m_table;
+            auto pctx = t.m_placement.context(t.m_storage, t.table_size(), t.storage_widths(), t.m_sizing);
+            pctx.next_allocated(m_cursor);
+            return *this;
+        }
+
+        inline iterator_t operator++(int) {
+            auto r = *this;
+            ++*this;
+            return r;
+        }
+
+        inline friend bool operator==(iterator_t const& lhs, iterator_t const& rhs) {
+            return lhs.m_cursor.done == rhs.m_cursor.done
+                && (lhs.m_cursor.done || lhs.m_cursor.pos == rhs.m_cursor.pos);
+        }
+
+        inline friend bool operator!=(iterator_t const& lhs, iterator_t const& rhs) {
+            return !(lhs == rhs);
+        }
+    };
+
+    /// The keys of the hashset as a range for range-based for loops
+    /// and STL algorithms.
+    struct entry_range_t {
+        iterator_t m_begin;
+
+        inline iterator_t begin() const { return m_begin; }
+        inline iterator_t end() const { return iterator_t(); }
+    };
+
+    /// Returns all keys of the hashset as a range, see `iterator_t`.
+    inline entry_range_t entries() {
+        auto pctx = m_placement.context(m_storage, table_size(), storage_widths(), m_sizing);
+        return entry_range_t { iterator_t(*this, pctx.first_allocated()) };
+    }
+
     /// Check wether for the `new_size` this hashtable would need
     /// to perform a grow of the capacity.
     inline bool needs_to_grow_capacity(size_t new_size) const {
@@ -297,6 +460,27 @@ public:
 private:
     using quot_width_t = typename satellite_t::entry_bit_width_t;
 
+    /// Returns the empty locations at which `parallel_for_each()`
+    /// splits the table into up to `threads` ranges.
+    inline std::vector<size_t> walk_bounds(size_t threads) {
+        if (!placement_t::concurrent_walk || m_storage.tracks_dirty()) {
+            threads = 1;
+        }
+        auto sctx = m_storage.context(table_size(), storage_widths());
+        return split_at_empty(sctx, table_size(), std::max<size_t>(threads, 1));
+    }
+
+    /// Calls `f(key)` for each key between the empty locations `start` and `end`.
+    template<typename F>
+    inline void for_each_between(size_t start, size_t end, F& f) {
+        auto pctx = m_placement.context(m_storage, table_size(), storage_widths(), m_sizing);
+        auto sctx = m_storage.context(table_size(), storage_widths());
+        for (auto c = pctx.first_allocated_between(start, end); !c.done; pctx.next_allocated(c)) {
+            auto ptr = sctx.at(sctx.table_pos(c.pos));
+            f(this->compose_key(c.initial_address, ptr.get_quotient()));
+        }
+    }
+
     /// Size of table, and width of the stored keys and values
     size_manager_t m_sizing;
     uint8_t m_key_width;
@@ -316,6 +500,15 @@ private:
     template<typename T>
     friend struct ::tdc::heap_size;
 
+    template<typename T>
+    friend struct ::tdc::serialize_chunked;
+
+    template<typename T>
+    friend class map::hashmap_view_t;
+
+    template<typename T>
+    friend class map::perfect_hashmap_t;
+
     /// The actual amount of bits currently usable for
     /// storing a key in the hashtable.
     ///
@@ -479,7 +672,14 @@ struct serialize<compact_hash::set::hashset_t<hash_t, placement_t>> {
 
         return bytes;
     }
-    static T read(std::istream& in) {
+    /// Reads a hashset written by `write()`.
+    ///
+    /// The storage config is not serialized, so the table uses
+    /// `config.storage_config`, e.g. the directory of a file-backed
+    /// allocation. Likewise, whether the placement advises transparent
+    /// huge pages is taken from `config.displacement_config`.
+    /// The other parts of `config` are read from the stream.
+    static T read(std::istream& in, typename T::config_args const& config = typename T::config_args{}) {
         using namespace compact_hash::set;
         using namespace compact_hash;
 
@@ -492,8 +692,8 @@ struct serialize<compact_hash::set::hashset_t<hash_t, placement_t>> {
         ret.m_key_width = std::move(key_width);
         ret.m_hash = std::move(hash);
 
-        auto storage = serialize<storage_t>::read(in, ret.table_size(), ret.storage_widths());
-        auto placement = serialize<placement_t>::read(in, ret.table_size());
+        auto storage = serialize<storage_t>::read(in, ret.table_size(), ret.storage_widths(), config.storage_config);
+        auto placement = serialize<placement_t>::read(in, ret.table_size(), config.displacement_config);
 
         ret.m_storage = std::move(storage);
         ret.m_placement = std::move(placement);
@@ -518,4 +718,82 @@ struct serialize<compact_hash::set::hashset_t<hash_t, placement_t>> {
     }
 };
 
+/// Writes the hashset as a chunked container.
+///
+/// The first chunk contains everything except the buckets of the storage,
+/// which are split into chunks of `chunked_config_t::units_per_chunk`
+/// buckets each.
+template<typename hash_t, typename placement_t>
+struct serialize_chunked<compact_hash::set::hashset_t<hash_t, placement_t>> {
+    using T = compact_hash::set::hashset_t<hash_t, placement_t>;
+    using storage_serialize_t = serialize<typename T::storage_t>;
+
+    static object_size_t write(std::ostream& out, T const& val, chunked_config_t const& config = chunked_config_t()) {
+        using namespace compact_hash;
+
+        CHECK_GT(config.units_per_chunk, 0u);
+
+        auto const table_size = val.table_size();
+        auto const widths = val.storage_widths();
+        uint64_t const units_per_chunk = config.units_per_chunk;
+        size_t const units = storage_serialize_t::unit_count(table_size, widths);
+        size_t const unit_chunks = (units + units_per_chunk - 1) / units_per_chunk;
+
+        chunked_writer_t writer(out, 1 + unit_chunks, config);
+        writer.write(0, 1, [&](size_t, std::ostream& chunk_out) {
+            serialize<uint64_t>::write(chunk_out, units_per_chunk);
+            serialize<size_manager_t>::write(chunk_out, val.m_sizing);
+            serialize<uint8_t>::write(chunk_out, val.m_key_width);
+            serialize<hash_t>::write(chunk_out, val.m_hash);
+            storage_serialize_t::write_head(chunk_out, val.m_storage, table_size, widths);
+            serialize<placement_t>::write(chunk_out, val.m_placement, table_size);
+        });
+        writer.write(1, 1 + unit_chunks, [&](size_t chunk, std::ostream& chunk_out) {
+            size_t const begin = (chunk - 1) * units_per_chunk;
+            size_t const end = std::min<size_t>(begin + units_per_chunk, units);
+            storage_serialize_t::write_units(chunk_out, val.m_storage, table_size, widths, begin, end);
+        });
+
+        return writer.finish();
+    }
+    /// See `serialize<hashset_t>::read()` for `table_config`.
+    static T read(std::istream& in,
+                  chunked_config_t const& config = chunked_config_t(),
+                  typename T::config_args const& table_config = typename T::config_args{}) {
+        using namespace compact_hash;
+
+        chunked_reader_t reader(in, config);
+        CHECK_GE(reader.chunk_count(), 1u);
+
+        T ret;
+        uint64_t units_per_chunk = 0;
+
+        reader.read(0, 1, [&](size_t, std::istream& chunk_in) {
+            units_per_chunk = serialize<uint64_t>::read(chunk_in);
+            ret.m_sizing = serialize<size_manager_t>::read(chunk_in);
+            ret.m_key_width = serialize<uint8_t>::read(chunk_in);
+            ret.m_hash = serialize<hash_t>::read(chunk_in);
+            ret.m_storage = storage_serialize_t::read_head(chunk_in, ret.table_size(), ret.storage_widths(),
+                                                           table_config.storage_config);
+            ret.m_placement = serialize<placement_t>::read(chunk_in, ret.table_size(),
+                                                            table_config.displacement_config);
+        });
+
+        auto const table_size = ret.table_size();
+        auto const widths = ret.storage_widths();
+        size_t const units = storage_serialize_t::unit_count(table_size, widths);
+        CHECK_GT(units_per_chunk, 0u);
+        CHECK_EQ(reader.chunk_count(), 1 + (units + units_per_chunk - 1) / units_per_chunk)
+            << "Corrupt chunk index";
+
+        reader.read(1, reader.chunk_count(), [&](size_t chunk, std::istream& chunk_in) {
+            size_t const begin = (chunk - 1) * units_per_chunk;
+            size_t const end = std::min<size_t>(begin + units_per_chunk, units);
+            storage_serialize_t::read_units(chunk_in, ret.m_storage, table_size, widths, begin, end);
+        });
+
+        return ret;
+    }
+};
+
 }
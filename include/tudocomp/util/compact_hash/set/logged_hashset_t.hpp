@@ -0,0 +1,101 @@
+#pragma once
+
+#include <fstream>
+#include <string>
+
+#include <tudocomp/util/serialization.hpp>
+#include <tudocomp/util/compact_hash/operation_log_t.hpp>
+
+namespace tdc {namespace compact_hash {namespace set {
+
+/// A hashset whose inserts are recorded in an `operation_log_t`,
+/// paired with snapshots written by `serialize`.
+///
+/// After a crash, `recover()` loads the latest snapshot and replays the
+/// log written since then.
+///
+/// NB: Only the inserts done through this class are recorded.
+/// Changes done through `table()` are not.
+template<typename table_t>
+class logged_hashset_t {
+    table_t m_table;
+    operation_log_t m_log;
+public:
+    using entry_t = typename table_t::entry_t;
+
+    /// Attaches a log at `log_path` to `table`, appending to an existing log.
+    inline logged_hashset_t(table_t&& table,
+                            std::string const& log_path,
+                            operation_log_t::config_args log_config = operation_log_t::config_args{}):
+        m_table(std::move(table)),
+        m_log(log_path, log_config) {}
+
+    /// Looks up the key `key` in the set, inserting and recording it if
+    /// it doesn't already exist.
+    inline entry_t lookup_insert(uint64_t key) {
+        return lookup_insert_key_width(key, m_table.key_width());
+    }
+
+    /// Looks up the key `key` in the set, inserting and recording it if
+    /// it doesn't already exist, and grows the key width to `key_width` bits.
+    ///
+    /// NB: The returned id is only valid until the next insert.
+    inline entry_t lookup_insert_key_width(uint64_t key, uint8_t key_width) {
+        size_t const old_key_width = m_table.key_width();
+        auto result = m_table.lookup_insert_key_width(key, key_width);
+        if (!result.key_already_exist() || m_table.key_width() != old_key_width) {
+            // NB: Logs the width of the table after the insert,
+            // such that replay grows the table in the same way.
+            m_log.append(key, m_table.key_width());
+        }
+        return result;
+    }
+
+    /// Appends the buffered records to the log.
+    inline void commit() {
+        m_log.commit();
+    }
+
+    /// Appends the buffered records to the log, and makes them durable.
+    inline void sync() {
+        m_log.commit();
+        m_log.sync();
+    }
+
+    /// Durably writes a snapshot of the table to `snapshot_path`,
+    /// and drops the log records contained in it.
+    inline void checkpoint(std::string const& snapshot_path) {
+        write_file_durably(snapshot_path, [&](std::ostream& out) {
+            serialize<table_t>::write(out, m_table);
+        });
+        m_log.reset();
+    }
+
+    /// Loads the snapshot at `snapshot_path` (or uses `initial` if there is
+    /// none yet), replays the log at `log_path`, and continues to log there.
+    inline static logged_hashset_t recover(std::string const& snapshot_path,
+                                           std::string const& log_path,
+                                           table_t&& initial = table_t(),
+                                           operation_log_t::config_args log_config = operation_log_t::config_args{}) {
+        table_t table = std::move(initial);
+        {
+            std::ifstream in(snapshot_path, std::ios::binary);
+            if (in) {
+                table = serialize<table_t>::read(in);
+            }
+        }
+
+        operation_log_t::replay(log_path, [&](operation_log_record_t const& record) {
+            table.lookup_insert_key_width(record.key, record.key_width);
+        });
+
+        return logged_hashset_t(std::move(table), log_path, log_config);
+    }
+
+    inline table_t& table() { return m_table; }
+    inline table_t const& table() const { return m_table; }
+
+    inline operation_log_t& log() { return m_log; }
+};
+
+}}}
@@ -3,6 +3,7 @@
 
 #include <memory>
 #include <cstdint>
+#include <cstring>
 #include <utility>
 #include <algorithm>
 
@@ -21,7 +22,12 @@ struct quot_bucket_layout_t {
         inline Layout(): quots_layout(), overall_qword_size(0) {
         }
     };
-    inline static Layout calc_sizes(size_t size, uint8_t quot_width) {
+
+    /// Calculates the layout of `size` entries.
+    ///
+    /// The quotients start at the beginning of the allocation, so the
+    /// `aligned` layout, see `val_quot_bucket_layout_t`, is the packed one.
+    inline static Layout calc_sizes(size_t size, uint8_t quot_width, bool = false) {
         DCHECK_NE(size, 0U);
 
         auto layout = cbp::bit_layout_t();
@@ -37,7 +43,7 @@ struct quot_bucket_layout_t {
 
     /// Creates the pointers to the beginnings of the two arrays inside
     /// the allocation.
-    inline static quot_ptr_t ptr(uint64_t* alloc, size_t size, uint8_t quot_width) {
+    inline static quot_ptr_t ptr(uint64_t* alloc, size_t size, uint8_t quot_width, bool = false) {
         DCHECK_NE(size, 0U);
         auto layout = calc_sizes(size, quot_width);
 
@@ -45,13 +51,13 @@ struct quot_bucket_layout_t {
     }
 
     // Run destructors of each element in the bucket.
-    inline static void destroy_vals(uint64_t*, size_t, uint8_t) {
+    inline static void destroy_vals(uint64_t*, size_t, uint8_t, bool = false) {
         // NB: this does not contain values
     }
 
     /// Returns a `val_quot_ptr_t` to position `pos`,
     /// or a sentinel value that acts as a one-pass-the-end pointer for the empty case.
-    inline static quot_ptr_t at(uint64_t* alloc, size_t size, size_t pos, uint8_t quot_width) {
+    inline static quot_ptr_t at(uint64_t* alloc, size_t size, size_t pos, uint8_t quot_width, bool = false) {
         if(size != 0) {
             auto ps = ptr(alloc, size, quot_width);
             return quot_ptr_t(ps.quot_ptr() + pos);
@@ -60,6 +66,46 @@ struct quot_bucket_layout_t {
             return quot_ptr_t();
         }
     }
+
+    /// Relocates the `n` entries starting at position `src_pos` of the
+    /// allocation `src` of `src_size` entries to the ones starting
+    /// at position `dst_pos` of the allocation `dst` of `dst_size` entries.
+    ///
+    /// Quotients of a native width are moved with `memcpy()`.
+    inline static void relocate(uint64_t* dst, size_t dst_size, size_t dst_pos,
+                                uint64_t* src, size_t src_size, size_t src_pos,
+                                size_t n, uint8_t quot_width) {
+        if (n == 0) {
+            return;
+        }
+        DCHECK_LE(dst_pos + n, dst_size);
+        DCHECK_LE(src_pos + n, src_size);
+
+        if (is_native_width(quot_width) && cbp_stores_native_arrays()) {
+            size_t const bytes = quot_width / 8;
+            std::memcpy(reinterpret_cast<char*>(dst) + dst_pos * bytes,
+                        reinterpret_cast<char const*>(src) + src_pos * bytes,
+                        n * bytes);
+        } else {
+            quot_ptr_t::relocate(at(dst, dst_size, dst_pos, quot_width),
+                                 at(src, src_size, src_pos, quot_width),
+                                 n);
+        }
+    }
+
+    /// Whether the aligned and the packed layout can differ,
+    /// which they never do.
+    inline static bool aligned_differs(size_t, uint8_t) {
+        return false;
+    }
+
+    inline static void to_packed(uint64_t const* aligned, uint64_t* packed, size_t size, uint8_t quot_width) {
+        std::copy(aligned, aligned + calc_sizes(size, quot_width).overall_qword_size, packed);
+    }
+
+    inline static void from_packed(uint64_t const* packed, uint64_t* aligned, size_t size, uint8_t quot_width) {
+        std::copy(packed, packed + calc_sizes(size, quot_width).overall_qword_size, aligned);
+    }
 };
 
 }}}
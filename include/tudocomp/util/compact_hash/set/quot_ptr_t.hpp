@@ -19,6 +19,9 @@ public:
         uint64_t quot;
     };
 
+    /// There are no values, so the quotients are just copied.
+    static constexpr bool relocates_by_memcpy = false;
+
     inline quot_ptr_t(QuotPtr quot_ptr):
         m_quot_ptr(quot_ptr)
     {
@@ -80,6 +83,15 @@ public:
         set_quotient(other.get_quotient());
     }
 
+    /// Copies the `n` quotients starting at `src` to the ones starting at `dst`.
+    inline static void relocate(quot_ptr_t dst, quot_ptr_t src, size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            dst.init_from(src);
+            dst.increment_ptr();
+            src.increment_ptr();
+        }
+    }
+
     inline void swap_with(quot_ptr_t other) {
         uint64_t tmp_quot = get_quotient();
         move_from(other);
@@ -3,10 +3,14 @@
 #include <tudocomp/util/compact_hash/set/hashset_t.hpp>
 #include <tudocomp/util/compact_hash/hash_functions.hpp>
 #include <tudocomp/util/compact_hash/index_structure/cv_bvs_t.hpp>
+#include <tudocomp/util/compact_hash/index_structure/cuckoo_t.hpp>
+#include <tudocomp/util/compact_hash/index_structure/hopscotch_t.hpp>
 #include <tudocomp/util/compact_hash/index_structure/displacement_t.hpp>
 #include <tudocomp/util/compact_hash/index_structure/elias_gamma_displacement_table_t.hpp>
 #include <tudocomp/util/compact_hash/index_structure/layered_displacement_table_t.hpp>
+#include <tudocomp/util/compact_hash/index_structure/compact_hash_spill_t.hpp>
 #include <tudocomp/util/compact_hash/index_structure/naive_displacement_table_t.hpp>
+#include <tudocomp/util/compact_hash/index_structure/robin_hood_t.hpp>
 
 namespace tdc {namespace compact_hash {namespace set {
 
@@ -23,4 +27,16 @@ using sparse_elias_hashset_t
     = hashset_t<hash_t, displacement_t<elias_gamma_displacement_table_t<
         dynamic_fixed_elias_gamma_bucket_size_t>>>;
 
+template<typename hash_t = poplar_xorshift_t>
+using sparse_robin_hood_hashset_t
+    = hashset_t<hash_t, robin_hood_t<layered_displacement_table_t<dynamic_layered_bit_width_t>>>;
+
+template<typename hash_t = poplar_xorshift_t>
+using sparse_cuckoo_hashset_t
+    = hashset_t<hash_t, cuckoo_t>;
+
+template<typename hash_t = poplar_xorshift_t>
+using sparse_hopscotch_hashset_t
+    = hashset_t<hash_t, hopscotch_t<>>;
+
 }}}
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+
+#include <glog/logging.h>
+
+#include <tudocomp/util/heap_size.hpp>
+#include <tudocomp/util/serialization.hpp>
+
+namespace tdc {namespace compact_hash {
+
+/// The initial addresses of the entries that a placement could not put
+/// where its search looks for them, as used by `cuckoo_t` and `hopscotch_t`.
+///
+/// The entries are indexed both by their position, to restore the initial
+/// address of an allocated location, and by their initial address, such
+/// that a search only inspects the entries with the initial address
+/// of the key instead of the whole stash.
+class stash_t {
+    template<typename T>
+    friend struct ::tdc::serialize;
+
+    template<typename T>
+    friend struct ::tdc::heap_size;
+
+    std::unordered_map<size_t, size_t> m_by_pos;
+    std::unordered_multimap<size_t, size_t> m_by_address;
+
+public:
+    static constexpr size_t NO_POS = size_t(-1);
+
+    /// Amount of entries in the stash.
+    inline size_t size() const {
+        return m_by_pos.size();
+    }
+
+    inline bool empty() const {
+        return m_by_pos.empty();
+    }
+
+    /// Whether the entry at `pos` is in the stash.
+    inline bool contains(size_t pos) const {
+        return m_by_pos.count(pos) != 0;
+    }
+
+    /// Returns the initial address of the entry at `pos`,
+    /// which has to be in the stash.
+    inline size_t initial_address(size_t pos) const {
+        DCHECK(contains(pos));
+        return m_by_pos.find(pos)->second;
+    }
+
+    /// Adds the entry at `pos` with initial address `initial_address`.
+    inline void insert(size_t pos, size_t initial_address) {
+        DCHECK(!contains(pos));
+        m_by_pos.emplace(pos, initial_address);
+        m_by_address.emplace(initial_address, pos);
+    }
+
+    /// Removes the entry at `pos`, if it is in the stash.
+    inline void erase(size_t pos) {
+        auto it = m_by_pos.find(pos);
+        if (it == m_by_pos.end()) {
+            return;
+        }
+        auto range = m_by_address.equal_range(it->second);
+        for (auto a = range.first; a != range.second; ++a) {
+            if (a->second == pos) {
+                m_by_address.erase(a);
+                break;
+            }
+        }
+        m_by_pos.erase(it);
+    }
+
+    /// Returns the position of the first entry with initial address
+    /// `initial_address` for which `match(pos)` is true, or `NO_POS`.
+    template<typename F>
+    inline size_t find(size_t initial_address, F match) const {
+        auto range = m_by_address.equal_range(initial_address);
+        for (auto a = range.first; a != range.second; ++a) {
+            if (match(a->second)) {
+                return a->second;
+            }
+        }
+        return NO_POS;
+    }
+
+    inline bool operator==(stash_t const& other) const {
+        return m_by_pos == other.m_by_pos;
+    }
+};
+
+}
+
+template<>
+struct heap_size<compact_hash::stash_t> {
+    using T = compact_hash::stash_t;
+
+    static object_size_t compute(T const& val) {
+        size_t unordered_map_size_guess
+            = sizeof(decltype(val.m_by_pos))
+            + sizeof(decltype(val.m_by_address))
+            + val.m_by_pos.size() * sizeof(size_t) * 4;
+        return object_size_t::unknown_extra_data(unordered_map_size_guess);
+    }
+};
+
+template<>
+struct serialize<compact_hash::stash_t> {
+    using T = compact_hash::stash_t;
+
+    static object_size_t write(std::ostream& out, T const& val) {
+        auto bytes = object_size_t::empty();
+
+        size_t stash_size = val.m_by_pos.size();
+        bytes += serialize_write(out, stash_size);
+        for (auto pair : val.m_by_pos) {
+            bytes += serialize_write(out, pair.first);
+            bytes += serialize_write(out, pair.second);
+        }
+
+        return bytes;
+    }
+
+    static T read(std::istream& in) {
+        T ret;
+
+        size_t stash_size;
+        serialize_read_into(in, stash_size);
+        for (size_t i = 0; i < stash_size; i++) {
+            size_t k;
+            size_t v;
+            serialize_read_into(in, k);
+            serialize_read_into(in, v);
+            ret.insert(k, v);
+        }
+
+        return ret;
+    }
+
+    static bool equal_check(T const& lhs, T const& rhs) {
+        return gen_equal_diagnostic(lhs == rhs);
+    }
+};
+
+}
@@ -19,6 +19,11 @@ using namespace compact_hash;
 /// - A dynamic-width array of quotients.
 /// - A potentially dynamic-width array of satellite values.
 ///
+/// The allocation uses the aligned layout of `bucket_data_layout_t`,
+/// such that quotients and values of 8, 16, 32 or 64 bits are arrays of
+/// native integers that are relocated with `memcpy()`.
+/// Serialized buckets use the packed layout of the other storages.
+///
 /// An empty bucket does not allocate any memory.
 ///
 /// WARNING:
@@ -45,6 +50,8 @@ public:
     /// Maps hashtable position to position of the corresponding bucket,
     /// and the position inside of it.
     struct bucket_layout_t: satellite_t::bucket_data_layout_t {
+        using base_t = typename satellite_t::bucket_data_layout_t;
+
         static constexpr size_t BVS_WIDTH_SHIFT = 6;
         static constexpr size_t BVS_WIDTH_MASK = 0b111111;
 
@@ -59,6 +66,25 @@ public:
         static inline size_t table_size_to_bucket_size(size_t size) {
             return (size + BVS_WIDTH_MASK) >> BVS_WIDTH_SHIFT;
         }
+
+        // NB: These shadow the ones of `bucket_data_layout_t`
+        // to select its aligned layout.
+
+        static inline typename base_t::Layout calc_sizes(size_t size, entry_bit_width_t width) {
+            return base_t::calc_sizes(size, width, true);
+        }
+
+        static inline entry_ptr_t ptr(uint64_t* alloc, size_t size, entry_bit_width_t width) {
+            return base_t::ptr(alloc, size, width, true);
+        }
+
+        static inline void destroy_vals(uint64_t* alloc, size_t size, entry_bit_width_t width) {
+            base_t::destroy_vals(alloc, size, width, true);
+        }
+
+        static inline entry_ptr_t at(uint64_t* alloc, size_t size, size_t pos, entry_bit_width_t width) {
+            return base_t::at(alloc, size, pos, width, true);
+        }
     };
 
     inline bucket_t(): m_data() {}
@@ -141,39 +167,87 @@ public:
         // NB: The elements in it are uninitialized
         auto new_bucket = bucket_t<N, satellite_t>(bv() | new_elem_bv_bit, width);
 
-        auto new_iter = new_bucket.at(0, width);
-        auto old_iter = at(0, width);
+        size_t const old_size = size();
 
-        auto const new_iter_midpoint = new_bucket.at(new_elem_bucket_pos, width);
-        auto const new_iter_end = new_bucket.at(new_bucket.size(), width);
+        // relocate all elements before the new element's location from old bucket into new bucket
+        new_bucket.relocate_from(0, *this, 0, new_elem_bucket_pos, width);
 
-        entry_ptr_t ret;
+        // relocate all elements after the new element's location from old bucket into new bucket
+        new_bucket.relocate_from(new_elem_bucket_pos + 1,
+                                 *this, new_elem_bucket_pos,
+                                 old_size - new_elem_bucket_pos,
+                                 width);
+
+        // NB: The old elements have been relocated, so they are not destroyed.
+        *this = std::move(new_bucket);
 
-        // move all elements before the new element's location from old bucket into new bucket
-        while(new_iter != new_iter_midpoint) {
-            new_iter.init_from(old_iter);
-            new_iter.increment_ptr();
-            old_iter.increment_ptr();
+        return at(new_elem_bucket_pos, width);
+    }
+    /// Insert the new elements of the bitvector `new_bits` into the bucket,
+    /// growing it once for all of them.
+    ///
+    /// NB: The new elements are uninitialized.
+    inline void insert_bits(uint64_t new_bits, entry_bit_width_t width) {
+        DCHECK_EQ(bv() & new_bits, 0U);
+
+        auto new_bucket = bucket_t<N, satellite_t>(bv() | new_bits, width);
+
+        size_t const old_size = size();
+        size_t old_pos = 0;
+        size_t new_pos = 0;
+
+        // relocate the old elements before each new element's location,
+        // and leave a gap for it
+        for (uint64_t rest = new_bits; rest != 0; rest &= rest - 1) {
+            uint64_t const new_elem_bv_bit = rest & (~rest + 1);
+            size_t const old_end = size(bv() & (new_elem_bv_bit - 1));
+
+            new_bucket.relocate_from(new_pos, *this, old_pos, old_end - old_pos, width);
+            new_pos += old_end - old_pos + 1;
+            old_pos = old_end;
         }
 
-        // move new element into its location in the new bucket
-        {
-            ret = new_iter;
-            new_iter.increment_ptr();
+        // relocate all elements after the last new element's location
+        new_bucket.relocate_from(new_pos, *this, old_pos, old_size - old_pos, width);
+
+        // NB: The old elements have been relocated, so they are not destroyed.
+        *this = std::move(new_bucket);
+    }
+    /// Remove the element at `elem_bucket_pos` from the bucket,
+    /// shrinking it as needed.
+    ///
+    /// This runs the destructor of the removed element.
+    inline void remove_at(
+        size_t elem_bucket_pos,
+        uint64_t elem_bv_bit,
+        entry_bit_width_t width)
+    {
+        DCHECK_NE(bv() & elem_bv_bit, 0U);
+
+        // create a new bucket with enough size for the remaining elements
+        // NB: The elements in it are uninitialized
+        auto new_bucket = bucket_t<N, satellite_t>(bv() & ~elem_bv_bit, width);
+
+        size_t const new_size = new_bucket.size();
+
+        // relocate all elements before the removed element's location from old bucket into new bucket
+        if (new_size != 0) {
+            new_bucket.relocate_from(0, *this, 0, elem_bucket_pos, width);
         }
 
-        // move all elements after the new element's location from old bucket into new bucket
-        while(new_iter != new_iter_end) {
-            new_iter.init_from(old_iter);
-            new_iter.increment_ptr();
-            old_iter.increment_ptr();
+        // destroy the removed element
+        at(elem_bucket_pos, width).uninitialize();
+
+        // relocate all elements after the removed element's location from old bucket into new bucket
+        if (new_size != 0) {
+            new_bucket.relocate_from(elem_bucket_pos,
+                                     *this, elem_bucket_pos + 1,
+                                     new_size - elem_bucket_pos,
+                                     width);
         }
 
-        // destroy old empty elements, and overwrite with new bucket
-        destroy_vals(width);
+        // NB: The old elements have been relocated, so they are not destroyed.
         *this = std::move(new_bucket);
-
-        return ret;
     }
 private:
     inline static size_t size(uint64_t bv) {
@@ -188,6 +262,22 @@ private:
         return bucket_layout_t::calc_sizes(size, width).overall_qword_size;
     }
 
+    /// Size of the allocation in the packed layout, which serialized
+    /// buckets use.
+    inline static size_t packed_qvd_data_size(size_t size, entry_bit_width_t width) {
+        return bucket_layout_t::base_t::calc_sizes(size, width).overall_qword_size;
+    }
+
+    /// Relocates the `n` elements starting at `src_pos` of `src`
+    /// to the ones starting at `dst_pos` of this bucket.
+    inline void relocate_from(size_t dst_pos, bucket_t const& src, size_t src_pos, size_t n, entry_bit_width_t width) {
+        if (n != 0) {
+            bucket_layout_t::relocate(get_qv(), size(), dst_pos,
+                                      src.get_qv(), src.size(), src_pos,
+                                      n, width);
+        }
+    }
+
     /// Creates the pointers to the beginnings of the two arrays inside
     /// the allocation.
     inline entry_ptr_t ptr(entry_bit_width_t width) const {
@@ -232,9 +322,14 @@ struct serialize<compact_hash::bucket_t<N, satellite_t>> {
         size_t size = val.size();
 
         if (size > 0) {
-            size_t raw_size = T::qvd_data_size(size, widths) + 1;
-            for (size_t i = 1; i < raw_size; i++) {
-                bytes += serialize<uint64_t>::write(out, val.m_data[i]);
+            using bucket_layout_t = typename T::bucket_layout_t;
+            if (!bucket_layout_t::aligned_differs(size, widths)) {
+                bytes += serialize_write_words(out, &val.m_data[1], T::qvd_data_size(size, widths));
+            } else {
+                size_t packed_size = T::packed_qvd_data_size(size, widths);
+                auto packed = std::make_unique<uint64_t[]>(packed_size);
+                bucket_layout_t::to_packed(&val.m_data[1], packed.get(), size, widths);
+                bytes += serialize_write_words(out, packed.get(), packed_size);
             }
         }
 
@@ -252,8 +347,15 @@ struct serialize<compact_hash::bucket_t<N, satellite_t>> {
             size_t raw_size = T::qvd_data_size(size, widths) + 1;
             ret.m_data = std::make_unique<uint64_t[]>(raw_size);
             ret.m_data[0] = bv;
-            for (size_t i = 1; i < raw_size; i++) {
-                ret.m_data[i] = serialize<uint64_t>::read(in);
+
+            using bucket_layout_t = typename T::bucket_layout_t;
+            if (!bucket_layout_t::aligned_differs(size, widths)) {
+                serialize_read_words(in, &ret.m_data[1], raw_size - 1);
+            } else {
+                size_t packed_size = T::packed_qvd_data_size(size, widths);
+                auto packed = std::make_unique<uint64_t[]>(packed_size);
+                serialize_read_words(in, packed.get(), packed_size);
+                bucket_layout_t::from_packed(packed.get(), &ret.m_data[1], size, widths);
             }
         }
 
@@ -1,12 +1,16 @@
 #pragma once
 
+#include <algorithm>
 #include <memory>
+#include <utility>
+#include <vector>
 
 #include <tudocomp/util/compact_hash/util.hpp>
 #include <tudocomp/util/compact_hash/storage/sparse_pos_t.hpp>
 #include <tudocomp/util/compact_hash/storage/bucket_t.hpp>
 
 #include <tudocomp/util/serialization.hpp>
+#include <tudocomp/util/delta_serialization.hpp>
 
 // Table for uninitalized elements
 
@@ -24,14 +28,25 @@ namespace tdc {namespace compact_hash {
 
         buckets_t m_buckets;
 
+        /// One bit per bucket that marks it as changed since the last
+        /// call of `clear_dirty()`, or `nullptr` if changes are not tracked.
+        std::unique_ptr<uint64_t[]> m_dirty;
+
         template<typename T>
         friend struct ::tdc::serialize;
 
         /// runtime initilization arguments, if any
-        struct config_args {};
+        struct config_args {
+            /// Whether to track which buckets change, for delta snapshots.
+            bool track_dirty = false;
+        };
 
         /// get the config of this instance
-        inline config_args current_config() const { return config_args{}; }
+        inline config_args current_config() const {
+            auto r = config_args{};
+            r.track_dirty = tracks_dirty();
+            return r;
+        }
 
         inline buckets_bv_t() {}
         inline buckets_bv_t(size_t table_size,
@@ -40,6 +55,38 @@ namespace tdc {namespace compact_hash {
             size_t buckets_size = bucket_layout_t::table_size_to_bucket_size(table_size);
 
             m_buckets = std::make_unique<my_bucket_t[]>(buckets_size);
+
+            if (config.track_dirty) {
+                // NB: A new table differs from any earlier snapshot as a whole.
+                size_t dirty_size = dirty_qword_size(buckets_size);
+                m_dirty = std::make_unique<uint64_t[]>(dirty_size);
+                std::fill(m_dirty.get(), m_dirty.get() + dirty_size, ~0ull);
+            }
+        }
+
+        inline static size_t dirty_qword_size(size_t buckets_size) {
+            return (buckets_size + 63) / 64;
+        }
+
+        inline bool tracks_dirty() const {
+            return m_dirty != nullptr;
+        }
+
+        /// Starts tracking changes if it is not yet enabled,
+        /// and marks all buckets as unchanged.
+        inline void clear_dirty(size_t table_size) {
+            size_t buckets_size = bucket_layout_t::table_size_to_bucket_size(table_size);
+            size_t dirty_size = dirty_qword_size(buckets_size);
+            if (!tracks_dirty()) {
+                m_dirty = std::make_unique<uint64_t[]>(dirty_size);
+            }
+            std::fill(m_dirty.get(), m_dirty.get() + dirty_size, 0ull);
+        }
+
+        /// Whether the `i`-th bucket changed since the last `clear_dirty()`.
+        inline bool is_dirty(size_t i) const {
+            DCHECK(tracks_dirty());
+            return (m_dirty[i / 64] >> (i % 64)) & 1ull;
         }
         using table_pos_t = sparse_pos_t<my_bucket_t, bucket_layout_t>;
 
@@ -50,11 +97,19 @@ namespace tdc {namespace compact_hash {
             entry_ptr_t               m_b_start;
             entry_ptr_t               m_b_end;
             entry_bit_width_t         m_widths;
+            my_bucket_t const*        m_buckets;
+            uint64_t*                 m_dirty;
 
             inline void set_bucket_elem_range(size_t end_offset) {
                 size_t start_offset = 0;
                 DCHECK_LE(start_offset, end_offset);
 
+                // NB: The elements get written through the iterator
+                if (m_dirty != nullptr) {
+                    size_t i = m_bucket - m_buckets;
+                    m_dirty[i / 64] |= 1ull << (i % 64);
+                }
+
                 m_b_start = m_bucket->at(start_offset, m_widths);
                 m_b_end   = m_bucket->at(end_offset, m_widths);
             }
@@ -62,8 +117,11 @@ namespace tdc {namespace compact_hash {
             inline iter_t(my_bucket_t const* buckets,
                           size_t buckets_size,
                           table_pos_t const& pos,
-                          entry_bit_width_t const& widths):
-                m_widths(widths)
+                          entry_bit_width_t const& widths,
+                          uint64_t* dirty):
+                m_widths(widths),
+                m_buckets(buckets),
+                m_dirty(dirty)
             {
                 // NB: Using pointer arithmetic here, because
                 // we can (intentionally) end up with the address 1-past
@@ -102,11 +160,19 @@ namespace tdc {namespace compact_hash {
             buckets_t& m_buckets;
             size_t const table_size;
             entry_bit_width_t widths;
+            uint64_t* m_dirty;
+
+            inline void mark_dirty(size_t i) {
+                if (m_dirty != nullptr) {
+                    m_dirty[i / 64] |= 1ull << (i % 64);
+                }
+            }
 
             /// Run the destructors of the elements of the `i`-th bucket,
             /// and drop it from the hashtable, replacing it with an empty one.
             inline void drop_bucket(size_t i) {
                 DCHECK_LT(i, bucket_layout_t::table_size_to_bucket_size(table_size));
+                mark_dirty(i);
                 m_buckets[i].destroy_vals(widths);
                 m_buckets[i] = my_bucket_t();
             }
@@ -126,26 +192,73 @@ namespace tdc {namespace compact_hash {
             inline entry_ptr_t allocate_pos(table_pos_t pos) {
                 DCHECK(!pos.exists_in_bucket());
 
+                mark_dirty(pos.idx_of_bucket);
+
                 auto& bucket = pos.bucket();
                 auto offset_in_bucket = pos.offset_in_bucket();
                 uint64_t new_bucket_bv = bucket.bv() | pos.bit_mask_in_bucket;
 
                 return bucket.insert_at(offset_in_bucket, new_bucket_bv, widths);
             }
+            /// Allocates the positions `first + j` for the set bits `j`
+            /// of `bits`, with a single reallocation of their bucket.
+            ///
+            /// NB: `first` is a multiple of 64, the first position of a bucket.
+            inline void allocate_positions(size_t first, uint64_t bits) {
+                DCHECK_EQ(bucket_layout_t::table_pos_to_idx_inside_bucket(first), 0U);
+
+                auto pos = table_pos(first);
+                mark_dirty(pos.idx_of_bucket);
+
+                pos.bucket().insert_bits(bits, widths);
+            }
+            inline void deallocate_pos(table_pos_t pos) {
+                DCHECK(pos.exists_in_bucket());
+                mark_dirty(pos.idx_of_bucket);
+
+                auto& bucket = pos.bucket();
+                auto offset_in_bucket = pos.offset_in_bucket();
+
+                bucket.remove_at(offset_in_bucket, pos.bit_mask_in_bucket, widths);
+            }
+            /// NB: Counts as a change of the bucket if changes are tracked,
+            /// since the entry can be written through the returned pointer.
             inline entry_ptr_t at(table_pos_t pos) {
                 DCHECK(pos.exists_in_bucket());
+                mark_dirty(pos.idx_of_bucket);
 
                 auto& bucket = pos.bucket();
                 auto offset_in_bucket = pos.offset_in_bucket();
 
                 return bucket.at(offset_in_bucket, widths);
             }
+            /// Marks the bucket of `pos` as changed, for placements that
+            /// change their state at positions without an entry.
+            inline void mark_changed(table_pos_t pos) {
+                mark_dirty(pos.idx_of_bucket);
+            }
             inline bool pos_is_empty(table_pos_t pos) {
                 return !pos.exists_in_bucket();
             }
+            /// Returns the first allocated position in `[pos, end)`, or `end`.
+            ///
+            /// NB: Empty buckets are skipped as a whole.
+            inline size_t next_allocated_pos(size_t pos, size_t end) {
+                while (pos < end) {
+                    auto p = table_pos(pos);
+                    uint64_t const bits = p.bucket().bv() & ~(p.bit_mask_in_bucket - 1);
+                    size_t const bucket_start
+                        = pos - bucket_layout_t::table_pos_to_idx_inside_bucket(pos);
+                    if (bits != 0) {
+                        return std::min<size_t>(bucket_start + trailing_zeros(bits), end);
+                    }
+                    pos = bucket_start + 64;
+                }
+                return end;
+            }
             inline iter_t make_iter(table_pos_t const& pos) {
                 size_t buckets_size = bucket_layout_t::table_size_to_bucket_size(table_size);
-                return iter_t(m_buckets.get(), buckets_size, pos, widths);
+                return iter_t(m_buckets.get(), buckets_size, pos, widths, m_dirty);
             }
             inline void trim_storage(table_pos_t* last_start, table_pos_t const& end) {
                 // Check if end lies on a bucket boundary, then drop all buckets before it
@@ -173,13 +286,13 @@ namespace tdc {namespace compact_hash {
         inline auto context(size_t table_size, entry_bit_width_t const& widths) {
             // DCHECK(m_buckets); // this needs to be commented out for swapping two CHTs with std::move. 
             return context_t<buckets_t> {
-                m_buckets, table_size, widths
+                m_buckets, table_size, widths, m_dirty.get()
             };
         }
         inline auto context(size_t table_size, entry_bit_width_t const& widths) const {
             DCHECK(m_buckets);
             return context_t<buckets_t const> {
-                m_buckets, table_size, widths
+                m_buckets, table_size, widths, nullptr
             };
         }
     };
@@ -197,6 +310,7 @@ struct heap_size<compact_hash::buckets_bv_t<satellite_t>> {
 
         auto bytes = object_size_t::empty();
         bytes += object_size_t::exact(sizeof(decltype(val.m_buckets)));
+        bytes += object_size_t::exact(sizeof(decltype(val.m_dirty)));
 
         auto ctx = val.context(table_size, widths);
 
@@ -206,6 +320,10 @@ struct heap_size<compact_hash::buckets_bv_t<satellite_t>> {
             bytes += heap_size<bucket_t>::compute(bucket, widths);
         }
 
+        if (val.tracks_dirty()) {
+            bytes += object_size_t::exact(T::dirty_qword_size(buckets_size) * sizeof(uint64_t));
+        }
+
         return bytes;
     }
 };
@@ -218,34 +336,122 @@ struct serialize<compact_hash::buckets_bv_t<satellite_t>> {
     using bucket_layout_t = typename T::bucket_layout_t;
 
     static object_size_t write(std::ostream& out, T const& val, size_t table_size, entry_bit_width_t const& widths) {
-        using namespace compact_hash;
-
         auto bytes = object_size_t::empty();
 
-        auto ctx = val.context(table_size, widths);
+        bytes += write_head(out, val, table_size, widths);
+        bytes += write_units(out, val, table_size, widths, 0, unit_count(table_size, widths));
 
-        size_t buckets_size = bucket_layout_t::table_size_to_bucket_size(table_size);
-        for(size_t i = 0; i < buckets_size; i++) {
-            auto& bucket = ctx.m_buckets[i];
-            bytes += serialize<bucket_t>::write(out, bucket, widths);
+        return bytes;
+    }
+    static T read(std::istream& in, size_t table_size, entry_bit_width_t const& widths,
+                  typename T::config_args const& config = typename T::config_args{}) {
+        T val = read_head(in, table_size, widths, config);
+        read_units(in, val, table_size, widths, 0, unit_count(table_size, widths));
+        return val;
+    }
+
+    // Parts of the serialization that the chunked serialization
+    // writes and reads independently. Each unit is one bucket.
+
+    static size_t unit_count(size_t table_size, entry_bit_width_t const& widths) {
+        return bucket_layout_t::table_size_to_bucket_size(table_size);
+    }
+    static object_size_t write_head(std::ostream& out, T const& val, size_t table_size, entry_bit_width_t const& widths) {
+        return object_size_t::empty();
+    }
+    static T read_head(std::istream& in, size_t table_size, entry_bit_width_t const& widths,
+                       typename T::config_args const& config = typename T::config_args{}) {
+        return T { table_size, widths, config };
+    }
+    static object_size_t write_units(std::ostream& out, T const& val, size_t table_size, entry_bit_width_t const& widths,
+                                     size_t begin, size_t end) {
+        auto bytes = object_size_t::empty();
+
+        for(size_t i = begin; i < end; i++) {
+            bytes += serialize<bucket_t>::write(out, val.m_buckets[i], widths);
         }
 
         return bytes;
     }
-    static T read(std::istream& in, size_t table_size, entry_bit_width_t const& widths) {
-        using namespace compact_hash;
-
-        T val { table_size, widths, {} };
+    static void read_units(std::istream& in, T& val, size_t table_size, entry_bit_width_t const& widths,
+                           size_t begin, size_t end) {
+        for(size_t i = begin; i < end; i++) {
+            val.m_buckets[i] = serialize<bucket_t>::read(in, widths);
+        }
+    }
 
-        auto ctx = val.context(table_size, widths);
+    // Delta snapshots, which only contain the buckets marked as dirty.
+    // Each unit is one bucket, and runs of dirty buckets are written as ranges.
 
+    static bool all_dirty(T const& val, size_t table_size) {
+        DCHECK(val.tracks_dirty());
         size_t buckets_size = bucket_layout_t::table_size_to_bucket_size(table_size);
         for(size_t i = 0; i < buckets_size; i++) {
-            auto& bucket = ctx.m_buckets[i];
-            bucket = serialize<bucket_t>::read(in, widths);
+            if (!val.is_dirty(i)) return false;
+        }
+        return true;
+    }
+    /// The runs of dirty buckets, as ranges of buckets.
+    static delta_ranges_t dirty_units(T const& val, size_t table_size) {
+        DCHECK(val.tracks_dirty());
+
+        size_t buckets_size = bucket_layout_t::table_size_to_bucket_size(table_size);
+        delta_ranges_t ranges;
+        for(size_t i = 0; i < buckets_size;) {
+            if ((val.m_dirty[i / 64] >> (i % 64)) == 0) {
+                // skip the clean rest of this word
+                i = (i / 64 + 1) * 64;
+                continue;
+            }
+            if (!val.is_dirty(i)) {
+                i++;
+                continue;
+            }
+            size_t begin = i;
+            while (i < buckets_size && val.is_dirty(i)) {
+                i++;
+            }
+            ranges.emplace_back(begin, i);
+        }
+        return ranges;
+    }
+    /// The table positions of the dirty buckets, see `delta_ranges_t`.
+    static delta_ranges_t dirty_ranges(T const& val, size_t table_size) {
+        auto ranges = dirty_units(val, table_size);
+        for (auto& range : ranges) {
+            range.first = range.first << bucket_layout_t::BVS_WIDTH_SHIFT;
+            range.second = std::min<size_t>(range.second << bucket_layout_t::BVS_WIDTH_SHIFT, table_size);
+        }
+        return ranges;
+    }
+    static object_size_t write_dirty_units(std::ostream& out, T const& val, size_t table_size, entry_bit_width_t const& widths) {
+        auto const ranges = dirty_units(val, table_size);
+
+        auto bytes = object_size_t::empty();
+        bytes += serialize<uint64_t>::write(out, uint64_t(ranges.size()));
+        for (auto const& range : ranges) {
+            bytes += serialize<uint64_t>::write(out, uint64_t(range.first));
+            bytes += serialize<uint64_t>::write(out, uint64_t(range.second));
+            bytes += write_units(out, val, table_size, widths, range.first, range.second);
         }
+        return bytes;
+    }
+    static void read_dirty_units(std::istream& in, T& val, size_t table_size, entry_bit_width_t const& widths) {
+        size_t buckets_size = unit_count(table_size, widths);
+        auto ctx = val.context(table_size, widths);
 
-        return val;
+        size_t range_count = serialize<uint64_t>::read(in);
+        for (size_t r = 0; r < range_count; r++) {
+            size_t begin = serialize<uint64_t>::read(in);
+            size_t end = serialize<uint64_t>::read(in);
+            CHECK_LE(begin, end);
+            CHECK_LE(end, buckets_size) << "Delta does not fit the table";
+
+            for(size_t i = begin; i < end; i++) {
+                ctx.drop_bucket(i);
+            }
+            read_units(in, val, table_size, widths, begin, end);
+        }
     }
     static bool equal_check(T const& lhs, T const& rhs, size_t table_size, entry_bit_width_t const& widths) {
         auto lhsc = lhs.context(table_size, widths);
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstdlib>
+#include <memory>
+
+#include <glog/logging.h>
+
+#include <tudocomp/util/heap_size.hpp>
+
+namespace tdc {namespace compact_hash {
+
+/// Allocation policy that keeps the flat array of a storage on the heap.
+class heap_allocation_t {
+    template<typename T>
+    friend struct ::tdc::heap_size;
+
+    struct free_deleter_t {
+        inline void operator()(uint64_t* data) const {
+            free(data);
+        }
+    };
+
+    std::unique_ptr<uint64_t[], free_deleter_t> m_data;
+    size_t m_size = 0;
+public:
+    /// runtime initilization arguments, if any
+    struct config_args {};
+
+    /// get the config of this instance
+    inline config_args current_config() const { return config_args{}; }
+
+    inline heap_allocation_t() = default;
+
+    /// Allocates `qword_size` zero-initialized 64 bit words.
+    ///
+    /// NB: This uses `calloc`, which gets large allocations as fresh
+    /// zero pages from the system, without touching them.
+    inline heap_allocation_t(size_t qword_size, config_args config):
+        m_data((uint64_t*) calloc(qword_size, sizeof(uint64_t))),
+        m_size(qword_size)
+    {
+        CHECK(m_data != nullptr || qword_size == 0)
+            << "Could not allocate " << qword_size << " words";
+    }
+
+    /// Start of the allocation.
+    ///
+    /// NB: Like a `std::unique_ptr`, constness does not propagate to the data.
+    inline uint64_t* get() const {
+        return m_data.get();
+    }
+
+    /// Size of the allocation in 64 bit words.
+    inline size_t size() const {
+        return m_size;
+    }
+
+    /// Does nothing, since parts of a heap allocation can not be released.
+    inline void release(size_t, size_t) {}
+};
+
+}
+
+template<>
+struct heap_size<compact_hash::heap_allocation_t> {
+    using T = compact_hash::heap_allocation_t;
+
+    static object_size_t compute(T const& val) {
+        return object_size_t::exact(sizeof(val.m_data) + val.m_size * sizeof(uint64_t));
+    }
+};
+
+}
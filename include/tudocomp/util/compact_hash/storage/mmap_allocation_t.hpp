@@ -0,0 +1,328 @@
+#pragma once
+
+#include <algorithm>
+#include <string>
+#include <utility>
+
+#include <cstdio>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <glog/logging.h>
+
+#include <tudocomp/util/heap_size.hpp>
+#include <tudocomp/util/compact_hash/page_policy.hpp>
+
+namespace tdc {namespace compact_hash {
+
+/// Allocation policy that keeps the flat array of a storage in a shared
+/// memory mapping.
+///
+/// If `config_args::directory` is set, the mapping is backed by a file
+/// created in that directory, such that tables larger than the main memory
+/// get paged out to it by the kernel. The file is unlinked right after its
+/// creation, so it does not outlive the table. With `config_args::named_file`,
+/// it keeps its name instead, and can be kept with `persist()` and mapped
+/// again with `open()`.
+/// Otherwise, the mapping is anonymous.
+///
+/// Each table of a growing hashmap gets its own mapping, which is sized with
+/// `ftruncate` and released as a whole after the old table has been drained.
+/// While it is drained, the pages of the drained slots are released with `release()`.
+///
+/// The mapping can be backed by huge pages to reduce TLB misses on random
+/// accesses, and its pages can be interleaved over the NUMA nodes.
+/// Explicit huge pages (`huge_2mb`, `huge_1gb`) are only requested for
+/// anonymous mappings or with a directory on a `hugetlbfs`, and fall
+/// back to transparent huge pages if the mapping fails.
+class mmap_allocation_t {
+    template<typename T>
+    friend struct ::tdc::heap_size;
+
+public:
+    /// runtime initilization arguments, if any
+    struct config_args {
+        /// Directory of the backing files, or empty for an anonymous mapping.
+        std::string directory;
+        /// Whether to fault in the whole mapping up front (`MAP_POPULATE`).
+        bool populate = false;
+        /// Access pattern hint passed to `madvise`.
+        int advice = MADV_RANDOM;
+        /// Size of the pages backing the mapping.
+        page_size_t page_size = page_size_t::normal;
+        /// Placement of the pages on the NUMA nodes.
+        numa_policy_t numa_policy = numa_policy_t::first_touch;
+        /// Whether the backing file keeps its name while it is mapped.
+        ///
+        /// It is still removed when the allocation is released,
+        /// unless it was kept with `persist()`, but a crash leaves it behind.
+        bool named_file = false;
+    };
+
+private:
+    uint64_t* m_data = nullptr;
+    size_t m_size = 0;
+    size_t m_mapped_bytes = 0;
+    config_args m_config;
+    std::string m_path;
+    bool m_keep_file = false;
+
+    inline size_t size_in_bytes() const {
+        return m_size * sizeof(uint64_t);
+    }
+
+    inline void unmap() {
+        if (m_data != nullptr) {
+            munmap(m_data, m_mapped_bytes);
+            m_data = nullptr;
+            m_size = 0;
+            m_mapped_bytes = 0;
+        }
+        if (!m_path.empty() && !m_keep_file) {
+            unlink(m_path.c_str());
+        }
+        m_path.clear();
+        m_keep_file = false;
+    }
+
+    inline static int explicit_huge_page_flags(page_size_t page_size) {
+        int flags = 0;
+#ifdef MAP_HUGETLB
+        flags |= MAP_HUGETLB;
+#ifdef MAP_HUGE_SHIFT
+        flags |= (page_size == page_size_t::huge_1gb ? 30 : 21) << MAP_HUGE_SHIFT;
+#endif
+#endif
+        return flags;
+    }
+
+    /// Maps `m_mapped_bytes` bytes of the file `fd`,
+    /// or anonymous memory if it is negative, and closes `fd`.
+    inline void map(int fd) {
+        bool const explicit_huge_pages = m_config.page_size == page_size_t::huge_2mb
+                                      || m_config.page_size == page_size_t::huge_1gb;
+        bool const interleave = m_config.numa_policy == numa_policy_t::interleave;
+
+        int flags = MAP_SHARED;
+        if (fd < 0) {
+            flags |= MAP_ANONYMOUS;
+        }
+
+#ifdef MAP_POPULATE
+        // NB: The NUMA policy needs to be set before the pages are touched.
+        if (m_config.populate && !interleave) {
+            flags |= MAP_POPULATE;
+        }
+#endif
+
+        void* data = MAP_FAILED;
+        if (explicit_huge_pages && fd < 0) {
+            data = mmap(nullptr, m_mapped_bytes, PROT_READ | PROT_WRITE,
+                        flags | explicit_huge_page_flags(m_config.page_size), fd, 0);
+        }
+        // NB: A file on a `hugetlbfs` gets huge pages anyway,
+        // and ignores the advice for transparent ones.
+        bool const got_explicit_huge_pages = data != MAP_FAILED;
+        if (data == MAP_FAILED) {
+            data = mmap(nullptr, m_mapped_bytes, PROT_READ | PROT_WRITE, flags, fd, 0);
+        }
+        CHECK(data != MAP_FAILED) << "Could not map " << m_mapped_bytes << " bytes";
+        m_data = (uint64_t*) data;
+
+        if (fd >= 0) {
+            close(fd);
+        }
+
+        madvise(m_data, m_mapped_bytes, m_config.advice);
+        if (m_config.page_size != page_size_t::normal && !got_explicit_huge_pages) {
+            advise_transparent_huge_pages(m_data, m_mapped_bytes);
+        }
+        if (interleave) {
+            interleave_numa_nodes(m_data, m_mapped_bytes);
+
+            if (m_config.populate) {
+                size_t const stride = page_size_in_bytes(page_size_t::normal);
+                auto bytes = (char volatile*) m_data;
+                for (size_t i = 0; i < m_mapped_bytes; i += stride) {
+                    bytes[i] = 0;
+                }
+            }
+        }
+    }
+
+public:
+    /// get the config of this instance
+    inline config_args current_config() const { return m_config; }
+
+    inline mmap_allocation_t() = default;
+
+    /// Maps `qword_size` zero-initialized 64 bit words.
+    inline mmap_allocation_t(size_t qword_size, config_args config):
+        m_size(qword_size),
+        m_config(config)
+    {
+        if (m_size == 0) {
+            return;
+        }
+
+        size_t const page_bytes = page_size_in_bytes(config.page_size);
+        m_mapped_bytes = (size_in_bytes() + page_bytes - 1) / page_bytes * page_bytes;
+
+        int fd = -1;
+        if (!config.directory.empty()) {
+            std::string path = config.directory + "/compact_hash_XXXXXX";
+            fd = mkstemp(&path[0]);
+            CHECK_GE(fd, 0) << "Could not create a file in " << config.directory;
+            if (config.named_file) {
+                m_path = path;
+            } else {
+                unlink(path.c_str());
+            }
+
+            // NB: The new file reads as zeroes.
+            CHECK_EQ(ftruncate(fd, m_mapped_bytes), 0)
+                << "Could not resize a file in " << config.directory;
+        }
+        map(fd);
+    }
+
+    /// Maps the file at `path`, which an allocation of `qword_size` words
+    /// was persisted to with `persist()`.
+    ///
+    /// Changes are written back to the file, which is kept after the
+    /// allocation is released.
+    inline static mmap_allocation_t open(std::string const& path,
+                                         size_t qword_size,
+                                         config_args config) {
+        mmap_allocation_t r;
+        r.m_size = qword_size;
+        r.m_config = config;
+        r.m_path = path;
+        r.m_keep_file = true;
+
+        int fd = ::open(path.c_str(), O_RDWR);
+        CHECK_GE(fd, 0) << "Could not open " << path;
+        struct stat st;
+        CHECK_EQ(fstat(fd, &st), 0) << "Could not stat " << path;
+        CHECK_GE(size_t(st.st_size), r.size_in_bytes()) << path << " is too small";
+
+        // NB: The pages behind the end of the file are never accessed.
+        size_t const page_bytes = page_size_in_bytes(config.page_size);
+        r.m_mapped_bytes = (r.size_in_bytes() + page_bytes - 1) / page_bytes * page_bytes;
+        if (r.m_size > 0) {
+            r.map(fd);
+        } else {
+            close(fd);
+        }
+        return r;
+    }
+
+    inline mmap_allocation_t(mmap_allocation_t&& other):
+        m_data(other.m_data),
+        m_size(other.m_size),
+        m_mapped_bytes(other.m_mapped_bytes),
+        m_config(std::move(other.m_config)),
+        m_path(std::move(other.m_path)),
+        m_keep_file(other.m_keep_file)
+    {
+        other.m_data = nullptr;
+        other.m_size = 0;
+        other.m_mapped_bytes = 0;
+        other.m_path.clear();
+    }
+    inline mmap_allocation_t& operator=(mmap_allocation_t&& other) {
+        unmap();
+        std::swap(m_data, other.m_data);
+        std::swap(m_size, other.m_size);
+        std::swap(m_mapped_bytes, other.m_mapped_bytes);
+        std::swap(m_path, other.m_path);
+        std::swap(m_keep_file, other.m_keep_file);
+        m_config = other.m_config;
+        return *this;
+    }
+    inline mmap_allocation_t(mmap_allocation_t const& other) = delete;
+    inline mmap_allocation_t& operator=(mmap_allocation_t const& other) = delete;
+
+    inline ~mmap_allocation_t() {
+        unmap();
+    }
+
+    /// Start of the allocation.
+    ///
+    /// NB: Like a `std::unique_ptr`, constness does not propagate to the data.
+    inline uint64_t* get() const {
+        return m_data;
+    }
+
+    /// Size of the allocation in 64 bit words.
+    inline size_t size() const {
+        return m_size;
+    }
+
+    /// Path of the backing file, or empty if it has no name.
+    inline std::string const& path() const {
+        return m_path;
+    }
+
+    /// Writes the mapping back to its file, and keeps the file at `path`
+    /// after the allocation is released, such that it can be mapped
+    /// again with `open()`.
+    ///
+    /// This needs a file created with `config_args::named_file`.
+    inline void persist(std::string const& path) {
+        CHECK(!m_path.empty()) << "persist() needs a named backing file";
+        if (m_data != nullptr) {
+            CHECK_EQ(msync(m_data, m_mapped_bytes, MS_SYNC), 0)
+                << "Could not write back " << m_path;
+        }
+        if (path != m_path) {
+            CHECK_EQ(std::rename(m_path.c_str(), path.c_str()), 0)
+                << "Could not rename " << m_path << " to " << path;
+            m_path = path;
+        }
+        m_keep_file = true;
+    }
+
+    /// Releases the memory of the whole pages inside the words `[begin, end)`,
+    /// whose contents are not needed anymore.
+    ///
+    /// The released words read as zeroes afterwards, or as their old
+    /// contents if the file system can not punch holes into the backing file.
+    inline void release(size_t begin, size_t end) {
+        size_t const page_bytes = page_size_in_bytes(page_size_t::normal);
+        size_t const first = (begin * sizeof(uint64_t) + page_bytes - 1) / page_bytes * page_bytes;
+        size_t const last = std::min(end * sizeof(uint64_t), m_mapped_bytes) / page_bytes * page_bytes;
+        if (m_data == nullptr || first >= last) {
+            return;
+        }
+        char* const bytes = (char*) m_data;
+        // NB: `MADV_DONTNEED` only drops the pages of a shared mapping from the
+        // page table, but keeps them in the page cache. `MADV_REMOVE`
+        // frees them, and the space they take in the file.
+#ifdef MADV_REMOVE
+        if (madvise(bytes + first, last - first, MADV_REMOVE) == 0) {
+            return;
+        }
+#endif
+        madvise(bytes + first, last - first, MADV_DONTNEED);
+    }
+};
+
+}
+
+template<>
+struct heap_size<compact_hash::mmap_allocation_t> {
+    using T = compact_hash::mmap_allocation_t;
+
+    static object_size_t compute(T const& val) {
+        // NB: The mapping is not part of the heap,
+        // but still occupies memory while it is resident.
+        return object_size_t::exact(sizeof(T))
+            + object_size_t::unknown_extra_data(val.m_mapped_bytes);
+    }
+};
+
+}
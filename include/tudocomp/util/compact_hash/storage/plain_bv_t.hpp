@@ -0,0 +1,316 @@
+#pragma once
+
+#include <algorithm>
+#include <memory>
+
+#include <tudocomp/util/compact_hash/util.hpp>
+#include <tudocomp/util/compact_hash/entry_t.hpp>
+#include <tudocomp/util/compact_hash/storage/heap_allocation_t.hpp>
+#include <tudocomp/util/compact_hash/storage/mmap_allocation_t.hpp>
+
+#include <tudocomp/util/serialization.hpp>
+
+// Table for uninitalized elements
+
+namespace tdc {namespace compact_hash {
+    /// Storage that keeps all slots in one flat array, provided by `allocation_t`,
+    /// and marks the occupied slots in a bit vector.
+    ///
+    /// Unlike `basic_plain_sentinel_t`, no value needs to be reserved for
+    /// empty slots, and checking a slot for emptiness does not load its value.
+    /// Runs of empty slots are skipped 64 slots at a time.
+    template<typename satellite_t, typename allocation_t>
+    struct basic_plain_bv_t {
+        using satellite_t_export = satellite_t;
+        using entry_ptr_t = typename satellite_t::entry_ptr_t;
+        using entry_bit_width_t = typename satellite_t::entry_bit_width_t;
+        using qvd_t = typename satellite_t::bucket_data_layout_t;
+
+        template<typename T>
+        friend struct ::tdc::serialize;
+
+        template<typename T>
+        friend struct ::tdc::heap_size;
+
+        allocation_t m_alloc;
+        allocation_t m_occupied;
+
+        inline static size_t occupied_qword_size(size_t table_size) {
+            return (table_size + 63) / 64;
+        }
+
+        /// runtime initilization arguments, if any
+        struct config_args {
+            typename allocation_t::config_args allocation_config;
+        };
+
+        /// get the config of this instance
+        inline config_args current_config() const {
+            return config_args{
+                m_alloc.current_config(),
+            };
+        }
+
+        inline basic_plain_bv_t() {}
+        inline basic_plain_bv_t(size_t table_size,
+                                entry_bit_width_t widths,
+                                config_args config):
+            m_alloc(qvd_t::calc_sizes(table_size, widths).overall_qword_size,
+                    config.allocation_config),
+            m_occupied(occupied_qword_size(table_size), config.allocation_config)
+        {
+            // NB: Slots are only initialized once they get allocated.
+        }
+        struct table_pos_t {
+            size_t offset;
+            inline table_pos_t(): offset(-1) {}
+            inline table_pos_t(size_t o): offset(o) {}
+            inline table_pos_t& operator=(table_pos_t const& other) = default;
+            inline table_pos_t(table_pos_t const& other) = default;
+        };
+        // pseudo-iterator for iterating over bucket elements
+        // NB: does not wrap around!
+        struct iter_t {
+            uint64_t const*   m_occupied;
+            uint64_t*         m_alloc;
+            size_t            m_table_size;
+            size_t            m_pos;
+            entry_bit_width_t m_widths;
+
+            inline entry_ptr_t get() {
+                return qvd_t::at(m_alloc, m_table_size, m_pos, m_widths);
+            }
+
+            inline void decrement() {
+                do {
+                    m_pos--;
+                } while(((m_occupied[m_pos / 64] >> (m_pos % 64)) & 1ull) == 0);
+            }
+
+            inline bool operator!=(iter_t& other) {
+                return m_pos != other.m_pos;
+            }
+        };
+
+        template<typename alloc_type>
+        struct context_t {
+            alloc_type& m_alloc;
+            alloc_type& m_occupied;
+            size_t const table_size;
+            entry_bit_width_t widths;
+
+            inline bool is_occupied(size_t pos) {
+                return (m_occupied.get()[pos / 64] >> (pos % 64)) & 1ull;
+            }
+
+            inline void destroy_vals() {
+                if (m_occupied.get() == nullptr) return;  // stop when this is an instance after std::move
+
+                for (size_t i = next_allocated_pos(0, table_size);
+                     i < table_size;
+                     i = next_allocated_pos(i + 1, table_size)) {
+                    at(table_pos(i)).uninitialize();
+                }
+            }
+
+            inline table_pos_t table_pos(size_t pos) {
+                return table_pos_t { pos };
+            }
+            inline entry_ptr_t allocate_pos(table_pos_t pos) {
+                DCHECK_LT(pos.offset, table_size);
+                DCHECK(!is_occupied(pos.offset));
+
+                m_occupied.get()[pos.offset / 64] |= 1ull << (pos.offset % 64);
+
+                return at(pos);
+            }
+            /// Allocates the positions `first + j` for the set bits `j` of `bits`.
+            ///
+            /// NB: `first` is a multiple of 64.
+            inline void allocate_positions(size_t first, uint64_t bits) {
+                DCHECK_EQ(first % 64, 0U);
+                DCHECK_EQ(m_occupied.get()[first / 64] & bits, 0U);
+
+                m_occupied.get()[first / 64] |= bits;
+            }
+            inline void deallocate_pos(table_pos_t pos) {
+                DCHECK_LT(pos.offset, table_size);
+                DCHECK(is_occupied(pos.offset));
+
+                at(pos).uninitialize();
+                m_occupied.get()[pos.offset / 64] &= ~(1ull << (pos.offset % 64));
+            }
+            inline entry_ptr_t at(table_pos_t pos) {
+                DCHECK_LT(pos.offset, table_size);
+                return qvd_t::at(m_alloc.get(), table_size, pos.offset, widths);
+            }
+            inline void mark_changed(table_pos_t pos) {
+                // Nothing to be done
+            }
+            inline bool pos_is_empty(table_pos_t pos) {
+                DCHECK_LT(pos.offset, table_size);
+                return !is_occupied(pos.offset);
+            }
+            /// Returns the first allocated position in `[pos, end)`, or `end`.
+            inline size_t next_allocated_pos(size_t pos, size_t end) {
+                DCHECK_LE(end, table_size);
+                while (pos < end) {
+                    uint64_t const bits = m_occupied.get()[pos / 64] >> (pos % 64);
+                    if (bits != 0) {
+                        return std::min<size_t>(pos + trailing_zeros(bits), end);
+                    }
+                    pos = (pos / 64 + 1) * 64;
+                }
+                return end;
+            }
+            inline iter_t make_iter(table_pos_t const& pos) {
+                // NB: One-pass-the-end is acceptable for a end iterator
+                DCHECK_LE(pos.offset, table_size);
+                return iter_t {
+                    m_occupied.get(), m_alloc.get(), table_size, pos.offset, widths,
+                };
+            }
+            inline void trim_storage(table_pos_t* last_start, table_pos_t const& end) {
+                // Nothing to be done
+            }
+        };
+        /// Whether reads mark parts of the storage as changed.
+        ///
+        /// Never the case for a flat array.
+        inline bool tracks_dirty() const {
+            return false;
+        }
+
+        inline auto context(size_t table_size, entry_bit_width_t const& widths) {
+            return context_t<allocation_t> {
+                m_alloc, m_occupied, table_size, widths,
+            };
+        }
+        inline auto context(size_t table_size, entry_bit_width_t const& widths) const {
+            return context_t<allocation_t const> {
+                m_alloc, m_occupied, table_size, widths,
+            };
+        }
+    };
+
+    /// Storage that keeps all slots in one flat array on the heap,
+    /// and marks the occupied slots in a bit vector.
+    template<typename satellite_t>
+    using plain_bv_t = basic_plain_bv_t<satellite_t, heap_allocation_t>;
+}
+
+template<typename satellite_t, typename allocation_t>
+struct heap_size<compact_hash::basic_plain_bv_t<satellite_t, allocation_t>> {
+    using T = compact_hash::basic_plain_bv_t<satellite_t, allocation_t>;
+    using entry_bit_width_t = typename T::entry_bit_width_t;
+    using qvd_t = typename T::qvd_t;
+
+    static object_size_t compute(T const& val, size_t table_size, entry_bit_width_t const& widths) {
+        auto bytes = object_size_t::empty();
+
+        DCHECK_EQ(val.m_alloc.size(), qvd_t::calc_sizes(table_size, widths).overall_qword_size);
+        DCHECK_EQ(val.m_occupied.size(), T::occupied_qword_size(table_size));
+
+        bytes += heap_size<allocation_t>::compute(val.m_alloc);
+        bytes += heap_size<allocation_t>::compute(val.m_occupied);
+
+        return bytes;
+    }
+};
+
+template<typename satellite_t, typename allocation_t>
+struct serialize<compact_hash::basic_plain_bv_t<satellite_t, allocation_t>> {
+    using T = compact_hash::basic_plain_bv_t<satellite_t, allocation_t>;
+    using entry_bit_width_t = typename T::entry_bit_width_t;
+    using qvd_t = typename T::qvd_t;
+
+    static object_size_t write(std::ostream& out, T const& val, size_t table_size, entry_bit_width_t const& widths) {
+        auto bytes = object_size_t::empty();
+
+        bytes += write_head(out, val, table_size, widths);
+        bytes += write_units(out, val, table_size, widths, 0, unit_count(table_size, widths));
+
+        return bytes;
+    }
+    static T read(std::istream& in, size_t table_size, entry_bit_width_t const& widths,
+                  typename T::config_args const& config = typename T::config_args{}) {
+        T ret = read_head(in, table_size, widths, config);
+        read_units(in, ret, table_size, widths, 0, unit_count(table_size, widths));
+        return ret;
+    }
+
+    // Parts of the serialization that the chunked serialization
+    // writes and reads independently. Each unit is one word of the
+    // occupancy bit vector, followed by one word of the allocation.
+
+    static size_t unit_count(size_t table_size, entry_bit_width_t const& widths) {
+        return T::occupied_qword_size(table_size)
+            + qvd_t::calc_sizes(table_size, widths).overall_qword_size;
+    }
+    static object_size_t write_head(std::ostream& out, T const& val, size_t table_size, entry_bit_width_t const& widths) {
+        return object_size_t::empty();
+    }
+    static T read_head(std::istream& in, size_t table_size, entry_bit_width_t const& widths,
+                       typename T::config_args const& config = typename T::config_args{}) {
+        auto occupied_size = T::occupied_qword_size(table_size);
+        auto alloc_size = qvd_t::calc_sizes(table_size, widths).overall_qword_size;
+
+        // NB: The allocation config is not serialized,
+        // so it is taken from `config`.
+        T ret;
+        ret.m_occupied = allocation_t(occupied_size, config.allocation_config);
+        ret.m_alloc = allocation_t(alloc_size, config.allocation_config);
+        return ret;
+    }
+    static object_size_t write_units(std::ostream& out, T const& val, size_t table_size, entry_bit_width_t const& widths,
+                                     size_t begin, size_t end) {
+        auto bytes = object_size_t::empty();
+        for_unit_ranges(val, table_size, begin, end, [&](uint64_t* data, size_t size) {
+            bytes += serialize_write_words(out, data, size);
+        });
+        return bytes;
+    }
+    static void read_units(std::istream& in, T& val, size_t table_size, entry_bit_width_t const& widths,
+                           size_t begin, size_t end) {
+        for_unit_ranges(val, table_size, begin, end, [&](uint64_t* data, size_t size) {
+            serialize_read_words(in, data, size);
+        });
+    }
+    /// Splits the units `[begin, end)` into the contiguous parts of both arrays.
+    template<typename F>
+    static void for_unit_ranges(T const& val, size_t table_size, size_t begin, size_t end, F f) {
+        size_t const occupied_size = T::occupied_qword_size(table_size);
+        if (begin < occupied_size) {
+            size_t const occupied_end = std::min(end, occupied_size);
+            f(val.m_occupied.get() + begin, occupied_end - begin);
+            begin = occupied_end;
+        }
+        if (begin < end) {
+            f(val.m_alloc.get() + (begin - occupied_size), end - begin);
+        }
+    }
+    static bool equal_check(T const& lhs, T const& rhs, size_t table_size, entry_bit_width_t const& widths) {
+        auto lhsc = lhs.context(table_size, widths);
+        auto rhsc = rhs.context(table_size, widths);
+
+        for (size_t i = 0; i < table_size; i++) {
+            auto lhspos = lhsc.table_pos(i);
+            auto rhspos = rhsc.table_pos(i);
+            if (!gen_equal_diagnostic(lhsc.pos_is_empty(lhspos) == rhsc.pos_is_empty(rhspos))) {
+                return false;
+            }
+            if (!lhsc.pos_is_empty(lhspos)) {
+                auto lhsptrs = lhsc.at(lhspos);
+                auto rhsptrs = rhsc.at(rhspos);
+
+                if (!gen_equal_diagnostic(lhsptrs.contents_eq(rhsptrs))) {
+                    return false;
+                }
+            }
+        }
+
+        return true;
+    }
+};
+
+}
@@ -1,17 +1,22 @@
 #pragma once
 
 #include <memory>
+#include <type_traits>
 
 #include <tudocomp/util/compact_hash/util.hpp>
 #include <tudocomp/util/compact_hash/entry_t.hpp>
+#include <tudocomp/util/compact_hash/storage/heap_allocation_t.hpp>
+#include <tudocomp/util/compact_hash/storage/mmap_allocation_t.hpp>
 
 #include <tudocomp/util/serialization.hpp>
 
 // Table for uninitalized elements
 
 namespace tdc {namespace compact_hash {
-    template<typename satellite_t>
-    struct plain_sentinel_t {
+    /// Storage that keeps all slots in one flat array, provided by `allocation_t`,
+    /// and marks empty slots with a sentinel value.
+    template<typename satellite_t, typename allocation_t>
+    struct basic_plain_sentinel_t {
         using satellite_t_export = satellite_t;
         using entry_ptr_t = typename satellite_t::entry_ptr_t;
         using entry_bit_width_t = typename satellite_t::entry_bit_width_t;
@@ -21,32 +26,46 @@ namespace tdc {namespace compact_hash {
         template<typename T>
         friend struct ::tdc::serialize;
 
-        std::unique_ptr<uint64_t[]> m_alloc;
+        allocation_t m_alloc;
         value_type m_empty_value;
 
+        /// Number of slots that are released at once by `trim_storage()`.
+        static constexpr size_t TRIM_SLOTS = size_t(1) << 15;
+
         /// runtime initilization arguments, if any
         struct config_args {
             value_type empty_value = value_type();
+            typename allocation_t::config_args allocation_config;
         };
 
         /// get the config of this instance
         inline config_args current_config() const {
             return config_args{
                 m_empty_value,
+                m_alloc.current_config(),
             };
         }
 
-        inline plain_sentinel_t() {}
-        inline plain_sentinel_t(size_t table_size,
-                                entry_bit_width_t widths,
-                                config_args config):
+        inline basic_plain_sentinel_t() {}
+        inline basic_plain_sentinel_t(size_t table_size,
+                                      entry_bit_width_t widths,
+                                      config_args config):
             m_empty_value(config.empty_value)
         {
             size_t alloc_size = qvd_t::calc_sizes(table_size, widths).overall_qword_size;
-            m_alloc = std::make_unique<uint64_t[]>(alloc_size);
+            m_alloc = allocation_t(alloc_size, config.allocation_config);
 
             auto ctx = context(table_size, widths);
 
+            // NB: The allocation is zero-initialized. If the all-zero bit pattern
+            // already represents an empty slot, the slots are left untouched,
+            // such that their pages only get mapped in once they are used.
+            if (std::is_trivially_copyable<value_type>::value
+                && table_size > 0
+                && ctx.pos_is_empty(ctx.table_pos(0))) {
+                return;
+            }
+
             for(size_t i = 0; i < table_size; i++) {
                 // NB: Using at because allocate_pos()
                 // destroys the location first.
@@ -114,14 +133,42 @@ namespace tdc {namespace compact_hash {
 
                 return tmp;
             }
+            /// Allocates the positions `first + j` for the set bits `j` of `bits`.
+            ///
+            /// NB: `first` is a multiple of 64.
+            inline void allocate_positions(size_t first, uint64_t bits) {
+                DCHECK_EQ(first % 64, 0U);
+                for (; bits != 0; bits &= bits - 1) {
+                    allocate_pos(table_pos(first + trailing_zeros(bits)));
+                }
+            }
+            inline void deallocate_pos(table_pos_t pos) {
+                DCHECK_LT(pos.offset, table_size);
+                auto tmp = at(pos);
+
+                // NB: Empty locations are represented by a empty_value,
+                // so we replace the existing value with one.
+                tmp.uninitialize();
+                tmp.set_no_drop(value_type(m_empty_value), 0);
+            }
             inline entry_ptr_t at(table_pos_t pos) {
                 DCHECK_LT(pos.offset, table_size);
                 return qvd_t::at(m_alloc.get(), table_size, pos.offset, widths);
             }
+            inline void mark_changed(table_pos_t pos) {
+                // Nothing to be done
+            }
             inline bool pos_is_empty(table_pos_t pos) {
                 DCHECK_LT(pos.offset, table_size);
                 return *at(pos).val_ptr() == m_empty_value;
             }
+            /// Returns the first allocated position in `[pos, end)`, or `end`.
+            inline size_t next_allocated_pos(size_t pos, size_t end) {
+                while (pos < end && pos_is_empty(table_pos(pos))) {
+                    pos++;
+                }
+                return pos;
+            }
             inline iter_t make_iter(table_pos_t const& pos) {
                 // NB: One-pass-the-end is acceptable for a end iterator
                 DCHECK_LE(pos.offset, table_size);
@@ -130,26 +177,66 @@ namespace tdc {namespace compact_hash {
                     m_empty_value,
                 };
             }
+            /// Releases the pages of the slots drained since `*last_start`,
+            /// see `allocation_t::release()`.
+            ///
+            /// NB: This happens each time the drain enters a new range of
+            /// `TRIM_SLOTS` slots, which starts at a page boundary of the value
+            /// array for any value width. Values with a destructor are kept,
+            /// since they are destroyed after the drain.
             inline void trim_storage(table_pos_t* last_start, table_pos_t const& end) {
-                // Nothing to be done
+                if (!std::is_trivially_destructible<value_type>::value) {
+                    return;
+                }
+                auto release = [&](size_t first, size_t last) {
+                    qvd_t::for_words_of_slots(table_size, widths, first, last, [&](size_t b, size_t e) {
+                        m_alloc.release(b, e);
+                    });
+                };
+                size_t const trim_end = end.offset / TRIM_SLOTS * TRIM_SLOTS;
+                if (end.offset < (*last_start).offset) {
+                    // NB: The drain wrapped around the end of the table.
+                    release((*last_start).offset, table_size);
+                    *last_start = table_pos(0);
+                }
+                if ((*last_start).offset < trim_end) {
+                    release((*last_start).offset, trim_end);
+                    *last_start = table_pos(trim_end);
+                }
             }
         };
+        /// Whether reads mark parts of the storage as changed.
+        ///
+        /// Never the case for a flat array.
+        inline bool tracks_dirty() const {
+            return false;
+        }
+
         inline auto context(size_t table_size, entry_bit_width_t const& widths) {
-            return context_t<std::unique_ptr<uint64_t[]>> {
+            return context_t<allocation_t> {
                 m_alloc, m_empty_value, table_size, widths,
             };
         }
         inline auto context(size_t table_size, entry_bit_width_t const& widths) const {
-            return context_t<std::unique_ptr<uint64_t[]> const> {
+            return context_t<allocation_t const> {
                 m_alloc, m_empty_value, table_size, widths,
             };
         }
     };
+
+    /// Storage that keeps all slots in one flat array on the heap.
+    template<typename satellite_t>
+    using plain_sentinel_t = basic_plain_sentinel_t<satellite_t, heap_allocation_t>;
+
+    /// Storage that keeps all slots in one flat array in a shared memory mapping,
+    /// which can be backed by a file. See `mmap_allocation_t`.
+    template<typename satellite_t>
+    using mmap_sentinel_t = basic_plain_sentinel_t<satellite_t, mmap_allocation_t>;
 }
 
-template<typename satellite_t>
-struct heap_size<compact_hash::plain_sentinel_t<satellite_t>> {
-    using T = compact_hash::plain_sentinel_t<satellite_t>;
+template<typename satellite_t, typename allocation_t>
+struct heap_size<compact_hash::basic_plain_sentinel_t<satellite_t, allocation_t>> {
+    using T = compact_hash::basic_plain_sentinel_t<satellite_t, allocation_t>;
     using entry_bit_width_t = typename T::entry_bit_width_t;
     using value_type = typename T::value_type;
     using qvd_t = typename T::qvd_t;
@@ -159,51 +246,63 @@ struct heap_size<compact_hash::plain_sentinel_t<satellite_t>> {
 
         auto bytes = object_size_t::empty();
 
-        auto alloc_size = qvd_t::calc_sizes(table_size, widths).overall_qword_size;
+        DCHECK_EQ(val.m_alloc.size(), qvd_t::calc_sizes(table_size, widths).overall_qword_size);
 
         bytes += heap_size<value_type>::compute(val.m_empty_value);
-        bytes += heap_size<std::unique_ptr<uint64_t[]>>::compute(val.m_alloc, alloc_size);
+        bytes += heap_size<allocation_t>::compute(val.m_alloc);
 
         return bytes;
     }
 };
 
-template<typename satellite_t>
-struct serialize<compact_hash::plain_sentinel_t<satellite_t>> {
-    using T = compact_hash::plain_sentinel_t<satellite_t>;
+template<typename satellite_t, typename allocation_t>
+struct serialize<compact_hash::basic_plain_sentinel_t<satellite_t, allocation_t>> {
+    using T = compact_hash::basic_plain_sentinel_t<satellite_t, allocation_t>;
     using entry_bit_width_t = typename T::entry_bit_width_t;
     using value_type = typename T::value_type;
     using qvd_t = typename T::qvd_t;
 
     static object_size_t write(std::ostream& out, T const& val, size_t table_size, entry_bit_width_t const& widths) {
-        using namespace compact_hash;
-
         auto bytes = object_size_t::empty();
 
-        auto alloc_size = qvd_t::calc_sizes(table_size, widths).overall_qword_size;
-
-        bytes += serialize<value_type>::write(out, val.m_empty_value);
-        for (size_t i = 0; i < alloc_size; i++) {
-            bytes += serialize<uint64_t>::write(out, val.m_alloc[i]);
-        }
+        bytes += write_head(out, val, table_size, widths);
+        bytes += write_units(out, val, table_size, widths, 0, unit_count(table_size, widths));
 
         return bytes;
     }
-    static T read(std::istream& in, size_t table_size, entry_bit_width_t const& widths) {
-        using namespace compact_hash;
+    static T read(std::istream& in, size_t table_size, entry_bit_width_t const& widths,
+                  typename T::config_args const& config = typename T::config_args{}) {
+        T ret = read_head(in, table_size, widths, config);
+        read_units(in, ret, table_size, widths, 0, unit_count(table_size, widths));
+        return ret;
+    }
 
-        auto alloc_size = qvd_t::calc_sizes(table_size, widths).overall_qword_size;
+    // Parts of the serialization that the chunked serialization
+    // writes and reads independently. Each unit is one word of the allocation.
 
+    static size_t unit_count(size_t table_size, entry_bit_width_t const& widths) {
+        return qvd_t::calc_sizes(table_size, widths).overall_qword_size;
+    }
+    static object_size_t write_head(std::ostream& out, T const& val, size_t table_size, entry_bit_width_t const& widths) {
+        return serialize<value_type>::write(out, val.m_empty_value);
+    }
+    static T read_head(std::istream& in, size_t table_size, entry_bit_width_t const& widths,
+                       typename T::config_args const& config = typename T::config_args{}) {
         T ret;
         ret.m_empty_value = serialize<value_type>::read(in);
-        ret.m_alloc = std::make_unique<uint64_t[]>(alloc_size);
-
-        for (size_t i = 0; i < alloc_size; i++) {
-            ret.m_alloc[i] = serialize<uint64_t>::read(in);
-        }
-
+        // NB: The allocation config is not serialized,
+        // so it is taken from `config`.
+        ret.m_alloc = allocation_t(unit_count(table_size, widths), config.allocation_config);
         return ret;
     }
+    static object_size_t write_units(std::ostream& out, T const& val, size_t table_size, entry_bit_width_t const& widths,
+                                     size_t begin, size_t end) {
+        return serialize_write_words(out, val.m_alloc.get() + begin, end - begin);
+    }
+    static void read_units(std::istream& in, T& val, size_t table_size, entry_bit_width_t const& widths,
+                           size_t begin, size_t end) {
+        serialize_read_words(in, val.m_alloc.get() + begin, end - begin);
+    }
     static bool equal_check(T const& lhs, T const& rhs, size_t table_size, entry_bit_width_t const& widths) {
         auto lhsc = lhs.context(table_size, widths);
         auto rhsc = rhs.context(table_size, widths);
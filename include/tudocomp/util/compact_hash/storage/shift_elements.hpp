@@ -0,0 +1,144 @@
+#pragma once
+
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+#include <tudocomp/util/compact_hash/util.hpp>
+
+namespace tdc {namespace compact_hash {
+
+/// `sparse_shift()` for values that are relocated with `memcpy()`,
+/// which moves their raw bytes instead of move-assigning them.
+template<typename storage_ctx_t>
+inline auto sparse_shift(std::true_type, storage_ctx_t sctx, size_t from, size_t to) {
+    DCHECK_LT(from, to);
+    using entry_ptr_t = decltype(sctx.at(sctx.table_pos(from)));
+
+    auto from_loc = sctx.table_pos(from);
+    auto from_iter = sctx.make_iter(from_loc);
+
+    auto last = sctx.table_pos(to - 1);
+    auto src = sctx.make_iter(last);
+    auto dst = sctx.make_iter(sctx.table_pos(to));
+
+    // move the raw bytes of the element at the last position out
+    auto tmp = sctx.at(last).relocate_out();
+
+    // relocate all elements one to the right
+    while(src != from_iter) {
+        // Decrement first for backward iteration
+        src.decrement();
+        dst.decrement();
+
+        entry_ptr_t::relocate(dst.get(), src.get(), 1);
+    }
+
+    // move them into the front
+    sctx.at(from_loc).relocate_in(tmp);
+    return from_loc;
+}
+
+/// `sparse_shift()` for all other values.
+template<typename storage_ctx_t>
+inline auto sparse_shift(std::false_type, storage_ctx_t sctx, size_t from, size_t to) {
+    DCHECK_LT(from, to);
+
+    // initialize iterators like this:
+    // [         ]
+    // ^from   to^
+    //          ||
+    //    <- src^|
+    //    <- dest^
+
+    auto from_loc = sctx.table_pos(from);
+    auto from_iter = sctx.make_iter(from_loc);
+
+    auto last = sctx.table_pos(to - 1);
+    auto src = sctx.make_iter(last);
+    auto dst = sctx.make_iter(sctx.table_pos(to));
+
+    // move the element at the last position to a temporary position
+    auto tmp_p = sctx.at(last);
+    auto tmp = tmp_p.move_out();
+
+    // move all elements one to the right
+    // TODO: Could be optimized
+    // to memcpies for different underlying layouts
+    while(src != from_iter) {
+        // Decrement first for backward iteration
+        src.decrement();
+        dst.decrement();
+
+        // Get access to the value/quotient at src and dst
+        auto src_be = src.get();
+        auto dst_be = dst.get();
+
+        // Copy value/quotient over
+        dst_be.move_from(src_be);
+    }
+
+    // move last element to the front
+    auto from_p = sctx.at(from_loc);
+    from_p.set(std::move(tmp));
+    return from_loc;
+}
+
+/// Shifts all elements of the half-open range [from, to) inside
+/// the table one to the right,
+/// moving the last element to the front position,
+/// and returns the table position of the front.
+template<typename storage_ctx_t>
+inline auto sparse_shift(storage_ctx_t sctx, size_t from, size_t to) {
+    using entry_ptr_t = decltype(sctx.at(sctx.table_pos(from)));
+    return sparse_shift(std::integral_constant<bool, entry_ptr_t::relocates_by_memcpy>(), sctx, from, to);
+}
+
+/// Shifts all elements of the half-open range [from, to)
+/// inside the table one to the right, and returns a pointer to the
+/// now-empty location `from`.
+///
+/// The position `to` needs to be empty.
+template<typename storage_ctx_t>
+inline auto shift_elements_and_insert(storage_ctx_t sctx, size_t from, size_t to) {
+    // move from...to one to the right, then insert at from
+
+    DCHECK(from != to);
+
+    decltype(sctx.table_pos(from)) from_pos;
+
+    if (to < from) {
+        // if the range wraps around, we decompose into two ranges:
+        // [   |      |      ]
+        // | to^      ^from  |
+        // ^start         end^
+        // [ 2 ]      [  1   ]
+        //
+        // NB: because we require from != to, and insert 1 additional element,
+        // we are always dealing with a minimum 2 element range,
+        // and thus can not end up with a split range with length == 0.
+
+        from_pos = sparse_shift(sctx, from, sctx.table_size);
+        if (to > 0) {
+            auto start_pos = sparse_shift(sctx, 0, to);
+            sctx.at(from_pos).swap_with(sctx.at(start_pos));
+        }
+    } else {
+        // [     |      |      ]
+        //   from^      ^to
+
+        from_pos = sparse_shift(sctx, from, to);
+    }
+
+    // insert the element from the end of the range at the free
+    // position to the right of it.
+    auto new_loc = sctx.allocate_pos(sctx.table_pos(to));
+
+    auto from_ptrs = sctx.at(from_pos);
+    new_loc.init_from(from_ptrs);
+    from_ptrs.uninitialize();
+
+    return from_ptrs;
+}
+
+}}
@@ -2,8 +2,10 @@
 
 #include <memory>
 #include <cstdint>
+#include <cstring>
 #include <utility>
 #include <algorithm>
+#include <type_traits>
 
 #include <tudocomp/util/bit_packed_layout_t.hpp>
 
@@ -31,8 +33,97 @@ using ValPtr = typename cbp::cbp_repr_t<val_t>::pointer_t;
 template<typename val_t>
 using ValRef = typename cbp::cbp_repr_t<val_t>::reference_t;
 
+/// Whether a value of type `T` can be moved to another address with
+/// `memcpy()`, without calling its move constructor and destructor.
+///
+/// This is the case for all trivially copyable types, and can be
+/// specialized for other types that do not point into themselves,
+/// like `std::unique_ptr`.
+template<typename T>
+struct is_trivially_relocatable: std::is_trivially_copyable<T> {};
+
 inline size_t popcount(uint64_t value) {
     return __builtin_popcountll(value);
 }
 
+/// Number of trailing zero bits, expects `value != 0`.
+inline size_t trailing_zeros(uint64_t value) {
+    return __builtin_ctzll(value);
+}
+
+/// Number of words needed for `count` values of `width` bits.
+inline size_t words_for(size_t count, size_t width) {
+    return (count * width + 63) / 64;
+}
+
+inline uint64_t width_mask(size_t width) {
+    return (width == 64) ? ~0ull : ((1ull << width) - 1);
+}
+
+/// Reads `width` bits starting at bit `bit` of the words at `words`.
+///
+/// NB: A value may span two words, but the second one is only read
+/// if the value reaches into it.
+inline uint64_t get_bits(uint64_t const* words, size_t bit, size_t width) {
+    if (width == 0) return 0;
+
+    size_t const word = bit / 64;
+    size_t const offset = bit % 64;
+
+    uint64_t v = words[word] >> offset;
+    if (offset + width > 64) {
+        v |= words[word + 1] << (64 - offset);
+    }
+    return v & width_mask(width);
+}
+
+/// Writes the low `width` bits of `value` starting at bit `bit`.
+inline void set_bits(uint64_t* words, size_t bit, size_t width, uint64_t value) {
+    if (width == 0) return;
+
+    size_t const word = bit / 64;
+    size_t const offset = bit % 64;
+    uint64_t const mask = width_mask(width);
+
+    value &= mask;
+    words[word] = (words[word] & ~(mask << offset)) | (value << offset);
+    if (offset + width > 64) {
+        words[word + 1] = (words[word + 1] & ~(mask >> (64 - offset)))
+                        | (value >> (64 - offset));
+    }
+}
+
+inline bool bit_is_set(uint64_t const* words, size_t pos) {
+    return (words[pos / 64] >> (pos % 64)) & 1ull;
+}
+
+/// Whether `width` is the width of a native unsigned integer type.
+inline bool is_native_width(size_t width) {
+    return width == 8 || width == 16 || width == 32 || width == 64;
+}
+
+/// Whether the bit-packed arrays of `cbp` store their elements as one
+/// little-endian stream of bits, such that an array of a native width that
+/// starts at a byte boundary is an array of native integers.
+///
+/// NB: This depends on the bit order of `cbp` and the byte order
+/// of the machine, so it is checked once by writing through a
+/// bit-packed pointer that straddles two words.
+inline bool cbp_stores_native_arrays() {
+    static bool const native = []() {
+        uint64_t words[2] = { 0, 0 };
+        auto layout = cbp::bit_layout_t();
+        layout.cbp_elements<dynamic_t>(1, 24);
+        auto ptr = layout.cbp_elements<dynamic_t>(5, 16).ptr_relative_to(words);
+
+        uint16_t expected[5];
+        for (size_t i = 0; i < 5; i++) {
+            expected[i] = uint16_t(0x0102 + i * 0x2321);
+            *(ptr + i) = expected[i];
+        }
+        return std::memcmp(reinterpret_cast<char const*>(words) + 3, expected, sizeof(expected)) == 0;
+    }();
+    return native;
+}
+
 }}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include <tudocomp/util/serialization.hpp>
+
+namespace tdc {
+    /// Constants of the delta snapshot format.
+    struct delta_format_t {
+        static constexpr uint64_t MAGIC = 0x41544C4544434454ull; // "TDCDELTA"
+        static constexpr uint64_t VERSION = 2;
+    };
+
+    /// Ranges `[begin, end)` of table positions that changed since the
+    /// previous delta snapshot, in ascending order.
+    ///
+    /// Each range starts at a multiple of 64 positions, and ends at
+    /// one or at the end of the table.
+    using delta_ranges_t = std::vector<std::pair<size_t, size_t>>;
+
+    /// Writes the words of a bit-packed array with `width` bits per
+    /// element that hold the elements in `ranges`.
+    ///
+    /// NB: Since the ranges start and end at multiples of 64 elements,
+    /// no word holds elements of two ranges, or of a range and a position
+    /// outside of them.
+    inline object_size_t delta_write_bits(std::ostream& out, uint64_t const* data,
+                                          size_t width, delta_ranges_t const& ranges) {
+        auto bytes = object_size_t::empty();
+        for (auto const& range : ranges) {
+            size_t const begin = range.first * width / 64;
+            size_t const end = (range.second * width + 63) / 64;
+            bytes += serialize_write_words(out, data + begin, end - begin);
+        }
+        return bytes;
+    }
+
+    /// Reads the words written by `delta_write_bits()` back into `data`.
+    inline void delta_read_bits(std::istream& in, uint64_t* data,
+                                size_t width, delta_ranges_t const& ranges) {
+        for (auto const& range : ranges) {
+            size_t const begin = range.first * width / 64;
+            size_t const end = (range.second * width + 63) / 64;
+            serialize_read_words(in, data + begin, end - begin);
+        }
+    }
+
+    /// Delta snapshots of a data structure, which only contain the parts
+    /// that changed since the previous snapshot.
+    ///
+    /// Needs to be specialized with `write(out, val)`, which writes a delta
+    /// and starts the next one, and `apply(in, val)`, which applies a delta
+    /// to the state of the previous snapshot.
+    ///
+    /// The placements of the hashtables take part with
+    /// `serialize<T>::write_ranges(out, val, table_size, ranges)` and
+    /// `serialize<T>::read_ranges(in, val, table_size, ranges)`,
+    /// which write and read the state of the positions in `ranges`.
+    template<typename T>
+    struct serialize_delta {
+    };
+}
@@ -52,6 +52,19 @@ namespace tdc {
         out = serialize<T>::read(inp);
     }
 
+    /// Writes an array of 64 bit words with one large `write`.
+    ///
+    /// NB: Produces the same bytes as writing each word with `serialize<uint64_t>`.
+    inline object_size_t serialize_write_words(std::ostream& out, uint64_t const* data, size_t size) {
+        out.write((char const*) data, size * sizeof(uint64_t));
+        return object_size_t::exact(size * sizeof(uint64_t));
+    }
+
+    /// Reads an array of 64 bit words with one large `read`.
+    inline void serialize_read_words(std::istream& in, uint64_t* data, size_t size) {
+        in.read((char*) data, size * sizeof(uint64_t));
+    }
+
 #define gen_direct_serialization(...) \
     template<>\
     struct serialize<__VA_ARGS__> {\
@@ -0,0 +1,160 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <functional>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include <tudocomp/util/compact_hash/map/typedefs.hpp>
+#include <tudocomp/util/compact_hash/map/fixed_width_hashmap_t.hpp>
+
+using namespace tdc::compact_hash;
+
+template<typename table_t>
+void check_table(table_t& table, std::unordered_map<uint64_t, uint64_t> const& expected) {
+    ASSERT_EQ(table.size(), expected.size());
+    for (auto const& kv : expected) {
+        auto ptr = table.search(kv.first);
+        ASSERT_TRUE(ptr != decltype(ptr)()) << "key " << kv.first;
+        ASSERT_EQ(uint64_t(*ptr), kv.second) << "key " << kv.first;
+    }
+}
+
+template<typename table_t>
+void insert_batch_test(size_t batches, size_t batch_size) {
+    auto table = table_t(0, 24, 20);
+    std::unordered_map<uint64_t, uint64_t> expected;
+    std::mt19937_64 gen(batch_size);
+    for (size_t b = 0; b < batches; b++) {
+        std::vector<uint64_t> keys(batch_size);
+        std::vector<uint64_t> values(batch_size);
+        for (size_t i = 0; i < batch_size; i++) {
+            // NB: Some duplicates inside and across batches.
+            keys[i] = gen() & ((1ull << 24) - 1) & ~(gen() & 0xff0000);
+            // NB: Not 0, which marks empty slots in `plain_sentinel_t`.
+            values[i] = (gen() & ((1ull << 20) - 2)) | 1;
+            expected[keys[i]] = values[i];
+        }
+        table.insert_batch(keys.data(), values.data(), batch_size);
+        check_table(table, expected);
+    }
+}
+
+template<typename table_t>
+void insert_batch_tests() {
+    insert_batch_test<table_t>(1, 0);
+    insert_batch_test<table_t>(5, 1);
+    insert_batch_test<table_t>(4, 1000);
+    insert_batch_test<table_t>(3, 50000);
+}
+
+TEST(batch_insert, plain_cv_hashmap) {
+    insert_batch_tests<map::plain_cv_hashmap_t<tdc::dynamic_t>>();
+}
+
+TEST(batch_insert, sparse_cv_hashmap) {
+    insert_batch_tests<map::sparse_cv_hashmap_t<tdc::dynamic_t>>();
+}
+
+TEST(batch_insert, plain_bv_cv_hashmap) {
+    insert_batch_tests<map::plain_bv_cv_hashmap_t<tdc::dynamic_t>>();
+}
+
+TEST(batch_insert, sparse_layered_hashmap) {
+    insert_batch_tests<map::sparse_layered_hashmap_t<tdc::dynamic_t>>();
+}
+
+TEST(batch_insert, plain_layered_hashmap) {
+    insert_batch_tests<map::plain_layered_hashmap_t<tdc::dynamic_t>>();
+}
+
+TEST(batch_insert, plain_bv_layered_hashmap) {
+    insert_batch_tests<map::plain_bv_layered_hashmap_t<tdc::dynamic_t>>();
+}
+
+TEST(batch_insert, sparse_fingerprint_layered_hashmap) {
+    insert_batch_tests<map::hashmap_t<tdc::dynamic_t, poplar_xorshift_t, buckets_bv_t,
+        displacement_t<layered_displacement_table_t<dynamic_layered_bit_width_t>, true>>>();
+}
+
+TEST(batch_insert, sparse_elias_hashmap) {
+    insert_batch_tests<map::sparse_elias_hashmap_t<tdc::dynamic_t>>();
+}
+
+TEST(batch_insert, sparse_robin_hood_hashmap) {
+    insert_batch_tests<map::sparse_robin_hood_hashmap_t<tdc::dynamic_t>>();
+}
+
+TEST(batch_insert, sparse_cuckoo_hashmap) {
+    insert_batch_tests<map::sparse_cuckoo_hashmap_t<tdc::dynamic_t>>();
+}
+
+TEST(batch_insert, sparse_hopscotch_hashmap) {
+    insert_batch_tests<map::sparse_hopscotch_hashmap_t<tdc::dynamic_t>>();
+}
+
+template<typename table_t>
+void upsert_counts_test() {
+    // NB: Starts with values of 1 bit, which the counts outgrow.
+    auto table = table_t(0, 16, 1);
+    std::unordered_map<uint64_t, uint64_t> expected;
+    std::mt19937_64 gen(2);
+    for (size_t b = 0; b < 20; b++) {
+        std::vector<uint64_t> keys(10000);
+        std::vector<uint64_t> ones(keys.size(), 1);
+        for (auto& key : keys) {
+            key = (gen() & 0xffff) & (gen() & 0xffff);
+            expected[key]++;
+        }
+        table.upsert_batch(keys.data(), ones.data(), keys.size(), std::plus<uint64_t>());
+        check_table(table, expected);
+    }
+    ASSERT_GT(table.value_width(), 10u);
+}
+
+TEST(batch_insert, upsert_counts) {
+    upsert_counts_test<map::sparse_cv_hashmap_t<tdc::dynamic_t>>();
+    upsert_counts_test<map::sparse_layered_hashmap_t<tdc::dynamic_t>>();
+}
+
+template<typename table_t>
+void combine_in_batch_order_test() {
+    auto table = table_t(0, 16, 8);
+    std::vector<uint64_t> keys { 5, 9, 5, 5, 9 };
+    std::vector<uint64_t> digits { 1, 2, 3, 4, 5 };
+    auto append = [](uint64_t lhs, uint64_t rhs) { return lhs * 10 + rhs; };
+    table.upsert_batch(keys.data(), digits.data(), keys.size(), append);
+    ASSERT_EQ(uint64_t(*table.search(5)), 134u);
+    ASSERT_EQ(uint64_t(*table.search(9)), 25u);
+
+    // The last value of a key wins on insert.
+    table.insert_batch(keys.data(), digits.data(), keys.size());
+    ASSERT_EQ(uint64_t(*table.search(5)), 4u);
+    ASSERT_EQ(uint64_t(*table.search(9)), 5u);
+    ASSERT_EQ(table.size(), 2u);
+}
+
+TEST(batch_insert, combine_in_batch_order) {
+    combine_in_batch_order_test<map::sparse_cv_hashmap_t<tdc::dynamic_t>>();
+    // NB: Grouped insertion, where the repeated keys are combined
+    // after the new keys of the group are inserted.
+    combine_in_batch_order_test<map::sparse_layered_hashmap_t<tdc::dynamic_t>>();
+}
+
+
+TEST(batch_insert, fixed_width) {
+    auto table = map::fixed_width_hashmap_t<20, 12>();
+    std::unordered_map<uint64_t, uint64_t> expected;
+    std::vector<uint64_t> keys(30000);
+    std::vector<uint64_t> values(keys.size());
+    std::mt19937_64 gen(3);
+    for (size_t i = 0; i < keys.size(); i++) {
+        keys[i] = gen() & 0xfffff;
+        values[i] = gen() & 0xfff;
+        expected[keys[i]] = values[i];
+    }
+    std::vector<typename decltype(table)::value_type> fixed_values(values.begin(), values.end());
+    table.insert_batch(keys.data(), fixed_values.data(), keys.size());
+    check_table(table, expected);
+}
@@ -0,0 +1,182 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <unordered_map>
+
+#include <tudocomp/util/compact_hash/map/typedefs.hpp>
+
+using namespace tdc::compact_hash;
+
+/// Counts the live values, and the values constructed from a key.
+struct counters_t {
+    static int64_t live;
+    static int64_t constructed;
+};
+int64_t counters_t::live = 0;
+int64_t counters_t::constructed = 0;
+
+/// A value that owns a heap allocation, such that leaked or twice
+/// destroyed values show up.
+template<typename tag_t>
+struct owning_t {
+    std::unique_ptr<uint64_t> m_key;
+
+    owning_t(): m_key(std::make_unique<uint64_t>(0)) {
+        counters_t::live++;
+        counters_t::constructed++;
+    }
+    explicit owning_t(uint64_t key): m_key(std::make_unique<uint64_t>(key)) {
+        counters_t::live++;
+        counters_t::constructed++;
+    }
+    owning_t(uint64_t high, uint64_t low): owning_t((high << 32) | low) {}
+    owning_t(owning_t&& other): m_key(std::move(other.m_key)) {
+        counters_t::live++;
+    }
+    owning_t& operator=(owning_t&& other) {
+        m_key = std::move(other.m_key);
+        return *this;
+    }
+    ~owning_t() {
+        counters_t::live--;
+    }
+
+    uint64_t key() const {
+        return m_key ? *m_key : ~0ull;
+    }
+    bool operator==(owning_t const& other) const {
+        return key() == other.key();
+    }
+};
+
+struct moved_tag {};
+struct relocated_tag {};
+
+/// Moved with its move constructor.
+using moved_t = owning_t<moved_tag>;
+/// Moved with `memcpy()`, since a `std::unique_ptr` does not point into itself.
+using relocated_t = owning_t<relocated_tag>;
+
+namespace tdc {namespace compact_hash {
+template<>
+struct is_trivially_relocatable<relocated_t>: std::true_type {};
+}}
+
+static_assert(!map::val_quot_ptrs_t<moved_t>::relocates_by_memcpy, "");
+static_assert(map::val_quot_ptrs_t<relocated_t>::relocates_by_memcpy, "");
+static_assert(map::val_quot_ptrs_t<uint64_t>::relocates_by_memcpy, "");
+static_assert(!map::val_quot_ptrs_t<tdc::dynamic_t>::relocates_by_memcpy, "");
+
+template<typename table_t>
+std::unordered_map<uint64_t, uint64_t> emplace_all(table_t& table, size_t n) {
+    std::unordered_map<uint64_t, uint64_t> expected;
+    std::mt19937_64 gen(n);
+    while (expected.size() < n) {
+        uint64_t const key = gen() & ((1ull << 30) - 1);
+        bool const exists = expected.count(key) != 0;
+        int64_t const constructed = counters_t::constructed;
+
+        auto entry = table.emplace(key, key >> 15, key & 0x7fff);
+        EXPECT_EQ(entry.key_already_exist(), exists);
+        EXPECT_EQ(counters_t::constructed, constructed + (exists ? 0 : 1));
+        expected[key] = (key >> 15 << 32) | (key & 0x7fff);
+    }
+    EXPECT_EQ(counters_t::live, int64_t(n));
+
+    // a new value of `access()` is constructed once
+    int64_t const constructed = counters_t::constructed;
+    uint64_t const new_key = (1ull << 30) - 1;
+    if (expected.count(new_key) == 0) {
+        EXPECT_EQ(table.access(new_key).key(), 0u);
+        EXPECT_EQ(counters_t::constructed, constructed + 1);
+        expected[new_key] = 0;
+    }
+    return expected;
+}
+
+template<typename table_t>
+void check_all(table_t& table, std::unordered_map<uint64_t, uint64_t> const& expected) {
+    ASSERT_EQ(table.size(), expected.size());
+    ASSERT_EQ(counters_t::live, int64_t(expected.size()));
+    for (auto const& kv : expected) {
+        auto ptr = table.search(kv.first);
+        ASSERT_NE(ptr, nullptr) << "key " << kv.first;
+        ASSERT_EQ(ptr->key(), kv.second) << "key " << kv.first;
+    }
+}
+
+template<typename table_t>
+void emplace_test(size_t n) {
+    counters_t::live = 0;
+    counters_t::constructed = 0;
+    {
+        auto table = table_t(0, 30);
+        auto const expected = emplace_all(table, n);
+        check_all(table, expected);
+    }
+    ASSERT_EQ(counters_t::live, 0);
+}
+
+// NB: Erasing from a robin hood table removes values from the middle
+// of buckets, and shifts the following values back.
+template<typename table_t>
+void emplace_erase_test(size_t n) {
+    counters_t::live = 0;
+    counters_t::constructed = 0;
+    {
+        auto table = table_t(0, 30);
+        auto expected = emplace_all(table, n);
+        for (auto it = expected.begin(); it != expected.end();) {
+            if (it->first & 1) {
+                ASSERT_EQ(table.erase(it->first), 1u);
+                it = expected.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        check_all(table, expected);
+    }
+    ASSERT_EQ(counters_t::live, 0);
+}
+
+template<typename val_t>
+void emplace_tests() {
+    for (size_t n : { 0, 1, 1000, 30000 }) {
+        emplace_test<map::sparse_cv_hashmap_t<val_t>>(n);
+        emplace_test<map::plain_bv_cv_hashmap_t<val_t>>(n);
+        emplace_test<map::sparse_layered_hashmap_t<val_t>>(n);
+        emplace_test<map::sparse_hopscotch_hashmap_t<val_t>>(n);
+        emplace_erase_test<map::sparse_robin_hood_hashmap_t<val_t>>(n);
+    }
+}
+
+TEST(emplace, moved_values) {
+    emplace_tests<moved_t>();
+}
+
+TEST(emplace, relocated_values) {
+    emplace_tests<relocated_t>();
+}
+
+TEST(emplace, strings) {
+    auto table = map::sparse_cv_hashmap_t<std::string>(0, 16);
+    for (uint64_t key = 0; key < 5000; key++) {
+        table.emplace(key, size_t(key % 50), 'a' + char(key % 26));
+    }
+    ASSERT_TRUE(table.emplace(7, "not inserted").key_already_exist());
+    ASSERT_EQ(table.size(), 5000u);
+    for (uint64_t key = 0; key < 5000; key++) {
+        ASSERT_EQ(*table.search(key), std::string(key % 50, 'a' + char(key % 26)));
+    }
+}
+
+TEST(emplace, dynamic_width) {
+    auto table = map::sparse_cv_hashmap_t<tdc::dynamic_t>(0, 16, 4);
+    ASSERT_FALSE(table.emplace(1, 1000).key_already_exist());
+    ASSERT_EQ(table.value_width(), 10u);
+    ASSERT_TRUE(table.emplace(1, 5).key_already_exist());
+    ASSERT_EQ(uint64_t(*table.search(1)), 1000u);
+}
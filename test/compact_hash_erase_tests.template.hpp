@@ -0,0 +1,88 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <vector>
+
+// Tests of `erase()`, for the placements that support it.
+// Included after "compact_hash_tests.template.hpp".
+
+TEST(hash, erase) {
+    auto ch = compact_hash_type<Init>(8, 16, 1);
+    ch.max_load_factor(1.0);
+    ch.insert(3, Init(0));
+    ch.insert(3 + 8, Init(1));
+    ch.insert(5, Init(2));
+    ch.insert(5 + 8, Init(3));
+    ch.insert(4, Init(4));
+    ch.insert(7, Init(5));
+
+    ASSERT_EQ(ch.erase(3), 1U);
+    ASSERT_EQ(ch.erase(3), 0U);
+    ASSERT_EQ(ch.erase(6), 0U);
+    ASSERT_EQ(ch.size(), 5U);
+    ASSERT_EQ(ch.count(3), 0U);
+
+    debug_check_single(ch, 3 + 8, Init(1));
+    debug_check_single(ch, 5, Init(2));
+    debug_check_single(ch, 5 + 8, Init(3));
+    debug_check_single(ch, 4, Init(4));
+    debug_check_single(ch, 7, Init(5));
+
+    ASSERT_EQ(ch.erase(5), 1U);
+    ASSERT_EQ(ch.erase(7), 1U);
+    debug_check_single(ch, 5 + 8, Init(3));
+    debug_check_single(ch, 4, Init(4));
+
+    ch.insert(3, Init(6));
+    debug_check_single(ch, 3, Init(6));
+    ASSERT_EQ(ch.size(), 4U);
+}
+
+TEST(hash, erase_load) {
+    auto ch = compact_hash_type<uint64_t>(0, 16, 16);
+    ch.max_load_factor(0.95);
+    for(size_t i = 0; i < 10000; i++) {
+        ch.insert(i, i * 2 + 1);
+    }
+    for(size_t i = 0; i < 10000; i += 3) {
+        ASSERT_EQ(ch.erase(i), 1U);
+    }
+    for(size_t i = 0; i < 10000; i++) {
+        if (i % 3 == 0) {
+            ASSERT_EQ(ch.count(i), 0U);
+        } else {
+            debug_check_single(ch, i, i * 2 + 1);
+        }
+    }
+}
+
+/// Erases from and reinserts into a table of size 4096 whose placement
+/// spills entries into its stash at high load.
+template<typename table_t>
+void check_stash_erase(table_t& ch) {
+    ch.max_load_factor(0.95);
+    std::vector<uint64_t> ids;
+    // NB: Stays below the load factor, so that the ids remain valid
+    for(size_t i = 0; i < 3800; i++) {
+        ids.push_back(ch.insert(i, i * 2 + 1).id());
+    }
+    ASSERT_GT(ch.placement().stash_size(), 0U);
+    for(size_t i = 0; i < 3800; i++) {
+        debug_check_single(ch, i, i * 2 + 1);
+        debug_check_single_id(ch, ids[i], i * 2 + 1);
+    }
+    for(size_t i = 0; i < 3800; i += 3) {
+        ASSERT_EQ(ch.erase(i), 1U);
+    }
+    for(size_t i = 0; i < 3800; i++) {
+        ASSERT_EQ(ch.count(i), size_t(i % 3 != 0));
+    }
+    // The erased entries left the stash, so reinserting them
+    // stashes them anew under their initial address.
+    for(size_t i = 0; i < 3800; i += 3) {
+        ch.insert(i, i * 2 + 2);
+    }
+    for(size_t i = 0; i < 3800; i++) {
+        debug_check_single(ch, i, i * 2 + 1 + size_t(i % 3 == 0));
+    }
+}
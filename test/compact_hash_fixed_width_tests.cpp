@@ -0,0 +1,160 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <random>
+#include <sstream>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <tudocomp/util/compact_hash/map/fixed_width_hashmap_t.hpp>
+#include <tudocomp/util/compact_hash/set/fixed_width_hashset_t.hpp>
+#include <tudocomp/util/compact_hash/map/typedefs.hpp>
+
+using namespace tdc::compact_hash;
+
+template<uint32_t W>
+void static_hash_test() {
+    std::mt19937_64 gen(W);
+    uint64_t const mask = -1ull >> (64 - W);
+
+    // the constant width, and larger widths of a table with more than 2^(W-1) slots
+    for (uint32_t w = W; w <= std::min<uint32_t>(W + 2, 64); w++) {
+        auto fixed = static_poplar_xorshift_t<W>(w, {});
+        auto dynamic = poplar_xorshift_t(w, {});
+        uint64_t const w_mask = -1ull >> (64 - w);
+        for (size_t i = 0; i < 1000; i++) {
+            uint64_t const key = gen() & ((w == W) ? mask : w_mask);
+            ASSERT_EQ(fixed.hash(key), dynamic.hash(key)) << "W=" << W << " w=" << w;
+            ASSERT_EQ(fixed.hash_inv(fixed.hash(key)), key) << "W=" << W << " w=" << w;
+        }
+    }
+}
+
+TEST(static_poplar_xorshift, same_as_poplar) {
+    static_hash_test<1>();
+    static_hash_test<7>();
+    static_hash_test<16>();
+    static_hash_test<31>();
+    static_hash_test<32>();
+    static_hash_test<40>();
+    static_hash_test<63>();
+    static_hash_test<64>();
+}
+
+TEST(static_poplar_xorshift, serialize) {
+    using hash_t = static_poplar_xorshift_t<40>;
+    auto hash = hash_t(40, {});
+    std::stringstream ss;
+    tdc::serialize<hash_t>::write(ss, hash);
+    auto read = tdc::serialize<hash_t>::read(ss);
+    ASSERT_TRUE(tdc::serialize<hash_t>::equal_check(hash, read));
+    ASSERT_EQ(read.hash(12345), hash.hash(12345));
+}
+
+template<typename table_t>
+void fixed_map_test(size_t n) {
+    uint64_t const key_mask = -1ull >> (64 - table_t::key_width());
+    uint64_t const val_mask = -1ull >> (64 - table_t::value_width());
+
+    auto table = table_t();
+    std::unordered_map<uint64_t, uint64_t> expected;
+    std::mt19937_64 gen(n);
+    while (expected.size() < n) {
+        uint64_t const key = gen() & key_mask;
+        // NB: Not 0, which marks empty slots in `plain_sentinel_t`.
+        uint64_t const value = (gen() & val_mask) | 1;
+        table.insert(key, typename table_t::value_type(value));
+        expected[key] = value;
+    }
+
+    ASSERT_EQ(table.size(), expected.size());
+    ASSERT_EQ(table.table().key_width(), table_t::key_width());
+    ASSERT_EQ(table.table().value_width(), table_t::value_width());
+    for (auto const& e : expected) {
+        auto ptr = table.search(e.first);
+        ASSERT_TRUE(ptr != nullptr) << "key " << e.first;
+        ASSERT_EQ(uint64_t(*ptr), e.second) << "key " << e.first;
+    }
+    for (size_t i = 0; i < 1000; i++) {
+        uint64_t const key = gen() & key_mask;
+        ASSERT_EQ(table.count(key), expected.count(key));
+    }
+
+    size_t visited = 0;
+    table.for_each([&](uint64_t key, auto value) {
+        ASSERT_EQ(uint64_t(value), expected.at(key));
+        visited++;
+    });
+    ASSERT_EQ(visited, expected.size());
+
+    table[expected.begin()->first] = 3;
+    ASSERT_EQ(uint64_t(*table.search(expected.begin()->first)), 3u);
+    expected[expected.begin()->first] = 3;
+
+    std::stringstream ss;
+    tdc::serialize<table_t>::write(ss, table);
+    auto read = tdc::serialize<table_t>::read(ss);
+    ASSERT_TRUE(tdc::serialize<table_t>::equal_check(table, read));
+    for (auto const& e : expected) {
+        ASSERT_EQ(uint64_t(*read.search(e.first)), e.second);
+    }
+}
+
+TEST(fixed_width_hashmap, sparse_cv) {
+    fixed_map_test<map::fixed_width_hashmap_t<32, 20>>(100000);
+}
+
+TEST(fixed_width_hashmap, wide) {
+    fixed_map_test<map::fixed_width_hashmap_t<64, 64>>(20000);
+}
+
+TEST(fixed_width_hashmap, plain_layered) {
+    fixed_map_test<map::fixed_width_hashmap_t<
+        40, 7, static_poplar_xorshift_t<40>, plain_sentinel_t,
+        displacement_t<layered_displacement_table_t<dynamic_layered_bit_width_t>>>>(50000);
+}
+
+// NB: All 2^10 keys need a table of 2^11 slots, and so a hash width of 12 bits.
+TEST(fixed_width_hashmap, table_larger_than_key_space) {
+    fixed_map_test<map::fixed_width_hashmap_t<10, 10>>(1024);
+}
+
+TEST(fixed_width_hashmap, robin_hood_erase) {
+    using table_t = map::fixed_width_hashmap_t<
+        24, 16, static_poplar_xorshift_t<24>, plain_sentinel_t,
+        robin_hood_t<layered_displacement_table_t<dynamic_layered_bit_width_t>>>;
+    auto table = table_t();
+    for (uint64_t i = 0; i < 1000; i++) {
+        table.insert(i * 3, table_t::value_type(i + 1));
+    }
+    for (uint64_t i = 0; i < 1000; i += 2) {
+        ASSERT_EQ(table.erase(i * 3), 1u);
+    }
+    ASSERT_EQ(table.size(), 500u);
+    for (uint64_t i = 0; i < 1000; i++) {
+        ASSERT_EQ(table.count(i * 3), i % 2);
+    }
+}
+
+TEST(fixed_width_hashset, insert_and_lookup) {
+    using table_t = set::fixed_width_hashset_t<28>;
+    auto table = table_t();
+    std::unordered_set<uint64_t> expected;
+    std::mt19937_64 gen(5);
+    while (expected.size() < 50000) {
+        uint64_t const key = gen() & ((1ull << 28) - 1);
+        auto entry = table.lookup_insert(key);
+        ASSERT_EQ(entry.key_already_exist(), expected.count(key) == 1);
+        expected.insert(key);
+    }
+    ASSERT_EQ(table.size(), expected.size());
+    for (uint64_t key : expected) {
+        ASSERT_TRUE(table.lookup(key).found());
+    }
+
+    std::stringstream ss;
+    tdc::serialize<table_t>::write(ss, table);
+    auto read = tdc::serialize<table_t>::read(ss);
+    ASSERT_TRUE(tdc::serialize<table_t>::equal_check(table, read));
+    ASSERT_EQ(read.size(), expected.size());
+}
@@ -0,0 +1,71 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include <tudocomp/util/compact_hash/hash_functions.hpp>
+
+using namespace tdc::compact_hash;
+
+/// The instruction sets that can be tested on the running CPU.
+std::vector<simd_level_t> supported_levels() {
+    std::vector<simd_level_t> levels { simd_level_t::scalar };
+    if (detected_simd_level() >= simd_level_t::avx2) {
+        levels.push_back(simd_level_t::avx2);
+    }
+    if (detected_simd_level() >= simd_level_t::avx512) {
+        levels.push_back(simd_level_t::avx512);
+    }
+    return levels;
+}
+
+template<typename hash_t>
+void batch_test() {
+    std::mt19937_64 gen(17);
+
+    for (uint32_t w = 1; w <= 64; w++) {
+        auto hash = hash_t(w, typename hash_t::config_args{});
+        uint64_t const mask = (w == 64) ? ~0ull : ((1ull << w) - 1);
+
+        // NB: Includes sizes that leave a remainder after the vector loop.
+        for (size_t n : { 0, 1, 3, 7, 8, 9, 37, 1000 }) {
+            std::vector<uint64_t> keys(n);
+            for (auto& key : keys) {
+                key = gen() & mask;
+            }
+
+            for (auto level : supported_levels()) {
+                std::vector<uint64_t> hashed(n);
+                hash.hash_batch(keys.data(), hashed.data(), n, level);
+                for (size_t i = 0; i < n; i++) {
+                    ASSERT_EQ(hashed[i], hash.hash(keys[i]))
+                        << "w=" << w << " level=" << int(level);
+                }
+
+                // in place
+                std::vector<uint64_t> restored = hashed;
+                hash.hash_inv_batch(restored.data(), restored.data(), n, level);
+                for (size_t i = 0; i < n; i++) {
+                    ASSERT_EQ(restored[i], hash.hash_inv(hashed[i]))
+                        << "w=" << w << " level=" << int(level);
+                    ASSERT_EQ(restored[i], keys[i]);
+                }
+            }
+
+            std::vector<uint64_t> hashed(n);
+            hash.hash_batch(keys.data(), hashed.data(), n);
+            for (size_t i = 0; i < n; i++) {
+                ASSERT_EQ(hashed[i], hash.hash(keys[i]));
+            }
+        }
+    }
+}
+
+TEST(hash_batch, poplar_xorshift) {
+    batch_test<poplar_xorshift_t>();
+}
+
+TEST(hash_batch, xorshift) {
+    batch_test<xorshift_t>();
+}
@@ -0,0 +1,134 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <random>
+#include <sstream>
+#include <vector>
+
+#include <tudocomp/util/compact_hash/hash_functions.hpp>
+#include <tudocomp/util/compact_hash/map/typedefs.hpp>
+
+using namespace tdc::compact_hash;
+
+template<typename hash_t>
+hash_t make_hash(uint32_t w, uint64_t seed) {
+    auto config = typename hash_t::config_args{};
+    config.seed = seed;
+    return hash_t(w, config);
+}
+
+template<typename hash_t>
+void bijective_test(uint64_t seed) {
+    // exhaustively for small widths
+    for (uint32_t w = 1; w <= 14; w++) {
+        auto hash = make_hash<hash_t>(w, seed);
+        std::vector<bool> seen(1ull << w);
+        for (uint64_t x = 0; x < (1ull << w); x++) {
+            uint64_t const h = hash.hash(x);
+            ASSERT_LT(h, 1ull << w) << "w=" << w;
+            ASSERT_FALSE(seen[h]) << "w=" << w << " x=" << x;
+            seen[h] = true;
+            ASSERT_EQ(hash.hash_inv(h), x) << "w=" << w;
+        }
+    }
+
+    // randomly for all widths
+    std::mt19937_64 gen(seed);
+    for (uint32_t w = 1; w <= 64; w++) {
+        auto hash = make_hash<hash_t>(w, seed);
+        uint64_t const mask = -1ull >> (64 - w);
+
+        std::vector<uint64_t> keys(1000);
+        for (auto& key : keys) {
+            key = gen() & mask;
+        }
+        std::vector<uint64_t> hashed(keys.size());
+        hash.hash_batch(keys.data(), hashed.data(), keys.size());
+        for (size_t i = 0; i < keys.size(); i++) {
+            ASSERT_EQ(hashed[i], hash.hash(keys[i]));
+            ASSERT_LE(hashed[i], mask);
+        }
+        hash.hash_inv_batch(hashed.data(), hashed.data(), hashed.size());
+        ASSERT_EQ(hashed, keys) << "w=" << w;
+    }
+}
+
+template<typename hash_t>
+void serialize_test() {
+    auto hash = make_hash<hash_t>(37, 12345);
+    std::stringstream ss;
+    tdc::serialize<hash_t>::write(ss, hash);
+    auto read = tdc::serialize<hash_t>::read(ss);
+    ASSERT_TRUE(tdc::serialize<hash_t>::equal_check(hash, read));
+    ASSERT_EQ(read.current_config().seed, 12345u);
+    for (uint64_t x = 0; x < 1000; x++) {
+        ASSERT_EQ(read.hash(x), hash.hash(x));
+    }
+
+    // different seeds give different functions
+    auto other = make_hash<hash_t>(37, 54321);
+    size_t equal = 0;
+    for (uint64_t x = 0; x < 1000; x++) {
+        equal += other.hash(x) == hash.hash(x);
+    }
+    ASSERT_LT(equal, 10u);
+}
+
+/// Uses the hash function in a map whose key width grows,
+/// and checks that the seed is kept across rehashes.
+template<typename hash_t>
+void map_test() {
+    using table_t = map::sparse_cv_hashmap_t<uint64_t, hash_t>;
+    auto config = typename table_t::config_args{};
+    config.hash_config.seed = 99;
+    auto table = table_t(0, 1, 16, config);
+
+    for (uint64_t i = 0; i < 20000; i++) {
+        table.insert_kv_width(i * 37, i & 0xffff, tdc::bits_for(i * 37), 16);
+    }
+    ASSERT_EQ(table.size(), 20000u);
+    for (uint64_t i = 0; i < 20000; i++) {
+        ASSERT_EQ(*table.search(i * 37), i & 0xffff);
+    }
+    ASSERT_EQ(table.current_config().hash_config.seed, 99u);
+}
+
+TEST(multiply_xorshift, bijective) {
+    bijective_test<multiply_xorshift_t>(0);
+}
+
+TEST(multiply_xorshift, bijective_seeded) {
+    bijective_test<multiply_xorshift_t>(42);
+}
+
+TEST(multiply_xorshift, serialize) {
+    serialize_test<multiply_xorshift_t>();
+}
+
+TEST(multiply_xorshift, map) {
+    map_test<multiply_xorshift_t>();
+}
+
+TEST(feistel, bijective) {
+    bijective_test<feistel_t>(0);
+}
+
+TEST(feistel, bijective_seeded) {
+    bijective_test<feistel_t>(42);
+}
+
+TEST(feistel, serialize) {
+    serialize_test<feistel_t>();
+}
+
+TEST(feistel, map) {
+    map_test<feistel_t>();
+}
+
+TEST(inverse_of_odd, inverse) {
+    std::mt19937_64 gen(3);
+    for (size_t i = 0; i < 1000; i++) {
+        uint64_t const a = gen() | 1;
+        ASSERT_EQ(a * inverse_of_odd(a), 1u);
+    }
+}
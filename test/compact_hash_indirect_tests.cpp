@@ -0,0 +1,126 @@
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <tudocomp/util/compact_hash/map/indirect_hashmap_t.hpp>
+#include <tudocomp/util/compact_hash/map/typedefs.hpp>
+
+using namespace tdc::compact_hash;
+
+/// A large value, filled with a pattern derived from `seed`.
+struct blob_t {
+    std::array<uint64_t, 16> words;
+
+    blob_t(): blob_t(0) {}
+    explicit blob_t(uint64_t seed) {
+        for (size_t i = 0; i < words.size(); i++) {
+            words[i] = seed * 31 + i;
+        }
+    }
+    bool operator==(blob_t const& other) const {
+        return words == other.words;
+    }
+};
+
+template<typename table_t>
+void indirect_test(size_t n) {
+    auto table = table_t(0, 30);
+    std::unordered_map<uint64_t, blob_t*> addrs;
+    std::mt19937_64 gen(n);
+    while (addrs.size() < n) {
+        uint64_t const key = gen() & ((1ull << 30) - 1);
+        auto r = table.emplace(key, key);
+        ASSERT_EQ(r.second, addrs.count(key) == 0);
+        if (r.second) {
+            addrs[key] = r.first;
+        } else {
+            ASSERT_EQ(r.first, addrs[key]);
+        }
+    }
+    ASSERT_EQ(table.size(), n);
+
+    // The values stay at the address they were inserted at.
+    for (auto const& kv : addrs) {
+        ASSERT_EQ(table.search(kv.first), kv.second) << "key " << kv.first;
+        ASSERT_EQ(*kv.second, blob_t(kv.first)) << "key " << kv.first;
+    }
+
+    size_t visited = 0;
+    table.for_each([&](uint64_t key, blob_t& value) {
+        ASSERT_EQ(&value, addrs.at(key));
+        visited++;
+    });
+    ASSERT_EQ(visited, n);
+}
+
+TEST(indirect, stable_addresses) {
+    for (size_t n : { 0, 1, 1000, 50000 }) {
+        indirect_test<map::indirect_hashmap_t<blob_t>>(n);
+        indirect_test<map::indirect_hashmap_t<blob_t, poplar_xorshift_t, plain_sentinel_t>>(n);
+        indirect_test<map::indirect_hashmap_t<blob_t, poplar_xorshift_t, buckets_bv_t,
+            displacement_t<layered_displacement_table_t<dynamic_layered_bit_width_t>>>>(n);
+    }
+}
+
+TEST(indirect, index_width) {
+    auto table = map::indirect_hashmap_t<uint64_t>(0, 16);
+    for (uint64_t key = 0; key < 1000; key++) {
+        table[key] = key * 2;
+    }
+    // NB: Indices up to 1000 are stored as 1 to 1000, in a width
+    // that fits an index for each location of the table.
+    ASSERT_GE(table.index_width(), 10u);
+    ASSERT_LE(table.index_width(), tdc::bits_for(table.table_size()));
+    for (uint64_t key = 0; key < 1000; key++) {
+        ASSERT_EQ(*table.search(key), key * 2);
+    }
+}
+
+TEST(indirect, insert_access_erase) {
+    using table_t = map::indirect_hashmap_t<
+        std::string, poplar_xorshift_t, buckets_bv_t,
+        robin_hood_t<layered_displacement_table_t<dynamic_layered_bit_width_t>>>;
+    auto table = table_t(0, 16);
+    std::unordered_map<uint64_t, std::string> expected;
+    for (uint64_t key = 0; key < 5000; key++) {
+        expected[key] = std::to_string(key) + std::string(key % 40, 'x');
+        table.insert(key, std::string(expected[key]));
+    }
+    table.insert(7, std::string("seven"));
+    expected[7] = "seven";
+    table[5000] += "new";
+    expected[5000] = "new";
+    ASSERT_EQ(table.count(5000), 1u);
+
+    // Erased slots are reused, and the remaining values do not move.
+    std::string* const kept = table.search(10);
+    for (uint64_t key = 1; key < 5000; key += 2) {
+        ASSERT_EQ(table.erase(key), 1u);
+        expected.erase(key);
+    }
+    ASSERT_EQ(table.erase(1), 0u);
+    size_t const width = table.index_width();
+    for (uint64_t key = 1; key < 5000; key += 2) {
+        expected[key] = "again";
+        table.emplace(key, "again");
+    }
+    ASSERT_EQ(table.index_width(), width);
+    ASSERT_EQ(table.search(10), kept);
+
+    ASSERT_EQ(table.size(), expected.size());
+    for (auto const& kv : expected) {
+        ASSERT_NE(table.search(kv.first), nullptr) << "key " << kv.first;
+        ASSERT_EQ(*table.search(kv.first), kv.second) << "key " << kv.first;
+    }
+
+    // Moving the table keeps the values where they are.
+    auto moved = std::move(table);
+    ASSERT_EQ(moved.search(10), kept);
+    table = std::move(moved);
+    ASSERT_EQ(table.search(10), kept);
+}
@@ -0,0 +1,147 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <tudocomp/util/compact_hash/map/typedefs.hpp>
+#include <tudocomp/util/compact_hash/set/typedefs.hpp>
+
+using namespace tdc::compact_hash;
+
+template<typename table_t>
+void map_iteration_test(size_t n) {
+    auto table = table_t(0, 30, 20);
+    std::unordered_map<uint64_t, uint64_t> expected;
+    std::mt19937_64 gen(n);
+    while (expected.size() < n) {
+        uint64_t const key = gen() & ((1ull << 30) - 1);
+        // NB: Not 0, which marks empty slots in `plain_sentinel_t`.
+        uint64_t const value = (gen() & ((1ull << 20) - 2)) | 1;
+        table.insert(key, typename table_t::value_type(value));
+        expected[key] = value;
+    }
+
+    // for_each visits each entry once, and can change the values
+    std::unordered_map<uint64_t, uint64_t> visited;
+    table.for_each([&](uint64_t key, auto value) {
+        ASSERT_EQ(visited.count(key), 0u) << "key " << key;
+        visited[key] = uint64_t(value);
+        value = uint64_t(value) + 1;
+    });
+    ASSERT_EQ(visited, expected);
+    ASSERT_EQ(table.size(), n);
+
+    // the iterators see the changed values
+    visited.clear();
+    for (auto entry : table.entries()) {
+        ASSERT_EQ(visited.count(entry.first), 0u) << "key " << entry.first;
+        visited[entry.first] = uint64_t(entry.second) - 1;
+    }
+    ASSERT_EQ(visited, expected);
+
+    auto range = table.entries();
+    ASSERT_EQ(size_t(std::distance(range.begin(), range.end())), n);
+}
+
+template<typename table_t>
+void map_iteration_tests() {
+    map_iteration_test<table_t>(0);
+    map_iteration_test<table_t>(1);
+    map_iteration_test<table_t>(1000);
+    map_iteration_test<table_t>(50000);
+}
+
+TEST(iteration, plain_cv_hashmap) {
+    map_iteration_tests<map::plain_cv_hashmap_t<tdc::dynamic_t>>();
+}
+
+TEST(iteration, sparse_cv_hashmap) {
+    map_iteration_tests<map::sparse_cv_hashmap_t<tdc::dynamic_t>>();
+}
+
+TEST(iteration, plain_bv_cv_hashmap) {
+    map_iteration_tests<map::plain_bv_cv_hashmap_t<tdc::dynamic_t>>();
+}
+
+TEST(iteration, plain_layered_hashmap) {
+    map_iteration_tests<map::plain_layered_hashmap_t<tdc::dynamic_t>>();
+}
+
+TEST(iteration, sparse_layered_hashmap) {
+    map_iteration_tests<map::sparse_layered_hashmap_t<tdc::dynamic_t>>();
+}
+
+TEST(iteration, sparse_elias_hashmap) {
+    map_iteration_tests<map::sparse_elias_hashmap_t<tdc::dynamic_t>>();
+}
+
+TEST(iteration, sparse_robin_hood_hashmap) {
+    map_iteration_tests<map::sparse_robin_hood_hashmap_t<tdc::dynamic_t>>();
+}
+
+TEST(iteration, sparse_cuckoo_hashmap) {
+    map_iteration_tests<map::sparse_cuckoo_hashmap_t<tdc::dynamic_t>>();
+}
+
+TEST(iteration, sparse_hopscotch_hashmap) {
+    map_iteration_tests<map::sparse_hopscotch_hashmap_t<tdc::dynamic_t>>();
+}
+
+// NB: A full table wraps groups around its end, which starts
+// and ends the walk of `cv_bvs_t` in the middle of the table.
+TEST(iteration, wrapping_groups) {
+    using table_t = map::sparse_cv_hashmap_t<tdc::dynamic_t>;
+    auto table = table_t(1024, 16, 8);
+    table.max_load_factor(0.95);
+    std::unordered_map<uint64_t, uint64_t> expected;
+    std::mt19937_64 gen(3);
+    while (expected.size() < 950) {
+        uint64_t const key = gen() & 0xffff;
+        table.insert(key, table_t::value_type(key & 0xff));
+        expected[key] = key & 0xff;
+    }
+    ASSERT_EQ(table.table_size(), 1024u);
+
+    std::unordered_map<uint64_t, uint64_t> visited;
+    for (auto entry : table.entries()) {
+        visited[entry.first] = uint64_t(entry.second);
+    }
+    ASSERT_EQ(visited, expected);
+}
+
+template<typename table_t>
+void set_iteration_test(size_t n) {
+    auto table = table_t(0, 30);
+    std::unordered_set<uint64_t> expected;
+    std::mt19937_64 gen(n);
+    while (expected.size() < n) {
+        uint64_t const key = gen() & ((1ull << 30) - 1);
+        table.lookup_insert(key);
+        expected.insert(key);
+    }
+
+    std::unordered_set<uint64_t> visited;
+    table.for_each([&](uint64_t key) {
+        ASSERT_EQ(visited.count(key), 0u) << "key " << key;
+        visited.insert(key);
+    });
+    ASSERT_EQ(visited, expected);
+
+    auto range = table.entries();
+    visited = std::unordered_set<uint64_t>(range.begin(), range.end());
+    ASSERT_EQ(visited, expected);
+    ASSERT_EQ(size_t(std::distance(range.begin(), range.end())), n);
+}
+
+TEST(iteration, hashsets) {
+    for (size_t n : { 0, 1, 1000, 50000 }) {
+        set_iteration_test<set::sparse_cv_hashset_t<>>(n);
+        set_iteration_test<set::sparse_layered_hashset_t<>>(n);
+        set_iteration_test<set::sparse_robin_hood_hashset_t<>>(n);
+        set_iteration_test<set::sparse_cuckoo_hashset_t<>>(n);
+        set_iteration_test<set::sparse_hopscotch_hashset_t<>>(n);
+    }
+}
@@ -0,0 +1,242 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <algorithm>
+#include <sstream>
+#include <string>
+
+#include <unistd.h>
+
+#include <tudocomp/util/compact_hash/map/typedefs.hpp>
+#include <tudocomp/util/serialization.hpp>
+#include <tudocomp/util/chunked_serialization.hpp>
+
+/// A layered hashmap whose storage is backed by files in the working directory.
+template<typename val_t>
+class COMPACT_TABLE: public tdc::compact_hash::map::mmap_layered_hashmap_t<val_t> {
+    using base_t = tdc::compact_hash::map::mmap_layered_hashmap_t<val_t>;
+
+    static typename base_t::config_args file_config() {
+        auto config = typename base_t::config_args{};
+        config.storage_config.allocation_config.directory = ".";
+        return config;
+    }
+public:
+    inline COMPACT_TABLE(size_t size = base_t::DEFAULT_TABLE_SIZE,
+                         size_t key_width = base_t::DEFAULT_KEY_WIDTH,
+                         size_t value_width = base_t::DEFAULT_VALUE_WIDTH):
+        base_t(size, key_width, value_width, file_config()) {}
+};
+
+#include "compact_hash_tests.template.hpp"
+
+TEST(hash, mmap_anonymous) {
+    auto ch = tdc::compact_hash::map::mmap_cv_hashmap_t<uint64_t>(0, 20, 20);
+
+    for (uint64_t i = 1; i < 10000; i++) {
+        ch.insert(i, uint64_t(i * 3));
+    }
+    for (uint64_t i = 1; i < 10000; i++) {
+        ASSERT_EQ(*ch.search(i), i * 3);
+    }
+}
+
+TEST(hash, mmap_config_survives_grow) {
+    auto ch = COMPACT_TABLE<uint64_t>(0, 20, 20);
+    size_t const initial_size = ch.table_size();
+
+    for (uint64_t i = 1; i < 10000; i++) {
+        ch.insert(i, uint64_t(i));
+    }
+
+    ASSERT_GT(ch.table_size(), initial_size);
+    ASSERT_EQ(ch.current_config().storage_config.allocation_config.directory, ".");
+}
+
+TEST(hash, mmap_config_survives_read) {
+    using table_t = tdc::compact_hash::map::mmap_layered_hashmap_t<uint64_t>;
+
+    auto config = table_t::config_args{};
+    config.storage_config.allocation_config.directory = ".";
+    config.storage_config.allocation_config.named_file = true;
+
+    auto a = table_t(0, 20, 20, config);
+    for (uint64_t i = 1; i < 1000; i++) {
+        a.insert(i, uint64_t(i * 3));
+    }
+
+    auto check = [&](table_t& table) {
+        auto const current = table.current_config().storage_config.allocation_config;
+        ASSERT_EQ(current.directory, ".");
+        ASSERT_TRUE(current.named_file);
+
+        size_t const read_size = table.table_size();
+        for (uint64_t i = 1000; i < 10000; i++) {
+            table.insert(i, uint64_t(i * 3));
+        }
+        ASSERT_GT(table.table_size(), read_size);
+
+        auto const grown = table.current_config().storage_config.allocation_config;
+        ASSERT_EQ(grown.directory, ".");
+        ASSERT_TRUE(grown.named_file);
+        for (uint64_t i = 1; i < 10000; i++) {
+            ASSERT_EQ(*table.search(i), i * 3);
+        }
+    };
+
+    std::stringstream ss;
+    tdc::serialize<table_t>::write(ss, a);
+    auto b = tdc::serialize<table_t>::read(ss, config);
+    check(b);
+
+    std::stringstream chunked_ss;
+    tdc::serialize_chunked<table_t>::write(chunked_ss, a);
+    auto c = tdc::serialize_chunked<table_t>::read(chunked_ss, tdc::chunked_config_t(), config);
+    check(c);
+}
+
+TEST(hash, mmap_huge_pages) {
+    using table_t = tdc::compact_hash::map::mmap_layered_hashmap_t<uint64_t>;
+    using tdc::compact_hash::page_size_t;
+    using tdc::compact_hash::numa_policy_t;
+
+    for (auto page_size : { page_size_t::transparent_huge, page_size_t::huge_2mb }) {
+        auto config = table_t::config_args{};
+        config.storage_config.allocation_config.page_size = page_size;
+        config.storage_config.allocation_config.numa_policy = numa_policy_t::interleave;
+        config.storage_config.allocation_config.populate = true;
+        config.displacement_config.table_config.transparent_huge_pages = true;
+
+        auto ch = table_t(0, 20, 20, config);
+        for (uint64_t i = 1; i < 10000; i++) {
+            ch.insert(i, uint64_t(i * 3));
+        }
+        for (uint64_t i = 1; i < 10000; i++) {
+            ASSERT_EQ(*ch.search(i), i * 3);
+        }
+
+        auto current = ch.current_config();
+        ASSERT_TRUE(current.storage_config.allocation_config.page_size == page_size);
+        ASSERT_TRUE(current.displacement_config.table_config.transparent_huge_pages);
+    }
+}
+
+TEST(hash, mmap_huge_pages_survive_read) {
+    using layered_t = tdc::compact_hash::map::mmap_layered_hashmap_t<uint64_t>;
+    using cv_t = tdc::compact_hash::map::sparse_cv_hashmap_t<uint64_t>;
+
+    auto layered_config = layered_t::config_args{};
+    layered_config.displacement_config.table_config.transparent_huge_pages = true;
+    auto cv_config = cv_t::config_args{};
+    cv_config.displacement_config.transparent_huge_pages = true;
+
+    auto check = [](auto& table, auto huge_pages) {
+        ASSERT_TRUE(huge_pages(table.current_config()));
+        size_t const read_size = table.table_size();
+        for (uint64_t i = 1000; i < 10000; i++) {
+            table.insert(i, uint64_t(i * 3));
+        }
+        ASSERT_GT(table.table_size(), read_size);
+        ASSERT_TRUE(huge_pages(table.current_config()));
+        for (uint64_t i = 1; i < 10000; i++) {
+            ASSERT_EQ(*table.search(i), i * 3);
+        }
+    };
+    auto layered_huge_pages = [](layered_t::config_args const& config) {
+        return config.displacement_config.table_config.transparent_huge_pages;
+    };
+    auto cv_huge_pages = [](cv_t::config_args const& config) {
+        return config.displacement_config.transparent_huge_pages;
+    };
+
+    auto a = layered_t(0, 20, 20, layered_config);
+    auto c = cv_t(0, 20, 20, cv_config);
+    for (uint64_t i = 1; i < 1000; i++) {
+        a.insert(i, uint64_t(i * 3));
+        c.insert(i, uint64_t(i * 3));
+    }
+
+    std::stringstream layered_ss;
+    tdc::serialize<layered_t>::write(layered_ss, a);
+    auto b = tdc::serialize<layered_t>::read(layered_ss, layered_config);
+    check(b, layered_huge_pages);
+
+    std::stringstream layered_chunked_ss;
+    tdc::serialize_chunked<layered_t>::write(layered_chunked_ss, a);
+    auto b2 = tdc::serialize_chunked<layered_t>::read(layered_chunked_ss, tdc::chunked_config_t(), layered_config);
+    check(b2, layered_huge_pages);
+
+    std::stringstream cv_ss;
+    tdc::serialize<cv_t>::write(cv_ss, c);
+    auto d = tdc::serialize<cv_t>::read(cv_ss, cv_config);
+    check(d, cv_huge_pages);
+}
+
+TEST(hash, mmap_drain_releases_pages) {
+    // NB: Large enough that the drains of the rehashes span several
+    // steps of `trim_storage()`.
+    auto ch = COMPACT_TABLE<uint64_t>(0, 24, 24);
+    for (uint64_t i = 1; i < 300000; i++) {
+        ch.insert(i, uint64_t(i * 5));
+    }
+    for (uint64_t i = 1; i < 300000; i++) {
+        ASSERT_EQ(*ch.search(i), i * 5);
+    }
+}
+
+TEST(hash, mmap_release_keeps_partial_pages) {
+    using tdc::compact_hash::mmap_allocation_t;
+
+    auto alloc = mmap_allocation_t(3 * 512, mmap_allocation_t::config_args{});
+    for (size_t i = 0; i < alloc.size(); i++) {
+        alloc.get()[i] = i + 1;
+    }
+
+    // NB: Only the second page lies completely inside the range.
+    alloc.release(1, 2 * 512 + 1);
+    for (size_t i = 0; i < alloc.size(); i++) {
+        if (i < 512 || i >= 2 * 512) {
+            ASSERT_EQ(alloc.get()[i], i + 1) << "word " << i;
+        }
+    }
+}
+
+TEST(hash, mmap_persist) {
+    using tdc::compact_hash::mmap_allocation_t;
+    std::string const path = "./compact_hash_mmap_persist_test.bin";
+
+    auto config = mmap_allocation_t::config_args{};
+    config.directory = ".";
+    config.named_file = true;
+
+    std::string temporary_path;
+    {
+        auto alloc = mmap_allocation_t(10000, config);
+        temporary_path = alloc.path();
+        ASSERT_FALSE(temporary_path.empty());
+        ASSERT_EQ(access(temporary_path.c_str(), F_OK), 0);
+    }
+    // NB: Not persisted, so the file is removed along with the allocation.
+    ASSERT_NE(access(temporary_path.c_str(), F_OK), 0);
+
+    {
+        auto alloc = mmap_allocation_t(10000, config);
+        for (size_t i = 0; i < alloc.size(); i++) {
+            alloc.get()[i] = i * 7;
+        }
+        alloc.persist(path);
+        ASSERT_EQ(alloc.path(), path);
+    }
+    {
+        auto alloc = mmap_allocation_t::open(path, 10000, config);
+        for (size_t i = 0; i < alloc.size(); i++) {
+            ASSERT_EQ(alloc.get()[i], i * 7) << "word " << i;
+        }
+        alloc.get()[0] = 42;
+    }
+    {
+        auto alloc = mmap_allocation_t::open(path, 10000, config);
+        ASSERT_EQ(alloc.get()[0], 42u);
+    }
+    ASSERT_EQ(unlink(path.c_str()), 0);
+}
@@ -0,0 +1,209 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <tudocomp/util/compact_hash/operation_log_t.hpp>
+#include <tudocomp/util/compact_hash/map/typedefs.hpp>
+#include <tudocomp/util/compact_hash/map/logged_hashmap_t.hpp>
+#include <tudocomp/util/compact_hash/set/typedefs.hpp>
+#include <tudocomp/util/compact_hash/set/logged_hashset_t.hpp>
+
+using namespace tdc::compact_hash;
+
+static std::string const LOG_PATH = "compact_hash_operation_log_test.log";
+static std::string const SNAPSHOT_PATH = "compact_hash_operation_log_test.snapshot";
+
+static void remove_files() {
+    std::remove(LOG_PATH.c_str());
+    std::remove(SNAPSHOT_PATH.c_str());
+}
+
+TEST(operation_log, replay_all_widths) {
+    remove_files();
+
+    std::vector<operation_log_record_t> records;
+    for (uint8_t key_width = 1; key_width <= 64; key_width++) {
+        for (uint8_t value_width = 0; value_width <= 64; value_width += 8) {
+            uint64_t key = ~0ull >> (64 - key_width);
+            uint64_t value = (value_width == 0) ? 0 : (0x5555555555555555ull >> (64 - value_width));
+            records.push_back(operation_log_record_t { key, value, key_width, value_width });
+        }
+    }
+
+    {
+        auto config = operation_log_t::config_args{};
+        config.records_per_group = 7;
+        operation_log_t log(LOG_PATH, config);
+        for (auto const& r : records) {
+            log.append(r.key, r.key_width, r.value, r.value_width);
+        }
+    }
+
+    size_t i = 0;
+    size_t count = operation_log_t::replay(LOG_PATH, [&](operation_log_record_t const& r) {
+        ASSERT_LT(i, records.size());
+        ASSERT_EQ(r.key, records[i].key);
+        ASSERT_EQ(r.value, records[i].value);
+        ASSERT_EQ(r.key_width, records[i].key_width);
+        ASSERT_EQ(r.value_width, records[i].value_width);
+        i++;
+    });
+    ASSERT_EQ(count, records.size());
+    ASSERT_EQ(i, records.size());
+
+    remove_files();
+}
+
+TEST(operation_log, torn_group_is_dropped) {
+    remove_files();
+
+    size_t valid_bytes;
+    {
+        operation_log_t log(LOG_PATH);
+        for (uint64_t i = 0; i < 100; i++) {
+            log.append(i, 8, i, 8);
+        }
+        log.commit();
+        operation_log_t::replay(LOG_PATH, [](operation_log_record_t const&) {}, &valid_bytes);
+        for (uint64_t i = 100; i < 200; i++) {
+            log.append(i, 8, i, 8);
+        }
+    }
+
+    // cut the second group in half, as if the process crashed while appending it
+    struct stat st;
+    ASSERT_EQ(stat(LOG_PATH.c_str(), &st), 0);
+    ASSERT_EQ(truncate(LOG_PATH.c_str(), (valid_bytes + st.st_size) / 2), 0);
+
+    ASSERT_EQ(operation_log_t::replay(LOG_PATH, [](operation_log_record_t const&) {}), 100u);
+
+    // appending after reopening drops the torn group first
+    {
+        operation_log_t log(LOG_PATH);
+        log.append(1000, 10, 1, 1);
+    }
+    std::vector<uint64_t> keys;
+    operation_log_t::replay(LOG_PATH, [&](operation_log_record_t const& r) {
+        keys.push_back(r.key);
+    });
+    ASSERT_EQ(keys.size(), 101u);
+    ASSERT_EQ(keys.back(), 1000u);
+
+    remove_files();
+}
+
+TEST(operation_log, torn_header_is_rewritten) {
+    remove_files();
+
+    {
+        operation_log_t log(LOG_PATH);
+    }
+
+    // cut the header in half, as if the process crashed while creating the log
+    ASSERT_EQ(truncate(LOG_PATH.c_str(), 8), 0);
+    ASSERT_EQ(operation_log_t::replay(LOG_PATH, [](operation_log_record_t const&) {}), 0u);
+
+    {
+        operation_log_t log(LOG_PATH);
+        log.append(7, 3, 5, 3);
+    }
+    std::vector<uint64_t> keys;
+    operation_log_t::replay(LOG_PATH, [&](operation_log_record_t const& r) {
+        keys.push_back(r.key);
+    });
+    ASSERT_EQ(keys, std::vector<uint64_t> { 7 });
+
+    // a map recovers from it
+    using table_t = map::sparse_layered_hashmap_t<tdc::dynamic_t>;
+    auto map = map::logged_hashmap_t<table_t>::recover(SNAPSHOT_PATH, LOG_PATH, table_t(0, 16, 1));
+    ASSERT_EQ(map.table().size(), 1u);
+    ASSERT_EQ(uint64_t(*map.table().search(7)), 5u);
+
+    remove_files();
+}
+
+TEST(operation_log, map_recover) {
+    using table_t = map::sparse_cv_hashmap_t<uint64_t>;
+    remove_files();
+
+    {
+        auto map = map::logged_hashmap_t<table_t>(table_t(0, 8, 8), LOG_PATH);
+        for (uint64_t i = 0; i < 1000; i++) {
+            map.insert_kv_width(i, i * 3, tdc::bits_for(i), tdc::bits_for(i * 3));
+        }
+        map.checkpoint(SNAPSHOT_PATH);
+
+        for (uint64_t i = 1000; i < 3000; i++) {
+            map.insert_kv_width(i, i * 3, tdc::bits_for(i), tdc::bits_for(i * 3));
+        }
+        // updates of existing values
+        for (uint64_t i = 0; i < 3000; i += 10) {
+            map.insert(i, i * 2);
+        }
+        map.sync();
+    }
+
+    auto map = map::logged_hashmap_t<table_t>::recover(SNAPSHOT_PATH, LOG_PATH);
+    ASSERT_EQ(map.table().size(), 3000u);
+    for (uint64_t i = 0; i < 3000; i++) {
+        ASSERT_EQ(*map.table().search(i), (i % 10 == 0) ? i * 2 : i * 3);
+    }
+
+    remove_files();
+}
+
+TEST(operation_log, map_recover_without_snapshot) {
+    using table_t = map::sparse_layered_hashmap_t<uint64_t>;
+    remove_files();
+
+    {
+        auto map = map::logged_hashmap_t<table_t>(table_t(0, 16, 16), LOG_PATH);
+        for (uint64_t i = 0; i < 500; i++) {
+            map.insert(i, i + 1);
+        }
+    }
+
+    auto map = map::logged_hashmap_t<table_t>::recover(SNAPSHOT_PATH, LOG_PATH, table_t(0, 16, 16));
+    ASSERT_EQ(map.table().size(), 500u);
+    for (uint64_t i = 0; i < 500; i++) {
+        ASSERT_EQ(*map.table().search(i), i + 1);
+    }
+
+    remove_files();
+}
+
+TEST(operation_log, set_recover) {
+    using table_t = set::sparse_cv_hashset_t<>;
+    remove_files();
+
+    {
+        auto set = set::logged_hashset_t<table_t>(table_t(0, 1), LOG_PATH);
+        for (uint64_t i = 0; i < 1000; i++) {
+            set.lookup_insert_key_width(i * 7, tdc::bits_for(i * 7));
+        }
+        set.checkpoint(SNAPSHOT_PATH);
+        for (uint64_t i = 1000; i < 2000; i++) {
+            set.lookup_insert_key_width(i * 7, tdc::bits_for(i * 7));
+        }
+        // already contained keys are not logged again
+        for (uint64_t i = 0; i < 2000; i++) {
+            set.lookup_insert(i * 7);
+        }
+        set.sync();
+        ASSERT_EQ(operation_log_t::replay(LOG_PATH, [](operation_log_record_t const&) {}), 1000u);
+    }
+
+    auto set = set::logged_hashset_t<table_t>::recover(SNAPSHOT_PATH, LOG_PATH);
+    ASSERT_EQ(set.table().size(), 2000u);
+    for (uint64_t i = 0; i < 2000; i++) {
+        ASSERT_TRUE(set.table().lookup(i * 7).found());
+    }
+
+    remove_files();
+}
@@ -0,0 +1,233 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <random>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <tudocomp/util/compact_hash/map/typedefs.hpp>
+#include <tudocomp/util/compact_hash/set/typedefs.hpp>
+
+using namespace tdc::compact_hash;
+
+template<typename table_t>
+std::unordered_map<uint64_t, uint64_t> fill_map(table_t& table, size_t n) {
+    std::unordered_map<uint64_t, uint64_t> expected;
+    std::mt19937_64 gen(n);
+    while (expected.size() < n) {
+        uint64_t const key = gen() & ((1ull << 30) - 1);
+        // NB: Not 0, which marks empty slots in `plain_sentinel_t`.
+        uint64_t const value = (gen() & ((1ull << 20) - 2)) | 1;
+        table.insert(key, typename table_t::value_type(value));
+        expected[key] = value;
+    }
+    return expected;
+}
+
+template<typename table_t>
+void map_parallel_test(size_t n, size_t threads) {
+    auto table = table_t(0, 30, 20);
+    auto const expected = fill_map(table, n);
+
+    // parallel_for_each visits each entry once
+    std::mutex mutex;
+    std::unordered_map<uint64_t, uint64_t> visited;
+    table.parallel_for_each([&](uint64_t key, auto value) {
+        uint64_t const v = uint64_t(value);
+        std::lock_guard<std::mutex> lock(mutex);
+        ASSERT_EQ(visited.count(key), 0u) << "key " << key;
+        visited[key] = v;
+    }, threads);
+    ASSERT_EQ(visited, expected);
+
+    // parallel_reduce sums up the same as a sequential loop
+    uint64_t sum = 0;
+    for (auto const& kv : expected) {
+        sum += kv.first ^ kv.second;
+    }
+    auto const count_sum = table.parallel_reduce(
+        std::pair<size_t, uint64_t>(0, 0),
+        [](std::pair<size_t, uint64_t>& acc, uint64_t key, auto value) {
+            acc.first++;
+            acc.second += key ^ uint64_t(value);
+        },
+        [](std::pair<size_t, uint64_t> lhs, std::pair<size_t, uint64_t> rhs) {
+            return std::pair<size_t, uint64_t>(lhs.first + rhs.first, lhs.second + rhs.second);
+        },
+        threads);
+    ASSERT_EQ(count_sum.first, n);
+    ASSERT_EQ(count_sum.second, sum);
+}
+
+template<typename table_t>
+void map_parallel_tests() {
+    for (size_t threads : { 1, 2, 4, 8 }) {
+        map_parallel_test<table_t>(0, threads);
+        map_parallel_test<table_t>(1, threads);
+        map_parallel_test<table_t>(1000, threads);
+        map_parallel_test<table_t>(50000, threads);
+    }
+}
+
+TEST(parallel, plain_cv_hashmap) {
+    map_parallel_tests<map::plain_cv_hashmap_t<tdc::dynamic_t>>();
+}
+
+TEST(parallel, sparse_cv_hashmap) {
+    map_parallel_tests<map::sparse_cv_hashmap_t<tdc::dynamic_t>>();
+}
+
+TEST(parallel, plain_bv_cv_hashmap) {
+    map_parallel_tests<map::plain_bv_cv_hashmap_t<tdc::dynamic_t>>();
+}
+
+TEST(parallel, plain_layered_hashmap) {
+    map_parallel_tests<map::plain_layered_hashmap_t<tdc::dynamic_t>>();
+}
+
+TEST(parallel, sparse_layered_hashmap) {
+    map_parallel_tests<map::sparse_layered_hashmap_t<tdc::dynamic_t>>();
+}
+
+// NB: Walks on one thread, since the table decodes its displacements
+// with a cursor.
+TEST(parallel, sparse_elias_hashmap) {
+    map_parallel_tests<map::sparse_elias_hashmap_t<tdc::dynamic_t>>();
+}
+
+TEST(parallel, sparse_robin_hood_hashmap) {
+    map_parallel_tests<map::sparse_robin_hood_hashmap_t<tdc::dynamic_t>>();
+}
+
+TEST(parallel, sparse_cuckoo_hashmap) {
+    map_parallel_tests<map::sparse_cuckoo_hashmap_t<tdc::dynamic_t>>();
+}
+
+TEST(parallel, sparse_hopscotch_hashmap) {
+    map_parallel_tests<map::sparse_hopscotch_hashmap_t<tdc::dynamic_t>>();
+}
+
+// NB: Walks on one thread, since reads mark buckets as changed.
+TEST(parallel, track_dirty) {
+    using table_t = map::sparse_cv_hashmap_t<tdc::dynamic_t>;
+    auto table = table_t(0, 30, 20);
+    auto const expected = fill_map(table, 10000);
+    table.clear_dirty();
+
+    std::atomic<size_t> count { 0 };
+    table.parallel_for_each([&](uint64_t key, auto value) {
+        ASSERT_EQ(expected.at(key), uint64_t(value));
+        count++;
+    }, 4);
+    ASSERT_EQ(count, expected.size());
+}
+
+// NB: A full table wraps groups around its end, which has to
+// stay within the last range of the walk.
+TEST(parallel, wrapping_groups) {
+    using table_t = map::sparse_cv_hashmap_t<tdc::dynamic_t>;
+    auto table = table_t(1024, 16, 8);
+    table.max_load_factor(0.95);
+    std::unordered_map<uint64_t, uint64_t> expected;
+    std::mt19937_64 gen(3);
+    while (expected.size() < 950) {
+        uint64_t const key = gen() & 0xffff;
+        table.insert(key, table_t::value_type(key & 0xff));
+        expected[key] = key & 0xff;
+    }
+    ASSERT_EQ(table.table_size(), 1024u);
+
+    for (size_t threads : { 2, 3, 8, 64 }) {
+        auto visited = table.parallel_reduce(
+            std::unordered_map<uint64_t, uint64_t>(),
+            [](std::unordered_map<uint64_t, uint64_t>& acc, uint64_t key, auto value) {
+                acc[key] = uint64_t(value);
+            },
+            [](std::unordered_map<uint64_t, uint64_t> lhs, std::unordered_map<uint64_t, uint64_t> rhs) {
+                for (auto const& kv : rhs) {
+                    EXPECT_EQ(lhs.count(kv.first), 0u) << "key " << kv.first;
+                    lhs.insert(kv);
+                }
+                return lhs;
+            },
+            threads);
+        ASSERT_EQ(visited, expected);
+    }
+}
+
+// A histogram of the values, merged from the threads in order.
+TEST(parallel, histogram) {
+    using table_t = map::sparse_layered_hashmap_t<tdc::dynamic_t>;
+    auto table = table_t(0, 30, 4);
+    std::vector<size_t> expected(16);
+    std::mt19937_64 gen(7);
+    for (size_t i = 0; i < 100000; i++) {
+        uint64_t const key = gen() & ((1ull << 30) - 1);
+        uint64_t const value = gen() & 0xf;
+        if (table.search(key) == table.end()) {
+            expected[value]++;
+            table.insert(key, table_t::value_type(value));
+        }
+    }
+
+    auto const histogram = table.parallel_reduce(
+        std::vector<size_t>(16),
+        [](std::vector<size_t>& acc, uint64_t, auto value) {
+            acc[uint64_t(value)]++;
+        },
+        [](std::vector<size_t> lhs, std::vector<size_t> const& rhs) {
+            for (size_t i = 0; i < lhs.size(); i++) {
+                lhs[i] += rhs[i];
+            }
+            return lhs;
+        },
+        4);
+    ASSERT_EQ(histogram, expected);
+}
+
+template<typename table_t>
+void set_parallel_test(size_t n, size_t threads) {
+    auto table = table_t(0, 30);
+    std::unordered_set<uint64_t> expected;
+    std::mt19937_64 gen(n);
+    while (expected.size() < n) {
+        uint64_t const key = gen() & ((1ull << 30) - 1);
+        table.lookup_insert(key);
+        expected.insert(key);
+    }
+
+    std::mutex mutex;
+    std::unordered_set<uint64_t> visited;
+    table.parallel_for_each([&](uint64_t key) {
+        std::lock_guard<std::mutex> lock(mutex);
+        ASSERT_EQ(visited.count(key), 0u) << "key " << key;
+        visited.insert(key);
+    }, threads);
+    ASSERT_EQ(visited, expected);
+
+    uint64_t sum = 0;
+    for (uint64_t key : expected) {
+        sum += key;
+    }
+    auto const reduced = table.parallel_reduce(
+        uint64_t(0),
+        [](uint64_t& acc, uint64_t key) { acc += key; },
+        [](uint64_t lhs, uint64_t rhs) { return lhs + rhs; },
+        threads);
+    ASSERT_EQ(reduced, sum);
+}
+
+TEST(parallel, hashsets) {
+    for (size_t threads : { 1, 2, 4, 8 }) {
+        for (size_t n : { 0, 1, 1000, 50000 }) {
+            set_parallel_test<set::sparse_cv_hashset_t<>>(n, threads);
+            set_parallel_test<set::sparse_layered_hashset_t<>>(n, threads);
+            set_parallel_test<set::sparse_robin_hood_hashset_t<>>(n, threads);
+            set_parallel_test<set::sparse_cuckoo_hashset_t<>>(n, threads);
+            set_parallel_test<set::sparse_hopscotch_hashset_t<>>(n, threads);
+        }
+    }
+}
@@ -0,0 +1,120 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <random>
+#include <sstream>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <tudocomp/util/compact_hash/map/typedefs.hpp>
+#include <tudocomp/util/compact_hash/set/typedefs.hpp>
+#include <tudocomp/util/compact_hash/map/perfect_hashmap_t.hpp>
+
+using namespace tdc::compact_hash;
+using namespace tdc::compact_hash::map;
+
+using perfect_t = perfect_hashmap_t<>;
+
+inline uint64_t mask_for(size_t width) {
+    return (width == 64) ? ~0ull : ((1ull << width) - 1);
+}
+
+template<typename table_t>
+std::unordered_map<uint64_t, uint64_t> fill(table_t& table, size_t n, size_t key_width, size_t value_width) {
+    std::unordered_map<uint64_t, uint64_t> expected;
+    std::mt19937_64 gen(n);
+
+    while (expected.size() < n) {
+        uint64_t const key = gen() & mask_for(key_width);
+        uint64_t const value = gen() & mask_for(value_width);
+        table.insert_kv_width(key, uint64_t(value), key_width, value_width);
+        expected[key] = value;
+    }
+
+    return expected;
+}
+
+void check(perfect_t const& perfect,
+           std::unordered_map<uint64_t, uint64_t> const& expected,
+           size_t key_width) {
+    ASSERT_EQ(perfect.size(), expected.size());
+    ASSERT_EQ(perfect.key_width(), key_width);
+
+    for (auto const& e : expected) {
+        uint64_t value;
+        ASSERT_TRUE(perfect.search(e.first, value)) << "key " << e.first;
+        ASSERT_EQ(value, e.second) << "key " << e.first;
+    }
+
+    std::mt19937_64 gen(42);
+    for (size_t i = 0; i < 10000; i++) {
+        uint64_t const key = gen() & mask_for(key_width);
+        ASSERT_EQ(perfect.count(key), expected.count(key)) << "key " << key;
+    }
+}
+
+template<typename table_t>
+void perfect_test(size_t n, size_t key_width, size_t value_width,
+                  perfect_t::config_args config = perfect_t::config_args{}) {
+    auto table = table_t(0, key_width, value_width);
+    auto expected = fill(table, n, key_width, value_width);
+
+    auto perfect = freeze_perfect(table, config);
+    check(perfect, expected, key_width);
+
+    std::stringstream ss;
+    tdc::serialize<perfect_t>::write(ss, perfect);
+    auto read = tdc::serialize<perfect_t>::read(ss);
+    ASSERT_TRUE(tdc::serialize<perfect_t>::equal_check(perfect, read));
+    check(read, expected, key_width);
+}
+
+TEST(perfect_hashmap, empty) {
+    perfect_test<sparse_cv_hashmap_t<uint64_t>>(0, 16, 16);
+}
+
+TEST(perfect_hashmap, single_partition) {
+    perfect_test<sparse_cv_hashmap_t<uint64_t>>(500, 16, 8);
+}
+
+TEST(perfect_hashmap, sparse_cv) {
+    perfect_test<sparse_cv_hashmap_t<uint64_t>>(100000, 32, 20);
+}
+
+TEST(perfect_hashmap, plain_layered_wide) {
+    perfect_test<plain_layered_hashmap_t<uint64_t>>(50000, 64, 64);
+}
+
+TEST(perfect_hashmap, sparse_cuckoo_dynamic) {
+    perfect_test<sparse_cuckoo_hashmap_t<tdc::dynamic_t>>(50000, 40, 7);
+}
+
+TEST(perfect_hashmap, parallel) {
+    auto config = perfect_t::config_args{};
+    config.threads = 4;
+    config.keys_per_partition = 100;
+    config.keys_per_bucket = 3;
+    perfect_test<sparse_cv_hashmap_t<uint64_t>>(100000, 30, 17, config);
+}
+
+TEST(perfect_hashmap, set) {
+    auto table = set::sparse_cv_hashset_t<>(0, 28);
+    std::unordered_set<uint64_t> expected;
+    std::mt19937_64 gen(7);
+    while (expected.size() < 50000) {
+        uint64_t const key = gen() & mask_for(28);
+        table.lookup_insert(key);
+        expected.insert(key);
+    }
+
+    auto perfect = freeze_perfect(table);
+    ASSERT_EQ(perfect.size(), expected.size());
+    ASSERT_EQ(perfect.value_width(), 0u);
+    for (uint64_t key : expected) {
+        ASSERT_EQ(perfect.count(key), 1u) << "key " << key;
+    }
+    for (size_t i = 0; i < 10000; i++) {
+        uint64_t const key = gen() & mask_for(28);
+        ASSERT_EQ(perfect.count(key), expected.count(key)) << "key " << key;
+    }
+}
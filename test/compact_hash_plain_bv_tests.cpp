@@ -0,0 +1,39 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <algorithm>
+
+#include <tudocomp/util/compact_hash/map/typedefs.hpp>
+
+template<typename val_t>
+using COMPACT_TABLE = tdc::compact_hash::map::plain_bv_layered_hashmap_t<val_t>;
+
+#include "compact_hash_tests.template.hpp"
+
+TEST(hash, plain_bv_full_value_range) {
+    // NB: Without a sentinel, every value can be stored, including 0.
+    auto ch = tdc::compact_hash::map::plain_bv_cv_hashmap_t<uint64_t>(0, 16, 2);
+    for (uint64_t i = 0; i < 10000; i++) {
+        ch.insert(i, uint64_t(i % 4));
+    }
+    ASSERT_EQ(ch.size(), 10000U);
+    for (uint64_t i = 0; i < 10000; i++) {
+        ASSERT_EQ(*ch.search(i), i % 4);
+    }
+    for (uint64_t i = 10000; i < 20000; i++) {
+        ASSERT_EQ(ch.count(i), 0U);
+    }
+}
+
+TEST(hash, plain_bv_sparse_grow) {
+    // Growing drains the old table with `for_all_allocated`,
+    // which skips the empty regions of the occupancy bit vector.
+    auto ch = COMPACT_TABLE<uint64_t>(1 << 16, 32, 32);
+    for (uint64_t i = 0; i < 100; i++) {
+        ch.insert(i * 7919, uint64_t(i));
+    }
+    ch.grow_key_width(40);
+    for (uint64_t i = 0; i < 100; i++) {
+        ASSERT_EQ(*ch.search(i * 7919), i);
+    }
+}
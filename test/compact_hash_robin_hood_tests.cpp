@@ -0,0 +1,14 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <algorithm>
+
+#include <tudocomp/util/compact_hash/map/typedefs.hpp>
+
+template<typename val_t>
+using COMPACT_TABLE = tdc::compact_hash::map::plain_robin_hood_hashmap_t<val_t>;
+
+#include "compact_hash_tests.template.hpp"
+// NB: Erasing from plain storage puts the empty value back into the
+// location, see `plain_sentinel_t::deallocate_pos()`.
+#include "compact_hash_erase_tests.template.hpp"
@@ -9,3 +9,24 @@ template<typename val_t>
 using COMPACT_TABLE = tdc::compact_hash::map::plain_cv_hashmap_t<val_t>;
 
 #include "compact_hash_tests.template.hpp"
+
+TEST(hash, nonzero_empty_value) {
+    using table_t = tdc::compact_hash::map::plain_cv_hashmap_t<uint64_t>;
+
+    // NB: With a non-zero empty value, all slots need to be initialized,
+    // and 0 becomes a valid value.
+    auto config = table_t::config_args{};
+    config.storage_config.empty_value = 255;
+
+    auto ch = table_t(0, 16, 8, config);
+    for (uint64_t i = 0; i < 1000; i++) {
+        ch.insert(i, uint64_t(i % 255));
+    }
+    ASSERT_EQ(ch.size(), 1000U);
+    for (uint64_t i = 0; i < 1000; i++) {
+        ASSERT_EQ(*ch.search(i), i % 255);
+    }
+    for (uint64_t i = 1000; i < 2000; i++) {
+        ASSERT_EQ(ch.count(i), 0U);
+    }
+}
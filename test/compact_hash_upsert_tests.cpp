@@ -0,0 +1,100 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <functional>
+#include <random>
+#include <unordered_map>
+
+#include <tudocomp/util/compact_hash/map/typedefs.hpp>
+#include <tudocomp/util/compact_hash/map/fixed_width_hashmap_t.hpp>
+
+using namespace tdc::compact_hash;
+
+template<typename table_t>
+void merge_counts_test() {
+    // NB: Starts with values of 1 bit, which the counts outgrow.
+    auto table = table_t(0, 20, 1);
+    std::unordered_map<uint64_t, uint64_t> expected;
+    std::mt19937_64 gen(1);
+    for (size_t i = 0; i < 200000; i++) {
+        // NB: Few keys with a skewed distribution, to get large counts.
+        uint64_t const key = (gen() & 0xfff) & (gen() & 0xfff);
+        uint64_t const count = table.merge(key, 1, std::plus<uint64_t>());
+        expected[key]++;
+        ASSERT_EQ(count, expected[key]) << "key " << key;
+    }
+    ASSERT_EQ(table.size(), expected.size());
+    ASSERT_GT(table.value_width(), 10u);
+
+    for (auto const& kv : expected) {
+        auto ptr = table.search(kv.first);
+        ASSERT_NE(ptr, table.end()) << "key " << kv.first;
+        ASSERT_EQ(uint64_t(*ptr), kv.second) << "key " << kv.first;
+    }
+}
+
+TEST(upsert, merge_counts) {
+    merge_counts_test<map::plain_cv_hashmap_t<tdc::dynamic_t>>();
+    merge_counts_test<map::sparse_cv_hashmap_t<tdc::dynamic_t>>();
+    merge_counts_test<map::plain_layered_hashmap_t<tdc::dynamic_t>>();
+    merge_counts_test<map::sparse_layered_hashmap_t<tdc::dynamic_t>>();
+    merge_counts_test<map::sparse_elias_hashmap_t<tdc::dynamic_t>>();
+    merge_counts_test<map::sparse_robin_hood_hashmap_t<tdc::dynamic_t>>();
+    merge_counts_test<map::sparse_cuckoo_hashmap_t<tdc::dynamic_t>>();
+    merge_counts_test<map::sparse_hopscotch_hashmap_t<tdc::dynamic_t>>();
+}
+
+TEST(upsert, init_and_update) {
+    using table_t = map::sparse_cv_hashmap_t<tdc::dynamic_t>;
+    auto table = table_t(0, 16, 4);
+
+    // A new key takes `init`, and grows the value width to fit it.
+    size_t calls = 0;
+    auto update = [&](uint64_t value) {
+        calls++;
+        return value * 3;
+    };
+    ASSERT_EQ(uint64_t(table.upsert(7, 1000, update)), 1000u);
+    ASSERT_EQ(calls, 0u);
+    ASSERT_EQ(table.value_width(), 10u);
+    ASSERT_EQ(table.size(), 1u);
+
+    // An existing key takes the updated value, and keeps its width if it fits.
+    ASSERT_EQ(uint64_t(table.upsert(7, 1000, [](uint64_t value) { return value / 2; })), 500u);
+    ASSERT_EQ(table.value_width(), 10u);
+
+    // ... or grows it otherwise.
+    ASSERT_EQ(uint64_t(table.upsert(7, 1000, update)), 1500u);
+    ASSERT_EQ(calls, 1u);
+    ASSERT_EQ(table.value_width(), 11u);
+    ASSERT_EQ(table.size(), 1u);
+    ASSERT_EQ(uint64_t(*table.search(7)), 1500u);
+
+    // The returned reference can be written to.
+    table.upsert(8, 1, update) = 2;
+    ASSERT_EQ(uint64_t(*table.search(8)), 2u);
+    ASSERT_EQ(uint64_t(*table.search(7)), 1500u);
+}
+
+TEST(upsert, fixed_types) {
+    // Values of a fixed type do not change the value width.
+    auto table = map::sparse_cv_hashmap_t<uint32_t>(0, 16);
+    for (uint64_t i = 0; i < 1000; i++) {
+        table.merge(i % 100, uint32_t(i), [](uint32_t lhs, uint32_t rhs) {
+            return std::max(lhs, rhs);
+        });
+    }
+    ASSERT_EQ(table.size(), 100u);
+    for (uint64_t key = 0; key < 100; key++) {
+        ASSERT_EQ(*table.search(key), uint32_t(900 + key));
+    }
+
+    auto fixed = map::fixed_width_hashmap_t<16, 12>();
+    for (uint64_t i = 0; i < 1000; i++) {
+        fixed.merge(i % 10, 1, std::plus<uint64_t>());
+    }
+    ASSERT_EQ(fixed.size(), 10u);
+    for (uint64_t key = 0; key < 10; key++) {
+        ASSERT_EQ(uint64_t(*fixed.search(key)), 100u);
+    }
+}
@@ -0,0 +1,329 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <tudocomp/util/compact_hash/map/typedefs.hpp>
+#include <tudocomp/util/compact_hash/map/hashmap_view_t.hpp>
+#include <tudocomp/util/compact_hash/map/frozen_hashmap_t.hpp>
+#include <tudocomp/util/compact_hash/set/typedefs.hpp>
+#include <tudocomp/util/compact_hash/set/frozen_hashset_t.hpp>
+#include <tudocomp/util/compact_hash/mmap_file_t.hpp>
+
+using namespace tdc::compact_hash;
+using namespace tdc::compact_hash::map;
+
+inline uint64_t mask_for(size_t width) {
+    return (width == 64) ? ~0ull : ((1ull << width) - 1);
+}
+
+/// Fills the map with random keys and returns the inserted pairs.
+///
+/// NB: The values are never 0, which is the empty value of `plain_sentinel_t`.
+template<typename table_t>
+std::unordered_map<uint64_t, uint64_t> fill(table_t& table, size_t n, size_t key_width, size_t value_width) {
+    std::unordered_map<uint64_t, uint64_t> expected;
+    std::mt19937_64 gen(n);
+
+    uint64_t const key_mask = mask_for(key_width);
+    uint64_t const value_mask = mask_for(value_width);
+    while (expected.size() < n) {
+        uint64_t const key = gen() & key_mask;
+        uint64_t const value = gen() & value_mask;
+        if (value == 0) {
+            continue;
+        }
+        table.insert_kv_width(key, uint64_t(value), key_width, value_width);
+        expected[key] = value;
+    }
+
+    return expected;
+}
+
+/// Aligned copy of the on-disk representation.
+inline std::vector<uint64_t> aligned_buffer(std::string const& bytes) {
+    std::vector<uint64_t> buffer((bytes.size() + 7) / 8);
+    memcpy(buffer.data(), bytes.data(), bytes.size());
+    return buffer;
+}
+
+template<typename view_t>
+void check_view(view_t const& view,
+                std::unordered_map<uint64_t, uint64_t> const& expected,
+                size_t key_width) {
+    ASSERT_EQ(view.size(), expected.size());
+    ASSERT_EQ(view.key_width(), key_width);
+
+    for (auto const& e : expected) {
+        uint64_t value;
+        ASSERT_TRUE(view.search(e.first, value)) << "key " << e.first;
+        ASSERT_EQ(value, e.second) << "key " << e.first;
+    }
+
+    std::mt19937_64 gen(42);
+    uint64_t const key_mask = mask_for(key_width);
+    for (size_t i = 0; i < 1000; i++) {
+        uint64_t const key = gen() & key_mask;
+        ASSERT_EQ(view.count(key), expected.count(key)) << "key " << key;
+    }
+}
+
+template<typename table_t>
+void check_roundtrip(table_t& table,
+                     std::unordered_map<uint64_t, uint64_t> const& expected,
+                     size_t key_width) {
+    std::stringstream out;
+    auto bytes = hashmap_view_t<>::write(out, table);
+    auto const data = out.str();
+    ASSERT_EQ(bytes.size_in_bytes(), data.size());
+
+    auto buffer = aligned_buffer(data);
+    auto view = hashmap_view_t<>(buffer.data(), data.size());
+    check_view(view, expected, key_width);
+    ASSERT_EQ(view.table_size(), table.table_size());
+}
+
+template<typename table_t>
+void roundtrip(size_t n, size_t key_width, size_t value_width) {
+    auto table = table_t(0, key_width, value_width);
+    auto expected = fill(table, n, key_width, value_width);
+    check_roundtrip(table, expected, key_width);
+}
+
+TEST(hashmap_view, empty) {
+    roundtrip<plain_cv_hashmap_t<uint64_t>>(0, 16, 16);
+}
+
+TEST(hashmap_view, plain_cv) {
+    roundtrip<plain_cv_hashmap_t<uint64_t>>(10000, 32, 20);
+}
+
+TEST(hashmap_view, sparse_cv) {
+    roundtrip<sparse_cv_hashmap_t<uint64_t>>(10000, 24, 64);
+}
+
+TEST(hashmap_view, sparse_cv_dynamic) {
+    roundtrip<sparse_cv_hashmap_t<tdc::dynamic_t>>(10000, 40, 7);
+}
+
+TEST(hashmap_view, sparse_layered) {
+    roundtrip<sparse_layered_hashmap_t<uint64_t>>(10000, 20, 13);
+}
+
+TEST(hashmap_view, plain_elias_dynamic) {
+    roundtrip<plain_elias_hashmap_t<tdc::dynamic_t>>(10000, 64, 33);
+}
+
+TEST(hashmap_view, plain_robin_hood) {
+    roundtrip<plain_robin_hood_hashmap_t<uint64_t>>(10000, 18, 1);
+}
+
+TEST(hashmap_view, plain_cuckoo) {
+    roundtrip<plain_cuckoo_hashmap_t<uint64_t>>(10000, 30, 16);
+}
+
+TEST(hashmap_view, sparse_hopscotch) {
+    roundtrip<sparse_hopscotch_hashmap_t<uint64_t>>(10000, 26, 9);
+}
+
+// NB: The entries in the stash of a cuckoo or hopscotch table are
+// placed anew by linear probing, like all other entries.
+TEST(hashmap_view, plain_cuckoo_stash) {
+    using table_t = plain_cuckoo_hashmap_t<uint64_t>;
+    auto config = table_t::config_args{};
+    config.displacement_config.max_search = 0;
+
+    auto table = table_t(0, 30, 16, config);
+    table.max_load_factor(0.95);
+    auto expected = fill(table, 20000, 30, 16);
+    ASSERT_GT(table.placement().stash_size(), 0u);
+    check_roundtrip(table, expected, 30);
+}
+
+TEST(hashmap_view, plain_hopscotch_stash) {
+    using table_t = hashmap_t<uint64_t, poplar_xorshift_t, plain_sentinel_t, hopscotch_t<2>>;
+
+    auto table = table_t(0, 30, 16);
+    table.max_load_factor(0.95);
+    auto expected = fill(table, 20000, 30, 16);
+    ASSERT_GT(table.placement().stash_size(), 0u);
+    check_roundtrip(table, expected, 30);
+}
+
+TEST(hashmap_view, file) {
+    using table_t = sparse_layered_hashmap_t<tdc::dynamic_t>;
+
+    auto table = table_t(0, 28, 11);
+    auto expected = fill(table, 5000, 28, 11);
+
+    std::string const path = "compact_hashmap_view_test.bin";
+    {
+        std::ofstream out(path, std::ios::binary);
+        hashmap_view_t<>::write(out, table);
+    }
+
+    {
+        auto file = mmap_file_t(path, true);
+        auto view = hashmap_view_t<>(file.data(), file.size());
+        check_view(view, expected, 28);
+    }
+
+    std::remove(path.c_str());
+}
+
+inline uint64_t packed_get(std::vector<uint64_t> const& words, size_t offset, size_t index, size_t width) {
+    uint64_t v = 0;
+    for (size_t i = 0; i < width; i++) {
+        size_t const bit = index * width + i;
+        v |= ((words[offset + bit / 64] >> (bit % 64)) & 1ull) << i;
+    }
+    return v;
+}
+
+inline void packed_set(std::vector<uint64_t>& words, size_t offset, size_t index, size_t width, uint64_t v) {
+    for (size_t i = 0; i < width; i++) {
+        size_t const bit = index * width + i;
+        words[offset + bit / 64] |= ((v >> i) & 1ull) << (bit % 64);
+    }
+}
+
+// NB: Version 1 stored the displacements for every slot, indexed by the slot.
+// The image is converted by appending such a section, which the header then points to.
+TEST(hashmap_view, version_1) {
+    auto table = sparse_cv_hashmap_t<uint64_t>(0, 24, 12);
+    auto expected = fill(table, 10000, 24, 12);
+
+    std::stringstream out;
+    hashmap_view_t<>::write(out, table);
+    auto buffer = aligned_buffer(out.str());
+
+    using header_t = hashmap_view_t<>::header_t;
+    header_t header;
+    memcpy(&header, buffer.data(), sizeof(header_t));
+    ASSERT_EQ(header.version, hashmap_view_t<>::VERSION);
+    ASSERT_EQ(header.file_size % 8, 0u);
+
+    size_t const table_size = size_t(1) << header.capacity_log2;
+    size_t const width = header.displacement_width;
+    size_t const occupied = header.occupied_offset / 8;
+    size_t const displacement = header.displacement_offset / 8;
+    size_t const per_slot = header.file_size / 8;
+    buffer.resize(per_slot + (table_size * width + 63) / 64, 0);
+
+    size_t r = 0;
+    for (size_t pos = 0; pos < table_size; pos++) {
+        if ((buffer[occupied + pos / 64] >> (pos % 64)) & 1ull) {
+            packed_set(buffer, per_slot, pos, width, packed_get(buffer, displacement, r, width));
+            r++;
+        }
+    }
+    ASSERT_EQ(r, expected.size());
+
+    header.version = 1;
+    header.displacement_offset = per_slot * 8;
+    header.file_size = buffer.size() * 8;
+    memcpy(buffer.data(), &header, sizeof(header_t));
+
+    auto view = hashmap_view_t<>(buffer.data(), header.file_size);
+    check_view(view, expected, 24);
+}
+
+template<typename table_t>
+void freeze_test(size_t n, size_t key_width, size_t value_width) {
+    auto table = table_t(0, key_width, value_width);
+    auto expected = fill(table, n, key_width, value_width);
+
+    auto frozen = freeze(table);
+    check_view(frozen, expected, key_width);
+    ASSERT_LT(tdc::heap_size_compute(frozen).size_in_bytes(),
+              tdc::heap_size_compute(table).size_in_bytes());
+
+    // the written representation can be opened as a view
+    std::stringstream out;
+    frozen.write(out);
+    auto const data = out.str();
+    auto buffer = aligned_buffer(data);
+    check_view(hashmap_view_t<>(buffer.data(), data.size()), expected, key_width);
+}
+
+TEST(frozen_hashmap, sparse_cv) {
+    freeze_test<sparse_cv_hashmap_t<uint64_t>>(10000, 32, 20);
+}
+
+TEST(frozen_hashmap, plain_layered) {
+    freeze_test<plain_layered_hashmap_t<uint64_t>>(10000, 40, 64);
+}
+
+TEST(frozen_hashmap, sparse_elias_dynamic) {
+    freeze_test<sparse_elias_hashmap_t<tdc::dynamic_t>>(10000, 64, 5);
+}
+
+TEST(frozen_hashmap, sparse_cuckoo) {
+    freeze_test<sparse_cuckoo_hashmap_t<uint64_t>>(10000, 24, 12);
+}
+
+TEST(frozen_hashmap, plain_hopscotch) {
+    freeze_test<plain_hopscotch_hashmap_t<uint64_t>>(10000, 36, 36);
+}
+
+TEST(frozen_hashmap, concurrent_readers) {
+    auto table = sparse_cv_hashmap_t<uint64_t>(0, 32, 32);
+    auto const expected = fill(table, 50000, 32, 32);
+    auto const frozen = freeze(table);
+
+    std::vector<std::thread> readers;
+    std::vector<size_t> found(4);
+    for (size_t t = 0; t < found.size(); t++) {
+        readers.emplace_back([&, t] {
+            for (auto const& e : expected) {
+                uint64_t value;
+                found[t] += frozen.search(e.first, value) && value == e.second;
+            }
+        });
+    }
+    for (auto& reader : readers) {
+        reader.join();
+    }
+    for (size_t f : found) {
+        ASSERT_EQ(f, expected.size());
+    }
+}
+
+template<typename table_t>
+void freeze_set_test(size_t n, size_t key_width) {
+    auto table = table_t(0, key_width);
+    std::unordered_set<uint64_t> expected;
+    std::mt19937_64 gen(n);
+    while (expected.size() < n) {
+        uint64_t const key = gen() & mask_for(key_width);
+        table.lookup_insert(key);
+        expected.insert(key);
+    }
+
+    auto frozen = tdc::compact_hash::set::freeze(table);
+    ASSERT_EQ(frozen.size(), n);
+    for (uint64_t key : expected) {
+        ASSERT_EQ(frozen.count(key), 1u) << "key " << key;
+    }
+    for (size_t i = 0; i < 1000; i++) {
+        uint64_t const key = gen() & mask_for(key_width);
+        ASSERT_EQ(frozen.count(key), expected.count(key)) << "key " << key;
+    }
+    ASSERT_LT(tdc::heap_size_compute(frozen).size_in_bytes(),
+              tdc::heap_size_compute(table).size_in_bytes());
+}
+
+TEST(frozen_hashset, sparse_cv) {
+    freeze_set_test<tdc::compact_hash::set::sparse_cv_hashset_t<>>(10000, 30);
+}
+
+TEST(frozen_hashset, sparse_robin_hood) {
+    freeze_set_test<tdc::compact_hash::set::sparse_robin_hood_hashset_t<>>(10000, 48);
+}
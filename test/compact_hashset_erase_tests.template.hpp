@@ -0,0 +1,20 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+
+// Tests of `erase()`, for the placements that support it.
+// Included after "compact_hashset_tests.template.hpp".
+
+TEST(hash, erase) {
+    auto ch = compact_hash_type(0, 16);
+    ch.max_load_factor(0.95);
+    for(size_t i = 0; i < 10000; i++) {
+        ch.lookup_insert(i);
+    }
+    for(size_t i = 0; i < 10000; i += 3) {
+        ASSERT_EQ(ch.erase(i), 1U);
+    }
+    for(size_t i = 0; i < 10000; i++) {
+        ASSERT_EQ(ch.count(i), size_t(i % 3 != 0));
+    }
+}
@@ -0,0 +1,22 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <algorithm>
+
+#include <tudocomp/util/compact_hash/map/typedefs.hpp>
+
+template<typename val_t>
+using COMPACT_TABLE = tdc::compact_hash::map::sparse_cuckoo_hashmap_t<val_t>;
+
+#include "compact_hash_tests.template.hpp"
+#include "compact_hash_erase_tests.template.hpp"
+
+TEST(hash, stash) {
+    // Disable the search for entries to move away,
+    // so that full blocks spill into the stash.
+    auto config = typename compact_hash_type<uint64_t>::config_args{};
+    config.displacement_config.max_search = 0;
+
+    auto ch = compact_hash_type<uint64_t>(4096, 16, 16, config);
+    check_stash_erase(ch);
+}
@@ -0,0 +1,67 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <algorithm>
+#include <sstream>
+
+#include <tudocomp/util/compact_hash/map/typedefs.hpp>
+#include <tudocomp/util/serialization.hpp>
+
+using fingerprint_placement_t = tdc::compact_hash::displacement_t<
+    tdc::compact_hash::layered_displacement_table_t<tdc::compact_hash::dynamic_layered_bit_width_t>,
+    true>;
+
+/// A layered hashmap that uses 8 bit fingerprints per default.
+template<typename val_t>
+using COMPACT_TABLE = tdc::compact_hash::map::hashmap_t<
+    val_t, tdc::compact_hash::poplar_xorshift_t,
+    tdc::compact_hash::buckets_bv_t, fingerprint_placement_t>;
+
+#include "compact_hash_tests.template.hpp"
+
+TEST(hash, fingerprint_heap_size) {
+    using plain_t = tdc::compact_hash::map::sparse_layered_hashmap_t<uint64_t>;
+
+    auto a = plain_t(1024, 16, 16);
+    auto b = COMPACT_TABLE<uint64_t>(1024, 16, 16);
+
+    auto a_bytes = tdc::heap_size_compute(a).size_in_bytes();
+    auto b_bytes = tdc::heap_size_compute(b).size_in_bytes();
+
+    // 8 bit per slot
+    ASSERT_GE(b_bytes, a_bytes + 1024);
+}
+
+TEST(hash, fingerprint_serialization) {
+    using table_t = COMPACT_TABLE<uint64_t>;
+    auto a = table_t(0, 16, 16);
+    for (uint64_t i = 0; i < 1000; i++) {
+        a.insert(i * 7, i + 1);
+    }
+
+    std::stringstream ss;
+    tdc::serialize<table_t>::write(ss, a);
+    auto b = tdc::serialize<table_t>::read(ss);
+    ASSERT_TRUE(tdc::serialize<table_t>::equal_check(a, b));
+    for (uint64_t i = 0; i < 1000; i++) {
+        ASSERT_EQ(*b.search(i * 7), i + 1);
+    }
+}
+
+// NB: Without fingerprints, the format is the one of the displacement table.
+TEST(hash, no_fingerprints_keep_format) {
+    using table_t = tdc::compact_hash::layered_displacement_table_t<
+        tdc::compact_hash::dynamic_layered_bit_width_t>;
+    using placement_t = tdc::compact_hash::displacement_t<table_t>;
+
+    auto placement = placement_t(1024, placement_t::config_args{});
+    for (size_t i = 0; i < 1024; i += 3) {
+        placement.displacement_table().set(i, i % 300);
+    }
+
+    std::stringstream with_placement;
+    std::stringstream with_table;
+    tdc::serialize<placement_t>::write(with_placement, placement, 1024);
+    tdc::serialize<table_t>::write(with_table, placement.displacement_table(), 1024);
+    ASSERT_EQ(with_placement.str(), with_table.str());
+}
@@ -0,0 +1,25 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <algorithm>
+
+#include <tudocomp/util/compact_hash/map/typedefs.hpp>
+
+template<typename val_t>
+using COMPACT_TABLE = tdc::compact_hash::map::sparse_hopscotch_hashmap_t<val_t>;
+
+#include "compact_hash_tests.template.hpp"
+#include "compact_hash_erase_tests.template.hpp"
+
+TEST(hash, stash) {
+    // A neighborhood of 2 slots is too small to place all entries
+    // at high load, so some of them spill into the stash.
+    using table_t = tdc::compact_hash::map::hashmap_t<
+        uint64_t,
+        tdc::compact_hash::poplar_xorshift_t,
+        tdc::compact_hash::buckets_bv_t,
+        tdc::compact_hash::hopscotch_t<2>>;
+
+    auto ch = table_t(4096, 16, 16);
+    check_stash_erase(ch);
+}
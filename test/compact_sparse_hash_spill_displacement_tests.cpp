@@ -0,0 +1,48 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <algorithm>
+
+#include <tudocomp/util/compact_hash/map/typedefs.hpp>
+
+template<typename val_t>
+using COMPACT_TABLE = tdc::compact_hash::map::hashmap_t<
+    val_t, tdc::compact_hash::poplar_xorshift_t, tdc::compact_hash::buckets_bv_t,
+    tdc::compact_hash::displacement_t<tdc::compact_hash::layered_displacement_table_t<
+        tdc::compact_hash::static_layered_bit_width_t<2>,
+        tdc::compact_hash::layered_compact_hash_spill_t<>>>>;
+
+#include "compact_hash_tests.template.hpp"
+
+template<typename spill_t>
+using spill_table_t = tdc::compact_hash::map::hashmap_t<
+    uint64_t, tdc::compact_hash::poplar_xorshift_t, tdc::compact_hash::buckets_bv_t,
+    tdc::compact_hash::displacement_t<tdc::compact_hash::layered_displacement_table_t<
+        tdc::compact_hash::static_layered_bit_width_t<1>, spill_t>>>;
+
+template<typename spill_t>
+size_t spill_heap_size() {
+    // NB: With 1 bit per displacement, every entry that is not at its
+    // initial address is spilled.
+    auto ch = spill_table_t<spill_t>(1 << 16, 32, 16);
+    ch.max_load_factor(0.95);
+    for (uint64_t i = 0; i < 60000; i++) {
+        ch.insert(i * 7, i & 0xffff);
+    }
+    for (uint64_t i = 0; i < 60000; i++) {
+        debug_check_single(ch, i * 7, i & 0xffff);
+    }
+    EXPECT_EQ(ch.table_size(), size_t(1) << 16);
+    auto const& spill = ch.placement().displacement_table().spill();
+    return tdc::heap_size_compute(spill).size_in_bytes();
+}
+
+TEST(hash, compact_spill_heap_size) {
+    size_t const unordered_map_bytes = spill_heap_size<tdc::compact_hash::unordered_map_spill_t>();
+    size_t const compact_bytes = spill_heap_size<tdc::compact_hash::compact_hash_spill_t<>>();
+    size_t const layered_bytes = spill_heap_size<tdc::compact_hash::layered_compact_hash_spill_t<>>();
+    // NB: The estimate for `std::unordered_map` only counts the keys
+    // and values, so the real difference is larger.
+    ASSERT_LT(compact_bytes * 3, unordered_map_bytes);
+    ASSERT_LT(layered_bytes * 3, unordered_map_bytes);
+}
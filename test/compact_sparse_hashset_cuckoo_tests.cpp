@@ -0,0 +1,12 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <algorithm>
+
+#include <tudocomp/util/compact_hash/set/typedefs.hpp>
+
+using COMPACT_TABLE = tdc::compact_hash::set::sparse_cuckoo_hashset_t<>;
+
+#include "compact_hashset_tests.template.hpp"
+
+#include "compact_hashset_erase_tests.template.hpp"
@@ -9,12 +9,18 @@
 #include <tudocomp/util/compact_hash/index_structure/displacement_t.hpp>
 #include <tudocomp/util/compact_hash/index_structure/elias_gamma_displacement_table_t.hpp>
 #include <tudocomp/util/compact_hash/index_structure/layered_displacement_table_t.hpp>
+#include <tudocomp/util/compact_hash/index_structure/compact_hash_spill_t.hpp>
 #include <tudocomp/util/compact_hash/index_structure/naive_displacement_table_t.hpp>
 #include <tudocomp/util/compact_hash/index_structure/cv_bvs_t.hpp>
+#include <tudocomp/util/compact_hash/index_structure/robin_hood_t.hpp>
+#include <tudocomp/util/compact_hash/index_structure/cuckoo_t.hpp>
+#include <tudocomp/util/compact_hash/index_structure/hopscotch_t.hpp>
 #include <tudocomp/util/compact_hash/hash_functions.hpp>
 #include <tudocomp/util/compact_hash/storage/buckets_bv_t.hpp>
 #include <tudocomp/util/compact_hash/storage/plain_sentinel_t.hpp>
+#include <tudocomp/util/compact_hash/storage/plain_bv_t.hpp>
 #include <tudocomp/util/serialization.hpp>
+#include <tudocomp/util/chunked_serialization.hpp>
 
 using namespace tdc::compact_hash;
 using namespace tdc::compact_hash::set;
@@ -23,6 +29,7 @@ using namespace tdc::compact_hash::map;
 template<typename table_t, typename build_func>
 void serialize_test_builder(build_func f) {
     using tdc::serialize;
+    using tdc::serialize_chunked;
     using tdc::heap_size;
     auto a = f();
 
@@ -40,6 +47,22 @@ void serialize_test_builder(build_func f) {
     ASSERT_TRUE(serialize<table_t>::equal_check(a, c));
     ASSERT_TRUE(serialize<table_t>::equal_check(b, c));
 
+    // Small chunks, such that several waves of threads are needed
+    for (bool checksums : { true, false }) {
+        auto config = tdc::chunked_config_t();
+        config.threads = 4;
+        config.units_per_chunk = 3;
+        config.checksums = checksums;
+
+        std::stringstream chunked_ss;
+        auto chunked_bytes = serialize_chunked<table_t>::write(chunked_ss, a, config);
+        size_t chunked_stream_bytes = chunked_ss.tellp();
+        ASSERT_EQ(chunked_bytes.size_in_bytes(), chunked_stream_bytes);
+
+        auto d = serialize_chunked<table_t>::read(chunked_ss, config);
+        ASSERT_TRUE(serialize<table_t>::equal_check(a, d));
+    }
+
     std::cout << "heap size: "
         << heap_size<table_t>::compute(a)
         << ", written bytes: "
@@ -150,6 +173,18 @@ gen_test_set(set_poplar_displacement_compact_dynamic,
     >
 )
 
+gen_test_set(set_poplar_displacement_compact_fixed_2_compact_spill,
+    hashset_t<
+        poplar_xorshift_t,
+        displacement_t<
+            layered_displacement_table_t<
+                static_layered_bit_width_t<2>,
+                layered_compact_hash_spill_t<>
+            >
+        >
+    >
+)
+
 gen_test_set(set_poplar_cv,
     hashset_t<
         poplar_xorshift_t,
@@ -157,6 +192,29 @@ gen_test_set(set_poplar_cv,
     >
 )
 
+gen_test_set(set_poplar_robin_hood_compact_dynamic,
+    hashset_t<
+        poplar_xorshift_t,
+        robin_hood_t<
+            layered_displacement_table_t<dynamic_layered_bit_width_t>
+        >
+    >
+)
+
+gen_test_set(set_poplar_cuckoo,
+    hashset_t<
+        poplar_xorshift_t,
+        cuckoo_t
+    >
+)
+
+gen_test_set(set_poplar_hopscotch_32,
+    hashset_t<
+        poplar_xorshift_t,
+        hopscotch_t<32>
+    >
+)
+
 gen_test_set(set_poplar_displacement_elias_fixed_1024,
     hashset_t<
         poplar_xorshift_t,
@@ -298,6 +356,20 @@ gen_test_map(map_poplar_bbv_displacement_compact_dynamic,
     >
 )
 
+gen_test_map(map_poplar_bbv_displacement_compact_fixed_2_compact_spill,
+    hashmap_t<
+        val_t,
+        poplar_xorshift_t,
+        buckets_bv_t,
+        displacement_t<
+            layered_displacement_table_t<
+                static_layered_bit_width_t<2>,
+                compact_hash_spill_t<>
+            >
+        >
+    >
+)
+
 gen_test_map(map_poplar_bbv_cv,
     hashmap_t<
         val_t,
@@ -307,6 +379,35 @@ gen_test_map(map_poplar_bbv_cv,
     >
 )
 
+gen_test_map(map_poplar_bbv_robin_hood_compact_dynamic,
+    hashmap_t<
+        val_t,
+        poplar_xorshift_t,
+        buckets_bv_t,
+        robin_hood_t<
+            layered_displacement_table_t<dynamic_layered_bit_width_t>
+        >
+    >
+)
+
+gen_test_map(map_poplar_bbv_cuckoo,
+    hashmap_t<
+        val_t,
+        poplar_xorshift_t,
+        buckets_bv_t,
+        cuckoo_t
+    >
+)
+
+gen_test_map(map_poplar_bbv_hopscotch_32,
+    hashmap_t<
+        val_t,
+        poplar_xorshift_t,
+        buckets_bv_t,
+        hopscotch_t<32>
+    >
+)
+
 gen_test_map(map_poplar_bbv_displacement_elias_fixed_1024,
     hashmap_t<
         val_t,
@@ -377,6 +478,35 @@ gen_test_map(map_poplar_ps_cv,
     >
 )
 
+gen_test_map(map_poplar_ps_robin_hood_compact_dynamic,
+    hashmap_t<
+        val_t,
+        poplar_xorshift_t,
+        plain_sentinel_t,
+        robin_hood_t<
+            layered_displacement_table_t<dynamic_layered_bit_width_t>
+        >
+    >
+)
+
+gen_test_map(map_poplar_ps_cuckoo,
+    hashmap_t<
+        val_t,
+        poplar_xorshift_t,
+        plain_sentinel_t,
+        cuckoo_t
+    >
+)
+
+gen_test_map(map_poplar_ps_hopscotch_32,
+    hashmap_t<
+        val_t,
+        poplar_xorshift_t,
+        plain_sentinel_t,
+        hopscotch_t<32>
+    >
+)
+
 gen_test_map(map_poplar_ps_displacement_elias_fixed_1024,
     hashmap_t<
         val_t,
@@ -415,3 +545,228 @@ gen_test_map(map_poplar_ps_displacement_elias_dynamic,
         >
     >
 )
+
+gen_test_map(map_poplar_pbv_displacement_compact_dynamic,
+    hashmap_t<
+        val_t,
+        poplar_xorshift_t,
+        plain_bv_t,
+        displacement_t<
+            layered_displacement_table_t<dynamic_layered_bit_width_t>
+        >
+    >
+)
+
+gen_test_map(map_poplar_pbv_cv,
+    hashmap_t<
+        val_t,
+        poplar_xorshift_t,
+        plain_bv_t,
+        cv_bvs_t
+    >
+)
+
+gen_test_map(map_poplar_pbv_robin_hood_compact_dynamic,
+    hashmap_t<
+        val_t,
+        poplar_xorshift_t,
+        plain_bv_t,
+        robin_hood_t<
+            layered_displacement_table_t<dynamic_layered_bit_width_t>
+        >
+    >
+)
+
+template<typename table_t>
+void serialize_test_byte_widths() {
+    // Buckets store quotients and values of these widths as arrays of
+    // native integers, and write them bit-packed.
+    for (size_t width : { 8, 9, 16, 32 }) {
+        serialize_test_builder<table_t>([width] {
+            auto ch = table_t(256, 8 + width, width);
+            auto key = [&](uint64_t i) {
+                return (i * 0x9E3779B97F4A7C15ull) & ((1ull << (8 + width)) - 1);
+            };
+
+            for(uint64_t i = 0; i < 100; i++) {
+                ch.insert(key(i), key(i) & ((1ull << width) - 1));
+            }
+            for(uint64_t i = 0; i < 100; i += 3) {
+                ch.erase(key(i));
+            }
+            EXPECT_EQ(ch.quotient_width(), width);
+
+            return ch;
+        });
+    }
+}
+
+TEST(serialize, map_poplar_bbv_robin_hood_byte_widths) {
+    serialize_test_byte_widths<hashmap_t<
+        tdc::dynamic_t,
+        poplar_xorshift_t,
+        buckets_bv_t,
+        robin_hood_t<
+            layered_displacement_table_t<dynamic_layered_bit_width_t>
+        >
+    >>();
+}
+
+template<typename table_t>
+void delta_test() {
+    using tdc::serialize;
+    using tdc::serialize_delta;
+
+    auto config = typename table_t::config_args{};
+    config.storage_config.track_dirty = true;
+    auto a = table_t(0, 10, 10, config);
+
+    for(uint64_t i = 0; i < 1000; i++) {
+        a.insert_kv_width(i, i * 3, 10, 16);
+    }
+
+    // base snapshot
+    std::stringstream base;
+    serialize<table_t>::write(base, a);
+    a.clear_dirty();
+    size_t const base_bytes = base.tellp();
+
+    std::vector<std::stringstream> deltas(6);
+
+    // updates of a few values
+    for(uint64_t i = 0; i < 1000; i += 100) {
+        a.insert_kv_width(i, i * 5, 10, 16);
+    }
+    auto small_bytes = serialize_delta<table_t>::write(deltas[0], a);
+    ASSERT_LT(small_bytes.size_in_bytes(), base_bytes);
+
+    // nothing changed
+    auto empty_bytes = serialize_delta<table_t>::write(deltas[1], a);
+
+    // lookups do not count as changes
+    for(uint64_t i = 0; i < 1000; i++) {
+        ASSERT_EQ(a.count(i), 1u);
+    }
+    auto lookup_bytes = serialize_delta<table_t>::write(deltas[2], a);
+    ASSERT_EQ(lookup_bytes.size_in_bytes(), empty_bytes.size_in_bytes());
+
+    // values changed through `find()`
+    for(uint64_t i = 1; i < 1000; i += 250) {
+        *a.find(i) = i * 11;
+    }
+    auto find_bytes = serialize_delta<table_t>::write(deltas[3], a);
+    ASSERT_LT(find_bytes.size_in_bytes(), base_bytes);
+
+    // the deltas up to here contain the changed values
+    {
+        std::stringstream base_copy(base.str());
+        auto c = serialize<table_t>::read(base_copy);
+        for (size_t d = 0; d < 4; d++) {
+            std::stringstream delta_copy(deltas[d].str());
+            serialize_delta<table_t>::apply(delta_copy, c);
+        }
+        ASSERT_TRUE(serialize<table_t>::equal_check(a, c));
+        for(uint64_t i = 1; i < 1000; i += 250) {
+            ASSERT_EQ(*c.search(i), i * 11);
+        }
+    }
+
+    // enough inserts to grow the table, and wider keys
+    for(uint64_t i = 1000; i < 5000; i++) {
+        a.insert_kv_width(i, i * 7, 14, 16);
+    }
+    serialize_delta<table_t>::write(deltas[4], a);
+
+    // a few more inserts after the grow
+    for(uint64_t i = 5000; i < 5010; i++) {
+        a.insert_kv_width(i, i * 9, 14, 16);
+    }
+    serialize_delta<table_t>::write(deltas[5], a);
+
+    auto b = serialize<table_t>::read(base);
+    for (auto& delta : deltas) {
+        serialize_delta<table_t>::apply(delta, b);
+    }
+
+    ASSERT_TRUE(serialize<table_t>::equal_check(a, b));
+    ASSERT_EQ(b.size(), 5010u);
+    for(uint64_t i = 0; i < 5010; i++) {
+        auto expected = i < 1000 ? (i % 100 == 0 ? i * 5 : i % 250 == 1 ? i * 11 : i * 3)
+                      : i < 5000 ? i * 7 : i * 9;
+        ASSERT_EQ(*b.search(i), expected);
+    }
+}
+
+TEST(serialize_delta, map_poplar_bbv_cv) {
+    delta_test<hashmap_t<val_t, poplar_xorshift_t, buckets_bv_t, cv_bvs_t>>();
+}
+
+TEST(serialize_delta, map_poplar_bbv_displacement_compact_dynamic) {
+    delta_test<hashmap_t<val_t, poplar_xorshift_t, buckets_bv_t,
+        displacement_t<layered_displacement_table_t<dynamic_layered_bit_width_t>>>>();
+}
+
+TEST(serialize_delta, map_poplar_bbv_displacement_fingerprints) {
+    delta_test<hashmap_t<val_t, poplar_xorshift_t, buckets_bv_t,
+        displacement_t<layered_displacement_table_t<dynamic_layered_bit_width_t>, true>>>();
+}
+
+TEST(serialize_delta, map_poplar_bbv_cuckoo) {
+    delta_test<hashmap_t<val_t, poplar_xorshift_t, buckets_bv_t, cuckoo_t>>();
+}
+
+TEST(serialize_delta, map_poplar_bbv_hopscotch) {
+    delta_test<hashmap_t<val_t, poplar_xorshift_t, buckets_bv_t, hopscotch_t<>>>();
+}
+
+/// A delta of a few changes only contains the placement state of the
+/// changed buckets, instead of the whole placement.
+TEST(serialize_delta, map_poplar_bbv_cv_placement_ranges) {
+    using tdc::serialize;
+    using tdc::serialize_delta;
+    using table_t = hashmap_t<val_t, poplar_xorshift_t, buckets_bv_t, cv_bvs_t>;
+
+    auto a = table_t(0, 20, 16);
+    for(uint64_t i = 0; i < 100000; i++) {
+        a.insert(i, uint64_t(i));
+    }
+    a.clear_dirty();
+
+    a.insert(100000, uint64_t(5));
+    std::stringstream delta;
+    auto bytes = serialize_delta<table_t>::write(delta, a);
+
+    std::stringstream placement;
+    auto placement_bytes = serialize<cv_bvs_t>::write(placement, a.placement(), a.table_size());
+    ASSERT_LT(bytes.size_in_bytes() * 10, placement_bytes.size_in_bytes());
+}
+
+TEST(serialize_delta, map_poplar_bbv_robin_hood_erase) {
+    using tdc::serialize;
+    using tdc::serialize_delta;
+    using table_t = hashmap_t<val_t, poplar_xorshift_t, buckets_bv_t,
+        robin_hood_t<layered_displacement_table_t<dynamic_layered_bit_width_t>>>;
+
+    auto a = table_t(0, 14, 16);
+    for(uint64_t i = 0; i < 3000; i++) {
+        a.insert(i, uint64_t(i * 3));
+    }
+
+    std::stringstream base;
+    serialize<table_t>::write(base, a);
+    a.clear_dirty();
+
+    for(uint64_t i = 0; i < 3000; i += 7) {
+        a.erase(i);
+    }
+    std::stringstream delta;
+    serialize_delta<table_t>::write(delta, a);
+
+    auto b = serialize<table_t>::read(base);
+    serialize_delta<table_t>::apply(delta, b);
+
+    ASSERT_TRUE(serialize<table_t>::equal_check(a, b));
+    for(uint64_t i = 0; i < 3000; i++) {
+        ASSERT_EQ(b.count(i), (i % 7 == 0) ? 0u : 1u);
+    }
+}